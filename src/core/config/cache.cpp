@@ -0,0 +1,38 @@
+#include "flock/core/config.hpp"
+
+namespace flock {
+
+std::string Config::get_result_cache_table_name() { return "FLOCKMTL_RESULT_CACHE_INTERNAL_TABLE"; }
+
+std::string Config::get_semantic_cache_table_name() { return "FLOCKMTL_SEMANTIC_CACHE_INTERNAL_TABLE"; }
+
+void Config::ConfigResultCacheTable(duckdb::Connection& con, std::string& schema_name, const ConfigType type) {
+    // Cached answers are shared across databases, so they only live in the global storage.
+    if (type != ConfigType::GLOBAL) {
+        return;
+    }
+
+    con.Query(duckdb_fmt::format(" CREATE TABLE IF NOT EXISTS {}.{} ( "
+                                 " cache_key VARCHAR PRIMARY KEY, "
+                                 " value VARCHAR NOT NULL, "
+                                 " size_bytes BIGINT NOT NULL, "
+                                 " created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP "
+                                 " ); ",
+                                 schema_name, get_result_cache_table_name()));
+}
+
+void Config::ConfigSemanticCacheTable(duckdb::Connection& con, std::string& schema_name, const ConfigType type) {
+    if (type != ConfigType::GLOBAL) {
+        return;
+    }
+
+    con.Query(duckdb_fmt::format(" CREATE TABLE IF NOT EXISTS {}.{} ( "
+                                 " cache_namespace VARCHAR NOT NULL, "
+                                 " embedding FLOAT[] NOT NULL, "
+                                 " value VARCHAR NOT NULL, "
+                                 " created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP "
+                                 " ); ",
+                                 schema_name, get_semantic_cache_table_name()));
+}
+
+}// namespace flock
@@ -91,6 +91,9 @@ void Config::ConfigureTables(duckdb::Connection& con, const ConfigType type) {
     ConfigSchema(con, schema);
     ConfigModelTable(con, schema, type);
     ConfigPromptTable(con, schema, type);
+    ConfigResultCacheTable(con, schema, type);
+    ConfigSemanticCacheTable(con, schema, type);
+    ConfigVectorIndexTables(con, schema, type);
     con.Commit();
 }
 
@@ -0,0 +1,39 @@
+#include "flock/core/config.hpp"
+
+namespace flock {
+
+std::string Config::get_vector_index_table_name() { return "FLOCKMTL_VECTOR_INDEX_INTERNAL_TABLE"; }
+
+std::string Config::get_vector_index_nodes_table_name() { return "FLOCKMTL_VECTOR_INDEX_NODES_INTERNAL_TABLE"; }
+
+void Config::ConfigVectorIndexTables(duckdb::Connection& con, std::string& schema_name, const ConfigType type) {
+    // An index describes a table of this database, so it is stored next to it.
+    if (type != ConfigType::LOCAL) {
+        return;
+    }
+
+    con.Query(duckdb_fmt::format(" CREATE TABLE IF NOT EXISTS {}.{} ( "
+                                 " index_name VARCHAR PRIMARY KEY, "
+                                 " table_name VARCHAR NOT NULL, "
+                                 " key_column VARCHAR NOT NULL, "
+                                 " embedding_column VARCHAR NOT NULL, "
+                                 " key_type VARCHAR NOT NULL, "
+                                 " model VARCHAR, "
+                                 " entry_point UINTEGER NOT NULL, "
+                                 " created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP "
+                                 " ); ",
+                                 schema_name, get_vector_index_table_name()));
+
+    // One row per graph node: the node's key in the indexed table, its links per level and its
+    // unit-length embedding.
+    con.Query(duckdb_fmt::format(" CREATE TABLE IF NOT EXISTS {}.{} ( "
+                                 " index_name VARCHAR NOT NULL, "
+                                 " node_id UINTEGER NOT NULL, "
+                                 " row_key VARCHAR NOT NULL, "
+                                 " neighbors UINTEGER[][] NOT NULL, "
+                                 " embedding FLOAT[] NOT NULL "
+                                 " ); ",
+                                 schema_name, get_vector_index_nodes_table_name()));
+}
+
+}// namespace flock
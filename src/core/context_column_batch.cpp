@@ -0,0 +1,99 @@
+#include "flock/core/context_column_batch.hpp"
+
+namespace flock {
+
+ContextColumnBatch ContextColumnBatch::FromJson(const nlohmann::json& context_columns) {
+    ContextColumnBatch batch;
+    batch.owned_cells = std::make_shared<std::deque<std::string>>();
+    if (!context_columns.is_array() || context_columns.empty()) {
+        return batch;
+    }
+
+    batch.row_count = context_columns[0].contains("data") ? context_columns[0]["data"].size() : 0;
+    batch.columns.resize(context_columns.size());
+    for (size_t column = 0; column < context_columns.size(); column++) {
+        auto& target = batch.columns[column];
+        target.metadata = nlohmann::json::object();
+        for (const auto& item: context_columns[column].items()) {
+            if (item.key() != "data") {
+                target.metadata[item.key()] = item.value();
+            }
+        }
+
+        target.cells.resize(batch.row_count);
+        target.valid.resize(batch.row_count, false);
+        if (!context_columns[column].contains("data")) {
+            continue;
+        }
+        const auto& data = context_columns[column]["data"];
+        for (idx_t row = 0; row < batch.row_count && row < data.size(); row++) {
+            if (data[row].is_null()) {
+                continue;
+            }
+            const auto& text = batch.owned_cells->emplace_back(data[row].is_string() ? data[row].get<std::string>()
+                                                                                     : data[row].dump());
+            target.cells[row] = duckdb::string_t(text.data(), static_cast<uint32_t>(text.size()));
+            target.valid[row] = true;
+        }
+    }
+    return batch;
+}
+
+std::string ContextColumnBatch::GetCell(const size_t column, const idx_t row) const {
+    const auto& source = columns[column];
+    return source.valid[row] ? source.cells[row].GetString() : std::string("NULL");
+}
+
+bool ContextColumnBatch::IsEmptyRow(const idx_t row) const {
+    static const duckdb::string_t null_text("NULL");
+    for (const auto& column: columns) {
+        if (column.valid[row] && column.cells[row].GetSize() != 0 && !(column.cells[row] == null_text)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ContextColumnBatch ContextColumnBatch::Select(const std::vector<size_t>& rows) const {
+    ContextColumnBatch selected;
+    selected.row_count = rows.size();
+    selected.cast_vectors = cast_vectors;
+    selected.owned_cells = owned_cells;
+    selected.columns.resize(columns.size());
+    for (size_t column = 0; column < columns.size(); column++) {
+        auto& target = selected.columns[column];
+        target.metadata = columns[column].metadata;
+        target.cells.reserve(rows.size());
+        target.valid.reserve(rows.size());
+        for (const auto row: rows) {
+            target.cells.push_back(columns[column].cells[row]);
+            target.valid.push_back(columns[column].valid[row]);
+        }
+    }
+    return selected;
+}
+
+ContextColumnBatch ContextColumnBatch::Slice(const idx_t start, const idx_t count) const {
+    std::vector<size_t> rows;
+    for (auto row = start; row < row_count && row < start + count; row++) {
+        rows.push_back(row);
+    }
+    return Select(rows);
+}
+
+nlohmann::json ContextColumnBatch::ToJson() const {
+    auto context_columns = nlohmann::json::array();
+    for (const auto& column: columns) {
+        auto context_column = column.metadata;
+        auto data = nlohmann::json::array();
+        data.get_ref<nlohmann::json::array_t&>().reserve(row_count);
+        for (idx_t row = 0; row < row_count; row++) {
+            data.push_back(column.valid[row] ? column.cells[row].GetString() : std::string("NULL"));
+        }
+        context_column["data"] = std::move(data);
+        context_columns.push_back(std::move(context_column));
+    }
+    return context_columns;
+}
+
+}// namespace flock
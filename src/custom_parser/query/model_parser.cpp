@@ -3,6 +3,7 @@
 #include "flock/core/common.hpp"
 #include "flock/core/config.hpp"
 #include "flock/custom_parser/query_parser.hpp"
+#include "flock/model_manager/repository.hpp"
 #include "flock/prompt_manager/repository.hpp"
 #include <sstream>
 #include <stdexcept>
@@ -13,7 +14,9 @@ namespace {
 
 bool IsAllowedModelArgKey(const std::string& key) {
     return key == "tuple_format" || key == "batch_size" || key == "max_batch_size" || key == "model_parameters" ||
-           key == "is_async" || key == "rate_limit" || key == "usage_limit";
+           key == "is_async" || key == "rate_limit" || key == "usage_limit" || key == "dictionary_encoding" ||
+           key == "output_token_budget" || key == "output_encoding" || key == "cache" ||
+           key == "semantic_cache" || key == "empty_input_default" || key == "long_input";
 }
 
 void ValidateAndAssignBatchSizeArg(nlohmann::json& model_args, const std::string& key, const nlohmann::json& value) {
@@ -55,12 +58,36 @@ nlohmann::json ValidateUsageLimitObject(const nlohmann::json& value) {
     return result;
 }
 
+nlohmann::json ValidateDictionaryEncodingObject(const nlohmann::json& value) {
+    const auto allowed_fields = std::vector<std::string>{"min_length", "min_repeats"};
+    const auto& error_message = "Expected 'dictionary_encoding' to be a JSON object such as {\"min_length\": 16, \"min_repeats\": 2}.";
+    if (!value.is_object()) {
+        throw std::runtime_error(error_message);
+    }
+
+    nlohmann::json result = nlohmann::json::object();
+    for (auto it = value.begin(); it != value.end(); ++it) {
+        const std::string& field = it.key();
+        if (std::find(allowed_fields.begin(), allowed_fields.end(), field) == allowed_fields.end() || !it.value().is_number_unsigned()) {
+            throw std::runtime_error(error_message);
+        }
+        const auto field_value = it.value().get<size_t>();
+        if (field_value <= 0) {
+            throw std::runtime_error("'" + field + "' must be larger than 0");
+        }
+        result[field] = field_value;
+    }
+
+    return result;
+}
+
 void ValidateAndAssignModelArg(nlohmann::json& model_args, const std::string& key, const nlohmann::json& value) {
     if (!IsAllowedModelArgKey(key)) {
         throw std::runtime_error(
                 "Unknown model_args parameter: '" + key +
-                "'. Only tuple_format, batch_size, max_batch_size, model_parameters, is_async, rate_limit, and "
-                "usage_limit are allowed.");
+                "'. Only tuple_format, batch_size, max_batch_size, model_parameters, is_async, rate_limit, "
+                "usage_limit, dictionary_encoding, output_token_budget, output_encoding, cache, semantic_cache, "
+                "empty_input_default, and long_input are allowed.");
     }
 
     if (key == "batch_size" || key == "max_batch_size") {
@@ -76,6 +103,37 @@ void ValidateAndAssignModelArg(nlohmann::json& model_args, const std::string& ke
         return;
     }
 
+    if (key == "output_encoding") {
+        if (!value.is_string()) {
+            throw std::runtime_error("Expected 'output_encoding' to be a string.");
+        }
+        model_args[key] = outputEncodingToString(stringToOutputEncoding(value.get<std::string>()));
+        return;
+    }
+
+    if (key == "cache") {
+        if (!value.is_string()) {
+            throw std::runtime_error("Expected 'cache' to be a string.");
+        }
+        model_args[key] = cacheModeToString(stringToCacheMode(value.get<std::string>()));
+        return;
+    }
+
+    if (key == "semantic_cache") {
+        model_args[key] = SemanticCacheToJson(ParseSemanticCacheFromJson(value));
+        return;
+    }
+
+    if (key == "empty_input_default") {
+        model_args[key] = ParseEmptyInputDefault(value);
+        return;
+    }
+
+    if (key == "long_input") {
+        model_args[key] = LongInputToJson(ParseLongInputFromJson(value));
+        return;
+    }
+
     if (key == "model_parameters") {
         if (!value.is_object()) {
             throw std::runtime_error("Expected 'model_parameters' to be a JSON object.");
@@ -84,9 +142,9 @@ void ValidateAndAssignModelArg(nlohmann::json& model_args, const std::string& ke
         return;
     }
 
-    if (key == "is_async") {
+    if (key == "is_async" || key == "output_token_budget") {
         if (!value.is_boolean()) {
-            throw std::runtime_error("Expected 'is_async' to be a boolean.");
+            throw std::runtime_error("Expected '" + key + "' to be a boolean.");
         }
         model_args[key] = value.get<bool>();
         return;
@@ -109,6 +167,11 @@ void ValidateAndAssignModelArg(nlohmann::json& model_args, const std::string& ke
         model_args[key] = ValidateUsageLimitObject(value);
         return;
     }
+
+    if (key == "dictionary_encoding") {
+        model_args[key] = ValidateDictionaryEncodingObject(value);
+        return;
+    }
 }
 
 }// namespace
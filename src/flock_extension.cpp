@@ -7,6 +7,9 @@
 #include "flock/core/common.hpp"
 #include "flock/core/config.hpp"
 #include "flock/custom_parser/query_parser.hpp"
+#include "flock/model_manager/inflight_budget.hpp"
+#include "flock/model_manager/request_executor.hpp"
+#include "flock/optimizer/llm_call_fusion.hpp"
 
 #include <flock/model_manager/model.hpp>
 
@@ -20,6 +23,9 @@ static void LoadInternal(ExtensionLoader& loader) {
     DuckParserExtension duck_parser;
     ParserExtension::Register(config, duck_parser);
     OperatorExtension::Register(config, make_shared_ptr<DuckOperatorExtension>());
+    flock::LlmCallFusion::Register(config);
+    flock::RequestExecutor::Register(config);
+    flock::InflightBudget::Register(config);
 }
 
 ParserExtensionParseResult duck_parse(ParserExtensionInfo*, const std::string& query) {
@@ -123,16 +123,10 @@ duckdb::unique_ptr<LlmFunctionBindData> AggregateFunctionBase::ValidateAndInitia
     return bind_data;
 }
 
-std::tuple<nlohmann::json, nlohmann::json>
-AggregateFunctionBase::CastInputsToJson(duckdb::Vector inputs[], idx_t count) {
-    auto prompt_context_json = CastVectorOfStructsToJson(inputs[1], count);
-    auto context_columns = nlohmann::json::array();
-    if (prompt_context_json.contains("context_columns")) {
-        context_columns = prompt_context_json["context_columns"];
-        prompt_context_json.erase("context_columns");
-    }
-
-    return std::make_tuple(prompt_context_json, context_columns);
+ContextColumnBatch AggregateFunctionBase::ExtractContextColumns(duckdb::Vector inputs[], idx_t count) {
+    // The prompt is resolved at bind time, so only the context columns are kept.
+    nlohmann::json prompt_json;
+    return ExtractPromptInputs(inputs[1], count, prompt_json);
 }
 
 }// namespace flock
@@ -7,29 +7,26 @@ void AggregateFunctionState::Initialize() {
     initialized = true;
 }
 
-void AggregateFunctionState::Update(const nlohmann::json& input) {
+void AggregateFunctionState::Update(const ContextColumnBatch& batch, const idx_t begin, const idx_t end) {
     if (!value) {
         Initialize();
     }
 
-    auto idx = 0u;
-    for (const auto& column: input) {
-        if (value->size() <= idx) {
+    for (size_t column = 0; column < batch.columns.size(); column++) {
+        if (value->size() <= column) {
             value->push_back(nlohmann::json::object());
-            (*value)[idx]["data"] = nlohmann::json::array();
+            (*value)[column]["data"] = nlohmann::json::array();
         }
-        for (const auto& item: column.items()) {
-            if (item.key() == "data") {
-                for (const auto& item_value: item.value()) {
-                    (*value)[idx]["data"].push_back(item_value);
-                }
-            } else {
-                if (!(*value)[idx].contains(item.key())) {
-                    (*value)[idx][item.key()] = item.value();
-                }
+        auto& target = (*value)[column];
+        for (const auto& item: batch.columns[column].metadata.items()) {
+            if (!target.contains(item.key())) {
+                target[item.key()] = item.value();
             }
         }
-        idx++;
+        auto& data = target["data"];
+        for (auto row = begin; row < end; row++) {
+            data.push_back(batch.GetCell(column, row));
+        }
     }
 }
 
@@ -2,6 +2,7 @@
 #include "flock/functions/aggregate/llm_first_or_last.hpp"
 #include "flock/functions/llm_function_bind_data.hpp"
 #include "flock/metrics/manager.hpp"
+#include "flock/model_manager/batch_size_controller.hpp"
 
 #include <chrono>
 #include <set>
@@ -17,7 +18,8 @@ duckdb::unique_ptr<duckdb::FunctionData> LlmFirstOrLast::Bind(
 
 int LlmFirstOrLast::GetFirstOrLastTupleId(nlohmann::json& tuples) {
     const auto [prompt, media_data] = PromptManager::Render(
-            user_query, tuples, function_type, model.GetModelDetails().tuple_format);
+            user_query, tuples, function_type, model.GetModelDetails().tuple_format,
+            model.GetModelDetails().dictionary_encoding);
     model.AddCompletionRequest(prompt, 1, OutputType::INTEGER, media_data);
     auto response = model.CollectCompletions()[0];
 
@@ -87,7 +89,9 @@ nlohmann::json LlmFirstOrLast::Evaluate(nlohmann::json& tuples) {
 
     auto batch_tuples = nlohmann::json::array();
     int start_index = 0;
-    auto batch_size = std::min<int>(model.GetModelDetails().max_batch_size, num_tuples);
+    const auto& model_details = model.GetModelDetails();
+    const int max_batch_size = model_details.max_batch_size;
+    auto batch_size = std::min<int>(BatchSizeController::Initial(model_details, user_query, max_batch_size), num_tuples);
 
     do {
         for (auto i = 0; i < static_cast<int>(tuples.size()); i++) {
@@ -109,9 +113,14 @@ nlohmann::json LlmFirstOrLast::Evaluate(nlohmann::json& tuples) {
         }
 
         start_index += batch_size;
+        const int batch_rows = static_cast<int>(batch_tuples[0]["data"].size());
 
         try {
+            const auto started = std::chrono::steady_clock::now();
             auto result_idx = GetFirstOrLastTupleId(batch_tuples);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+            batch_size = BatchSizeController::OnSuccess(model_details, user_query, batch_rows, elapsed.count(),
+                                                        max_batch_size);
 
             batch_tuples.clear();
             for (auto i = 0; i < static_cast<int>(tuples.size()); i++) {
@@ -127,7 +136,7 @@ nlohmann::json LlmFirstOrLast::Evaluate(nlohmann::json& tuples) {
             }
         } catch (const TokenLimitExceededError&) {
             start_index -= batch_size;
-            batch_size = static_cast<int>(batch_size * 0.9);
+            batch_size = BatchSizeController::OnTokenLimit(model_details, user_query, batch_rows);
             if (batch_size <= 0) {
                 throw std::runtime_error("Batch size reduced to zero, unable to process tuples");
             }
@@ -158,7 +167,7 @@ void LlmFirstOrLast::FinalizeResults(duckdb::Vector& states, duckdb::AggregateIn
     auto& bind_data = aggr_input_data.bind_data->Cast<LlmFunctionBindData>();
 
     auto temp_model = bind_data.CreateModel();
-    auto model_details_obj = temp_model.GetModelDetails();
+    const auto& model_details_obj = temp_model.GetModelDetails();
 
     auto db = Config::db;
     std::vector<const void*> processed_state_ids;
@@ -2,6 +2,7 @@
 #include "flock/functions/aggregate/llm_reduce.hpp"
 #include "flock/functions/llm_function_bind_data.hpp"
 #include "flock/metrics/manager.hpp"
+#include "flock/model_manager/batch_size_controller.hpp"
 
 #include <chrono>
 
@@ -18,7 +19,8 @@ nlohmann::json LlmReduce::ReduceBatch(nlohmann::json& tuples,
                                       const AggregateFunctionType& function_type,
                                       const nlohmann::json& summary) {
     auto [prompt, media_data] = PromptManager::Render(
-            user_query, tuples, function_type, model.GetModelDetails().tuple_format);
+            user_query, tuples, function_type, model.GetModelDetails().tuple_format,
+            model.GetModelDetails().dictionary_encoding);
 
     prompt += "\n\n" + summary.dump(4);
 
@@ -33,7 +35,9 @@ nlohmann::json LlmReduce::ReduceLoop(const nlohmann::json& tuples,
     auto summary = nlohmann::json::object({{"Previous Batch Summary", ""}});
     int start_index = 0;
     int num_tuples = static_cast<int>(tuples[0]["data"].size());
-    auto batch_size = std::min<int>(model.GetModelDetails().max_batch_size, num_tuples);
+    const auto& model_details = model.GetModelDetails();
+    const int max_batch_size = model_details.max_batch_size;
+    auto batch_size = std::min<int>(BatchSizeController::Initial(model_details, user_query, max_batch_size), num_tuples);
 
     do {
         for (auto i = 0; i < static_cast<int>(tuples.size()); i++) {
@@ -52,13 +56,19 @@ nlohmann::json LlmReduce::ReduceLoop(const nlohmann::json& tuples,
 
         start_index += batch_size;
 
+        const int batch_rows = static_cast<int>(batch_tuples[0]["data"].size());
         try {
+            const auto started = std::chrono::steady_clock::now();
             auto response = ReduceBatch(batch_tuples, function_type, summary);
             batch_tuples.clear();
             summary = nlohmann::json::object({{"Previous Batch Summary", response}});
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+            batch_size = BatchSizeController::OnSuccess(model_details, user_query, batch_rows, elapsed.count(),
+                                                        max_batch_size);
         } catch (const TokenLimitExceededError&) {
             start_index -= batch_size;// Retry the current batch with reduced size
-            batch_size = static_cast<int>(batch_size * 0.9);
+            batch_tuples.clear();
+            batch_size = BatchSizeController::OnTokenLimit(model_details, user_query, batch_rows);
             if (batch_size <= 0) {
                 throw std::runtime_error("Batch size reduced to zero, unable to process tuples");
             }
@@ -80,7 +90,7 @@ void LlmReduce::FinalizeResults(duckdb::Vector& states, duckdb::AggregateInputDa
 
     // Get model details for metrics (create temp model just for details)
     auto temp_model = bind_data.CreateModel();
-    auto model_details_obj = temp_model.GetModelDetails();
+    const auto& model_details_obj = temp_model.GetModelDetails();
 
     auto db = Config::db;
     std::vector<const void*> processed_state_ids;
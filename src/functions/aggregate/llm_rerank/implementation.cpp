@@ -1,7 +1,9 @@
 #include "flock/core/config.hpp"
 #include "flock/functions/aggregate/llm_rerank.hpp"
+#include "flock/functions/output_decoder.hpp"
 #include "flock/functions/llm_function_bind_data.hpp"
 #include "flock/metrics/manager.hpp"
+#include "flock/model_manager/batch_size_controller.hpp"
 
 #include <chrono>
 #include <set>
@@ -16,14 +18,9 @@ duckdb::unique_ptr<duckdb::FunctionData> LlmRerank::Bind(
 }
 
 std::vector<int> LlmRerank::RerankBatch(const nlohmann::json& tuples) {
-    auto [prompt, media_data] = PromptManager::Render(
-            user_query, tuples, AggregateFunctionType::RERANK, model.GetModelDetails().tuple_format);
-
+    const auto& model_details = model.GetModelDetails();
     int num_tuples = static_cast<int>(tuples[0]["data"].size());
 
-    model.AddCompletionRequest(prompt, num_tuples, OutputType::INTEGER, media_data);
-    auto responses = model.CollectCompletions();
-
     // Find flock_row_id column to get valid IDs
     std::set<std::string> valid_ids;
     for (const auto& column: tuples) {
@@ -39,10 +36,30 @@ std::vector<int> LlmRerank::RerankBatch(const nlohmann::json& tuples) {
         }
     }
 
+    nlohmann::json ranked_items;
+    if (model_details.output_encoding == OutputEncoding::COMPACT) {
+        auto [prompt, media_data] = PromptManager::Render(
+                user_query, tuples, AggregateFunctionType::RERANK, model_details.tuple_format,
+                model_details.dictionary_encoding, OutputEncoding::COMPACT);
+        model.AddCompletionRequest(prompt, num_tuples, OutputType::INDEX_LIST, media_data);
+        if (auto decoded = DecodeCompactIndexList(model.CollectCompletions()[0]["items"], valid_ids)) {
+            ranked_items = std::move(*decoded);
+        }
+    }
+
+    // JSON encoding, also used when a compact answer does not validate
+    if (ranked_items.is_null()) {
+        auto [prompt, media_data] = PromptManager::Render(
+                user_query, tuples, AggregateFunctionType::RERANK, model_details.tuple_format,
+                model_details.dictionary_encoding);
+        model.AddCompletionRequest(prompt, num_tuples, OutputType::INTEGER, media_data);
+        ranked_items = model.CollectCompletions()[0]["items"];
+    }
+
     std::vector<int> indices;
     std::set<std::string> seen_ids;
 
-    for (const auto& item: responses[0]["items"]) {
+    for (const auto& item: ranked_items) {
         std::string id_str;
         int id_int = -1;
 
@@ -109,7 +126,9 @@ nlohmann::json LlmRerank::SlidingWindow(nlohmann::json& tuples) {
     auto carry_forward_tuples = nlohmann::json::array();
     int start_index = 0;
 
-    auto batch_size = std::min<int>(model.GetModelDetails().max_batch_size, num_tuples);
+    const auto& model_details = model.GetModelDetails();
+    const int max_batch_size = model_details.max_batch_size;
+    auto batch_size = std::min<int>(BatchSizeController::Initial(model_details, user_query, max_batch_size), num_tuples);
 
     while (start_index < num_tuples || !carry_forward_tuples.empty()) {
         auto window_tuples = carry_forward_tuples;
@@ -147,6 +166,7 @@ nlohmann::json LlmRerank::SlidingWindow(nlohmann::json& tuples) {
             continue;
         }
 
+        const int batch_rows = static_cast<int>(window_tuples[0]["data"].size());
         try {
             // Build indexed tuples with flock_row_id
             auto indexed_tuples = window_tuples;
@@ -155,7 +175,11 @@ nlohmann::json LlmRerank::SlidingWindow(nlohmann::json& tuples) {
                 indexed_tuples.back()["data"].push_back(std::to_string(i));
             }
 
+            const auto started = std::chrono::steady_clock::now();
             auto ranked_indices = RerankBatch(indexed_tuples);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+            batch_size = BatchSizeController::OnSuccess(model_details, user_query, batch_rows, elapsed.count(),
+                                                        max_batch_size);
 
             // Initialize final_ranked_tuples structure if needed (first time adding results)
             if (final_ranked_tuples.empty() && !window_tuples.empty()) {
@@ -219,7 +243,7 @@ nlohmann::json LlmRerank::SlidingWindow(nlohmann::json& tuples) {
 
         } catch (const TokenLimitExceededError&) {
             // Retry the current batch with reduced size
-            batch_size = static_cast<int>(batch_size * 0.9);
+            batch_size = BatchSizeController::OnTokenLimit(model_details, user_query, batch_rows);
             if (batch_size <= 0) {
                 throw std::runtime_error("Batch size reduced to zero, unable to process tuples");
             }
@@ -239,7 +263,7 @@ void LlmRerank::Finalize(duckdb::Vector& states, duckdb::AggregateInputData& agg
 
     // Get model details for metrics (create temp model just for details)
     auto temp_model = bind_data.CreateModel();
-    auto model_details_obj = temp_model.GetModelDetails();
+    const auto& model_details_obj = temp_model.GetModelDetails();
 
     auto db = Config::db;
     std::vector<const void*> processed_state_ids;
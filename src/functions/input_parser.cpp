@@ -1,6 +1,11 @@
 #include "flock/functions/input_parser.hpp"
 
 #include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "flock/prompt_manager/token_counter.hpp"
+
+#include <algorithm>
+#include <optional>
 
 namespace flock {
 
@@ -36,66 +41,184 @@ static void ValidateAndCleanContextColumn(nlohmann::json& column, const std::ini
     if (has_type && column_type == "audio" && !has_transcription_model) {
         throw std::runtime_error("Argument 'transcription_model' is required when type is 'audio'.");
     }
+
+    if (column.contains("max_tokens")) {
+        int max_tokens = 0;
+        try {
+            max_tokens = std::stoi(column["max_tokens"].get<std::string>());
+        } catch (const std::exception&) {
+            throw std::runtime_error("Expected 'max_tokens' in 'context_columns' to be an integer.");
+        }
+        if (max_tokens <= 0) {
+            throw std::runtime_error("'max_tokens' in 'context_columns' must be larger than 0");
+        }
+        column["max_tokens"] = max_tokens;
+    }
+
+    if (column.contains("truncate")) {
+        if (!column.contains("max_tokens")) {
+            throw std::runtime_error("Argument 'truncate' in 'context_columns' requires 'max_tokens'.");
+        }
+        auto strategy = column["truncate"].get<std::string>();
+        stringToTruncationStrategy(strategy);
+        std::transform(strategy.begin(), strategy.end(), strategy.begin(), ::tolower);
+        column["truncate"] = strategy;
+    }
 }
 
-nlohmann::json CastVectorOfStructsToJson(const duckdb::Vector& struct_vector, const int size) {
-    nlohmann::json struct_json;
+static constexpr std::initializer_list<const char*> CONTEXT_COLUMN_KEYS = {
+        "name", "data", "type", "detail", "transcription_model", "max_tokens", "truncate"};
 
-    for (auto i = 0; i < size; i++) {
-        for (auto j = 0; j < static_cast<int>(duckdb::StructType::GetChildCount(struct_vector.GetType())); j++) {
-            const auto key = duckdb::StructType::GetChildName(struct_vector.GetType(), j);
-            auto value = duckdb::StructValue::GetChildren(struct_vector.GetValue(i))[j];
-            if (key == "context_columns") {
-                if (value.GetTypeMutable().id() != duckdb::LogicalTypeId::LIST) {
-                    throw std::runtime_error("Expected 'context_columns' to be a list.");
-                }
+static void FlattenDictionary(duckdb::Vector& vector, const idx_t count) {
+    if (vector.GetVectorType() == duckdb::VectorType::DICTIONARY_VECTOR) {
+        vector.Flatten(count);
+    }
+}
 
-                auto context_columns = duckdb::ListValue::GetChildren(value);
-                for (auto context_column_idx = 0; context_column_idx < static_cast<int>(context_columns.size()); context_column_idx++) {
-                    auto context_column = context_columns[context_column_idx];
-                    auto context_column_json = CastVectorOfStructsToJson(duckdb::Vector(context_column), 1);
-                    auto allowed_keys = {"name", "data", "type", "detail", "transcription_model"};
-                    for (const auto& key: context_column_json.items()) {
-                        if (std::find(std::begin(allowed_keys), std::end(allowed_keys), key.key()) == std::end(allowed_keys)) {
-                            throw std::runtime_error(duckdb_fmt::format("Unexpected key in 'context_columns': {}", key.key()));
-                        }
-                    }
+// Reads the `context_columns` list of every row. Column metadata is taken from the first row
+// that has a list; the cells of each column are collected as string views.
+static void ExtractContextColumns(duckdb::Vector& list_vector, const duckdb::UnifiedVectorFormat& struct_format,
+                                  const idx_t size, ContextColumnBatch& batch) {
+    if (list_vector.GetType().id() != duckdb::LogicalTypeId::LIST) {
+        throw std::runtime_error("Expected 'context_columns' to be a list.");
+    }
+    duckdb::UnifiedVectorFormat list_format;
+    list_vector.ToUnifiedFormat(size, list_format);
+    const auto list_entries = duckdb::UnifiedVectorFormat::GetData<duckdb::list_entry_t>(list_format);
 
-                    auto required_keys = {"data"};
-                    for (const auto& key: required_keys) {
-                        if (!context_column_json.contains(key)) {
-                            throw std::runtime_error(duckdb_fmt::format("Expected 'context_columns' to contain key: {}", key));
-                        }
-                    }
+    std::vector<const duckdb::list_entry_t*> row_lists(size, nullptr);
+    const duckdb::list_entry_t* first_list = nullptr;
+    for (idx_t row = 0; row < size; row++) {
+        const auto struct_idx = struct_format.sel->get_index(row);
+        const auto list_idx = list_format.sel->get_index(struct_idx);
+        if (!struct_format.validity.RowIsValid(struct_idx) || !list_format.validity.RowIsValid(list_idx)) {
+            continue;
+        }
+        row_lists[row] = &list_entries[list_idx];
+        if (!first_list) {
+            first_list = row_lists[row];
+        } else if (row_lists[row]->length != first_list->length) {
+            throw std::runtime_error("Expected every row to pass the same number of 'context_columns'.");
+        }
+    }
+    if (!first_list || first_list->length == 0) {
+        return;
+    }
 
-                    if (struct_json.contains("context_columns") && struct_json["context_columns"].size() == context_columns.size()) {
-                        struct_json["context_columns"][context_column_idx]["data"].push_back(context_column_json["data"]);
-                    } else {
-                        struct_json["context_columns"].push_back(context_column_json);
-                        ValidateAndCleanContextColumn(struct_json["context_columns"][context_column_idx], allowed_keys);
-                        struct_json["context_columns"][context_column_idx]["data"] = nlohmann::json::array();
-                        struct_json["context_columns"][context_column_idx]["data"].push_back(context_column_json["data"]);
-                    }
-                }
-            } else if (key == "batch_size" || key == "max_batch_size") {
-                if (value.GetTypeMutable() != duckdb::LogicalType::INTEGER) {
-                    throw std::runtime_error("Expected '" + std::string(key) + "' to be an integer.");
-                }
-                const int batch_size = value.GetValue<int>();
-                if (batch_size <= 0) {
-                    throw std::runtime_error("'" + std::string(key) + "' must be larger than 0");
-                }
-                struct_json[key] = batch_size;
-            } else if (key == "is_async") {
-                if (value.GetTypeMutable().id() != duckdb::LogicalTypeId::BOOLEAN) {
-                    throw std::runtime_error("Expected 'is_async' to be a boolean.");
-                }
-                struct_json[key] = value.GetValue<bool>();
-            } else {
-                struct_json[key] = value.ToString();
+    auto& columns_vector = duckdb::ListVector::GetEntry(list_vector);
+    const auto total = duckdb::ListVector::GetListSize(list_vector);
+    if (columns_vector.GetType().id() != duckdb::LogicalTypeId::STRUCT) {
+        throw std::runtime_error("Expected 'context_columns' to be a list of structs.");
+    }
+    FlattenDictionary(columns_vector, total);
+    duckdb::UnifiedVectorFormat columns_format;
+    columns_vector.ToUnifiedFormat(total, columns_format);
+    auto& fields = duckdb::StructVector::GetEntries(columns_vector);
+
+    std::optional<idx_t> data_field;
+    for (idx_t field = 0; field < fields.size(); field++) {
+        const auto& key = duckdb::StructType::GetChildName(columns_vector.GetType(), field);
+        if (std::find(CONTEXT_COLUMN_KEYS.begin(), CONTEXT_COLUMN_KEYS.end(), key) == CONTEXT_COLUMN_KEYS.end()) {
+            throw std::runtime_error(duckdb_fmt::format("Unexpected key in 'context_columns': {}", key));
+        }
+        if (key == "data") {
+            data_field = field;
+        }
+    }
+    if (!data_field.has_value()) {
+        throw std::runtime_error("Expected 'context_columns' to contain key: data");
+    }
+
+    // Non-VARCHAR data is cast once per chunk, with the same text Value::ToString would give.
+    duckdb::Vector* data_vector = fields[*data_field].get();
+    if (data_vector->GetType().id() != duckdb::LogicalTypeId::VARCHAR) {
+        batch.cast_vectors.push_back(std::make_shared<duckdb::Vector>(duckdb::LogicalType::VARCHAR, total));
+        duckdb::VectorOperations::DefaultCast(*data_vector, *batch.cast_vectors.back(), total);
+        data_vector = batch.cast_vectors.back().get();
+    }
+    duckdb::UnifiedVectorFormat data_format;
+    data_vector->ToUnifiedFormat(total, data_format);
+    const auto strings = duckdb::UnifiedVectorFormat::GetData<duckdb::string_t>(data_format);
+
+    batch.columns.resize(first_list->length);
+    for (idx_t column = 0; column < first_list->length; column++) {
+        auto& metadata = batch.columns[column].metadata;
+        const auto descriptor = columns_format.sel->get_index(first_list->offset + column);
+        for (idx_t field = 0; field < fields.size(); field++) {
+            if (field != *data_field) {
+                metadata[duckdb::StructType::GetChildName(columns_vector.GetType(), field)] =
+                        fields[field]->GetValue(descriptor).ToString();
+            }
+        }
+        ValidateAndCleanContextColumn(metadata, CONTEXT_COLUMN_KEYS);
+        batch.columns[column].cells.resize(size);
+        batch.columns[column].valid.resize(size, false);
+    }
+
+    for (idx_t row = 0; row < size; row++) {
+        if (!row_lists[row]) {
+            continue;
+        }
+        for (idx_t column = 0; column < first_list->length; column++) {
+            const auto descriptor = columns_format.sel->get_index(row_lists[row]->offset + column);
+            const auto data_idx = data_format.sel->get_index(descriptor);
+            if (columns_format.validity.RowIsValid(descriptor) && data_format.validity.RowIsValid(data_idx)) {
+                batch.columns[column].cells[row] = strings[data_idx];
+                batch.columns[column].valid[row] = true;
+            }
+        }
+    }
+}
+
+ContextColumnBatch ExtractPromptInputs(duckdb::Vector& struct_vector, const idx_t size, nlohmann::json& prompt_json) {
+    ContextColumnBatch batch;
+    batch.row_count = size;
+    if (size == 0) {
+        return batch;
+    }
+
+    FlattenDictionary(struct_vector, size);
+    duckdb::UnifiedVectorFormat struct_format;
+    struct_vector.ToUnifiedFormat(size, struct_format);
+    auto& entries = duckdb::StructVector::GetEntries(struct_vector);
+
+    for (idx_t j = 0; j < entries.size(); j++) {
+        const auto& key = duckdb::StructType::GetChildName(struct_vector.GetType(), j);
+        auto& child = *entries[j];
+        if (key == "context_columns") {
+            ExtractContextColumns(child, struct_format, size, batch);
+            continue;
+        }
+
+        // Every other key is the same for all rows of a call; the last row's value is kept.
+        const auto value = child.GetValue(struct_format.sel->get_index(size - 1));
+        if (key == "batch_size" || key == "max_batch_size") {
+            if (child.GetType() != duckdb::LogicalType::INTEGER) {
+                throw std::runtime_error("Expected '" + std::string(key) + "' to be an integer.");
+            }
+            const int batch_size = value.GetValue<int>();
+            if (batch_size <= 0) {
+                throw std::runtime_error("'" + std::string(key) + "' must be larger than 0");
             }
+            prompt_json[key] = batch_size;
+        } else if (key == "is_async") {
+            if (child.GetType().id() != duckdb::LogicalTypeId::BOOLEAN) {
+                throw std::runtime_error("Expected 'is_async' to be a boolean.");
+            }
+            prompt_json[key] = value.GetValue<bool>();
+        } else {
+            prompt_json[key] = value.ToString();
         }
     }
+    return batch;
+}
+
+nlohmann::json CastVectorOfStructsToJson(duckdb::Vector& struct_vector, const int size) {
+    nlohmann::json struct_json;
+    const auto batch = ExtractPromptInputs(struct_vector, static_cast<idx_t>(size), struct_json);
+    if (!batch.columns.empty()) {
+        struct_json["context_columns"] = batch.ToJson();
+    }
     return struct_json;
 }
 
@@ -137,4 +260,23 @@ nlohmann::json CastValueToJson(const duckdb::Value& value) {
     return result;
 }
 
+std::optional<double> ParseJsonNumber(const nlohmann::json& value) {
+    if (value.is_number()) {
+        return value.get<double>();
+    }
+    if (!value.is_string()) {
+        return std::nullopt;
+    }
+    const auto& text = value.get_ref<const std::string&>();
+    try {
+        size_t parsed = 0;
+        const auto number = std::stod(text, &parsed);
+        if (parsed == text.size()) {
+            return number;
+        }
+    } catch (const std::exception&) {
+    }
+    return std::nullopt;
+}
+
 }// namespace flock
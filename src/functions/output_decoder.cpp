@@ -0,0 +1,92 @@
+#include "flock/functions/output_decoder.hpp"
+
+#include <cctype>
+
+namespace flock {
+
+namespace {
+
+const std::string* SingleStringItem(const nlohmann::json& items) {
+    if (!items.is_array() || items.size() != 1 || !items[0].is_string()) {
+        return nullptr;
+    }
+    return &items[0].get_ref<const std::string&>();
+}
+
+bool IsSpace(const char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+
+}// namespace
+
+std::optional<nlohmann::json> DecodeCompactBoolItems(const nlohmann::json& items, const size_t expected_count) {
+    const auto* encoded = SingleStringItem(items);
+    if (encoded == nullptr) {
+        return std::nullopt;
+    }
+
+    auto decoded = nlohmann::json::array();
+    for (const auto c: *encoded) {
+        if (IsSpace(c)) {
+            continue;
+        }
+        if (c == 'T' || c == 't') {
+            decoded.push_back(true);
+        } else if (c == 'F' || c == 'f') {
+            decoded.push_back(false);
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    if (decoded.size() != expected_count) {
+        return std::nullopt;
+    }
+    return decoded;
+}
+
+std::optional<nlohmann::json> DecodeCompactIndexList(const nlohmann::json& items,
+                                                     const std::set<std::string>& valid_ids) {
+    const auto* encoded = SingleStringItem(items);
+    if (encoded == nullptr) {
+        return std::nullopt;
+    }
+
+    auto decoded = nlohmann::json::array();
+    std::set<std::string> seen_ids;
+    size_t start = 0;
+    while (start <= encoded->size()) {
+        auto end = encoded->find(',', start);
+        if (end == std::string::npos) {
+            end = encoded->size();
+        }
+
+        auto first = start;
+        auto last = end;
+        while (first < last && IsSpace((*encoded)[first])) {
+            first++;
+        }
+        while (last > first && IsSpace((*encoded)[last - 1])) {
+            last--;
+        }
+        const auto id = encoded->substr(first, last - first);
+        if (id.empty()) {
+            return std::nullopt;
+        }
+        for (const auto c: id) {
+            if (!std::isdigit(static_cast<unsigned char>(c))) {
+                return std::nullopt;
+            }
+        }
+        if (valid_ids.find(id) == valid_ids.end() || !seen_ids.insert(id).second) {
+            return std::nullopt;
+        }
+        decoded.push_back(std::stoi(id));
+        start = end + 1;
+    }
+
+    if (seen_ids.size() != valid_ids.size()) {
+        return std::nullopt;
+    }
+    return decoded;
+}
+
+}// namespace flock
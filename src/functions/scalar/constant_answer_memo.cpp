@@ -0,0 +1,49 @@
+#include "flock/functions/scalar/constant_answer_memo.hpp"
+
+namespace flock {
+
+ConstantAnswerMemo& ConstantAnswerMemo::Get(duckdb::ClientContext& context) {
+    return *context.registered_state->GetOrCreate<ConstantAnswerMemo>(STATE_NAME);
+}
+
+std::string ConstantAnswerMemo::Key(const nlohmann::json& model_json, const std::string& prompt,
+                                    const OutputType output_type) {
+    return std::to_string(static_cast<int>(output_type)) + '\x1f' + model_json.dump() + '\x1f' + prompt;
+}
+
+nlohmann::json ConstantAnswerMemo::GetOrCompute(const std::string& key,
+                                                const std::function<nlohmann::json()>& compute) {
+    std::promise<nlohmann::json> promise;
+    std::shared_future<nlohmann::json> answer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto [it, inserted] = answers_.emplace(key, promise.get_future().share());
+        if (!inserted) {
+            answer = it->second;
+        }
+    }
+    if (answer.valid()) {
+        return answer.get();
+    }
+
+    try {
+        auto result = compute();
+        promise.set_value(result);
+        return result;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+size_t ConstantAnswerMemo::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return answers_.size();
+}
+
+void ConstantAnswerMemo::QueryEnd() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    answers_.clear();
+}
+
+}// namespace flock
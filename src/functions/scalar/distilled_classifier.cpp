@@ -0,0 +1,347 @@
+#include "flock/functions/scalar/distilled_classifier.hpp"
+#include "flock/core/vector_math.hpp"
+#include "flock/functions/input_parser.hpp"
+#include "flock/functions/scalar/scalar.hpp"
+#include "flock/metrics/manager.hpp"
+#include "flock/model_manager/model.hpp"
+#include "flock/model_manager/semantic_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+namespace flock {
+
+namespace {
+
+void Softmax(std::vector<float>& values) {
+    const auto max_value = *std::max_element(values.begin(), values.end());
+    float sum = 0.0f;
+    for (auto& value: values) {
+        value = std::exp(value - max_value);
+        sum += value;
+    }
+    for (auto& value: values) {
+        value /= sum;
+    }
+}
+
+size_t ArgMax(const std::vector<float>& values) {
+    return static_cast<size_t>(std::max_element(values.begin(), values.end()) - values.begin());
+}
+
+}// namespace
+
+void SoftmaxClassifier::Logits(const float* embedding, float* logits) const {
+    for (size_t c = 0; c < class_count_; c++) {
+        logits[c] = biases_[c] + VectorMath::Dot(weights_.data() + c * dims_, embedding, dims_);
+    }
+}
+
+void SoftmaxClassifier::Train(const std::vector<std::vector<float>>& embeddings, const std::vector<size_t>& labels,
+                              const size_t class_count) {
+    class_count_ = class_count;
+    dims_ = embeddings.empty() ? 0 : embeddings[0].size();
+    weights_.assign(class_count_ * dims_, 0.0f);
+    biases_.assign(class_count_, 0.0f);
+    if (embeddings.empty()) {
+        return;
+    }
+
+    std::vector<size_t> counts(class_count_, 0);
+    for (size_t i = 0; i < embeddings.size(); i++) {
+        if (embeddings[i].size() != dims_) {
+            throw std::runtime_error("Classifier embeddings must all have the same number of dimensions.");
+        }
+        counts[labels[i]]++;
+    }
+    const auto row_count = static_cast<float>(embeddings.size());
+    std::vector<float> class_weights(class_count_, 0.0f);
+    for (size_t c = 0; c < class_count_; c++) {
+        if (counts[c] != 0) {
+            class_weights[c] = row_count / static_cast<float>(class_count_ * counts[c]);
+        }
+    }
+
+    std::vector<float> weight_gradients(weights_.size());
+    std::vector<float> bias_gradients(class_count_);
+    std::vector<float> probabilities(class_count_);
+    for (size_t epoch = 0; epoch < EPOCHS; epoch++) {
+        std::fill(weight_gradients.begin(), weight_gradients.end(), 0.0f);
+        std::fill(bias_gradients.begin(), bias_gradients.end(), 0.0f);
+        for (size_t i = 0; i < embeddings.size(); i++) {
+            const auto* embedding = embeddings[i].data();
+            Logits(embedding, probabilities.data());
+            Softmax(probabilities);
+            for (size_t c = 0; c < class_count_; c++) {
+                const auto error =
+                        (probabilities[c] - (c == labels[i] ? 1.0f : 0.0f)) * class_weights[labels[i]];
+                bias_gradients[c] += error;
+                auto* gradient = weight_gradients.data() + c * dims_;
+                for (size_t d = 0; d < dims_; d++) {
+                    gradient[d] += error * embedding[d];
+                }
+            }
+        }
+        for (size_t c = 0; c < class_count_; c++) {
+            biases_[c] -= LEARNING_RATE * bias_gradients[c] / row_count;
+        }
+        for (size_t w = 0; w < weights_.size(); w++) {
+            weights_[w] -= LEARNING_RATE * (weight_gradients[w] / row_count + L2_PENALTY * weights_[w]);
+        }
+    }
+}
+
+std::vector<float> SoftmaxClassifier::Predict(const std::vector<float>& embedding) const {
+    if (embedding.size() != dims_) {
+        throw std::runtime_error(duckdb_fmt::format("Classifier expected an embedding of {} dimensions, got {}.",
+                                                    dims_, embedding.size()));
+    }
+    std::vector<float> probabilities(class_count_);
+    Logits(embedding.data(), probabilities.data());
+    Softmax(probabilities);
+    return probabilities;
+}
+
+DistilledClassifier::Options DistilledClassifier::ParseOptions(const nlohmann::json& value,
+                                                              const std::string& function_name) {
+    if (!value.is_object() || !value.contains("embedding_model") || !value["embedding_model"].is_string()) {
+        throw duckdb::BinderException(function_name + ": 'classifier' must be a struct with an 'embedding_model'.");
+    }
+    Options options;
+    options.embedding_model = value["embedding_model"].get<std::string>();
+    // Reports unknown embedding models before any row is labelled.
+    Model::ResolveModelDetailsToJson(nlohmann::json{{"model_name", options.embedding_model}});
+
+    const auto get_number = [&value, &function_name](const char* key) {
+        const auto number = ParseJsonNumber(value.at(key));
+        if (!number.has_value()) {
+            throw duckdb::BinderException(
+                    duckdb_fmt::format("{}: the classifier '{}' must be a number.", function_name, key));
+        }
+        return *number;
+    };
+    if (value.contains("sample_size")) {
+        const auto sample_size = get_number("sample_size");
+        if (sample_size < 2) {
+            throw duckdb::BinderException(function_name + ": the classifier 'sample_size' must be at least 2.");
+        }
+        // The sample is drawn from one chunk that has more rows than it.
+        if (sample_size >= STANDARD_VECTOR_SIZE) {
+            throw duckdb::BinderException(duckdb_fmt::format(
+                    "{}: the classifier 'sample_size' must be smaller than {}, the rows of one chunk.", function_name,
+                    STANDARD_VECTOR_SIZE));
+        }
+        options.sample_size = static_cast<size_t>(sample_size);
+    }
+    if (value.contains("holdout")) {
+        options.holdout = get_number("holdout");
+        if (options.holdout <= 0.0 || options.holdout >= 1.0) {
+            throw duckdb::BinderException(function_name + ": the classifier 'holdout' must be in (0, 1).");
+        }
+    }
+    if (value.contains("target_accuracy")) {
+        options.target_accuracy = get_number("target_accuracy");
+        if (options.target_accuracy <= 0.0 || options.target_accuracy > 1.0) {
+            throw duckdb::BinderException(function_name + ": the classifier 'target_accuracy' must be in (0, 1].");
+        }
+    }
+    return options;
+}
+
+DistilledClassifier::DistilledClassifier(Options options) : options_(std::move(options)) {}
+
+DistilledClassifier::State DistilledClassifier::GetState() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+double DistilledClassifier::GetThreshold() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return threshold_;
+}
+
+DistilledClassifier::Training DistilledClassifier::Train(const ContextColumnBatch& batch,
+                                                        const std::vector<size_t>& rows,
+                                                        const ModelAnswers& model_answers,
+                                                        nlohmann::json& answers) const {
+    Training training;
+
+    // A random sample of `rows`, in row order.
+    std::vector<size_t> sample_rows = rows;
+    std::mt19937 generator(static_cast<uint32_t>(rows.size()));
+    std::shuffle(sample_rows.begin(), sample_rows.end(), generator);
+    sample_rows.resize(std::min(sample_rows.size(), options_.sample_size));
+    std::sort(sample_rows.begin(), sample_rows.end());
+    const auto labels = model_answers(batch.Select(sample_rows));
+
+    // Positions in `sample_rows` of each answer's rows.
+    std::unordered_map<std::string, size_t> class_indexes;
+    std::vector<std::vector<size_t>> class_members;
+    for (size_t i = 0; i < sample_rows.size() && i < labels.size(); i++) {
+        answers[sample_rows[i]] = labels[i];
+        if (labels[i].is_null()) {
+            continue;
+        }
+        const auto [entry, inserted] = class_indexes.emplace(labels[i].dump(), training.classes.size());
+        if (inserted) {
+            training.classes.push_back(labels[i]);
+            class_members.emplace_back();
+        }
+        class_members[entry->second].push_back(i);
+    }
+    if (training.classes.size() < 2 || training.classes.size() > MAX_CLASSES) {
+        return training;
+    }
+    // Only the labelled sample is embedded here; rows left to score are embedded once accepted.
+    const auto embeddings =
+            SemanticCache::Embed(options_.embedding_model, SemanticCache::RowTexts(batch, sample_rows));
+
+    // Every answer with more than one labelled row is represented on both sides of the split.
+    std::vector<std::vector<float>> training_embeddings;
+    std::vector<size_t> training_labels;
+    std::vector<std::pair<size_t, size_t>> holdout;
+    for (size_t c = 0; c < class_members.size(); c++) {
+        auto& members = class_members[c];
+        std::shuffle(members.begin(), members.end(), generator);
+        auto holdout_count = static_cast<size_t>(std::round(static_cast<double>(members.size()) * options_.holdout));
+        holdout_count = members.size() < 2 ? 0 : std::clamp<size_t>(holdout_count, 1, members.size() - 1);
+        for (size_t i = 0; i < members.size(); i++) {
+            if (i < holdout_count) {
+                holdout.emplace_back(members[i], c);
+            } else {
+                training_embeddings.push_back(embeddings[members[i]]);
+                training_labels.push_back(c);
+            }
+        }
+    }
+    if (holdout.empty()) {
+        return training;
+    }
+    training.classifier.Train(training_embeddings, training_labels, training.classes.size());
+
+    // The lowest confidence at which the held-out rows scored at or above it reach the target.
+    std::vector<std::pair<float, bool>> scored;
+    scored.reserve(holdout.size());
+    size_t correct = 0;
+    for (const auto& [position, label]: holdout) {
+        const auto probabilities = training.classifier.Predict(embeddings[position]);
+        const auto predicted = ArgMax(probabilities);
+        scored.emplace_back(probabilities[predicted], predicted == label);
+        correct += predicted == label;
+    }
+    std::sort(scored.begin(), scored.end(), [](const auto& left, const auto& right) { return left.first > right.first; });
+    size_t correct_above = 0;
+    bool calibrated = false;
+    for (size_t i = 0; i < scored.size(); i++) {
+        correct_above += scored[i].second;
+        if (static_cast<double>(correct_above) >= options_.target_accuracy * static_cast<double>(i + 1)) {
+            training.threshold = scored[i].first;
+            calibrated = true;
+        }
+    }
+
+    MetricsManager::SetClassifierTraining(static_cast<int64_t>(training_labels.size()),
+                                          static_cast<int64_t>(holdout.size()),
+                                          static_cast<double>(correct) / static_cast<double>(holdout.size()),
+                                          calibrated ? training.threshold : 0.0);
+    if (calibrated) {
+        training.state = State::ACCEPTED;
+    }
+    return training;
+}
+
+nlohmann::json DistilledClassifier::Answer(const ContextColumnBatch& batch, const ModelAnswers& model_answers) {
+    const auto row_count = batch.empty() ? 0 : batch.row_count;
+    auto answers = nlohmann::json::array();
+    // Empty rows are left to the model, which answers them with `empty_input_default` for free.
+    std::vector<size_t> rows;
+    std::vector<size_t> model_rows;
+    for (size_t row = 0; row < row_count; row++) {
+        answers.push_back(nullptr);
+        (batch.IsEmptyRow(row) ? model_rows : rows).push_back(row);
+    }
+
+    State state;
+    bool train;
+    {
+        // Concurrent chunks wait for the one that trains instead of paying for their own requests.
+        std::unique_lock<std::mutex> lock(mutex_);
+        trained_.wait(lock, [this] { return !training_; });
+        train = state_ == State::PENDING && rows.size() > options_.sample_size;
+        training_ = train;
+        state = state_;
+    }
+    if (train) {
+        // Labelling, embedding and fitting run without the lock; the result is published at once.
+        Training training;
+        try {
+            training = Train(batch, rows, model_answers, answers);
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                state_ = State::REJECTED;
+                training_ = false;
+            }
+            trained_.notify_all();
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = training.state;
+            classifier_ = std::move(training.classifier);
+            classes_ = std::move(training.classes);
+            threshold_ = training.threshold;
+            training_ = false;
+            state = state_;
+        }
+        trained_.notify_all();
+    }
+
+    // The classifier is not modified once accepted.
+    if (state == State::ACCEPTED) {
+        std::vector<size_t> unanswered_rows;
+        for (const auto row: rows) {
+            if (answers[row].is_null()) {
+                unanswered_rows.push_back(row);
+            }
+        }
+        std::vector<std::vector<float>> embeddings;
+        if (!unanswered_rows.empty()) {
+            embeddings =
+                    SemanticCache::Embed(options_.embedding_model, SemanticCache::RowTexts(batch, unanswered_rows));
+        }
+        int64_t local_rows = 0;
+        for (size_t i = 0; i < unanswered_rows.size(); i++) {
+            const auto probabilities = classifier_.Predict(embeddings[i]);
+            const auto predicted = ArgMax(probabilities);
+            if (probabilities[predicted] >= threshold_) {
+                answers[unanswered_rows[i]] = classes_[predicted];
+                local_rows++;
+            } else {
+                model_rows.push_back(unanswered_rows[i]);
+            }
+        }
+        MetricsManager::AddClassifierRows(local_rows, static_cast<int64_t>(model_rows.size()));
+    } else {
+        for (const auto row: rows) {
+            if (answers[row].is_null()) {
+                model_rows.push_back(row);
+            }
+        }
+    }
+
+    if (model_rows.empty()) {
+        return answers;
+    }
+    std::sort(model_rows.begin(), model_rows.end());
+    const auto model_rows_answers = model_answers(batch.Select(model_rows));
+    for (size_t i = 0; i < model_rows.size() && i < model_rows_answers.size(); i++) {
+        answers[model_rows[i]] = model_rows_answers[i];
+    }
+    return answers;
+}
+
+}// namespace flock
@@ -0,0 +1,124 @@
+#include "flock/functions/scalar/flock_quantize_embedding.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace flock {
+
+EmbeddingEncoding FlockQuantizeEmbedding::ParseEncoding(const std::string& encoding) {
+    if (encoding == "int8") {
+        return EmbeddingEncoding::INT8;
+    }
+    if (encoding == "binary") {
+        return EmbeddingEncoding::BINARY;
+    }
+    throw std::runtime_error("flock_quantize_embedding: encoding must be 'int8' or 'binary', got '" + encoding + "'.");
+}
+
+std::string FlockQuantizeEmbedding::Quantize(const float* values, const idx_t dims, const EmbeddingEncoding encoding) {
+    std::string blob(HEADER_SIZE, '\0');
+    blob[0] = static_cast<char>(encoding);
+
+    if (encoding == EmbeddingEncoding::INT8) {
+        // Symmetric scaling keeps zero exact and lets int8 dot products be rescaled with one multiply.
+        float max_abs = 0.0f;
+        for (idx_t i = 0; i < dims; i++) {
+            max_abs = std::max(max_abs, std::abs(values[i]));
+        }
+        const float scale = max_abs / 127.0f;
+        std::memcpy(&blob[1], &scale, sizeof(scale));
+        blob.resize(HEADER_SIZE + dims);
+        for (idx_t i = 0; i < dims; i++) {
+            const auto code = scale == 0.0f ? 0L : std::lround(values[i] / scale);
+            blob[HEADER_SIZE + i] = static_cast<char>(static_cast<int8_t>(std::clamp(code, -127L, 127L)));
+        }
+        return blob;
+    }
+
+    const auto stored_dims = static_cast<uint32_t>(dims);
+    std::memcpy(&blob[1], &stored_dims, sizeof(stored_dims));
+    blob.resize(HEADER_SIZE + (dims + 7) / 8);
+    for (idx_t i = 0; i < dims; i++) {
+        if (values[i] > 0.0f) {
+            blob[HEADER_SIZE + i / 8] = static_cast<char>(static_cast<uint8_t>(blob[HEADER_SIZE + i / 8]) | (0x80u >> (i % 8)));
+        }
+    }
+    return blob;
+}
+
+QuantizedEmbedding FlockQuantizeEmbedding::Parse(const char* blob, const idx_t size) {
+    if (size < HEADER_SIZE) {
+        throw std::runtime_error("flock_topk_similar: BLOB embeddings must come from flock_quantize_embedding.");
+    }
+    QuantizedEmbedding embedding{};
+    embedding.data = reinterpret_cast<const uint8_t*>(blob + HEADER_SIZE);
+    switch (static_cast<EmbeddingEncoding>(blob[0])) {
+        case EmbeddingEncoding::INT8:
+            embedding.encoding = EmbeddingEncoding::INT8;
+            std::memcpy(&embedding.scale, blob + 1, sizeof(embedding.scale));
+            embedding.dims = static_cast<uint32_t>(size - HEADER_SIZE);
+            return embedding;
+        case EmbeddingEncoding::BINARY:
+            embedding.encoding = EmbeddingEncoding::BINARY;
+            embedding.scale = 1.0f;
+            std::memcpy(&embedding.dims, blob + 1, sizeof(embedding.dims));
+            if (size != HEADER_SIZE + (embedding.dims + 7) / 8) {
+                break;
+            }
+            return embedding;
+    }
+    throw std::runtime_error("flock_topk_similar: BLOB embeddings must come from flock_quantize_embedding.");
+}
+
+void FlockQuantizeEmbedding::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
+    const auto count = args.size();
+    auto& embeddings = args.data[0];
+
+    duckdb::UnifiedVectorFormat list_format;
+    embeddings.ToUnifiedFormat(count, list_format);
+    const auto lists = duckdb::UnifiedVectorFormat::GetData<duckdb::list_entry_t>(list_format);
+
+    duckdb::UnifiedVectorFormat child_format;
+    duckdb::ListVector::GetEntry(embeddings).ToUnifiedFormat(duckdb::ListVector::GetListSize(embeddings), child_format);
+    const auto values = duckdb::UnifiedVectorFormat::GetData<float>(child_format);
+
+    duckdb::UnifiedVectorFormat encoding_format;
+    if (args.ColumnCount() > 1) {
+        args.data[1].ToUnifiedFormat(count, encoding_format);
+    }
+
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto blobs = duckdb::FlatVector::GetData<duckdb::string_t>(result);
+    std::vector<float> buffer;
+    for (idx_t row = 0; row < count; row++) {
+        const auto list_index = list_format.sel->get_index(row);
+        if (!list_format.validity.RowIsValid(list_index)) {
+            duckdb::FlatVector::SetNull(result, row, true);
+            continue;
+        }
+
+        auto encoding = EmbeddingEncoding::INT8;
+        if (args.ColumnCount() > 1) {
+            const auto encoding_index = encoding_format.sel->get_index(row);
+            if (encoding_format.validity.RowIsValid(encoding_index)) {
+                encoding = ParseEncoding(
+                        duckdb::UnifiedVectorFormat::GetData<duckdb::string_t>(encoding_format)[encoding_index].GetString());
+            }
+        }
+
+        const auto& entry = lists[list_index];
+        buffer.resize(entry.length);
+        for (idx_t i = 0; i < entry.length; i++) {
+            const auto child_index = child_format.sel->get_index(entry.offset + i);
+            if (!child_format.validity.RowIsValid(child_index)) {
+                throw std::runtime_error("flock_quantize_embedding: embeddings must not contain NULL values.");
+            }
+            buffer[i] = values[child_index];
+        }
+        blobs[row] = duckdb::StringVector::AddStringOrBlob(result, Quantize(buffer.data(), entry.length, encoding));
+    }
+}
+
+}// namespace flock
@@ -0,0 +1,16 @@
+#include "flock/functions/scalar/flock_quantize_embedding.hpp"
+#include "flock/registry/registry.hpp"
+
+namespace flock {
+
+void ScalarRegistry::RegisterFlockQuantizeEmbedding(duckdb::ExtensionLoader& loader) {
+    const auto embedding_type = duckdb::LogicalType::LIST(duckdb::LogicalType::FLOAT);
+    duckdb::ScalarFunctionSet functions(FlockQuantizeEmbedding::FUNCTION_NAME);
+    functions.AddFunction(duckdb::ScalarFunction({embedding_type}, duckdb::LogicalType::BLOB,
+                                                 FlockQuantizeEmbedding::Execute));
+    functions.AddFunction(duckdb::ScalarFunction({embedding_type, duckdb::LogicalType::VARCHAR},
+                                                 duckdb::LogicalType::BLOB, FlockQuantizeEmbedding::Execute));
+    loader.RegisterFunction(functions);
+}
+
+}// namespace flock
@@ -1,6 +1,8 @@
 #include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "flock/functions/scalar/distilled_classifier.hpp"
 #include "flock/functions/scalar/llm_complete.hpp"
 #include "flock/functions/scalar/scalar.hpp"
+#include "flock/functions/typed_output.hpp"
 #include "flock/metrics/manager.hpp"
 #include "flock/model_manager/model.hpp"
 
@@ -11,7 +13,14 @@ duckdb::unique_ptr<duckdb::FunctionData> LlmComplete::Bind(
         duckdb::ClientContext& context,
         duckdb::ScalarFunction& bound_function,
         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
-    return ScalarFunctionBase::ValidateAndInitializeBindData(context, arguments, "llm_complete", false);
+    auto bind_data = ScalarFunctionBase::ValidateAndInitializeBindData(context, arguments, "llm_complete", false);
+    if (!bind_data->returns.empty()) {
+        if (const auto return_type = TypedOutput::ResolveReturnType(bind_data->returns, bind_data->model_json,
+                                                                     ScalarFunctionType::COMPLETE)) {
+            bound_function.return_type = *return_type;
+        }
+    }
+    return bind_data;
 }
 
 
@@ -34,44 +43,41 @@ void LlmComplete::ValidateArguments(duckdb::DataChunk& args) {
     }
 }
 
-std::vector<std::string> LlmComplete::Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data) {
+std::vector<nlohmann::json> LlmComplete::Answer(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data) {
     Model model = bind_data->CreateModel();
 
-    auto model_details = model.GetModelDetails();
+    const auto& model_details = model.GetModelDetails();
     MetricsManager::SetModelInfo(model_details.model_name, model_details.provider_name);
 
-    auto prompt_context_json = CastVectorOfStructsToJson(args.data[1], args.size());
-    auto context_columns = nlohmann::json::array();
-    if (prompt_context_json.contains("context_columns")) {
-        context_columns = prompt_context_json["context_columns"];
-    }
+    nlohmann::json prompt_json;
+    const auto batch = ExtractPromptInputs(args.data[1], args.size(), prompt_json);
 
     auto prompt = bind_data->prompt;
 
-    std::vector<std::string> results;
-    if (context_columns.empty()) {
-        auto template_str = prompt;
-        model.AddCompletionRequest(template_str, 1, OutputType::STRING);
-        auto response = model.CollectCompletions()[0]["items"][0];
-        if (response.is_string()) {
-            results.push_back(response.get<std::string>());
-        } else {
-            results.push_back(response.dump());
-        }
-    } else {
-        if (context_columns.empty()) {
-            return results;
-        }
+    if (batch.empty()) {
+        return {CompleteConstant(context, *bind_data, OutputType::STRING, model)};
+    }
+
+    const auto answer_rows = [&](const ContextColumnBatch& rows) {
+        return BatchAndComplete(rows, prompt, ScalarFunctionType::COMPLETE, model);
+    };
+    auto responses = bind_data->distilled_classifier ? bind_data->distilled_classifier->Answer(batch, answer_rows)
+                                                     : answer_rows(batch);
+    return std::move(responses.get_ref<nlohmann::json::array_t&>());
+}
 
-        auto responses = BatchAndComplete(context_columns, prompt, ScalarFunctionType::COMPLETE, model);
+std::vector<std::string> LlmComplete::Operation(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data) {
+    const auto answers = Answer(context, args, bind_data);
 
-        results.reserve(responses.size());
-        for (const auto& response: responses) {
-            if (response.is_string()) {
-                results.push_back(response.get<std::string>());
-            } else {
-                results.push_back(response.dump());
-            }
+    std::vector<std::string> results;
+    results.reserve(answers.size());
+    for (const auto& answer: answers) {
+        if (answer.is_string()) {
+            results.push_back(answer.get<std::string>());
+        } else {
+            results.push_back(answer.dump());
         }
     }
     return results;
@@ -89,16 +95,10 @@ void LlmComplete::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& stat
     auto& func_expr = state.expr.Cast<duckdb::BoundFunctionExpression>();
     auto* bind_data = &func_expr.bind_info->Cast<LlmFunctionBindData>();
 
-    if (const auto results = LlmComplete::Operation(args, bind_data); static_cast<int>(results.size()) == 1) {
-        auto empty_vec = duckdb::Vector(std::string());
-        duckdb::UnaryExecutor::Execute<duckdb::string_t, duckdb::string_t>(
-                empty_vec, result, args.size(),
-                [&](duckdb::string_t name) { return duckdb::StringVector::AddString(result, results[0]); });
+    if (result.GetType().id() == duckdb::LogicalTypeId::VARCHAR) {
+        TypedOutput::WriteStrings(LlmComplete::Operation(context, args, bind_data), result, args.size());
     } else {
-        auto index = 0;
-        for (const auto& res: results) {
-            result.SetValue(index++, duckdb::Value(res));
-        }
+        TypedOutput::WriteAnswers(LlmComplete::Answer(context, args, bind_data), result, args.size());
     }
 
     auto exec_end = std::chrono::high_resolution_clock::now();
@@ -4,10 +4,12 @@
 namespace flock {
 
 void ScalarRegistry::RegisterLlmComplete(duckdb::ExtensionLoader& loader) {
-    loader.RegisterFunction(duckdb::ScalarFunction("llm_complete",
-                                                   {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
-                                                   duckdb::LogicalType::JSON(), LlmComplete::Execute,
-                                                   LlmComplete::Bind));
+    auto function = duckdb::ScalarFunction("llm_complete", {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
+                                           duckdb::LogicalType::JSON(), LlmComplete::Execute, LlmComplete::Bind);
+    // Answers are not reproducible across queries, but within one query identical calls may be
+    // deduplicated: constant prompts are memoized per query (see ConstantAnswerMemo).
+    function.stability = duckdb::FunctionStability::CONSISTENT_WITHIN_QUERY;
+    loader.RegisterFunction(function);
 }
 
 }// namespace flock
@@ -1,8 +1,10 @@
 #include "duckdb/planner/expression/bound_function_expression.hpp"
 #include "flock/core/config.hpp"
 #include "flock/functions/scalar/llm_embedding.hpp"
+#include "flock/functions/typed_output.hpp"
 #include "flock/metrics/manager.hpp"
 #include "flock/model_manager/model.hpp"
+#include "flock/model_manager/result_cache.hpp"
 
 namespace flock {
 
@@ -10,7 +12,19 @@ duckdb::unique_ptr<duckdb::FunctionData> LlmEmbedding::Bind(
         duckdb::ClientContext& context,
         duckdb::ScalarFunction& bound_function,
         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
-    return ScalarFunctionBase::ValidateAndInitializeBindData(context, arguments, "llm_embedding", true, false);
+    auto bind_data = ScalarFunctionBase::ValidateAndInitializeBindData(context, arguments, "llm_embedding", true, false);
+    if (!bind_data->returns.empty()) {
+        if (const auto return_type = TypedOutput::ResolveEmbeddingType(bind_data->returns, bind_data->model_json)) {
+            bound_function.return_type = *return_type;
+            // OpenAI then answers with float32 buffers that are decoded straight into the result
+            // instead of one JSON number per element.
+            if (bind_data->model_json["provider"] == OPENAI &&
+                !bind_data->model_json["model_parameters"].contains("encoding_format")) {
+                bind_data->model_json["model_parameters"]["encoding_format"] = "base64";
+            }
+        }
+    }
+    return bind_data;
 }
 
 
@@ -26,60 +40,104 @@ void LlmEmbedding::ValidateArguments(duckdb::DataChunk& args) {
     }
 }
 
-std::vector<duckdb::vector<duckdb::Value>> LlmEmbedding::Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data) {
-    auto inputs = CastVectorOfStructsToJson(args.data[1], args.size());
-    for (const auto& item: inputs.items()) {
-        if (item.key() != "context_columns") {
-            throw std::runtime_error(duckdb_fmt::format("Unexpected key in inputs: {}", item.key()));
-        }
+std::vector<nlohmann::json> LlmEmbedding::Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data) {
+    nlohmann::json prompt_json;
+    const auto batch = ExtractPromptInputs(args.data[1], args.size(), prompt_json);
+    for (const auto& item: prompt_json.items()) {
+        throw std::runtime_error(duckdb_fmt::format("Unexpected key in inputs: {}", item.key()));
     }
-    for (const auto& context_column: inputs["context_columns"]) {
-        if (context_column.contains("type") && context_column["type"].get<std::string>() == "image") {
+    for (const auto& column: batch.columns) {
+        if (column.metadata.contains("type") && column.metadata["type"].get<std::string>() == "image") {
             throw std::runtime_error("Image embedding is not supported yet. Please use text data for embedding.");
         }
     }
 
     Model model = bind_data->CreateModel();
 
-    auto model_details = model.GetModelDetails();
+    const auto& model_details = model.GetModelDetails();
     MetricsManager::SetModelInfo(model_details.model_name, model_details.provider_name);
 
     std::vector<std::string> prepared_inputs;
-    auto num_rows = inputs["context_columns"][0]["data"].size();
+    const auto num_rows = batch.empty() ? 0 : batch.row_count;
+    prepared_inputs.reserve(num_rows);
     for (size_t row_idx = 0; row_idx < num_rows; row_idx++) {
         std::string concat_input;
-        for (auto& context_column: inputs["context_columns"]) {
-            concat_input += context_column["data"][row_idx].get<std::string>() + " ";
+        for (size_t column = 0; column < batch.columns.size(); column++) {
+            const auto& metadata = batch.columns[column].metadata;
+            auto text = batch.GetCell(column, row_idx);
+            if (metadata.contains("max_tokens")) {
+                const auto strategy = metadata.contains("truncate")
+                                              ? stringToTruncationStrategy(metadata["truncate"].get<std::string>())
+                                              : TruncationStrategy::HEAD;
+                text = TokenCounter::Truncate(text, metadata["max_tokens"].get<size_t>(), strategy);
+            }
+            concat_input += text + " ";
         }
-        prepared_inputs.push_back(concat_input);
+        prepared_inputs.push_back(std::move(concat_input));
     }
 
-    auto batch_size = model.GetModelDetails().max_batch_size;
-
-    if (batch_size > static_cast<int>(prepared_inputs.size())) {
-        batch_size = static_cast<int>(prepared_inputs.size());
+    // Rows with a cached embedding are not sent to the provider.
+    std::vector<nlohmann::json> embeddings(prepared_inputs.size());
+    std::vector<std::string> cache_keys;
+    std::vector<size_t> miss_rows;
+    if (model_details.cache != CacheMode::OFF) {
+        cache_keys = ResultCache::EmbeddingKeys(model_details, prepared_inputs);
+        const auto cached = ResultCache::Lookup(cache_keys);
+        for (size_t row_idx = 0; row_idx < cached.size(); row_idx++) {
+            if (cached[row_idx].has_value()) {
+                embeddings[row_idx] = *cached[row_idx];
+            } else {
+                miss_rows.push_back(row_idx);
+            }
+        }
+    } else {
+        for (size_t row_idx = 0; row_idx < prepared_inputs.size(); row_idx++) {
+            miss_rows.push_back(row_idx);
+        }
     }
 
-    for (size_t i = 0; i < prepared_inputs.size(); i += batch_size) {
-        std::vector<std::string> batch_inputs;
-        for (size_t j = i; j < i + batch_size && j < prepared_inputs.size(); j++) {
-            batch_inputs.push_back(prepared_inputs[j]);
+    if (!miss_rows.empty()) {
+        auto batch_size = model_details.max_batch_size;
+
+        if (batch_size > miss_rows.size()) {
+            batch_size = miss_rows.size();
         }
-        model.AddEmbeddingRequest(batch_inputs);
-    }
 
-    std::vector<duckdb::vector<duckdb::Value>> results;
-    auto all_embeddings = model.CollectEmbeddings();
-    for (size_t index = 0; index < all_embeddings.size(); index++) {
-        for (auto& embedding: all_embeddings[index]) {
-            duckdb::vector<duckdb::Value> formatted_embedding;
-            for (auto& value: embedding) {
-                formatted_embedding.push_back(duckdb::Value(static_cast<double>(value)));
+        for (size_t i = 0; i < miss_rows.size(); i += batch_size) {
+            std::vector<std::string> batch_inputs;
+            for (size_t j = i; j < i + batch_size && j < miss_rows.size(); j++) {
+                batch_inputs.push_back(prepared_inputs[miss_rows[j]]);
             }
-            results.push_back(formatted_embedding);
+            model.AddEmbeddingRequest(batch_inputs);
+        }
+
+        // Every response holds the embeddings of its request's inputs, in input order.
+        size_t miss_index = 0;
+        auto all_embeddings = model.CollectEmbeddings();
+        for (size_t index = 0; index < all_embeddings.size(); index++) {
+            for (auto& embedding: all_embeddings[index]) {
+                if (miss_index < miss_rows.size()) {
+                    embeddings[miss_rows[miss_index++]] = embedding;
+                }
+            }
+        }
+        if (miss_index != miss_rows.size()) {
+            throw std::runtime_error(duckdb_fmt::format(
+                    "llm_embedding: the provider returned {} embeddings for {} inputs.", miss_index, miss_rows.size()));
+        }
+
+        if (model_details.cache == CacheMode::READWRITE) {
+            std::vector<std::pair<std::string, nlohmann::json>> new_entries;
+            for (const auto row_idx: miss_rows) {
+                if (!embeddings[row_idx].is_null()) {
+                    new_entries.emplace_back(cache_keys[row_idx], embeddings[row_idx]);
+                }
+            }
+            ResultCache::Store(new_entries);
         }
     }
-    return results;
+
+    return embeddings;
 }
 
 void LlmEmbedding::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
@@ -94,12 +152,8 @@ void LlmEmbedding::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& sta
     auto& func_expr = state.expr.Cast<duckdb::BoundFunctionExpression>();
     auto* bind_data = &func_expr.bind_info->Cast<LlmFunctionBindData>();
 
-    auto results = LlmEmbedding::Operation(args, bind_data);
-
-    auto index = 0;
-    for (const auto& res: results) {
-        result.SetValue(index++, duckdb::Value::LIST(res));
-    }
+    const auto embeddings = LlmEmbedding::Operation(args, bind_data);
+    TypedOutput::WriteEmbeddings(embeddings, result, args.size());
 
     auto exec_end = std::chrono::high_resolution_clock::now();
     double exec_duration_ms = std::chrono::duration<double, std::milli>(exec_end - exec_start).count();
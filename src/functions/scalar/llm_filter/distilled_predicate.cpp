@@ -0,0 +1,249 @@
+#include "flock/functions/scalar/distilled_predicate.hpp"
+#include "flock/functions/input_parser.hpp"
+#include "flock/functions/scalar/scalar.hpp"
+#include "re2/re2.h"
+
+#include <algorithm>
+#include <random>
+
+namespace flock {
+
+std::optional<DistilledPredicate::Options> DistilledPredicate::ParseOptions(const nlohmann::json& value) {
+    Options options;
+    if (value.is_boolean()) {
+        return value.get<bool>() ? std::optional<Options>(options) : std::nullopt;
+    }
+    if (!value.is_object()) {
+        throw duckdb::BinderException("llm_filter: 'distill' must be a boolean or a struct.");
+    }
+    const auto get_number = [&value](const char* key) {
+        const auto number = ParseJsonNumber(value.at(key));
+        if (!number.has_value()) {
+            throw duckdb::BinderException(duckdb_fmt::format("llm_filter: the distill '{}' must be a number.", key));
+        }
+        return *number;
+    };
+    if (value.contains("sample_size")) {
+        const auto sample_size = get_number("sample_size");
+        if (sample_size < 1) {
+            throw duckdb::BinderException("llm_filter: the distill 'sample_size' must be larger than 0.");
+        }
+        // The sample is drawn from one chunk that has more rows than it.
+        if (sample_size >= STANDARD_VECTOR_SIZE) {
+            throw duckdb::BinderException(duckdb_fmt::format(
+                    "llm_filter: the distill 'sample_size' must be smaller than {}, the rows of one chunk.",
+                    STANDARD_VECTOR_SIZE));
+        }
+        options.sample_size = static_cast<size_t>(sample_size);
+    }
+    if (value.contains("agreement")) {
+        options.agreement = get_number("agreement");
+        if (options.agreement <= 0.0 || options.agreement > 1.0) {
+            throw duckdb::BinderException("llm_filter: the distill 'agreement' must be in (0, 1].");
+        }
+    }
+    return options;
+}
+
+DistilledPredicate::DistilledPredicate(Options options) : options_(options) {}
+
+DistilledPredicate::~DistilledPredicate() = default;
+
+DistilledPredicate::State DistilledPredicate::GetState() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+std::string DistilledPredicate::GetPattern() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pattern_;
+}
+
+std::string DistilledPredicate::BuildPatternPrompt(const std::string& prompt, const std::vector<std::string>& matching,
+                                                   const std::vector<std::string>& non_matching) {
+    auto result = "Write one regular expression in RE2 syntax that finds a match in a text exactly when the text "
+                  "satisfies this criterion: " +
+                  prompt +
+                  "\nThe expression is searched anywhere in the text; use (?i) for case-insensitive matching. "
+                  "Answer with the expression only, without delimiters or explanation.";
+    const auto append_examples = [&result](const char* title, const std::vector<std::string>& texts) {
+        if (texts.empty()) {
+            return;
+        }
+        result += duckdb_fmt::format("\n\n{}:", title);
+        for (const auto& text: texts) {
+            result += "\n- " + nlohmann::json(text).dump();
+        }
+    };
+    append_examples("Texts that satisfy the criterion", matching);
+    append_examples("Texts that do not satisfy the criterion", non_matching);
+    return result;
+}
+
+std::optional<std::vector<std::optional<std::string>>> DistilledPredicate::GetRowTexts(
+        const ContextColumnBatch& batch) {
+    if (batch.columns.size() != 1) {
+        return std::nullopt;
+    }
+    const auto& column = batch.columns[0];
+    if (column.metadata.contains("type") && column.metadata["type"] != "tabular") {
+        return std::nullopt;
+    }
+
+    std::vector<std::optional<std::string>> texts;
+    texts.reserve(batch.row_count);
+    for (idx_t row = 0; row < batch.row_count; row++) {
+        auto text = batch.GetCell(0, row);
+        if (text != "NULL") {
+            texts.emplace_back(std::move(text));
+        } else {
+            texts.emplace_back(std::nullopt);
+        }
+    }
+    return texts;
+}
+
+bool DistilledPredicate::Matches(const duckdb_re2::RE2& regex, const std::string& text) {
+    return duckdb_re2::RE2::PartialMatch(text, regex);
+}
+
+DistilledPredicate::Training DistilledPredicate::Train(const ContextColumnBatch& batch,
+                                                       const std::vector<std::optional<std::string>>& texts,
+                                                       const std::string& prompt, Model& model,
+                                                       nlohmann::json& answers) const {
+    std::vector<size_t> candidates;
+    for (size_t row = 0; row < texts.size(); row++) {
+        if (texts[row].has_value()) {
+            candidates.push_back(row);
+        }
+    }
+    std::mt19937 generator(static_cast<uint32_t>(texts.size()));
+    std::shuffle(candidates.begin(), candidates.end(), generator);
+    candidates.resize(std::min(candidates.size(), options_.sample_size));
+    std::sort(candidates.begin(), candidates.end());
+
+    const auto labels =
+            ScalarFunctionBase::BatchAndComplete(batch.Select(candidates), prompt, ScalarFunctionType::FILTER, model);
+    std::vector<size_t> labelled_rows;
+    std::vector<bool> labelled_values;
+    for (size_t i = 0; i < candidates.size() && i < labels.size(); i++) {
+        answers[candidates[i]] = labels[i];
+        if (labels[i].is_boolean()) {
+            labelled_rows.push_back(candidates[i]);
+            labelled_values.push_back(labels[i].get<bool>());
+        }
+    }
+
+    Training training;
+    if (labelled_rows.empty()) {
+        return training;
+    }
+
+    // At most half of the labelled rows become examples, so the other half can check the expression:
+    // an expression that only lists the example texts would agree with them trivially.
+    const auto max_examples = labelled_rows.size() / 2;
+    std::vector<std::string> matching;
+    std::vector<std::string> non_matching;
+    std::vector<bool> is_example(labelled_rows.size(), false);
+    for (size_t i = 0; i < labelled_rows.size() && matching.size() + non_matching.size() < max_examples; i++) {
+        auto& examples = labelled_values[i] ? matching : non_matching;
+        if (examples.size() < MAX_EXAMPLES) {
+            examples.push_back(*texts[labelled_rows[i]]);
+            is_example[i] = true;
+        }
+    }
+
+    model.AddCompletionRequest(BuildPatternPrompt(prompt, matching, non_matching), 1, OutputType::STRING);
+    const auto response = model.CollectCompletions()[0]["items"][0];
+    if (!response.is_string()) {
+        return training;
+    }
+    duckdb_re2::RE2::Options regex_options;
+    regex_options.set_log_errors(false);
+    auto regex = std::make_shared<const duckdb_re2::RE2>(response.get<std::string>(), regex_options);
+    if (!regex->ok()) {
+        return training;
+    }
+
+    size_t checked = 0;
+    size_t agreeing = 0;
+    for (size_t i = 0; i < labelled_rows.size(); i++) {
+        if (is_example[i]) {
+            continue;
+        }
+        checked++;
+        agreeing += Matches(*regex, *texts[labelled_rows[i]]) == labelled_values[i];
+    }
+    if (checked > 0 && static_cast<double>(agreeing) >= options_.agreement * static_cast<double>(checked)) {
+        training.state = State::ACCEPTED;
+        training.pattern = response.get<std::string>();
+        training.regex = std::move(regex);
+    }
+    return training;
+}
+
+nlohmann::json DistilledPredicate::Answer(const ContextColumnBatch& batch, const std::string& prompt,
+                                          Model& model, std::vector<size_t>& model_rows) {
+    const auto texts = GetRowTexts(batch);
+    const auto row_count = batch.empty() ? 0 : batch.row_count;
+    auto answers = nlohmann::json::array();
+    for (size_t row = 0; row < row_count; row++) {
+        answers.push_back(nullptr);
+    }
+
+    State state;
+    std::shared_ptr<const duckdb_re2::RE2> regex;
+    bool train;
+    {
+        // Concurrent chunks wait for the one that trains instead of paying for their own requests.
+        std::unique_lock<std::mutex> lock(mutex_);
+        trained_.wait(lock, [this] { return !training_; });
+        if (!texts.has_value()) {
+            state_ = State::REJECTED;
+        }
+        train = state_ == State::PENDING && row_count > options_.sample_size;
+        training_ = train;
+        state = state_;
+        regex = regex_;
+    }
+    if (train) {
+        // Labelling and deriving the expression run without the lock; the result is published at once.
+        Training training;
+        try {
+            training = Train(batch, *texts, prompt, model, answers);
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                state_ = State::REJECTED;
+                training_ = false;
+            }
+            trained_.notify_all();
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = training.state;
+            pattern_ = std::move(training.pattern);
+            regex_ = std::move(training.regex);
+            training_ = false;
+            state = state_;
+            regex = regex_;
+        }
+        trained_.notify_all();
+    }
+
+    for (size_t row = 0; row < row_count; row++) {
+        if (!answers[row].is_null()) {
+            continue;
+        }
+        // NULL texts keep going to the model so they get `empty_input_default` like any other call.
+        if (state == State::ACCEPTED && (*texts)[row].has_value()) {
+            answers[row] = Matches(*regex, *(*texts)[row]);
+        } else {
+            model_rows.push_back(row);
+        }
+    }
+    return answers;
+}
+
+}// namespace flock
@@ -1,7 +1,10 @@
 #include "duckdb/planner/expression/bound_function_expression.hpp"
 #include "flock/core/config.hpp"
+#include "flock/functions/scalar/distilled_classifier.hpp"
+#include "flock/functions/scalar/distilled_predicate.hpp"
 #include "flock/functions/scalar/llm_filter.hpp"
 #include "flock/functions/scalar/scalar.hpp"
+#include "flock/functions/typed_output.hpp"
 #include "flock/metrics/manager.hpp"
 #include "flock/model_manager/model.hpp"
 
@@ -11,9 +14,140 @@ duckdb::unique_ptr<duckdb::FunctionData> LlmFilter::Bind(
         duckdb::ClientContext& context,
         duckdb::ScalarFunction& bound_function,
         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
-    return ScalarFunctionBase::ValidateAndInitializeBindData(context, arguments, "llm_filter", false);
+    auto bind_data = ScalarFunctionBase::ValidateAndInitializeBindData(context, arguments, "llm_filter", false);
+    if (!bind_data->cascade_model_json.is_null()) {
+        BindCascade(*bind_data);
+    }
+    if (!bind_data->distill_json.is_null()) {
+        const auto distill_options = DistilledPredicate::ParseOptions(bind_data->distill_json);
+        if (!distill_options.has_value()) {
+            // `'distill': false` is the same call as no option at all, and may still be fused.
+            bind_data->distill_json = nullptr;
+        } else if (bind_data->distilled_classifier) {
+            throw duckdb::BinderException("llm_filter: 'distill' and 'classifier' cannot be combined.");
+        } else {
+            bind_data->distilled_predicate = std::make_shared<DistilledPredicate>(*distill_options);
+        }
+    }
+    if (!bind_data->returns.empty()) {
+        if (const auto return_type = TypedOutput::ResolveReturnType(bind_data->returns, bind_data->model_json,
+                                                                     ScalarFunctionType::FILTER)) {
+            bound_function.return_type = *return_type;
+        }
+    }
+    return bind_data;
 }
 
+void LlmFilter::BindCascade(LlmFunctionBindData& bind_data) {
+    auto cascade_json = bind_data.cascade_model_json;
+    if (!cascade_json.is_object() || !cascade_json.contains("model_name")) {
+        throw duckdb::BinderException("llm_filter: 'cascade' must be a struct with a 'model_name'.");
+    }
+
+    bind_data.cascade_threshold = DEFAULT_CASCADE_THRESHOLD;
+    if (cascade_json.contains("threshold")) {
+        const auto threshold = ParseJsonNumber(cascade_json["threshold"]);
+        if (!threshold.has_value()) {
+            throw duckdb::BinderException("llm_filter: the cascade 'threshold' must be a number.");
+        }
+        bind_data.cascade_threshold = *threshold;
+        if (bind_data.cascade_threshold <= 0.0 || bind_data.cascade_threshold > 1.0) {
+            throw duckdb::BinderException("llm_filter: the cascade 'threshold' must be in (0, 1].");
+        }
+        cascade_json.erase("threshold");
+    }
+    bind_data.cascade_model_json = Model::ResolveModelDetailsToJson(cascade_json);
+}
+
+std::string LlmFilter::BuildCascadePrompt(const std::string& prompt) {
+    return "Answer each of the following tasks separately for every row:"
+           "\n- keep (true or false): " +
+           prompt +
+           "\n- confidence (number between 0 and 1): how likely your `keep` answer is to be correct. "
+           "Use low values whenever the row is ambiguous or the answer depends on knowledge you are unsure of.";
+}
+
+nlohmann::json LlmFilter::BuildCascadeItemSchema() {
+    return {{"type", "object"},
+            {"properties", {{"keep", {{"type", "boolean"}}}, {"confidence", {{"type", "number"}}}}},
+            {"required", {"keep", "confidence"}},
+            {"additionalProperties", false}};
+}
+
+nlohmann::json LlmFilter::CascadeAnswers(const ContextColumnBatch& batch, const LlmFunctionBindData& bind_data) {
+    // The first stage asks for an object per row, the way fused calls do, so the confidence
+    // travels in the same structured response as the answer.
+    auto first_model_json = bind_data.model_json;
+    first_model_json["item_schema"] = BuildCascadeItemSchema();
+    Model first_model(first_model_json);
+    auto responses =
+            BatchAndComplete(batch, BuildCascadePrompt(bind_data.prompt), ScalarFunctionType::FUSED, first_model);
+
+    auto answers = nlohmann::json::array();
+    std::vector<size_t> escalated_rows;
+    for (size_t row = 0; row < responses.size(); row++) {
+        const auto& response = responses[row];
+        const auto confident = response.is_object() && response.contains("keep") && response["keep"].is_boolean() &&
+                               response.contains("confidence") && response["confidence"].is_number() &&
+                               response["confidence"].get<double>() >= bind_data.cascade_threshold;
+        if (confident) {
+            answers.push_back(response["keep"]);
+        } else {
+            answers.push_back(nullptr);
+            escalated_rows.push_back(row);
+        }
+    }
+
+    const auto cascade_model_name = bind_data.cascade_model_json.value("model_name", "");
+    MetricsManager::AddCascadeStats(cascade_model_name, static_cast<int64_t>(responses.size() - escalated_rows.size()),
+                                    static_cast<int64_t>(escalated_rows.size()));
+    if (escalated_rows.empty()) {
+        return answers;
+    }
+
+    // The escalated rows are recorded as their own `llm_filter` entry, so each stage reports the
+    // tokens, calls and model it used.
+    const auto metrics_context = MetricsManager::GetContext();
+    MetricsManager::ScopedContext stage_scope(metrics_context);
+    MetricsManager::StartInvocation(metrics_context.db, MetricsManager::GenerateUniqueId(), FunctionType::LLM_FILTER);
+    const auto stage_start = std::chrono::high_resolution_clock::now();
+
+    Model cascade_model(bind_data.cascade_model_json);
+    const auto& cascade_details = cascade_model.GetModelDetails();
+    MetricsManager::SetModelInfo(cascade_details.model_name, cascade_details.provider_name);
+    const auto escalated_answers =
+            BatchAndComplete(batch.Select(escalated_rows), bind_data.prompt, ScalarFunctionType::FILTER, cascade_model);
+
+    const auto stage_end = std::chrono::high_resolution_clock::now();
+    MetricsManager::AddExecutionTime(std::chrono::duration<double, std::milli>(stage_end - stage_start).count());
+    for (size_t i = 0; i < escalated_rows.size() && i < escalated_answers.size(); i++) {
+        answers[escalated_rows[i]] = escalated_answers[i];
+    }
+    return answers;
+}
+
+nlohmann::json LlmFilter::ModelAnswers(const ContextColumnBatch& batch, const LlmFunctionBindData& bind_data,
+                                       Model& model) {
+    if (!bind_data.cascade_model_json.is_null()) {
+        return CascadeAnswers(batch, bind_data);
+    }
+    return BatchAndComplete(batch, bind_data.prompt, ScalarFunctionType::FILTER, model);
+}
+
+nlohmann::json LlmFilter::DistilledAnswers(const ContextColumnBatch& batch, const LlmFunctionBindData& bind_data,
+                                           Model& model) {
+    std::vector<size_t> model_rows;
+    auto answers = bind_data.distilled_predicate->Answer(batch, bind_data.prompt, model, model_rows);
+    if (model_rows.empty()) {
+        return answers;
+    }
+
+    const auto model_answers = ModelAnswers(batch.Select(model_rows), bind_data, model);
+    for (size_t i = 0; i < model_rows.size() && i < model_answers.size(); i++) {
+        answers[model_rows[i]] = model_answers[i];
+    }
+    return answers;
+}
 
 void LlmFilter::ValidateArguments(duckdb::DataChunk& args) {
     if (args.ColumnCount() < 2 || args.ColumnCount() > 3) {
@@ -32,43 +166,51 @@ void LlmFilter::ValidateArguments(duckdb::DataChunk& args) {
     }
 }
 
-std::vector<std::string> LlmFilter::Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data) {
+std::vector<nlohmann::json> LlmFilter::Answer(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data) {
     Model model = bind_data->CreateModel();
 
-    auto model_details = model.GetModelDetails();
+    const auto& model_details = model.GetModelDetails();
     MetricsManager::SetModelInfo(model_details.model_name, model_details.provider_name);
 
-    auto prompt_context_json = CastVectorOfStructsToJson(args.data[1], args.size());
-    auto context_columns = nlohmann::json::array();
-    if (prompt_context_json.contains("context_columns")) {
-        context_columns = prompt_context_json["context_columns"];
-    }
-
-    auto prompt = bind_data->prompt;
+    nlohmann::json prompt_json;
+    const auto batch = ExtractPromptInputs(args.data[1], args.size(), prompt_json);
 
-    std::vector<std::string> results;
-    if (context_columns.empty()) {
-        auto template_str = prompt;
-        model.AddCompletionRequest(template_str, 1, OutputType::BOOL);
-        auto response = model.CollectCompletions()[0]["items"][0];
-        if (response.is_null()) {
-            results.push_back("true");
+    std::vector<nlohmann::json> answers;
+    if (batch.empty()) {
+        answers.push_back(CompleteConstant(context, *bind_data, OutputType::BOOL, model));
+    } else {
+        nlohmann::json responses;
+        if (bind_data->distilled_predicate) {
+            responses = DistilledAnswers(batch, *bind_data, model);
+        } else if (bind_data->distilled_classifier) {
+            responses = bind_data->distilled_classifier->Answer(batch, [&](const ContextColumnBatch& rows) {
+                return ModelAnswers(rows, *bind_data, model);
+            });
         } else {
-            results.push_back(response.dump());
+            responses = ModelAnswers(batch, *bind_data, model);
         }
-    } else {
-        auto responses = BatchAndComplete(context_columns, prompt, ScalarFunctionType::FILTER, model);
-
-        results.reserve(responses.size());
-        for (const auto& response: responses) {
-            if (response.is_null()) {
-                results.emplace_back("true");
-                continue;
-            }
-            results.push_back(response.dump());
+        answers = std::move(responses.get_ref<nlohmann::json::array_t&>());
+    }
+
+    // Rows without an answer are kept.
+    for (auto& answer: answers) {
+        if (answer.is_null()) {
+            answer = true;
         }
     }
+    return answers;
+}
+
+std::vector<std::string> LlmFilter::Operation(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data) {
+    const auto answers = Answer(context, args, bind_data);
 
+    std::vector<std::string> results;
+    results.reserve(answers.size());
+    for (const auto& answer: answers) {
+        results.push_back(answer.dump());
+    }
     return results;
 }
 
@@ -84,16 +226,10 @@ void LlmFilter::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state,
     auto& func_expr = state.expr.Cast<duckdb::BoundFunctionExpression>();
     auto* bind_data = &func_expr.bind_info->Cast<LlmFunctionBindData>();
 
-    if (const auto results = LlmFilter::Operation(args, bind_data); static_cast<int>(results.size()) == 1) {
-        auto empty_vec = duckdb::Vector(std::string());
-        duckdb::UnaryExecutor::Execute<duckdb::string_t, duckdb::string_t>(
-                empty_vec, result, args.size(),
-                [&](duckdb::string_t name) { return duckdb::StringVector::AddString(result, results[0]); });
+    if (result.GetType().id() == duckdb::LogicalTypeId::BOOLEAN) {
+        TypedOutput::WriteAnswers(LlmFilter::Answer(context, args, bind_data), result, args.size());
     } else {
-        auto index = 0;
-        for (const auto& res: results) {
-            result.SetValue(index++, duckdb::Value(res));
-        }
+        TypedOutput::WriteStrings(LlmFilter::Operation(context, args, bind_data), result, args.size());
     }
 
     auto exec_end = std::chrono::high_resolution_clock::now();
@@ -4,10 +4,11 @@
 namespace flock {
 
 void ScalarRegistry::RegisterLlmFilter(duckdb::ExtensionLoader& loader) {
-    loader.RegisterFunction(duckdb::ScalarFunction("llm_filter",
-                                                   {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
-                                                   duckdb::LogicalType::VARCHAR, LlmFilter::Execute,
-                                                   LlmFilter::Bind));
+    auto function = duckdb::ScalarFunction("llm_filter", {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
+                                           duckdb::LogicalType::VARCHAR, LlmFilter::Execute, LlmFilter::Bind);
+    // Like llm_complete, a call is only guaranteed to answer the same within one query.
+    function.stability = duckdb::FunctionStability::CONSISTENT_WITHIN_QUERY;
+    loader.RegisterFunction(function);
 }
 
 }// namespace flock
@@ -0,0 +1,192 @@
+#include "flock/functions/scalar/llm_fused.hpp"
+#include "flock/functions/typed_output.hpp"
+#include "flock/metrics/manager.hpp"
+#include "flock/model_manager/model.hpp"
+#include "flock/model_manager/result_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
+namespace flock {
+
+namespace {
+
+// Results of the last fused request per group on this thread. A projection evaluates all of its
+// expressions for a chunk on one thread, so the siblings of the call that issued the request
+// find the answers here; the entry is dropped once every task has been served.
+struct FusedChunkResults {
+    std::string key;
+    std::vector<std::vector<std::string>> results;
+    std::vector<bool> served;
+};
+
+std::unordered_map<uint64_t, FusedChunkResults>& GetFusedChunkResults() {
+    thread_local std::unordered_map<uint64_t, FusedChunkResults> fused_chunk_results;
+    return fused_chunk_results;
+}
+
+std::string FormatTaskAnswer(const nlohmann::json& answer, const ScalarFunctionType function_type) {
+    if (function_type == ScalarFunctionType::FILTER) {
+        if (answer.is_null()) {
+            return "true";
+        }
+        if (answer.is_string()) {
+            auto value = answer.get<std::string>();
+            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+            if (value == "true" || value == "false") {
+                return value;
+            }
+        }
+        return answer.dump();
+    }
+    if (answer.is_string()) {
+        return answer.get<std::string>();
+    }
+    return answer.dump();
+}
+
+// Identifies the chunk a fused request answered: a 128-bit hash folded over the hashes of its
+// cells, so no copy of the chunk is kept. Siblings share their context columns, so only the
+// cells can differ between chunks.
+std::string ChunkKey(const ContextColumnBatch& batch) {
+    auto key = ResultCache::Hash(std::to_string(batch.row_count));
+    for (const auto& column: batch.columns) {
+        for (idx_t row = 0; row < batch.row_count; row++) {
+            const auto& cell = column.cells[row];
+            key += column.valid[row] ? ResultCache::Hash(cell.GetData(), cell.GetSize()) : "null";
+            key = ResultCache::Hash(key);
+        }
+    }
+    return key;
+}
+
+}// namespace
+
+std::shared_ptr<const LlmFusionGroup> LlmFused::CreateGroup(const nlohmann::json& model_json,
+                                                            std::vector<FusedTask> tasks) {
+    static std::atomic<uint64_t> next_group_id{0};
+    auto group = std::make_shared<LlmFusionGroup>();
+    group->id = ++next_group_id;
+    group->model_json = model_json;
+    group->tasks = std::move(tasks);
+    return group;
+}
+
+void LlmFused::Rewrite(duckdb::BoundFunctionExpression& call, const std::shared_ptr<const LlmFusionGroup>& group,
+                       const idx_t task_index) {
+    auto bind_data = duckdb::make_uniq<LlmFusedBindData>();
+    bind_data->model_json = group->model_json;
+    bind_data->prompt = group->tasks[task_index].prompt;
+    bind_data->group = group;
+    bind_data->task_index = task_index;
+
+    call.function.name = FUNCTION_NAME;
+    call.function.function = LlmFused::Execute;
+    call.bind_info = std::move(bind_data);
+}
+
+std::string LlmFused::GetTaskKey(const idx_t task_index) {
+    return "task_" + std::to_string(task_index);
+}
+
+std::string LlmFused::BuildFusedPrompt(const std::vector<FusedTask>& tasks) {
+    std::string prompt = "Answer each of the following tasks separately for every row:";
+    for (idx_t i = 0; i < tasks.size(); i++) {
+        const auto answer_kind = tasks[i].function_type == ScalarFunctionType::FILTER ? "true or false" : "text answer";
+        prompt += duckdb_fmt::format("\n- {} ({}): {}", GetTaskKey(i), answer_kind, tasks[i].prompt);
+    }
+    return prompt;
+}
+
+nlohmann::json LlmFused::BuildItemSchema(const std::vector<FusedTask>& tasks) {
+    auto properties = nlohmann::json::object();
+    auto required = nlohmann::json::array();
+    for (idx_t i = 0; i < tasks.size(); i++) {
+        const auto key = GetTaskKey(i);
+        properties[key] = {{"type", tasks[i].function_type == ScalarFunctionType::FILTER ? "boolean" : "string"}};
+        required.push_back(key);
+    }
+    return {{"type", "object"},
+            {"properties", properties},
+            {"required", required},
+            {"additionalProperties", false}};
+}
+
+std::vector<std::vector<std::string>> LlmFused::SplitResponses(const nlohmann::json& responses,
+                                                               const std::vector<FusedTask>& tasks) {
+    std::vector<std::vector<std::string>> results(tasks.size());
+    for (auto& task_results: results) {
+        task_results.reserve(responses.size());
+    }
+
+    for (const auto& response: responses) {
+        for (idx_t i = 0; i < tasks.size(); i++) {
+            const auto key = GetTaskKey(i);
+            // A scalar response (e.g. `empty_input_default` for an empty row) answers every call.
+            const auto answer = !response.is_object()       ? response
+                                : response.contains(key) ? response[key]
+                                                         : nlohmann::json();
+            results[i].push_back(FormatTaskAnswer(answer, tasks[i].function_type));
+        }
+    }
+    return results;
+}
+
+std::vector<std::vector<std::string>> LlmFused::Operation(const ContextColumnBatch& batch,
+                                                          const LlmFusionGroup& group) {
+    auto model_json = group.model_json;
+    model_json["item_schema"] = BuildItemSchema(group.tasks);
+    Model model(model_json);
+
+    const auto& model_details = model.GetModelDetails();
+    MetricsManager::SetModelInfo(model_details.model_name, model_details.provider_name);
+
+    auto responses = BatchAndComplete(batch, BuildFusedPrompt(group.tasks), ScalarFunctionType::FUSED, model);
+    return SplitResponses(responses, group.tasks);
+}
+
+void LlmFused::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
+    auto& func_expr = state.expr.Cast<duckdb::BoundFunctionExpression>();
+    auto& bind_data = func_expr.bind_info->Cast<LlmFusedBindData>();
+    const auto& group = *bind_data.group;
+
+    auto& context = state.GetContext();
+    auto* db = context.db.get();
+    const void* invocation_id = MetricsManager::GenerateUniqueId();
+    const auto function_type = group.tasks[bind_data.task_index].function_type == ScalarFunctionType::FILTER
+                                       ? FunctionType::LLM_FILTER
+                                       : FunctionType::LLM_COMPLETE;
+    MetricsManager::StartInvocation(db, invocation_id, function_type);
+
+    auto exec_start = std::chrono::high_resolution_clock::now();
+
+    nlohmann::json prompt_json;
+    const auto batch = ExtractPromptInputs(args.data[1], args.size(), prompt_json);
+    auto key = ChunkKey(batch);
+
+    auto& chunk_results = GetFusedChunkResults();
+    auto entry = chunk_results.find(group.id);
+    if (entry == chunk_results.end() || entry->second.key != key || entry->second.served[bind_data.task_index]) {
+        FusedChunkResults fresh;
+        fresh.results = Operation(batch, group);
+        fresh.served.assign(group.tasks.size(), false);
+        fresh.key = std::move(key);
+        entry = chunk_results.insert_or_assign(group.id, std::move(fresh)).first;
+    }
+
+    auto& fused = entry->second;
+    TypedOutput::WriteStrings(fused.results[bind_data.task_index], result, args.size());
+
+    fused.served[bind_data.task_index] = true;
+    if (std::all_of(fused.served.begin(), fused.served.end(), [](const bool served) { return served; })) {
+        chunk_results.erase(entry);
+    }
+
+    auto exec_end = std::chrono::high_resolution_clock::now();
+    double exec_duration_ms = std::chrono::duration<double, std::milli>(exec_end - exec_start).count();
+    MetricsManager::AddExecutionTime(exec_duration_ms);
+}
+
+}// namespace flock
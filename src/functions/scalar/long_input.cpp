@@ -0,0 +1,167 @@
+#include "flock/functions/scalar/long_input.hpp"
+#include "flock/functions/scalar/scalar.hpp"
+#include "flock/model_manager/request_executor.hpp"
+#include "flock/prompt_manager/token_counter.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace flock {
+
+namespace {
+
+constexpr auto MAP_PROMPT =
+        "The input is part {} of {} of a longer text that was split into overlapping parts. Using only this part, "
+        "answer the task below and keep every detail an answer for the whole text may need. If the part holds "
+        "nothing relevant, say so briefly.\n\nTask: {}";
+constexpr auto REDUCE_PROMPT =
+        "The input holds partial answers to the task below, one for each part of a longer text that was split "
+        "into overlapping parts. Combine them into the answer for the whole text.\n\nTask: {}";
+
+// Where the chunk answers of one row start among the collected responses.
+struct RowChunks {
+    size_t answer_index;
+    size_t first_response;
+    size_t chunk_count;
+};
+
+std::string ItemText(const nlohmann::json& item) {
+    return item.is_string() ? item.get<std::string>() : item.dump();
+}
+
+// Collects the `queued` requests of `model` into `responses` once they fill a wave, or whatever is
+// queued when `flush` is set.
+void CollectWave(Model& model, size_t& queued, const size_t wave_size, const bool flush,
+                 std::vector<nlohmann::json>& responses) {
+    if (queued == 0 || (queued < wave_size && !flush)) {
+        return;
+    }
+    auto wave_responses = model.CollectCompletions();
+    if (wave_responses.size() != queued) {
+        throw std::runtime_error(duckdb_fmt::format("Expected {} completion batch responses, got {}", queued,
+                                                    wave_responses.size()));
+    }
+    responses.insert(responses.end(), std::make_move_iterator(wave_responses.begin()),
+                     std::make_move_iterator(wave_responses.end()));
+    queued = 0;
+}
+
+}// namespace
+
+std::optional<size_t> LongInput::LongestTextColumn(const ContextColumnBatch& batch, const size_t row) {
+    std::optional<size_t> longest;
+    size_t longest_size = 0;
+    for (size_t i = 0; i < batch.columns.size(); i++) {
+        const auto& column = batch.columns[i];
+        // Images and audio are not text the model reads in pieces.
+        if (column.metadata.contains("type") &&
+            (column.metadata["type"] == "image" || column.metadata["type"] == "audio")) {
+            continue;
+        }
+        if (column.valid[row] && column.cells[row].GetSize() > longest_size) {
+            longest = i;
+            longest_size = column.cells[row].GetSize();
+        }
+    }
+    return longest;
+}
+
+std::vector<nlohmann::json> LongInput::CompleteRows(const ContextColumnBatch& batch, const std::vector<int>& rows,
+                                                    const std::string& user_prompt,
+                                                    const ScalarFunctionType function_type, Model& model) {
+    std::vector<nlohmann::json> answers(rows.size());
+    const auto& long_input = model.GetModelDetails().long_input;
+    // Fused calls answer several prompts per row, which a single reduce request cannot combine.
+    if (!long_input.has_value() || function_type == ScalarFunctionType::FUSED || rows.empty()) {
+        return answers;
+    }
+
+    // Audio is transcribed once for these rows, not again for each of their chunks.
+    const std::vector<size_t> selected_rows(rows.begin(), rows.end());
+    const auto selected = PromptManager::TranscribeAudioColumns(batch.Select(selected_rows));
+
+    // Map: the chunks of all rows are answered concurrently, in waves of at most
+    // flock_max_http_concurrency requests, so a very long row does not send all its chunks at once.
+    const auto wave_size = std::max<size_t>(RequestExecutor::GetMaxConcurrency(), 1);
+    auto map_model = model.WithFreshProvider();
+    std::vector<RowChunks> row_chunks;
+    std::vector<nlohmann::json> chunk_responses;
+    size_t queued = 0;
+    size_t in_wave = 0;
+    try {
+        for (size_t i = 0; i < rows.size(); i++) {
+            const auto column = LongestTextColumn(selected, i);
+            if (!column.has_value()) {
+                continue;
+            }
+            const auto chunks = TokenCounter::Split(selected.GetCell(*column, i), long_input->chunk_tokens,
+                                                    long_input->overlap_tokens);
+            if (chunks.size() < 2) {
+                continue;
+            }
+
+            row_chunks.push_back({i, queued, chunks.size()});
+            const auto row_tuples = selected.Select({i}).ToJson();
+            for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+                auto chunk_tuples = row_tuples;
+                chunk_tuples[*column]["data"][0] = chunks[chunk];
+                ScalarFunctionBase::QueueCompletion(
+                        chunk_tuples, duckdb_fmt::format(MAP_PROMPT, chunk + 1, chunks.size(), user_prompt),
+                        ScalarFunctionType::COMPLETE, map_model, false);
+                in_wave++;
+                CollectWave(map_model, in_wave, wave_size, false, chunk_responses);
+            }
+            queued += chunks.size();
+        }
+        CollectWave(map_model, in_wave, wave_size, true, chunk_responses);
+    } catch (const TokenLimitExceededError&) {
+        return answers;
+    } catch (const UsageLimitExceededError&) {
+        return answers;
+    }
+    if (row_chunks.empty()) {
+        return answers;
+    }
+
+    // Reduce: one request per row over its partial answers, in the function's own output format.
+    auto reduce_model = model.WithFreshProvider();
+    std::vector<size_t> reduced_rows;
+    std::vector<nlohmann::json> reduce_responses;
+    try {
+        for (const auto& chunks: row_chunks) {
+            std::string partial_answers;
+            bool complete = true;
+            for (size_t chunk = 0; chunk < chunks.chunk_count && complete; chunk++) {
+                const auto& response = chunk_responses[chunks.first_response + chunk];
+                if (IsTokenLimitExceededMarker(response)) {
+                    complete = false;
+                    continue;
+                }
+                partial_answers += duckdb_fmt::format("Part {}:\n{}\n\n", chunk + 1, ItemText(response["items"][0]));
+            }
+            if (!complete) {
+                continue;
+            }
+
+            auto reduce_tuples = nlohmann::json::array(
+                    {{{"name", PARTIAL_ANSWERS_COLUMN}, {"data", nlohmann::json::array({partial_answers})}}});
+            ScalarFunctionBase::QueueCompletion(reduce_tuples, duckdb_fmt::format(REDUCE_PROMPT, user_prompt),
+                                                function_type, reduce_model, false);
+            reduced_rows.push_back(chunks.answer_index);
+            in_wave++;
+            CollectWave(reduce_model, in_wave, wave_size, false, reduce_responses);
+        }
+        CollectWave(reduce_model, in_wave, wave_size, true, reduce_responses);
+    } catch (const TokenLimitExceededError&) {
+        return answers;
+    } catch (const UsageLimitExceededError&) {
+        return answers;
+    }
+    for (size_t i = 0; i < reduced_rows.size(); i++) {
+        if (!IsTokenLimitExceededMarker(reduce_responses[i])) {
+            answers[reduced_rows[i]] = reduce_responses[i]["items"][0];
+        }
+    }
+    return answers;
+}
+
+}// namespace flock
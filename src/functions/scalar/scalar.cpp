@@ -1,37 +1,35 @@
 #include "flock/functions/scalar/scalar.hpp"
+#include "duckdb/parallel/task_executor.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "flock/core/config.hpp"
+#include "flock/functions/output_decoder.hpp"
+#include "flock/functions/scalar/constant_answer_memo.hpp"
+#include "flock/functions/scalar/distilled_classifier.hpp"
+#include "flock/functions/scalar/long_input.hpp"
+#include "flock/functions/scalar/distilled_predicate.hpp"
+#include "flock/functions/scalar/llm_filter.hpp"
+#include "flock/functions/typed_output.hpp"
+#include "flock/metrics/manager.hpp"
+#include "flock/model_manager/batch_size_controller.hpp"
+#include "flock/model_manager/inflight_budget.hpp"
 #include "flock/model_manager/model.hpp"
+#include "flock/model_manager/output_token_budget.hpp"
+#include "flock/model_manager/request_executor.hpp"
+#include "flock/model_manager/result_cache.hpp"
+#include "flock/model_manager/semantic_cache.hpp"
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <deque>
 #include <duckdb/planner/expression/bound_function_expression.hpp>
+#include <future>
+#include <unordered_map>
 #include <vector>
 
 namespace flock {
 
 namespace {
 
-nlohmann::json BuildBatchTuples(const nlohmann::json& tuples, int start_index, int batch_size) {
-    auto batch_tuples = nlohmann::json::array();
-
-    for (auto i = 0; i < static_cast<int>(tuples.size()); i++) {
-        batch_tuples.push_back(nlohmann::json::object());
-        for (const auto& item: tuples[i].items()) {
-            if (item.key() != "data") {
-                batch_tuples[i][item.key()] = item.value();
-                continue;
-            }
-
-            for (auto j = 0; j < batch_size && start_index + j < static_cast<int>(item.value().size()); j++) {
-                if (j == 0) {
-                    batch_tuples[i]["data"] = nlohmann::json::array();
-                }
-                batch_tuples[i]["data"].push_back(item.value()[start_index + j]);
-            }
-        }
-    }
-
-    return batch_tuples;
-}
-
 void NormalizeAndAppendBatchResponse(nlohmann::json response, size_t expected_size, nlohmann::json& responses) {
     if (response.size() < expected_size) {
         for (auto i = response.size(); i < expected_size; i++) {
@@ -46,6 +44,20 @@ void NormalizeAndAppendBatchResponse(nlohmann::json response, size_t expected_si
     }
 }
 
+// Identifies a row by its cells as the model sees them; each cell is length-prefixed so no two
+// rows share a key.
+std::string RowKey(const ContextColumnBatch& batch, const size_t row) {
+    std::string key;
+    for (const auto& column: batch.columns) {
+        const auto cell = column.valid[row] ? column.cells[row] : duckdb::string_t("NULL");
+        key += std::to_string(cell.GetSize());
+        key += ':';
+        key.append(cell.GetData(), cell.GetSize());
+        key += '\x1e';
+    }
+    return key;
+}
+
 nlohmann::json BuildNullResponsesForRowCount(int row_count) {
     auto responses = nlohmann::json::array();
 
@@ -59,6 +71,8 @@ nlohmann::json BuildNullResponsesForRowCount(int row_count) {
 struct AsyncBatchWork {
     int start_index;
     int batch_size;
+    // Set after a compact answer failed validation; the retry asks for plain JSON.
+    bool force_json = false;
 };
 
 void WriteBatchResponseToResults(const nlohmann::json& batch_response,
@@ -82,20 +96,78 @@ void NullBatchRows(int start_index, int rows_to_null, nlohmann::json& responses)
     }
 }
 
+// Batches of one async round that are collected together.
+struct AsyncWave {
+    size_t begin = 0;
+    size_t end = 0;
+    std::vector<OutputEncoding> encodings;
+    std::shared_ptr<Model> model;
+    std::chrono::steady_clock::time_point started;
+    // When the wave's responses arrived, stamped by whichever thread collected them.
+    std::shared_ptr<std::chrono::steady_clock::time_point> finished =
+            std::make_shared<std::chrono::steady_clock::time_point>();
+    // Set when the wave is collected on an I/O thread while later waves render.
+    std::optional<std::future<nlohmann::json>> collected;
+};
+
+class ScalarWorkTask : public duckdb::BaseExecutorTask {
+public:
+    ScalarWorkTask(duckdb::TaskExecutor& executor, std::function<void()> work)
+        : BaseExecutorTask(executor), work_(std::move(work)) {}
+
+    void ExecuteTask() override {
+        work_();
+    }
+
+private:
+    std::function<void()> work_;
+};
+
+// Runs `work(i)` for every i below `count` on DuckDB's task scheduler, with the calling thread
+// helping, and returns once all have finished.
+void RunOnScheduler(const size_t count, const std::function<void(size_t)>& work) {
+    if (count < 2 || Config::db == nullptr) {
+        for (size_t i = 0; i < count; i++) {
+            work(i);
+        }
+        return;
+    }
+    const auto metrics_context = MetricsManager::GetContext();
+    duckdb::TaskExecutor executor(duckdb::TaskScheduler::GetScheduler(*Config::db));
+    for (size_t i = 0; i < count; i++) {
+        executor.ScheduleTask(duckdb::make_uniq<ScalarWorkTask>(executor, [&work, &metrics_context, i]() {
+            MetricsManager::ScopedContext scope(metrics_context);
+            work(i);
+        }));
+    }
+    executor.WorkOnTasks();
+}
+
+// A single row that still overflows is recorded in `oversized_rows`, for LongInput to split.
 void RetryOrSetOutputToNull(const AsyncBatchWork& work,
                             std::vector<AsyncBatchWork>& pending,
-                            nlohmann::json& responses) {
+                            nlohmann::json& responses,
+                            std::vector<int>& oversized_rows) {
     const int new_batch_size = work.batch_size / 2;
     if (new_batch_size == 0) {
         NullBatchRows(work.start_index, work.batch_size, responses);
+        oversized_rows.push_back(work.start_index);
         return;
     }
 
-    pending.push_back({work.start_index, new_batch_size});
+    pending.push_back({work.start_index, new_batch_size, work.force_json});
     const int remainder = work.batch_size - new_batch_size;
     if (remainder > 0) {
-        pending.push_back({work.start_index + new_batch_size, remainder});
+        pending.push_back({work.start_index + new_batch_size, remainder, work.force_json});
+    }
+}
+
+OutputEncoding ResolveOutputEncoding(const ScalarFunctionType function_type, const ModelDetails& model_details,
+                                     const bool allow_compact_output) {
+    if (allow_compact_output && function_type == ScalarFunctionType::FILTER) {
+        return model_details.output_encoding;
     }
+    return OutputEncoding::JSON;
 }
 
 }// namespace
@@ -160,59 +232,141 @@ void ScalarFunctionBase::InitializeModelJson(
 
     auto model_value = duckdb::ExpressionExecutor::EvaluateScalar(context, *model_expr);
     auto user_model_json = CastValueToJson(model_value);
+    if (user_model_json.contains(TypedOutput::OPTION_NAME)) {
+        bind_data.returns = user_model_json[TypedOutput::OPTION_NAME].get<std::string>();
+        user_model_json.erase(TypedOutput::OPTION_NAME);
+    }
+    // Resolved by LlmFilter::Bind, the only function that accepts a cascade or distilled predicate.
+    if (user_model_json.contains(LlmFilter::CASCADE_OPTION_NAME)) {
+        bind_data.cascade_model_json = user_model_json[LlmFilter::CASCADE_OPTION_NAME];
+        user_model_json.erase(LlmFilter::CASCADE_OPTION_NAME);
+    }
+    if (user_model_json.contains(DistilledPredicate::OPTION_NAME)) {
+        bind_data.distill_json = user_model_json[DistilledPredicate::OPTION_NAME];
+        user_model_json.erase(DistilledPredicate::OPTION_NAME);
+    }
+    if (user_model_json.contains(DistilledClassifier::OPTION_NAME)) {
+        bind_data.classifier_json = user_model_json[DistilledClassifier::OPTION_NAME];
+        user_model_json.erase(DistilledClassifier::OPTION_NAME);
+    }
     bind_data.model_json = Model::ResolveModelDetailsToJson(user_model_json);
 }
 
-void ScalarFunctionBase::QueueCompletion(nlohmann::json& tuples, const std::string& user_prompt,
-                                         ScalarFunctionType function_type, Model& model) {
-    const auto [prompt, media_data] = PromptManager::Render(user_prompt, tuples, function_type, model.GetModelDetails().tuple_format);
-    OutputType output_type = OutputType::STRING;
+ScalarFunctionBase::RenderedCompletion ScalarFunctionBase::RenderCompletion(const nlohmann::json& tuples,
+                                                                          const std::string& user_prompt,
+                                                                          ScalarFunctionType function_type,
+                                                                          const ModelDetails& model_details,
+                                                                          const bool allow_compact_output) {
+    RenderedCompletion rendered;
+    rendered.output_encoding = ResolveOutputEncoding(function_type, model_details, allow_compact_output);
+    std::tie(rendered.prompt, rendered.media_data) =
+            PromptManager::Render(user_prompt, tuples, function_type, model_details.tuple_format,
+                                  model_details.dictionary_encoding, rendered.output_encoding);
     if (function_type == ScalarFunctionType::FILTER) {
-        output_type = OutputType::BOOL;
+        rendered.output_type =
+                rendered.output_encoding == OutputEncoding::COMPACT ? OutputType::BITSTRING : OutputType::BOOL;
+    } else if (function_type == ScalarFunctionType::FUSED) {
+        rendered.output_type = OutputType::OBJECT;
     }
+    rendered.num_tuples = static_cast<int>(tuples[0]["data"].size());
+    return rendered;
+}
+
+void ScalarFunctionBase::QueueRendered(const RenderedCompletion& rendered, const std::string& user_prompt,
+                                       Model& model) {
+    const auto& model_details = model.GetModelDetails();
+    if (rendered.output_type == OutputType::STRING && model_details.output_token_budget) {
+        model.SetStringTokensPerTupleHint(
+                OutputTokenBudget::LearnedTokensPerTuple(model_details, user_prompt));
+    }
+    model.AddCompletionRequest(rendered.prompt, rendered.num_tuples, rendered.output_type, rendered.media_data);
+}
 
-    model.AddCompletionRequest(prompt, static_cast<int>(tuples[0]["data"].size()), output_type, media_data);
+OutputEncoding ScalarFunctionBase::QueueCompletion(nlohmann::json& tuples, const std::string& user_prompt,
+                                                   ScalarFunctionType function_type, Model& model,
+                                                   const bool allow_compact_output) {
+    const auto rendered =
+            RenderCompletion(tuples, user_prompt, function_type, model.GetModelDetails(), allow_compact_output);
+    QueueRendered(rendered, user_prompt, model);
+    return rendered.output_encoding;
+}
+
+std::optional<nlohmann::json> ScalarFunctionBase::DecodeItems(const nlohmann::json& response,
+                                                              const OutputEncoding output_encoding,
+                                                              const size_t expected_count) {
+    if (output_encoding == OutputEncoding::COMPACT) {
+        return DecodeCompactBoolItems(response["items"], expected_count);
+    }
+    return response["items"];
 }
 
 nlohmann::json ScalarFunctionBase::Complete(nlohmann::json& columns, const std::string& user_prompt,
                                             ScalarFunctionType function_type, Model& model) {
-    QueueCompletion(columns, user_prompt, function_type, model);
+    const auto expected_count = columns[0]["data"].size();
+    const auto output_encoding = QueueCompletion(columns, user_prompt, function_type, model);
     auto response = model.CollectCompletions();
+    // Providers answer a request that overflows the context window with a marker; callers
+    // shrink the batch on the error instead.
+    if (IsTokenLimitExceededMarker(response[0])) {
+        throw TokenLimitExceededError();
+    }
+    if (auto items = DecodeItems(response[0], output_encoding, expected_count)) {
+        return *items;
+    }
+
+    // The compact answer did not validate; ask again for the plain JSON encoding.
+    QueueCompletion(columns, user_prompt, function_type, model, false);
+    response = model.CollectCompletions();
+    if (IsTokenLimitExceededMarker(response[0])) {
+        throw TokenLimitExceededError();
+    }
     return response[0]["items"];
 };
 
-nlohmann::json ScalarFunctionBase::BatchAndCompleteSync(const nlohmann::json& tuples,
+nlohmann::json ScalarFunctionBase::CompleteConstant(duckdb::ClientContext& context, const LlmFunctionBindData& bind_data,
+                                                    const OutputType output_type, Model& model) {
+    const auto key = ConstantAnswerMemo::Key(bind_data.model_json, bind_data.prompt, output_type);
+    return ConstantAnswerMemo::Get(context).GetOrCompute(key, [&]() {
+        model.AddCompletionRequest(bind_data.prompt, 1, output_type);
+        return model.CollectCompletions()[0]["items"][0];
+    });
+}
+
+nlohmann::json ScalarFunctionBase::BatchAndCompleteSync(const ContextColumnBatch& batch,
                                                         const std::string& user_prompt,
                                                         const ScalarFunctionType function_type, Model& model) {
-    const int row_count = static_cast<int>(tuples[0]["data"].size());
-    const int configured = std::min<int>(model.GetModelDetails().max_batch_size, row_count);
-    auto batch_size = configured;
+    const int row_count = static_cast<int>(batch.row_count);
+    const auto& model_details = model.GetModelDetails();
+    const int max_batch_size = model_details.max_batch_size;
+    auto batch_size = std::min<int>(BatchSizeController::Initial(model_details, user_prompt, max_batch_size), row_count);
 
     auto responses = nlohmann::json::array();
 
     int start_index = 0;
 
     do {
-        auto batch_tuples = BuildBatchTuples(tuples, start_index, batch_size);
+        auto batch_tuples = batch.Slice(start_index, batch_size).ToJson();
+        const int batch_rows = std::min(batch_size, row_count - start_index);
 
         start_index += batch_size;
 
         try {
+            const auto started = std::chrono::steady_clock::now();
             auto response = Complete(batch_tuples, user_prompt, function_type, model);
-            NormalizeAndAppendBatchResponse(response, batch_tuples[0]["data"].size(), responses);
-            batch_size = configured;
+            NormalizeAndAppendBatchResponse(response, batch_rows, responses);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+            batch_size = BatchSizeController::OnSuccess(model_details, user_prompt, batch_rows, elapsed.count(),
+                                                        max_batch_size);
         } catch (const TokenLimitExceededError&) {
             start_index -= batch_size;
-            const int attempted_batch_size = batch_size;
-            batch_size = batch_size / 2;
+            batch_size = BatchSizeController::OnTokenLimit(model_details, user_prompt, batch_rows);
             if (batch_size == 0) {
-                const int remaining = row_count - start_index;
-                const int rows_to_null = std::min<int>(attempted_batch_size, remaining);
-                for (int i = 0; i < rows_to_null; i++) {
-                    responses.push_back(nullptr);
-                }
-                start_index += rows_to_null;
-                batch_size = configured;
+                // A single row that does not fit on its own; chunked when the model enables long_input.
+                const auto answers =
+                        LongInput::CompleteRows(batch, {start_index}, user_prompt, function_type, model);
+                responses.push_back(answers[0]);
+                start_index += batch_rows;
+                batch_size = BatchSizeController::Initial(model_details, user_prompt, max_batch_size);
             }
         } catch (const UsageLimitExceededError&) {
             const int rows_not_yet_responded = row_count - static_cast<int>(responses.size());
@@ -227,81 +381,305 @@ nlohmann::json ScalarFunctionBase::BatchAndCompleteSync(const nlohmann::json& tu
     return responses;
 }
 
-nlohmann::json ScalarFunctionBase::BatchAndCompleteAsync(const nlohmann::json& tuples,
+nlohmann::json ScalarFunctionBase::BatchAndCompleteAsync(const ContextColumnBatch& batch,
                                                          const std::string& user_prompt,
                                                          const ScalarFunctionType function_type, Model& model) {
-    const int row_count = static_cast<int>(tuples[0]["data"].size());
-    const int configured = std::min<int>(model.GetModelDetails().max_batch_size, row_count);
+    const int row_count = static_cast<int>(batch.row_count);
+    const auto& model_details = model.GetModelDetails();
+    const int max_batch_size = model_details.max_batch_size;
+    const int configured =
+            std::min<int>(BatchSizeController::Initial(model_details, user_prompt, max_batch_size), row_count);
 
     auto responses = BuildNullResponsesForRowCount(row_count);
     std::vector<AsyncBatchWork> pending;
+    std::vector<int> oversized_rows;
 
     for (int start_index = 0; start_index < row_count; start_index += configured) {
         pending.push_back({start_index, std::min<int>(configured, row_count - start_index)});
     }
 
-    while (!pending.empty()) {
-        auto attempt_model = Model(model.GetModelDetailsAsJson());
+    // Audio is transcribed once for the whole batch on this thread, so the rendering tasks below
+    // never block a scheduler thread on a transcription request.
+    const auto transcribed = PromptManager::TranscribeAudioColumns(batch);
+
+    // A round is sent in waves of at most flock_max_http_concurrency batches. Each wave is rendered
+    // on the task scheduler and sent from an I/O thread while the next wave renders; the last wave
+    // is collected on this thread. Wave N + 1 is only sent once wave N - 1 has been processed, so
+    // at most two waves, about twice the concurrency limit, are in flight; while the in-flight
+    // budget is used up, the previous wave is processed first as well. Called from a
+    // RequestExecutor thread, as llm_map does, waves are collected on this thread instead: a wave
+    // submitted to the pool could wait behind this very job and never run.
+    const auto wave_size = std::max<size_t>(RequestExecutor::GetMaxConcurrency(), 1);
+    const bool collect_inline = RequestExecutor::OnWorkerThread();
+    const auto metrics_context = MetricsManager::GetContext();
+    bool usage_limit_reached = false;
+    while (!pending.empty() && !usage_limit_reached) {
         const auto current_round = std::move(pending);
         pending.clear();
 
-        for (const auto& work: current_round) {
-            auto batch_tuples = BuildBatchTuples(tuples, work.start_index, work.batch_size);
-            QueueCompletion(batch_tuples, user_prompt, function_type, attempt_model);
-        }
+        auto process_wave = [&](AsyncWave& wave) {
+            std::vector<nlohmann::json> batch_responses;
+            bool collect_threw_token_error = false;
+            bool collect_threw_usage_limit_error = false;
+            try {
+                if (wave.collected.has_value()) {
+                    batch_responses = wave.collected->get().get<std::vector<nlohmann::json>>();
+                } else {
+                    batch_responses = wave.model->CollectCompletions();
+                    *wave.finished = std::chrono::steady_clock::now();
+                }
+            } catch (const TokenLimitExceededError&) {
+                collect_threw_token_error = true;
+            } catch (const UsageLimitExceededError&) {
+                collect_threw_usage_limit_error = true;
+            }
 
-        std::vector<nlohmann::json> batch_responses;
-        bool collect_threw_token_error = false;
-        bool collect_threw_usage_limit_error = false;
-        try {
-            batch_responses = attempt_model.CollectCompletions();
-        } catch (const TokenLimitExceededError&) {
-            collect_threw_token_error = true;
-        } catch (const UsageLimitExceededError&) {
-            collect_threw_usage_limit_error = true;
-        }
+            if (collect_threw_usage_limit_error) {
+                // Waves already in flight keep their answers, but nothing is retried.
+                for (size_t i = wave.begin; i < wave.end; i++) {
+                    NullBatchRows(current_round[i].start_index, current_round[i].batch_size, responses);
+                }
+                usage_limit_reached = true;
+                return;
+            }
 
-        if (collect_threw_usage_limit_error) {
-            for (const auto& work: current_round) {
-                NullBatchRows(work.start_index, work.batch_size, responses);
+            if (collect_threw_token_error) {
+                for (size_t i = wave.begin; i < wave.end; i++) {
+                    BatchSizeController::OnTokenLimit(model_details, user_prompt, current_round[i].batch_size);
+                    RetryOrSetOutputToNull(current_round[i], pending, responses, oversized_rows);
+                }
+                return;
+            }
+
+            const auto wave_batches = wave.end - wave.begin;
+            if (batch_responses.size() != wave_batches) {
+                throw std::runtime_error(duckdb_fmt::format("Expected {} completion batch responses, got {}",
+                                                            wave_batches, batch_responses.size()));
             }
-            break;
-        }
 
-        if (collect_threw_token_error) {
-            for (const auto& work: current_round) {
-                RetryOrSetOutputToNull(work, pending, responses);
+            // The batches of a wave run concurrently, so the wave's latency, from sending to the last
+            // response and not to when this thread got to it, is that of its slowest batch. It is
+            // recorded once per wave, for the wave's largest successful batch.
+            const std::chrono::duration<double, std::milli> elapsed = *wave.finished - wave.started;
+            int largest_success = 0;
+            std::vector<std::optional<nlohmann::json>> decoded(wave_batches);
+            RunOnScheduler(wave_batches, [&](const size_t i) {
+                if (!IsTokenLimitExceededMarker(batch_responses[i])) {
+                    decoded[i] = DecodeItems(batch_responses[i], wave.encodings[i],
+                                             current_round[wave.begin + i].batch_size);
+                }
+            });
+            for (size_t i = 0; i < wave_batches; i++) {
+                const auto& work = current_round[wave.begin + i];
+                if (IsTokenLimitExceededMarker(batch_responses[i])) {
+                    BatchSizeController::OnTokenLimit(model_details, user_prompt, work.batch_size);
+                    RetryOrSetOutputToNull(work, pending, responses, oversized_rows);
+                } else if (decoded[i].has_value()) {
+                    WriteBatchResponseToResults(nlohmann::json{{"items", *decoded[i]}}, work.start_index,
+                                                work.batch_size, responses);
+                    largest_success = std::max(largest_success, work.batch_size);
+                } else {
+                    pending.push_back({work.start_index, work.batch_size, true});
+                }
+            }
+            if (largest_success > 0) {
+                BatchSizeController::OnSuccess(model_details, user_prompt, largest_success, elapsed.count(),
+                                               max_batch_size);
+            }
+        };
+
+        // Batches not yet sent when the usage limit is reached keep their NULL rows.
+        std::deque<AsyncWave> waves;
+        size_t next_batch = 0;
+        while (next_batch < current_round.size() && !usage_limit_reached) {
+            AsyncWave wave;
+            wave.begin = next_batch;
+            wave.end = std::min(next_batch + wave_size, current_round.size());
+            next_batch = wave.end;
+
+            std::vector<RenderedCompletion> rendered(wave.end - wave.begin);
+            RunOnScheduler(rendered.size(), [&](const size_t i) {
+                const auto& work = current_round[wave.begin + i];
+                rendered[i] = RenderCompletion(transcribed.Slice(work.start_index, work.batch_size).ToJson(),
+                                               user_prompt, function_type, model.GetModelDetails(), !work.force_json);
+            });
+
+            while (waves.size() > 1 || (!waves.empty() && InflightBudget::IsExhausted())) {
+                process_wave(waves.front());
+                waves.pop_front();
+            }
+            if (usage_limit_reached) {
+                break;
             }
+
+            wave.model = std::make_shared<Model>(model.WithFreshProvider());
+            for (const auto& request: rendered) {
+                QueueRendered(request, user_prompt, *wave.model);
+                wave.encodings.push_back(request.output_encoding);
+            }
+            wave.started = std::chrono::steady_clock::now();
+            if (wave.end < current_round.size() && !collect_inline) {
+                wave.collected = RequestExecutor::Submit([wave_model = wave.model, finished = wave.finished,
+                                                          metrics_context]() {
+                    MetricsManager::ScopedContext scope(metrics_context);
+                    auto wave_responses = nlohmann::json(wave_model->CollectCompletions());
+                    *finished = std::chrono::steady_clock::now();
+                    return wave_responses;
+                });
+            }
+            waves.push_back(std::move(wave));
+        }
+        while (!waves.empty()) {
+            process_wave(waves.front());
+            waves.pop_front();
+        }
+    }
+
+    if (!oversized_rows.empty() && !usage_limit_reached) {
+        const auto answers = LongInput::CompleteRows(transcribed, oversized_rows, user_prompt, function_type, model);
+        for (size_t i = 0; i < oversized_rows.size(); i++) {
+            responses[oversized_rows[i]] = answers[i];
+        }
+    }
+
+    return responses;
+}
+
+nlohmann::json ScalarFunctionBase::BatchAndComplete(const ContextColumnBatch& batch,
+                                                    const std::string& user_prompt,
+                                                    const ScalarFunctionType function_type, Model& model) {
+    const auto row_count = batch.empty() ? 0 : batch.row_count;
+    const auto& empty_input_default = model.GetModelDetails().empty_input_default;
+
+    // Each distinct non-empty row is completed once; `source_rows[i]` is the distinct row
+    // that answers row i, or row_count for empty rows.
+    std::vector<size_t> distinct_rows;
+    std::vector<size_t> source_rows(row_count, row_count);
+    std::unordered_map<std::string, size_t> distinct_index;
+    for (size_t row = 0; row < row_count; row++) {
+        if (batch.IsEmptyRow(row)) {
             continue;
         }
+        const auto [it, inserted] = distinct_index.emplace(RowKey(batch, row), distinct_rows.size());
+        if (inserted) {
+            distinct_rows.push_back(row);
+        }
+        source_rows[row] = it->second;
+    }
+
+    if (distinct_rows.size() == row_count) {
+        return CompleteWithCache(batch, user_prompt, function_type, model);
+    }
+
+    auto distinct_responses = nlohmann::json::array();
+    if (!distinct_rows.empty()) {
+        distinct_responses =
+                CompleteWithCache(batch.Select(distinct_rows), user_prompt, function_type, model);
+    }
+
+    auto responses = nlohmann::json::array();
+    for (size_t row = 0; row < row_count; row++) {
+        const auto source = source_rows[row];
+        if (source == row_count) {
+            responses.push_back(empty_input_default);
+        } else {
+            responses.push_back(source < distinct_responses.size() ? distinct_responses[source] : nullptr);
+        }
+    }
+    return responses;
+}
+
+nlohmann::json ScalarFunctionBase::CompleteWithCache(const ContextColumnBatch& batch,
+                                                     const std::string& user_prompt,
+                                                     const ScalarFunctionType function_type, Model& model) {
+    const auto& model_details = model.GetModelDetails();
+    if (model_details.cache == CacheMode::OFF) {
+        return DispatchBatches(batch, user_prompt, function_type, model);
+    }
 
-        if (batch_responses.size() != current_round.size()) {
-            throw std::runtime_error(
-                    duckdb_fmt::format("Expected {} completion batch responses, got {}",
-                                       current_round.size(), batch_responses.size()));
+    // Only rows without a cached answer are sent to the provider.
+    const auto cache_keys = ResultCache::CompletionKeys(model_details, user_prompt, function_type, batch);
+    const auto cached = ResultCache::Lookup(cache_keys);
+
+    auto responses = nlohmann::json::array();
+    std::vector<size_t> miss_rows;
+    for (size_t i = 0; i < cached.size(); i++) {
+        responses.push_back(cached[i].value_or(nullptr));
+        if (!cached[i].has_value()) {
+            miss_rows.push_back(i);
         }
+    }
+    if (miss_rows.empty()) {
+        return responses;
+    }
 
-        for (size_t i = 0; i < current_round.size(); i++) {
-            const auto& work = current_round[i];
-            if (IsTokenLimitExceededMarker(batch_responses[i])) {
-                RetryOrSetOutputToNull(work, pending, responses);
-            } else {
-                WriteBatchResponseToResults(batch_responses[i], work.start_index, work.batch_size, responses);
+    // Exact misses may still reuse the answer of a near-duplicate row.
+    std::string semantic_namespace;
+    std::vector<std::vector<float>> miss_embeddings;
+    if (model_details.semantic_cache.has_value()) {
+        const auto& semantic_cache = *model_details.semantic_cache;
+        semantic_namespace = SemanticCache::Namespace(model_details, user_prompt, function_type);
+        const auto embeddings =
+                SemanticCache::Embed(semantic_cache.embedding_model, SemanticCache::RowTexts(batch, miss_rows));
+        const auto matches = SemanticCache::Lookup(semantic_namespace, embeddings, semantic_cache.threshold);
+
+        std::vector<size_t> remaining_rows;
+        int64_t rejections = 0;
+        for (size_t i = 0; i < miss_rows.size(); i++) {
+            if (matches[i].answer.has_value()) {
+                responses[miss_rows[i]] = *matches[i].answer;
+                continue;
+            }
+            if (matches[i].RejectedByThreshold()) {
+                rejections++;
             }
+            remaining_rows.push_back(miss_rows[i]);
+            miss_embeddings.push_back(embeddings[i]);
+        }
+        MetricsManager::AddSemanticCacheStats(static_cast<int64_t>(miss_rows.size() - remaining_rows.size()),
+                                              static_cast<int64_t>(remaining_rows.size()), rejections);
+        miss_rows = std::move(remaining_rows);
+        if (miss_rows.empty()) {
+            return responses;
         }
     }
 
+    const auto miss_responses =
+            DispatchBatches(batch.Select(miss_rows), user_prompt, function_type, model);
+
+    std::vector<std::pair<std::string, nlohmann::json>> new_entries;
+    std::vector<std::vector<float>> new_embeddings;
+    std::vector<nlohmann::json> new_answers;
+    for (size_t i = 0; i < miss_rows.size() && i < miss_responses.size(); i++) {
+        responses[miss_rows[i]] = miss_responses[i];
+        if (model_details.cache == CacheMode::READWRITE && !miss_responses[i].is_null()) {
+            new_entries.emplace_back(cache_keys[miss_rows[i]], miss_responses[i]);
+            if (!miss_embeddings.empty()) {
+                new_embeddings.push_back(miss_embeddings[i]);
+                new_answers.push_back(miss_responses[i]);
+            }
+        }
+    }
+    ResultCache::Store(new_entries);
+    if (!new_embeddings.empty()) {
+        SemanticCache::Insert(semantic_namespace, new_embeddings, new_answers);
+    }
+
     return responses;
 }
 
-nlohmann::json ScalarFunctionBase::BatchAndComplete(const nlohmann::json& tuples,
-                                                    const std::string& user_prompt,
-                                                    const ScalarFunctionType function_type, Model& model) {
-    if (model.GetModelDetails().is_async) {
-        return BatchAndCompleteAsync(tuples, user_prompt, function_type, model);
+nlohmann::json ScalarFunctionBase::DispatchBatches(const ContextColumnBatch& batch,
+                                                   const std::string& user_prompt,
+                                                   const ScalarFunctionType function_type, Model& model) {
+    const auto& model_details = model.GetModelDetails();
+    auto responses = model_details.is_async ? BatchAndCompleteAsync(batch, user_prompt, function_type, model)
+                                            : BatchAndCompleteSync(batch, user_prompt, function_type, model);
+
+    if (function_type == ScalarFunctionType::COMPLETE && model_details.output_token_budget) {
+        OutputTokenBudget::Observe(model_details, user_prompt, responses);
     }
 
-    return BatchAndCompleteSync(tuples, user_prompt, function_type, model);
+    return responses;
 }
 
 void ScalarFunctionBase::InitializePrompt(
@@ -361,6 +739,22 @@ duckdb::unique_ptr<LlmFunctionBindData> ScalarFunctionBase::ValidateAndInitializ
     auto bind_data = duckdb::make_uniq<LlmFunctionBindData>();
 
     InitializeModelJson(context, arguments[0], *bind_data);
+    if (function_name != "llm_filter") {
+        if (!bind_data->cascade_model_json.is_null()) {
+            throw duckdb::BinderException(function_name + ": the 'cascade' option is only supported by llm_filter.");
+        }
+        if (!bind_data->distill_json.is_null()) {
+            throw duckdb::BinderException(function_name + ": the 'distill' option is only supported by llm_filter.");
+        }
+    }
+    if (!bind_data->classifier_json.is_null()) {
+        if (function_name != "llm_filter" && function_name != "llm_complete") {
+            throw duckdb::BinderException(function_name +
+                                          ": the 'classifier' option is only supported by llm_filter and llm_complete.");
+        }
+        bind_data->distilled_classifier = std::make_shared<DistilledClassifier>(
+                DistilledClassifier::ParseOptions(bind_data->classifier_json, function_name));
+    }
     if (initialize_prompt) {
         InitializePrompt(context, arguments[1], *bind_data);
     }
@@ -0,0 +1,384 @@
+#include "flock/functions/table/flock_topk_similar.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/parser/parser.hpp"
+#include "duckdb/parser/qualified_name.hpp"
+#include "duckdb/parser/statement/select_statement.hpp"
+#include "duckdb/parser/tableref/subqueryref.hpp"
+#include "flock/core/vector_math.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace flock {
+
+namespace {
+
+// Reads rows of a LIST(FLOAT) vector. Rows of a flat child vector without NULLs are returned in
+// place; anything else is copied into a buffer that stays valid until the next Read.
+class FloatListReader {
+public:
+    FloatListReader(duckdb::Vector& lists, const idx_t count) {
+        lists.ToUnifiedFormat(count, list_format_);
+        duckdb::ListVector::GetEntry(lists).ToUnifiedFormat(duckdb::ListVector::GetListSize(lists), child_format_);
+        entries_ = duckdb::UnifiedVectorFormat::GetData<duckdb::list_entry_t>(list_format_);
+        values_ = duckdb::UnifiedVectorFormat::GetData<float>(child_format_);
+        in_place_ = !child_format_.sel->IsSet() && child_format_.validity.AllValid();
+    }
+
+    // Null for a NULL list.
+    const float* Read(const idx_t row, idx_t& length) {
+        const auto index = list_format_.sel->get_index(row);
+        if (!list_format_.validity.RowIsValid(index)) {
+            return nullptr;
+        }
+        const auto& entry = entries_[index];
+        length = entry.length;
+        if (in_place_) {
+            return values_ + entry.offset;
+        }
+        buffer_.resize(entry.length);
+        for (idx_t i = 0; i < entry.length; i++) {
+            const auto child_index = child_format_.sel->get_index(entry.offset + i);
+            if (!child_format_.validity.RowIsValid(child_index)) {
+                throw std::runtime_error("flock_topk_similar: embeddings must not contain NULL values.");
+            }
+            buffer_[i] = values_[child_index];
+        }
+        return buffer_.data();
+    }
+
+private:
+    duckdb::UnifiedVectorFormat list_format_;
+    duckdb::UnifiedVectorFormat child_format_;
+    const duckdb::list_entry_t* entries_ = nullptr;
+    const float* values_ = nullptr;
+    bool in_place_ = false;
+    std::vector<float> buffer_;
+};
+
+std::string QuoteTableName(const std::string& table) {
+    const auto name = duckdb::QualifiedName::Parse(table);
+    std::string quoted;
+    if (!name.catalog.empty()) {
+        quoted += duckdb::KeywordHelper::WriteOptionallyQuoted(name.catalog) + ".";
+    }
+    if (!name.schema.empty()) {
+        quoted += duckdb::KeywordHelper::WriteOptionallyQuoted(name.schema) + ".";
+    }
+    return quoted + duckdb::KeywordHelper::WriteOptionallyQuoted(name.name);
+}
+
+std::string FloatListLiteral(const duckdb::Value& value) {
+    std::string literal = "[";
+    for (const auto& child: duckdb::ListValue::GetChildren(value.DefaultCastAs(duckdb::LogicalType::LIST(duckdb::LogicalType::FLOAT)))) {
+        const auto element = child.IsNull() ? NAN : child.GetValue<float>();
+        if (!std::isfinite(element)) {
+            throw duckdb::BinderException("flock_topk_similar: the query embedding must only contain finite numbers.");
+        }
+        literal += (literal.size() > 1 ? ", " : "") + duckdb_fmt::format("{}", element);
+    }
+    return literal + "]::FLOAT[]";
+}
+
+bool ByScoreDescending(const TopkSimilarState::Candidate& left, const TopkSimilarState::Candidate& right) {
+    return left.score > right.score;
+}
+
+}// namespace
+
+duckdb::unique_ptr<duckdb::TableRef> FlockTopkSimilar::BindReplace(duckdb::ClientContext& context,
+                                                                   duckdb::TableFunctionBindInput& input) {
+    if (input.inputs.size() != 3) {
+        throw duckdb::BinderException("flock_topk_similar expects a query embedding, a table name and k.");
+    }
+    if (input.inputs[0].IsNull() || input.inputs[1].IsNull() || input.inputs[2].IsNull()) {
+        throw duckdb::BinderException("flock_topk_similar: the query embedding, table name and k must not be NULL.");
+    }
+    const auto k = input.inputs[2].GetValue<int64_t>();
+    if (k <= 0) {
+        throw duckdb::BinderException("flock_topk_similar: k must be larger than 0.");
+    }
+
+    std::string column = DEFAULT_COLUMN;
+    std::string metric = "cosine";
+    std::string rescore_column;
+    for (const auto& [name, value]: input.named_parameters) {
+        if (name == "column") {
+            column = value.GetValue<std::string>();
+        } else if (name == "metric") {
+            metric = value.GetValue<std::string>();
+        } else if (name == "rescore") {
+            rescore_column = value.GetValue<std::string>();
+        }
+    }
+    ParseMetric(metric);
+
+    // The row alias doubles as a STRUCT of the whole row, which the aggregate carries to the output.
+    const std::string row = "__flock_row";
+    std::string arguments = duckdb_fmt::format("{}, {}.{}, {}, {}, {}", row, row,
+                                               duckdb::KeywordHelper::WriteOptionallyQuoted(column),
+                                               FloatListLiteral(input.inputs[0]), k,
+                                               duckdb::KeywordHelper::WriteQuoted(metric, '\''));
+    if (!rescore_column.empty()) {
+        arguments += duckdb_fmt::format(", {}.{}", row, duckdb::KeywordHelper::WriteOptionallyQuoted(rescore_column));
+    }
+    const auto query = duckdb_fmt::format(
+            "SELECT unnest(__flock_match.value), __flock_match.score AS score "
+            "FROM (SELECT unnest({}({})) AS __flock_match FROM {} AS {}) ORDER BY score DESC",
+            AGGREGATE_NAME, arguments, QuoteTableName(input.inputs[1].GetValue<std::string>()), row);
+
+    duckdb::Parser parser;
+    parser.ParseQuery(query);
+    if (parser.statements.size() != 1 || parser.statements[0]->type != duckdb::StatementType::SELECT_STATEMENT) {
+        throw duckdb::BinderException("flock_topk_similar: could not build the similarity query.");
+    }
+    auto select = duckdb::unique_ptr_cast<duckdb::SQLStatement, duckdb::SelectStatement>(std::move(parser.statements[0]));
+    return duckdb::make_uniq<duckdb::SubqueryRef>(std::move(select));
+}
+
+SimilarityMetric FlockTopkSimilar::ParseMetric(const std::string& metric) {
+    if (metric == "cosine") {
+        return SimilarityMetric::COSINE;
+    }
+    if (metric == "dot") {
+        return SimilarityMetric::DOT;
+    }
+    throw duckdb::BinderException("flock_topk_similar: metric must be 'cosine' or 'dot', got '" + metric + "'.");
+}
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockTopkSimilar::Bind(
+        duckdb::ClientContext& context, duckdb::AggregateFunction& function,
+        duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
+    if (arguments.size() != 5 && arguments.size() != 6) {
+        throw duckdb::BinderException(
+                "flock_topk_similar_agg expects (value, embedding, query, k, metric[, rescore_embedding]).");
+    }
+    for (idx_t i = 2; i < 5; i++) {
+        if (!arguments[i]->IsFoldable()) {
+            throw duckdb::BinderException("flock_topk_similar_agg: query, k and metric must be constants.");
+        }
+    }
+    const auto float_list = duckdb::LogicalType::LIST(duckdb::LogicalType::FLOAT);
+    const auto query_value = duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[2]);
+    const auto k_value = duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[3]);
+    const auto metric_value = duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[4]);
+    if (query_value.IsNull() || k_value.IsNull() || metric_value.IsNull()) {
+        throw duckdb::BinderException("flock_topk_similar_agg: query, k and metric must not be NULL.");
+    }
+
+    auto bind_data = duckdb::make_uniq<TopkSimilarBindData>();
+    for (const auto& element: duckdb::ListValue::GetChildren(query_value.DefaultCastAs(float_list))) {
+        if (element.IsNull()) {
+            throw duckdb::BinderException("flock_topk_similar_agg: the query embedding must not contain NULL values.");
+        }
+        bind_data->query.push_back(element.GetValue<float>());
+    }
+    if (bind_data->query.empty()) {
+        throw duckdb::BinderException("flock_topk_similar_agg: the query embedding must not be empty.");
+    }
+    const auto k = k_value.GetValue<int64_t>();
+    if (k <= 0) {
+        throw duckdb::BinderException("flock_topk_similar_agg: k must be larger than 0.");
+    }
+    bind_data->k = static_cast<idx_t>(k);
+    bind_data->metric = ParseMetric(metric_value.ToString());
+    bind_data->rescore = arguments.size() == 6;
+    bind_data->capacity = bind_data->k * (bind_data->rescore ? RESCORE_FACTOR : 1);
+
+    const auto dims = bind_data->query.size();
+    bind_data->query_int8 = FlockQuantizeEmbedding::Quantize(bind_data->query.data(), dims, EmbeddingEncoding::INT8);
+    bind_data->query_binary = FlockQuantizeEmbedding::Quantize(bind_data->query.data(), dims, EmbeddingEncoding::BINARY);
+    const auto query_codes = reinterpret_cast<const int8_t*>(bind_data->query_int8.data() + FlockQuantizeEmbedding::HEADER_SIZE);
+    bind_data->query_int8_norm = std::sqrt(static_cast<double>(VectorMath::DotInt8(query_codes, query_codes, dims)));
+    if (bind_data->metric == SimilarityMetric::COSINE) {
+        VectorMath::Normalize(bind_data->query);
+    }
+
+    const auto& value_type = arguments[0]->return_type;
+    const auto embedding_type =
+            arguments[1]->return_type.id() == duckdb::LogicalTypeId::BLOB ? duckdb::LogicalType::BLOB : float_list;
+    function.arguments = {value_type, embedding_type, float_list, duckdb::LogicalType::BIGINT,
+                          duckdb::LogicalType::VARCHAR};
+    if (bind_data->rescore) {
+        function.arguments.push_back(float_list);
+    }
+    function.return_type = duckdb::LogicalType::LIST(
+            duckdb::LogicalType::STRUCT({{"value", value_type}, {"score", duckdb::LogicalType::DOUBLE}}));
+    return std::move(bind_data);
+}
+
+double FlockTopkSimilar::Score(const TopkSimilarBindData& bind_data, const float* embedding, const idx_t dims) {
+    if (dims != bind_data.query.size()) {
+        throw std::runtime_error(duckdb_fmt::format(
+                "flock_topk_similar: the query has {} dimensions but an embedding has {}.", bind_data.query.size(), dims));
+    }
+    const auto dot = VectorMath::Dot(bind_data.query.data(), embedding, dims);
+    if (bind_data.metric == SimilarityMetric::DOT) {
+        return dot;
+    }
+    const auto norm = std::sqrt(VectorMath::Dot(embedding, embedding, dims));
+    return norm == 0.0f ? 0.0 : dot / norm;
+}
+
+double FlockTopkSimilar::Score(const TopkSimilarBindData& bind_data, const QuantizedEmbedding& embedding) {
+    if (embedding.dims != bind_data.query.size()) {
+        throw std::runtime_error(duckdb_fmt::format("flock_topk_similar: the query has {} dimensions but an embedding has {}.",
+                                                    bind_data.query.size(), embedding.dims));
+    }
+    const auto dims = embedding.dims;
+    if (embedding.encoding == EmbeddingEncoding::BINARY) {
+        const auto query = reinterpret_cast<const uint8_t*>(bind_data.query_binary.data() + FlockQuantizeEmbedding::HEADER_SIZE);
+        return 1.0 - static_cast<double>(VectorMath::Hamming(query, embedding.data, (dims + 7) / 8)) / dims;
+    }
+
+    const auto query = FlockQuantizeEmbedding::Parse(bind_data.query_int8.data(), bind_data.query_int8.size());
+    const auto codes = reinterpret_cast<const int8_t*>(embedding.data);
+    const auto dot = static_cast<double>(VectorMath::DotInt8(reinterpret_cast<const int8_t*>(query.data), codes, dims));
+    if (bind_data.metric == SimilarityMetric::DOT) {
+        return dot * query.scale * embedding.scale;
+    }
+    const auto norms = bind_data.query_int8_norm * std::sqrt(static_cast<double>(VectorMath::DotInt8(codes, codes, dims)));
+    return norms == 0.0 ? 0.0 : dot / norms;
+}
+
+void FlockTopkSimilar::Initialize(const duckdb::AggregateFunction&, duckdb::data_ptr_t state_p) {
+    auto state = reinterpret_cast<TopkSimilarState*>(state_p);
+    state->candidates = new std::vector<TopkSimilarState::Candidate>();
+}
+
+void FlockTopkSimilar::AddCandidate(TopkSimilarState& state, const idx_t capacity,
+                                    TopkSimilarState::Candidate candidate) {
+    auto& candidates = *state.candidates;
+    if (candidates.size() >= capacity) {
+        if (candidate.score <= candidates.front().score) {
+            return;
+        }
+        std::pop_heap(candidates.begin(), candidates.end(), ByScoreDescending);
+        candidates.pop_back();
+    }
+    candidates.push_back(std::move(candidate));
+    std::push_heap(candidates.begin(), candidates.end(), ByScoreDescending);
+}
+
+template<class STATE_OF_ROW>
+void FlockTopkSimilar::AddRows(duckdb::Vector inputs[], const TopkSimilarBindData& bind_data, const idx_t input_count,
+                               const idx_t count, STATE_OF_ROW state_of_row) {
+    auto& embeddings = inputs[1];
+    const bool quantized = embeddings.GetType().id() == duckdb::LogicalTypeId::BLOB;
+    duckdb::UnifiedVectorFormat blob_format;
+    std::optional<FloatListReader> float_reader;
+    if (quantized) {
+        embeddings.ToUnifiedFormat(count, blob_format);
+    } else {
+        float_reader.emplace(embeddings, count);
+    }
+    std::optional<FloatListReader> rescore_reader;
+    if (bind_data.rescore) {
+        rescore_reader.emplace(inputs[input_count - 1], count);
+    }
+
+    for (idx_t row = 0; row < count; row++) {
+        double score;
+        if (quantized) {
+            const auto index = blob_format.sel->get_index(row);
+            if (!blob_format.validity.RowIsValid(index)) {
+                continue;
+            }
+            const auto blob = duckdb::UnifiedVectorFormat::GetData<duckdb::string_t>(blob_format)[index];
+            score = Score(bind_data, FlockQuantizeEmbedding::Parse(blob.GetData(), blob.GetSize()));
+        } else {
+            idx_t dims = 0;
+            const auto* values = float_reader->Read(row, dims);
+            if (!values) {
+                continue;
+            }
+            score = Score(bind_data, values, dims);
+        }
+
+        // Most rows lose against a full heap; only the survivors pay for materializing their value.
+        auto& state = state_of_row(row);
+        if (state.candidates->size() >= bind_data.capacity && score <= state.candidates->front().score) {
+            continue;
+        }
+        TopkSimilarState::Candidate candidate{score, inputs[0].GetValue(row), {}};
+        if (rescore_reader) {
+            idx_t dims = 0;
+            if (const auto* values = rescore_reader->Read(row, dims)) {
+                candidate.rescore_embedding.assign(values, values + dims);
+            }
+        }
+        AddCandidate(state, bind_data.capacity, std::move(candidate));
+    }
+}
+
+void FlockTopkSimilar::Update(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data,
+                              const idx_t input_count, duckdb::Vector& states, const idx_t count) {
+    const auto& bind_data = aggr_input_data.bind_data->Cast<TopkSimilarBindData>();
+    duckdb::UnifiedVectorFormat state_format;
+    states.ToUnifiedFormat(count, state_format);
+    const auto state_pointers = duckdb::UnifiedVectorFormat::GetData<TopkSimilarState*>(state_format);
+    AddRows(inputs, bind_data, input_count, count, [&](const idx_t row) -> TopkSimilarState& {
+        return *state_pointers[state_format.sel->get_index(row)];
+    });
+}
+
+void FlockTopkSimilar::SimpleUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data,
+                                    const idx_t input_count, duckdb::data_ptr_t state_p, const idx_t count) {
+    const auto& bind_data = aggr_input_data.bind_data->Cast<TopkSimilarBindData>();
+    auto& state = *reinterpret_cast<TopkSimilarState*>(state_p);
+    AddRows(inputs, bind_data, input_count, count, [&](const idx_t) -> TopkSimilarState& { return state; });
+}
+
+void FlockTopkSimilar::Combine(duckdb::Vector& source, duckdb::Vector& target,
+                               duckdb::AggregateInputData& aggr_input_data, const idx_t count) {
+    const auto& bind_data = aggr_input_data.bind_data->Cast<TopkSimilarBindData>();
+    const auto sources = duckdb::FlatVector::GetData<TopkSimilarState*>(source);
+    const auto targets = duckdb::FlatVector::GetData<TopkSimilarState*>(target);
+    for (idx_t i = 0; i < count; i++) {
+        // Sources are copied rather than moved: DuckDB may combine the same state more than once.
+        for (const auto& candidate: *sources[i]->candidates) {
+            AddCandidate(*targets[i], bind_data.capacity, candidate);
+        }
+    }
+}
+
+void FlockTopkSimilar::Finalize(duckdb::Vector& states, duckdb::AggregateInputData& aggr_input_data,
+                                duckdb::Vector& result, const idx_t count, const idx_t offset) {
+    const auto& bind_data = aggr_input_data.bind_data->Cast<TopkSimilarBindData>();
+    const auto state_pointers = duckdb::FlatVector::GetData<TopkSimilarState*>(states);
+    const auto& entry_type = duckdb::ListType::GetChildType(result.GetType());
+    for (idx_t i = 0; i < count; i++) {
+        auto candidates = *state_pointers[i]->candidates;
+        if (bind_data.rescore) {
+            for (auto& candidate: candidates) {
+                if (!candidate.rescore_embedding.empty()) {
+                    candidate.score = Score(bind_data, candidate.rescore_embedding.data(),
+                                            candidate.rescore_embedding.size());
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), ByScoreDescending);
+        candidates.resize(std::min<size_t>(candidates.size(), bind_data.k));
+
+        duckdb::vector<duckdb::Value> entries;
+        entries.reserve(candidates.size());
+        for (auto& candidate: candidates) {
+            entries.push_back(duckdb::Value::STRUCT(
+                    entry_type, {std::move(candidate.value), duckdb::Value::DOUBLE(candidate.score)}));
+        }
+        result.SetValue(offset + i, duckdb::Value::LIST(entry_type, std::move(entries)));
+    }
+}
+
+void FlockTopkSimilar::Destroy(duckdb::Vector& states, duckdb::AggregateInputData&, const idx_t count) {
+    const auto state_pointers = duckdb::FlatVector::GetData<TopkSimilarState*>(states);
+    for (idx_t i = 0; i < count; i++) {
+        delete state_pointers[i]->candidates;
+        state_pointers[i]->candidates = nullptr;
+    }
+}
+
+}// namespace flock
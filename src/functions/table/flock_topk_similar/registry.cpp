@@ -0,0 +1,31 @@
+#include "flock/functions/table/flock_topk_similar.hpp"
+#include "flock/registry/registry.hpp"
+
+namespace flock {
+
+void TableRegistry::RegisterFlockTopkSimilar(duckdb::ExtensionLoader& loader) {
+    duckdb::AggregateFunctionSet aggregates(FlockTopkSimilar::AGGREGATE_NAME);
+    duckdb::vector<duckdb::LogicalType> arguments = {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY,
+                                                     duckdb::LogicalType::ANY, duckdb::LogicalType::BIGINT,
+                                                     duckdb::LogicalType::VARCHAR};
+    for (auto i = 0; i < 2; i++) {
+        aggregates.AddFunction(duckdb::AggregateFunction(
+                arguments, duckdb::LogicalType::ANY, duckdb::AggregateFunction::StateSize<TopkSimilarState>,
+                FlockTopkSimilar::Initialize, FlockTopkSimilar::Update, FlockTopkSimilar::Combine,
+                FlockTopkSimilar::Finalize, FlockTopkSimilar::SimpleUpdate, FlockTopkSimilar::Bind,
+                FlockTopkSimilar::Destroy));
+        arguments.push_back(duckdb::LogicalType::ANY);
+    }
+    loader.RegisterFunction(aggregates);
+
+    duckdb::TableFunction function(FlockTopkSimilar::FUNCTION_NAME,
+                                   {duckdb::LogicalType::ANY, duckdb::LogicalType::VARCHAR, duckdb::LogicalType::BIGINT},
+                                   nullptr);
+    function.bind_replace = FlockTopkSimilar::BindReplace;
+    function.named_parameters["column"] = duckdb::LogicalType::VARCHAR;
+    function.named_parameters["metric"] = duckdb::LogicalType::VARCHAR;
+    function.named_parameters["rescore"] = duckdb::LogicalType::VARCHAR;
+    loader.RegisterFunction(function);
+}
+
+}// namespace flock
@@ -0,0 +1,221 @@
+#include "flock/functions/table/flock_vector_index.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/parser/parser.hpp"
+#include "duckdb/parser/statement/select_statement.hpp"
+#include "duckdb/parser/tableref/subqueryref.hpp"
+#include "flock/functions/input_parser.hpp"
+#include "flock/model_manager/model.hpp"
+
+#include <algorithm>
+
+namespace flock {
+
+std::string FlockVectorIndex::GetIndexName(const duckdb::TableFunctionBindInput& input,
+                                           const std::string& function_name) {
+    if (input.inputs.empty() || input.inputs[0].IsNull()) {
+        throw duckdb::BinderException(function_name + ": the index name must not be NULL.");
+    }
+    return input.inputs[0].GetValue<std::string>();
+}
+
+void FlockVectorIndex::BindSearchSize(const duckdb::TableFunctionBindInput& input, VectorIndexBindData& bind_data) {
+    if (input.inputs[1].IsNull() || input.inputs[2].IsNull()) {
+        throw duckdb::BinderException("flock_knn: the query and k must not be NULL.");
+    }
+    const auto k = input.inputs[2].GetValue<int64_t>();
+    if (k <= 0) {
+        throw duckdb::BinderException("flock_knn: k must be larger than 0.");
+    }
+    bind_data.k = static_cast<idx_t>(k);
+    bind_data.ef_search = std::max<idx_t>(bind_data.k, VectorIndex::DEFAULT_EF_SEARCH);
+    for (const auto& [name, value]: input.named_parameters) {
+        if (name == "ef_search") {
+            const auto ef_search = value.GetValue<int64_t>();
+            if (ef_search <= 0) {
+                throw duckdb::BinderException("flock_knn: 'ef_search' must be larger than 0.");
+            }
+            bind_data.ef_search = std::max<idx_t>(bind_data.k, static_cast<idx_t>(ef_search));
+        }
+    }
+}
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockVectorIndex::BindCreate(duckdb::ClientContext& context,
+                                                                      duckdb::TableFunctionBindInput& input,
+                                                                      duckdb::vector<duckdb::LogicalType>& return_types,
+                                                                      duckdb::vector<std::string>& names) {
+    for (idx_t i = 0; i < 4; i++) {
+        if (input.inputs[i].IsNull()) {
+            throw duckdb::BinderException(
+                    "flock_create_index: the index name, table, key column and embedding column must not be NULL.");
+        }
+    }
+    auto bind_data = duckdb::make_uniq<VectorIndexBindData>();
+    bind_data->definition.name = input.inputs[0].GetValue<std::string>();
+    bind_data->definition.table = input.inputs[1].GetValue<std::string>();
+    bind_data->definition.key_column = input.inputs[2].GetValue<std::string>();
+    bind_data->definition.embedding_column = input.inputs[3].GetValue<std::string>();
+    if (input.inputs.size() > 4) {
+        if (input.inputs[4].type().id() != duckdb::LogicalTypeId::STRUCT) {
+            throw duckdb::BinderException("flock_create_index: model details must be a struct.");
+        }
+        // Resolving the model now reports unknown models before the index is built.
+        const auto model_json = CastValueToJson(input.inputs[4]);
+        Model::ResolveModelDetailsToJson(model_json);
+        bind_data->definition.model = model_json;
+    }
+
+    return_types = {duckdb::LogicalType::VARCHAR, duckdb::LogicalType::BIGINT};
+    names = {"index_name", "indexed_rows"};
+    return std::move(bind_data);
+}
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockVectorIndex::BindUpdate(duckdb::ClientContext& context,
+                                                                      duckdb::TableFunctionBindInput& input,
+                                                                      duckdb::vector<duckdb::LogicalType>& return_types,
+                                                                      duckdb::vector<std::string>& names) {
+    auto bind_data = duckdb::make_uniq<VectorIndexBindData>();
+    bind_data->definition.name = GetIndexName(input, UPDATE_FUNCTION_NAME);
+    return_types = {duckdb::LogicalType::VARCHAR, duckdb::LogicalType::BIGINT};
+    names = {"index_name", "indexed_rows"};
+    return std::move(bind_data);
+}
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockVectorIndex::BindDrop(duckdb::ClientContext& context,
+                                                                    duckdb::TableFunctionBindInput& input,
+                                                                    duckdb::vector<duckdb::LogicalType>& return_types,
+                                                                    duckdb::vector<std::string>& names) {
+    auto bind_data = duckdb::make_uniq<VectorIndexBindData>();
+    bind_data->definition.name = GetIndexName(input, DROP_FUNCTION_NAME);
+    return_types = {duckdb::LogicalType::VARCHAR};
+    names = {"index_name"};
+    return std::move(bind_data);
+}
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockVectorIndex::BindKnnKeys(duckdb::ClientContext& context,
+                                                                       duckdb::TableFunctionBindInput& input,
+                                                                       duckdb::vector<duckdb::LogicalType>& return_types,
+                                                                       duckdb::vector<std::string>& names) {
+    auto bind_data = duckdb::make_uniq<VectorIndexBindData>();
+    bind_data->definition.name = GetIndexName(input, KNN_KEYS_FUNCTION_NAME);
+    BindSearchSize(input, *bind_data);
+
+    const auto& query = input.inputs[1];
+    if (query.type().InternalType() == duckdb::PhysicalType::VARCHAR) {
+        bind_data->query = query.DefaultCastAs(duckdb::LogicalType::VARCHAR);
+    } else if (query.type().id() == duckdb::LogicalTypeId::LIST || query.type().id() == duckdb::LogicalTypeId::ARRAY) {
+        bind_data->query = query.DefaultCastAs(duckdb::LogicalType::LIST(duckdb::LogicalType::FLOAT));
+    } else {
+        throw duckdb::BinderException("flock_knn: the query must be a text or an embedding.");
+    }
+
+    return_types = {duckdb::LogicalType::VARCHAR, duckdb::LogicalType::FLOAT};
+    names = {"row_key", "score"};
+    return std::move(bind_data);
+}
+
+duckdb::unique_ptr<duckdb::TableRef> FlockVectorIndex::BindReplaceKnn(duckdb::ClientContext& context,
+                                                                      duckdb::TableFunctionBindInput& input) {
+    const auto name = GetIndexName(input, KNN_FUNCTION_NAME);
+    VectorIndexBindData search_size;
+    BindSearchSize(input, search_size);
+    const auto definition = VectorIndex::GetDefinition(*context.db, name);
+
+    // Joining on the key column in its own type lets DuckDB push the k matched keys into the
+    // scan of the indexed table instead of reading all of it.
+    const auto query = duckdb_fmt::format(
+            "SELECT __flock_row.*, __flock_knn.score "
+            "FROM {}({}, {}, {}, ef_search := {}) AS __flock_knn "
+            "JOIN {} AS __flock_row ON __flock_row.{} = CAST(__flock_knn.row_key AS {}) "
+            "ORDER BY __flock_knn.score DESC",
+            KNN_KEYS_FUNCTION_NAME, duckdb::Value(name).ToSQLString(), input.inputs[1].ToSQLString(), search_size.k,
+            search_size.ef_search, VectorIndex::QuoteTableName(definition.table),
+            duckdb::KeywordHelper::WriteOptionallyQuoted(definition.key_column), definition.key_type);
+
+    duckdb::Parser parser;
+    parser.ParseQuery(query);
+    if (parser.statements.size() != 1 || parser.statements[0]->type != duckdb::StatementType::SELECT_STATEMENT) {
+        throw duckdb::BinderException("flock_knn: could not build the search query.");
+    }
+    auto select = duckdb::unique_ptr_cast<duckdb::SQLStatement, duckdb::SelectStatement>(std::move(parser.statements[0]));
+    return duckdb::make_uniq<duckdb::SubqueryRef>(std::move(select));
+}
+
+duckdb::unique_ptr<duckdb::GlobalTableFunctionState> FlockVectorIndex::InitGlobal(duckdb::ClientContext& context,
+                                                                                  duckdb::TableFunctionInitInput& input) {
+    return duckdb::make_uniq<VectorIndexGlobalState>();
+}
+
+void FlockVectorIndex::ExecuteCreate(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                                     duckdb::DataChunk& output) {
+    auto& state = data.global_state->Cast<VectorIndexGlobalState>();
+    if (state.done) {
+        return;
+    }
+    state.done = true;
+    const auto& bind_data = data.bind_data->Cast<VectorIndexBindData>();
+    const auto count = VectorIndex::Create(*context.db, bind_data.definition);
+    output.SetValue(0, 0, duckdb::Value(bind_data.definition.name));
+    output.SetValue(1, 0, duckdb::Value::BIGINT(static_cast<int64_t>(count)));
+    output.SetCardinality(1);
+}
+
+void FlockVectorIndex::ExecuteUpdate(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                                     duckdb::DataChunk& output) {
+    auto& state = data.global_state->Cast<VectorIndexGlobalState>();
+    if (state.done) {
+        return;
+    }
+    state.done = true;
+    const auto& name = data.bind_data->Cast<VectorIndexBindData>().definition.name;
+    const auto count = VectorIndex::Update(*context.db, name);
+    output.SetValue(0, 0, duckdb::Value(name));
+    output.SetValue(1, 0, duckdb::Value::BIGINT(static_cast<int64_t>(count)));
+    output.SetCardinality(1);
+}
+
+void FlockVectorIndex::ExecuteDrop(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                                   duckdb::DataChunk& output) {
+    auto& state = data.global_state->Cast<VectorIndexGlobalState>();
+    if (state.done) {
+        return;
+    }
+    state.done = true;
+    const auto& name = data.bind_data->Cast<VectorIndexBindData>().definition.name;
+    VectorIndex::Drop(*context.db, name);
+    output.SetValue(0, 0, duckdb::Value(name));
+    output.SetCardinality(1);
+}
+
+void FlockVectorIndex::ExecuteKnnKeys(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                                      duckdb::DataChunk& output) {
+    auto& state = data.global_state->Cast<VectorIndexGlobalState>();
+    const auto& bind_data = data.bind_data->Cast<VectorIndexBindData>();
+    if (!state.done) {
+        state.done = true;
+        const auto& name = bind_data.definition.name;
+        std::vector<float> query;
+        if (bind_data.query.type().id() == duckdb::LogicalTypeId::VARCHAR) {
+            query = VectorIndex::EmbedQuery(VectorIndex::GetDefinition(*context.db, name),
+                                            bind_data.query.GetValue<std::string>());
+        } else {
+            for (const auto& value: duckdb::ListValue::GetChildren(bind_data.query)) {
+                if (value.IsNull()) {
+                    throw std::runtime_error("flock_knn: the query embedding must not contain NULL values.");
+                }
+                query.push_back(value.GetValue<float>());
+            }
+        }
+        state.matches = VectorIndex::Search(*context.db, name, std::move(query), bind_data.k, bind_data.ef_search);
+    }
+
+    const auto count = std::min<idx_t>(STANDARD_VECTOR_SIZE, state.matches.size() - state.offset);
+    for (idx_t row = 0; row < count; row++) {
+        const auto& match = state.matches[state.offset + row];
+        output.SetValue(0, row, duckdb::Value(match.key));
+        output.SetValue(1, row, duckdb::Value::FLOAT(match.score));
+    }
+    state.offset += count;
+    output.SetCardinality(count);
+}
+
+}// namespace flock
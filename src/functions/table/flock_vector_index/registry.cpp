@@ -0,0 +1,38 @@
+#include "flock/functions/table/flock_vector_index.hpp"
+#include "flock/registry/registry.hpp"
+
+namespace flock {
+
+void TableRegistry::RegisterFlockVectorIndex(duckdb::ExtensionLoader& loader) {
+    const auto varchar = duckdb::LogicalType::VARCHAR;
+
+    duckdb::TableFunctionSet create(FlockVectorIndex::CREATE_FUNCTION_NAME);
+    create.AddFunction(duckdb::TableFunction({varchar, varchar, varchar, varchar}, FlockVectorIndex::ExecuteCreate,
+                                             FlockVectorIndex::BindCreate, FlockVectorIndex::InitGlobal));
+    create.AddFunction(duckdb::TableFunction({varchar, varchar, varchar, varchar, duckdb::LogicalType::ANY},
+                                             FlockVectorIndex::ExecuteCreate, FlockVectorIndex::BindCreate,
+                                             FlockVectorIndex::InitGlobal));
+    loader.RegisterFunction(create);
+
+    loader.RegisterFunction(duckdb::TableFunction(FlockVectorIndex::UPDATE_FUNCTION_NAME, {varchar},
+                                                  FlockVectorIndex::ExecuteUpdate, FlockVectorIndex::BindUpdate,
+                                                  FlockVectorIndex::InitGlobal));
+    loader.RegisterFunction(duckdb::TableFunction(FlockVectorIndex::DROP_FUNCTION_NAME, {varchar},
+                                                  FlockVectorIndex::ExecuteDrop, FlockVectorIndex::BindDrop,
+                                                  FlockVectorIndex::InitGlobal));
+
+    const duckdb::vector<duckdb::LogicalType> search_arguments = {varchar, duckdb::LogicalType::ANY,
+                                                                  duckdb::LogicalType::BIGINT};
+    duckdb::TableFunction knn_keys(FlockVectorIndex::KNN_KEYS_FUNCTION_NAME, search_arguments,
+                                   FlockVectorIndex::ExecuteKnnKeys, FlockVectorIndex::BindKnnKeys,
+                                   FlockVectorIndex::InitGlobal);
+    knn_keys.named_parameters["ef_search"] = duckdb::LogicalType::BIGINT;
+    loader.RegisterFunction(knn_keys);
+
+    duckdb::TableFunction knn(FlockVectorIndex::KNN_FUNCTION_NAME, search_arguments, nullptr);
+    knn.bind_replace = FlockVectorIndex::BindReplaceKnn;
+    knn.named_parameters["ef_search"] = duckdb::LogicalType::BIGINT;
+    loader.RegisterFunction(knn);
+}
+
+}// namespace flock
@@ -0,0 +1,309 @@
+#include "flock/functions/table/llm_map.hpp"
+#include "flock/functions/input_parser.hpp"
+#include "flock/functions/scalar/scalar.hpp"
+#include "flock/metrics/manager.hpp"
+#include "flock/model_manager/request_executor.hpp"
+#include "flock/prompt_manager/prompt_manager.hpp"
+
+#include <algorithm>
+
+namespace flock {
+
+LlmMapLocalState::~LlmMapLocalState() {
+    cancelled->store(true);
+    for (auto& batch: inflight) {
+        if (batch.answers.valid()) {
+            batch.answers.wait();
+        }
+    }
+}
+
+duckdb::unique_ptr<duckdb::FunctionData> LlmMap::Bind(duckdb::ClientContext& context,
+                                                      duckdb::TableFunctionBindInput& input,
+                                                      duckdb::vector<duckdb::LogicalType>& return_types,
+                                                      duckdb::vector<std::string>& names) {
+    if (input.inputs.size() != 3) {
+        throw duckdb::BinderException("llm_map expects a table, a model struct and a prompt struct.");
+    }
+    if (input.inputs[1].type().id() != duckdb::LogicalTypeId::STRUCT) {
+        throw duckdb::BinderException("llm_map: model details must be a struct.");
+    }
+    if (input.inputs[2].type().id() != duckdb::LogicalTypeId::STRUCT) {
+        throw duckdb::BinderException("llm_map: prompt details must be a struct.");
+    }
+    if (input.input_table_names.empty()) {
+        throw duckdb::BinderException("llm_map: the input table must have at least one column.");
+    }
+
+    auto bind_data = duckdb::make_uniq<LlmMapBindData>();
+    bind_data->model_json = Model::ResolveModelDetailsToJson(CastValueToJson(input.inputs[1]));
+
+    auto prompt_json = CastValueToJson(input.inputs[2]);
+    if (prompt_json.contains("context_columns")) {
+        throw duckdb::BinderException("llm_map uses every input column as context; remove 'context_columns'.");
+    }
+    bind_data->prompt = PromptManager::CreatePromptDetails(prompt_json).prompt;
+
+    bind_data->column_names = input.input_table_names;
+    bind_data->batch_size = std::max<size_t>(Model(bind_data->model_json).GetModelDetails().max_batch_size, 1);
+    bind_data->inflight_batches = DEFAULT_INFLIGHT_BATCHES;
+
+    std::string output_column = DEFAULT_OUTPUT_COLUMN;
+    for (const auto& [name, value]: input.named_parameters) {
+        if (name == "output_column") {
+            output_column = value.GetValue<std::string>();
+        } else if (name == "inflight_batches") {
+            const auto inflight_batches = value.GetValue<int64_t>();
+            if (inflight_batches <= 0) {
+                throw duckdb::BinderException("llm_map: 'inflight_batches' must be larger than 0.");
+            }
+            bind_data->inflight_batches = static_cast<size_t>(inflight_batches);
+        }
+    }
+
+    return_types = input.input_table_types;
+    names = input.input_table_names;
+    return_types.push_back(duckdb::LogicalType::VARCHAR);
+    names.push_back(output_column);
+
+    return std::move(bind_data);
+}
+
+duckdb::unique_ptr<duckdb::LocalTableFunctionState> LlmMap::InitLocal(duckdb::ExecutionContext& context,
+                                                                       duckdb::TableFunctionInitInput& input,
+                                                                       duckdb::GlobalTableFunctionState* global_state) {
+    auto state = duckdb::make_uniq<LlmMapLocalState>();
+    state->db = context.client.db.get();
+    state->allocator = &duckdb::Allocator::Get(context.client);
+    state->invocation_id = MetricsManager::GenerateUniqueId();
+    return std::move(state);
+}
+
+ContextColumnBatch LlmMap::BuildContextColumns(const std::vector<std::string>& column_names,
+                                               const duckdb::ColumnDataCollection& rows) {
+    // The batch owns its cells: it is answered on an executor thread while `rows` waits in the state.
+    ContextColumnBatch batch;
+    batch.row_count = rows.Count();
+    batch.owned_cells = std::make_shared<std::deque<std::string>>();
+    batch.columns.resize(column_names.size());
+    for (size_t column = 0; column < column_names.size(); column++) {
+        batch.columns[column].metadata = {{"name", column_names[column]}};
+        batch.columns[column].cells.resize(batch.row_count);
+        batch.columns[column].valid.resize(batch.row_count, false);
+    }
+
+    idx_t offset = 0;
+    for (auto& chunk: rows.Chunks()) {
+        for (size_t column = 0; column < column_names.size(); column++) {
+            // Same rendering as the scalar functions: non-VARCHAR data is cast as Value::ToString
+            // would, and NULL stays NULL, which the prompt renders as "NULL".
+            duckdb::Vector* source = &chunk.data[column];
+            duckdb::unique_ptr<duckdb::Vector> cast;
+            if (source->GetType().id() != duckdb::LogicalTypeId::VARCHAR) {
+                cast = duckdb::make_uniq<duckdb::Vector>(duckdb::LogicalType::VARCHAR, chunk.size());
+                duckdb::VectorOperations::DefaultCast(*source, *cast, chunk.size());
+                source = cast.get();
+            }
+            duckdb::UnifiedVectorFormat format;
+            source->ToUnifiedFormat(chunk.size(), format);
+            const auto strings = duckdb::UnifiedVectorFormat::GetData<duckdb::string_t>(format);
+
+            auto& target = batch.columns[column];
+            for (idx_t row = 0; row < chunk.size(); row++) {
+                const auto idx = format.sel->get_index(row);
+                if (!format.validity.RowIsValid(idx)) {
+                    continue;
+                }
+                const auto& text = batch.owned_cells->emplace_back(strings[idx].GetString());
+                target.cells[offset + row] = duckdb::string_t(text.data(), static_cast<uint32_t>(text.size()));
+                target.valid[offset + row] = true;
+            }
+        }
+        offset += chunk.size();
+    }
+    return batch;
+}
+
+std::optional<std::string> LlmMap::FormatAnswer(const nlohmann::json& answer) {
+    if (answer.is_null()) {
+        return std::nullopt;
+    }
+    return answer.is_string() ? answer.get<std::string>() : answer.dump();
+}
+
+void LlmMap::BufferRows(const LlmMapBindData& bind_data, LlmMapLocalState& state, duckdb::DataChunk& input) {
+    idx_t offset = 0;
+    while (offset < input.size()) {
+        if (state.pending.empty() || state.pending.back()->Count() >= bind_data.batch_size) {
+            state.pending.push_back(duckdb::make_uniq<duckdb::ColumnDataCollection>(*state.allocator, input.GetTypes()));
+        }
+        auto& target = *state.pending.back();
+        const auto count = std::min<idx_t>(bind_data.batch_size - target.Count(), input.size() - offset);
+        if (offset == 0 && count == input.size()) {
+            target.Append(input);
+        } else {
+            duckdb::SelectionVector sel(count);
+            for (idx_t i = 0; i < count; i++) {
+                sel.set_index(i, offset + i);
+            }
+            duckdb::DataChunk slice;
+            slice.InitializeEmpty(input.GetTypes());
+            slice.Slice(input, sel, count);
+            target.Append(slice);
+        }
+        offset += count;
+    }
+}
+
+void LlmMap::SubmitBatches(const LlmMapBindData& bind_data, LlmMapLocalState& state, const bool flush) {
+    const auto max_buffered_rows = bind_data.batch_size * bind_data.inflight_batches;
+    while (!state.pending.empty() && (flush || state.pending.front()->Count() >= bind_data.batch_size)) {
+        while (!state.inflight.empty() &&
+               state.inflight.front().answers.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            MoveAnswersToReady(state.inflight.front(), state);
+            state.inflight.pop_front();
+        }
+        // With the window full the thread keeps buffering input instead of waiting, and only
+        // blocks on the oldest request once a whole window of rows is buffered.
+        if (state.inflight.size() >= bind_data.inflight_batches) {
+            idx_t buffered_rows = 0;
+            for (const auto& rows: state.pending) {
+                buffered_rows += rows->Count();
+            }
+            if (!flush && buffered_rows <= max_buffered_rows) {
+                break;
+            }
+            MoveAnswersToReady(state.inflight.front(), state);
+            state.inflight.pop_front();
+        }
+
+        LlmMapLocalState::Batch batch;
+        batch.rows = std::move(state.pending.front());
+        state.pending.pop_front();
+        SubmitBatch(bind_data, state, std::move(batch));
+    }
+}
+
+void LlmMap::SubmitBatch(const LlmMapBindData& bind_data, LlmMapLocalState& state, LlmMapLocalState::Batch batch) {
+    auto context_columns = BuildContextColumns(bind_data.column_names, *batch.rows);
+    batch.answers = RequestExecutor::Submit([model_json = bind_data.model_json, prompt = bind_data.prompt,
+                                             db = state.db, invocation_id = state.invocation_id,
+                                             cancelled = state.cancelled,
+                                             context_columns = std::move(context_columns)]() {
+        if (cancelled->load()) {
+            return nlohmann::json::array();
+        }
+        MetricsManager::StartInvocation(db, invocation_id, FunctionType::LLM_COMPLETE);
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        Model model(model_json);
+        const auto& model_details = model.GetModelDetails();
+        MetricsManager::SetModelInfo(model_details.model_name, model_details.provider_name);
+        auto answers =
+                ScalarFunctionBase::BatchAndComplete(context_columns, prompt, ScalarFunctionType::COMPLETE, model);
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        MetricsManager::AddExecutionTime(std::chrono::duration<double, std::milli>(end - start).count());
+        return answers;
+    });
+    state.inflight.push_back(std::move(batch));
+}
+
+void LlmMap::MoveAnswersToReady(LlmMapLocalState::Batch& batch, LlmMapLocalState& state) {
+    const auto answers = batch.answers.get();
+    auto& answered = state.ready.emplace_back();
+    answered.answers.reserve(batch.rows->Count());
+    for (idx_t i = 0; i < batch.rows->Count(); i++) {
+        answered.answers.push_back(FormatAnswer(i < answers.size() ? answers[i] : nullptr));
+    }
+    answered.rows = std::move(batch.rows);
+    answered.rows->InitializeScan(answered.scan_state);
+    answered.rows->InitializeScanChunk(answered.chunk);
+}
+
+void LlmMap::Emit(LlmMapLocalState& state, duckdb::DataChunk& output, const bool wait) {
+    const auto answer_column = output.ColumnCount() - 1;
+    auto& answer_vector = output.data[answer_column];
+    const auto answer_data = duckdb::FlatVector::GetData<duckdb::string_t>(answer_vector);
+    idx_t count = 0;
+    while (count < STANDARD_VECTOR_SIZE) {
+        if (state.ready.empty()) {
+            if (state.inflight.empty()) {
+                break;
+            }
+            auto& oldest = state.inflight.front();
+            if (!wait && oldest.answers.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                break;
+            }
+            MoveAnswersToReady(oldest, state);
+            state.inflight.pop_front();
+            continue;
+        }
+
+        auto& answered = state.ready.front();
+        if (answered.emitted == answered.answers.size()) {
+            state.ready.pop_front();
+            continue;
+        }
+        if (answered.chunk_offset == answered.chunk.size()) {
+            answered.chunk_offset = 0;
+            answered.rows->Scan(answered.scan_state, answered.chunk);
+        }
+
+        const auto take = std::min<idx_t>(answered.chunk.size() - answered.chunk_offset, STANDARD_VECTOR_SIZE - count);
+        for (idx_t column = 0; column < answer_column; column++) {
+            duckdb::VectorOperations::Copy(answered.chunk.data[column], output.data[column],
+                                           answered.chunk_offset + take, answered.chunk_offset, count);
+        }
+        for (idx_t i = 0; i < take; i++) {
+            const auto& answer = answered.answers[answered.emitted + i];
+            if (answer.has_value()) {
+                answer_data[count + i] = duckdb::StringVector::AddString(answer_vector, *answer);
+            } else {
+                duckdb::FlatVector::SetNull(answer_vector, count + i, true);
+            }
+        }
+        answered.chunk_offset += take;
+        answered.emitted += take;
+        count += take;
+        if (answered.emitted == answered.answers.size()) {
+            state.ready.pop_front();
+        }
+    }
+    output.SetCardinality(count);
+}
+
+duckdb::OperatorResultType LlmMap::Execute(duckdb::ExecutionContext& context, duckdb::TableFunctionInput& data,
+                                           duckdb::DataChunk& input, duckdb::DataChunk& output) {
+    const auto& bind_data = data.bind_data->Cast<LlmMapBindData>();
+    auto& state = data.local_state->Cast<LlmMapLocalState>();
+
+    if (!state.input_consumed) {
+        BufferRows(bind_data, state, input);
+        SubmitBatches(bind_data, state, false);
+        state.input_consumed = true;
+    }
+
+    Emit(state, output, false);
+    if (!state.ready.empty()) {
+        return duckdb::OperatorResultType::HAVE_MORE_OUTPUT;
+    }
+    state.input_consumed = false;
+    return duckdb::OperatorResultType::NEED_MORE_INPUT;
+}
+
+duckdb::OperatorFinalizeResultType LlmMap::Finalize(duckdb::ExecutionContext& context,
+                                                    duckdb::TableFunctionInput& data, duckdb::DataChunk& output) {
+    const auto& bind_data = data.bind_data->Cast<LlmMapBindData>();
+    auto& state = data.local_state->Cast<LlmMapLocalState>();
+
+    // The last, possibly partial, batch is only sent once the input is exhausted.
+    SubmitBatches(bind_data, state, true);
+    Emit(state, output, true);
+    if (state.ready.empty() && state.inflight.empty()) {
+        return duckdb::OperatorFinalizeResultType::FINISHED;
+    }
+    return duckdb::OperatorFinalizeResultType::HAVE_MORE_OUTPUT;
+}
+
+}// namespace flock
@@ -0,0 +1,17 @@
+#include "flock/functions/table/llm_map.hpp"
+#include "flock/registry/registry.hpp"
+
+namespace flock {
+
+void TableRegistry::RegisterLlmMap(duckdb::ExtensionLoader& loader) {
+    duckdb::TableFunction function(LlmMap::FUNCTION_NAME,
+                                   {duckdb::LogicalType::TABLE, duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
+                                   nullptr, LlmMap::Bind, nullptr, LlmMap::InitLocal);
+    function.in_out_function = LlmMap::Execute;
+    function.in_out_function_final = LlmMap::Finalize;
+    function.named_parameters["output_column"] = duckdb::LogicalType::VARCHAR;
+    function.named_parameters["inflight_batches"] = duckdb::LogicalType::BIGINT;
+    loader.RegisterFunction(function);
+}
+
+}// namespace flock
@@ -0,0 +1,357 @@
+#include "flock/functions/typed_output.hpp"
+#include "duckdb/common/types/blob.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <type_traits>
+
+namespace flock {
+
+namespace {
+
+std::string Lowercase(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    return value;
+}
+
+std::optional<bool> ParseBoolean(const nlohmann::json& answer) {
+    if (answer.is_boolean()) {
+        return answer.get<bool>();
+    }
+    if (answer.is_number_integer() && (answer.get<int64_t>() == 0 || answer.get<int64_t>() == 1)) {
+        return answer.get<int64_t>() == 1;
+    }
+    if (answer.is_string()) {
+        const auto value = Lowercase(answer.get<std::string>());
+        if (value == "true") {
+            return true;
+        }
+        if (value == "false") {
+            return false;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<int64_t> ParseInteger(const nlohmann::json& answer) {
+    if (answer.is_number_integer()) {
+        return answer.get<int64_t>();
+    }
+    if (answer.is_number_float()) {
+        const auto value = answer.get<double>();
+        if (std::trunc(value) == value && std::abs(value) < 9.2e18) {
+            return static_cast<int64_t>(value);
+        }
+        return std::nullopt;
+    }
+    if (answer.is_string()) {
+        const auto& text = answer.get_ref<const std::string&>();
+        int64_t value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error == std::errc() && end == text.data() + text.size()) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<double> ParseDouble(const nlohmann::json& answer) {
+    if (answer.is_number()) {
+        return answer.get<double>();
+    }
+    if (answer.is_string()) {
+        const auto& text = answer.get_ref<const std::string&>();
+        char* end = nullptr;
+        const auto value = std::strtod(text.c_str(), &end);
+        if (!text.empty() && end == text.c_str() + text.size()) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string SchemaType(const nlohmann::json& schema) {
+    if (!schema.is_object() || !schema.contains("type")) {
+        return "";
+    }
+    const auto& type = schema["type"];
+    if (type.is_string()) {
+        return type.get<std::string>();
+    }
+    // Nullable fields are written as ["string", "null"].
+    if (type.is_array()) {
+        for (const auto& entry: type) {
+            if (entry.is_string() && entry.get<std::string>() != "null") {
+                return entry.get<std::string>();
+            }
+        }
+    }
+    return "";
+}
+
+// Number of elements in a JSON number array or a base64 float32 buffer.
+idx_t EmbeddingSize(const nlohmann::json& embedding) {
+    if (embedding.is_array()) {
+        return embedding.size();
+    }
+    if (!embedding.is_string()) {
+        throw std::runtime_error("llm_embedding: the provider returned an embedding that is not a list of numbers.");
+    }
+    const auto& encoded = embedding.get_ref<const std::string&>();
+    const auto bytes =
+            duckdb::Blob::FromBase64Size(duckdb::string_t(encoded.data(), static_cast<uint32_t>(encoded.size())));
+    if (bytes % sizeof(float) != 0) {
+        throw std::runtime_error("llm_embedding: the provider returned a base64 embedding that is not float32 data.");
+    }
+    return bytes / sizeof(float);
+}
+
+template<class T>
+void DecodeEmbedding(const nlohmann::json& embedding, T* out, const idx_t size) {
+    if (embedding.is_array()) {
+        for (idx_t i = 0; i < size; i++) {
+            out[i] = static_cast<T>(embedding[i].get<double>());
+        }
+        return;
+    }
+    // Providers send little-endian float32, the layout of a FLOAT child vector.
+    const auto& encoded = embedding.get_ref<const std::string&>();
+    const duckdb::string_t input(encoded.data(), static_cast<uint32_t>(encoded.size()));
+    if constexpr (std::is_same_v<T, float>) {
+        duckdb::Blob::FromBase64(input, reinterpret_cast<duckdb::data_ptr_t>(out), size * sizeof(float));
+    } else {
+        std::vector<float> decoded(size);
+        duckdb::Blob::FromBase64(input, reinterpret_cast<duckdb::data_ptr_t>(decoded.data()), size * sizeof(float));
+        std::copy(decoded.begin(), decoded.end(), out);
+    }
+}
+
+}// namespace
+
+std::optional<duckdb::LogicalType> TypedOutput::ResolveReturnType(const std::string& returns,
+                                                                  const nlohmann::json& model_json,
+                                                                  const ScalarFunctionType function_type) {
+    const auto value = Lowercase(returns);
+    if (function_type == ScalarFunctionType::FILTER) {
+        if (value == "boolean") {
+            return duckdb::LogicalType::BOOLEAN;
+        }
+        if (value == "varchar") {
+            return std::nullopt;
+        }
+        throw duckdb::BinderException("llm_filter: 'returns' must be 'boolean' or 'varchar'.");
+    }
+
+    if (value == "json") {
+        return std::nullopt;
+    }
+    if (value == "varchar") {
+        return duckdb::LogicalType::VARCHAR;
+    }
+    if (value == "boolean") {
+        return duckdb::LogicalType::BOOLEAN;
+    }
+    if (value == "integer") {
+        return duckdb::LogicalType::BIGINT;
+    }
+    if (value == "double") {
+        return duckdb::LogicalType::DOUBLE;
+    }
+    if (value == "schema") {
+        const auto parameters = model_json.value("model_parameters", nlohmann::json::object());
+        if (!parameters.contains("response_format") || !parameters["response_format"].contains("json_schema") ||
+            !parameters["response_format"]["json_schema"].contains("schema")) {
+            throw duckdb::BinderException(
+                    "llm_complete: 'returns' = 'schema' requires model_parameters.response_format.json_schema.schema.");
+        }
+        return TypeFromJsonSchema(parameters["response_format"]["json_schema"]["schema"]);
+    }
+    throw duckdb::BinderException(
+            "llm_complete: 'returns' must be one of 'json', 'varchar', 'boolean', 'integer', 'double', or 'schema'.");
+}
+
+std::optional<duckdb::LogicalType> TypedOutput::ResolveEmbeddingType(const std::string& returns,
+                                                                     const nlohmann::json& model_json) {
+    const auto value = Lowercase(returns);
+    if (value == "double") {
+        return std::nullopt;
+    }
+    if (value != "float") {
+        throw duckdb::BinderException("llm_embedding: 'returns' must be 'double' or 'float'.");
+    }
+    const auto parameters = model_json.value("model_parameters", nlohmann::json::object());
+    if (!parameters.contains("dimensions") || !parameters["dimensions"].is_number_integer() ||
+        parameters["dimensions"].get<int64_t>() <= 0 ||
+        parameters["dimensions"].get<int64_t>() > static_cast<int64_t>(duckdb::ArrayType::MAX_ARRAY_SIZE)) {
+        throw duckdb::BinderException(
+                "llm_embedding: 'returns' = 'float' requires the embedding size in model_parameters.dimensions.");
+    }
+    return duckdb::LogicalType::ARRAY(duckdb::LogicalType::FLOAT, parameters["dimensions"].get<idx_t>());
+}
+
+duckdb::LogicalType TypedOutput::TypeFromJsonSchema(const nlohmann::json& schema) {
+    const auto type = SchemaType(schema);
+    if (type == "string") {
+        return duckdb::LogicalType::VARCHAR;
+    }
+    if (type == "integer") {
+        return duckdb::LogicalType::BIGINT;
+    }
+    if (type == "number") {
+        return duckdb::LogicalType::DOUBLE;
+    }
+    if (type == "boolean") {
+        return duckdb::LogicalType::BOOLEAN;
+    }
+    if (type == "array" && schema.contains("items")) {
+        return duckdb::LogicalType::LIST(TypeFromJsonSchema(schema["items"]));
+    }
+    if (type == "object" && schema.contains("properties") && schema["properties"].is_object() &&
+        !schema["properties"].empty()) {
+        duckdb::child_list_t<duckdb::LogicalType> children;
+        for (const auto& [name, property]: schema["properties"].items()) {
+            children.emplace_back(name, TypeFromJsonSchema(property));
+        }
+        return duckdb::LogicalType::STRUCT(std::move(children));
+    }
+    return duckdb::LogicalType::JSON();
+}
+
+void TypedOutput::WriteAnswers(const std::vector<nlohmann::json>& answers, duckdb::Vector& result, const idx_t count) {
+    static const nlohmann::json missing_answer;
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    for (idx_t row = 0; row < count; row++) {
+        if (answers.size() == 1) {
+            WriteValue(result, row, answers[0]);
+        } else {
+            WriteValue(result, row, row < answers.size() ? answers[row] : missing_answer);
+        }
+    }
+}
+
+void TypedOutput::WriteStrings(const std::vector<std::string>& values, duckdb::Vector& result, const idx_t count) {
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto data = duckdb::FlatVector::GetData<duckdb::string_t>(result);
+    for (idx_t row = 0; row < count; row++) {
+        if (values.size() != 1 && row >= values.size()) {
+            duckdb::FlatVector::SetNull(result, row, true);
+            continue;
+        }
+        data[row] = duckdb::StringVector::AddString(result, values.size() == 1 ? values[0] : values[row]);
+    }
+}
+
+void TypedOutput::WriteValue(duckdb::Vector& vector, const idx_t row, const nlohmann::json& answer) {
+    if (answer.is_null()) {
+        duckdb::FlatVector::SetNull(vector, row, true);
+        return;
+    }
+
+    const auto& type = vector.GetType();
+    switch (type.id()) {
+        case duckdb::LogicalTypeId::BOOLEAN: {
+            const auto value = ParseBoolean(answer);
+            if (!value.has_value()) {
+                duckdb::FlatVector::SetNull(vector, row, true);
+                return;
+            }
+            duckdb::FlatVector::GetData<bool>(vector)[row] = *value;
+            return;
+        }
+        case duckdb::LogicalTypeId::BIGINT: {
+            const auto value = ParseInteger(answer);
+            if (!value.has_value()) {
+                duckdb::FlatVector::SetNull(vector, row, true);
+                return;
+            }
+            duckdb::FlatVector::GetData<int64_t>(vector)[row] = *value;
+            return;
+        }
+        case duckdb::LogicalTypeId::DOUBLE: {
+            const auto value = ParseDouble(answer);
+            if (!value.has_value()) {
+                duckdb::FlatVector::SetNull(vector, row, true);
+                return;
+            }
+            duckdb::FlatVector::GetData<double>(vector)[row] = *value;
+            return;
+        }
+        case duckdb::LogicalTypeId::STRUCT: {
+            if (!answer.is_object()) {
+                duckdb::FlatVector::SetNull(vector, row, true);
+                return;
+            }
+            auto& entries = duckdb::StructVector::GetEntries(vector);
+            for (idx_t i = 0; i < entries.size(); i++) {
+                const auto& name = duckdb::StructType::GetChildName(type, i);
+                WriteValue(*entries[i], row, answer.contains(name) ? answer[name] : nlohmann::json());
+            }
+            return;
+        }
+        case duckdb::LogicalTypeId::LIST: {
+            if (!answer.is_array()) {
+                duckdb::FlatVector::SetNull(vector, row, true);
+                return;
+            }
+            const auto offset = duckdb::ListVector::GetListSize(vector);
+            duckdb::ListVector::Reserve(vector, offset + answer.size());
+            auto& child = duckdb::ListVector::GetEntry(vector);
+            for (idx_t i = 0; i < answer.size(); i++) {
+                WriteValue(child, offset + i, answer[i]);
+            }
+            duckdb::ListVector::SetListSize(vector, offset + answer.size());
+            duckdb::FlatVector::GetData<duckdb::list_entry_t>(vector)[row] = {offset, answer.size()};
+            return;
+        }
+        default: {
+            // VARCHAR and JSON results keep strings as they are and serialize everything else.
+            const auto text = answer.is_string() ? answer.get<std::string>() : answer.dump();
+            duckdb::FlatVector::GetData<duckdb::string_t>(vector)[row] = duckdb::StringVector::AddString(vector, text);
+            return;
+        }
+    }
+}
+
+void TypedOutput::WriteEmbeddings(const std::vector<nlohmann::json>& embeddings, duckdb::Vector& result,
+                                  const idx_t count) {
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    const auto& type = result.GetType();
+    for (idx_t row = 0; row < count; row++) {
+        const bool missing = row >= embeddings.size() || embeddings[row].is_null();
+        if (type.id() == duckdb::LogicalTypeId::ARRAY) {
+            const auto dimensions = duckdb::ArrayType::GetSize(type);
+            auto& child = duckdb::ArrayVector::GetEntry(result);
+            if (missing) {
+                duckdb::FlatVector::SetNull(result, row, true);
+                for (idx_t i = 0; i < dimensions; i++) {
+                    duckdb::FlatVector::SetNull(child, row * dimensions + i, true);
+                }
+                continue;
+            }
+            const auto size = EmbeddingSize(embeddings[row]);
+            if (size != dimensions) {
+                throw std::runtime_error(duckdb_fmt::format(
+                        "llm_embedding: expected {} dimensions but the provider returned {}.", dimensions, size));
+            }
+            DecodeEmbedding(embeddings[row], duckdb::FlatVector::GetData<float>(child) + row * dimensions, size);
+            continue;
+        }
+
+        if (missing) {
+            duckdb::FlatVector::SetNull(result, row, true);
+            continue;
+        }
+        const auto size = EmbeddingSize(embeddings[row]);
+        const auto offset = duckdb::ListVector::GetListSize(result);
+        duckdb::ListVector::Reserve(result, offset + size);
+        DecodeEmbedding(embeddings[row],
+                        duckdb::FlatVector::GetData<double>(duckdb::ListVector::GetEntry(result)) + offset, size);
+        duckdb::ListVector::SetListSize(result, offset + size);
+        duckdb::FlatVector::GetData<duckdb::list_entry_t>(result)[row] = {offset, size};
+    }
+}
+
+}// namespace flock
@@ -26,6 +26,10 @@ public:
     static std::string get_default_models_table_name();
     static std::string get_user_defined_models_table_name();
     static std::string get_prompts_table_name();
+    static std::string get_result_cache_table_name();
+    static std::string get_semantic_cache_table_name();
+    static std::string get_vector_index_table_name();
+    static std::string get_vector_index_nodes_table_name();
     static void AttachToGlobalStorage(duckdb::Connection& con, bool read_only = true);
     static void DetachFromGlobalStorage(duckdb::Connection& con);
 
@@ -55,6 +59,9 @@ private:
     static void ConfigSchema(duckdb::Connection& con, std::string& schema_name);
     static void ConfigPromptTable(duckdb::Connection& con, std::string& schema_name, ConfigType type);
     static void ConfigModelTable(duckdb::Connection& con, std::string& schema_name, ConfigType type);
+    static void ConfigResultCacheTable(duckdb::Connection& con, std::string& schema_name, ConfigType type);
+    static void ConfigSemanticCacheTable(duckdb::Connection& con, std::string& schema_name, ConfigType type);
+    static void ConfigVectorIndexTables(duckdb::Connection& con, std::string& schema_name, ConfigType type);
     static void SetupDefaultModelsConfig(duckdb::Connection& con, std::string& schema_name);
     static void SetupUserDefinedModelsConfig(duckdb::Connection& con, std::string& schema_name);
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include <deque>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+namespace flock {
+
+// Context columns of a set of rows, in the columnar form the scalar and aggregate pipelines work
+// on. Column metadata is parsed once per chunk; cells are string views into the input chunk, into
+// `cast_vectors` for non-VARCHAR data, or into `owned_cells` for batches built from JSON. Row
+// selections share that storage, so no batch may outlive the chunk it was extracted from. JSON is
+// only built for the rows of one request, when its prompt is rendered.
+struct ContextColumnBatch {
+    struct Column {
+        nlohmann::json metadata;
+        std::vector<duckdb::string_t> cells;
+        std::vector<bool> valid;
+    };
+
+    idx_t row_count = 0;
+    std::vector<Column> columns;
+    std::vector<std::shared_ptr<duckdb::Vector>> cast_vectors;
+    std::shared_ptr<std::deque<std::string>> owned_cells;
+
+    // A batch over `context_columns` JSON; JSON nulls are NULL cells and other non-strings are dumped.
+    static ContextColumnBatch FromJson(const nlohmann::json& context_columns);
+
+    bool empty() const { return columns.empty(); }
+    // The cell text, or "NULL" for a NULL cell, as the prompt pipeline renders it.
+    std::string GetCell(size_t column, idx_t row) const;
+    // A row whose context values are all NULL, empty or "NULL" has nothing for the model to answer.
+    bool IsEmptyRow(idx_t row) const;
+
+    // The given rows, in that order.
+    ContextColumnBatch Select(const std::vector<size_t>& rows) const;
+    // Rows [start, start + count), clamped to the batch.
+    ContextColumnBatch Slice(idx_t start, idx_t count) const;
+
+    // `context_columns` in the shape the prompt pipeline takes, with NULL cells as "NULL".
+    nlohmann::json ToJson() const;
+};
+
+}// namespace flock
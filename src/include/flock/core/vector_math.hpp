@@ -0,0 +1,294 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#define FLOCK_VECTOR_MATH_SSE
+#if defined(__GNUC__) || defined(__clang__)
+// The AVX2 and AVX-512 kernels are always compiled, each for its own target only, and picked at
+// runtime from the features of the CPU the extension is loaded on.
+#define FLOCK_VECTOR_MATH_TARGET(features) __attribute__((target(features)))
+#define FLOCK_VECTOR_MATH_CPU_SUPPORTS(feature) __builtin_cpu_supports(feature)
+#define FLOCK_VECTOR_MATH_AVX2
+#define FLOCK_VECTOR_MATH_AVX512
+#define FLOCK_VECTOR_MATH_AVX512_POPCNT
+#else
+// Without target attributes the wider kernels exist only when the build targets them.
+#define FLOCK_VECTOR_MATH_TARGET(features)
+#define FLOCK_VECTOR_MATH_CPU_SUPPORTS(feature) true
+#if defined(__AVX2__)
+#define FLOCK_VECTOR_MATH_AVX2
+#endif
+#if defined(__AVX512F__)
+#define FLOCK_VECTOR_MATH_AVX512
+#endif
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#define FLOCK_VECTOR_MATH_AVX512_POPCNT
+#endif
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define FLOCK_VECTOR_MATH_NEON
+#endif
+
+namespace flock {
+
+// Kernels for embedding similarity over float32, int8 and packed-bit vectors. On x86 each kernel
+// is dispatched once per process to the widest of AVX-512, AVX2 or SSE the CPU supports; other
+// targets use NEON or plain loops. Every kernel finishes with a scalar tail.
+class VectorMath {
+public:
+    static float Dot(const float* left, const float* right, const size_t dims) {
+        return GetKernels().dot(left, right, dims);
+    }
+
+    static int32_t DotInt8(const int8_t* left, const int8_t* right, const size_t dims) {
+        return GetKernels().dot_int8(left, right, dims);
+    }
+
+    // Number of differing bits between two packed bit vectors of `bytes` bytes.
+    static uint32_t Hamming(const uint8_t* left, const uint8_t* right, const size_t bytes) {
+        return GetKernels().hamming(left, right, bytes);
+    }
+
+    static uint32_t PopCount(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<uint32_t>(__builtin_popcountll(value));
+#else
+        uint32_t count = 0;
+        for (; value != 0; value &= value - 1) {
+            count++;
+        }
+        return count;
+#endif
+    }
+
+    // Scales `values` to unit length so cosine similarity becomes a dot product. Zero
+    // vectors are left unchanged.
+    static void Normalize(std::vector<float>& values) {
+        const auto norm = std::sqrt(Dot(values.data(), values.data(), values.size()));
+        if (norm == 0.0f) {
+            return;
+        }
+        for (auto& value: values) {
+            value /= norm;
+        }
+    }
+
+private:
+    struct Kernels {
+        float (*dot)(const float*, const float*, size_t);
+        int32_t (*dot_int8)(const int8_t*, const int8_t*, size_t);
+        uint32_t (*hamming)(const uint8_t*, const uint8_t*, size_t);
+    };
+
+    static const Kernels& GetKernels() {
+        static const Kernels kernels = SelectKernels();
+        return kernels;
+    }
+
+    static Kernels SelectKernels() {
+        Kernels kernels{DotBaseline, DotInt8Baseline, HammingBaseline};
+#if defined(FLOCK_VECTOR_MATH_SSE) && (defined(__GNUC__) || defined(__clang__))
+        // May run from a static initializer, before libgcc has probed the CPU.
+        __builtin_cpu_init();
+#endif
+#if defined(FLOCK_VECTOR_MATH_AVX2)
+        if (FLOCK_VECTOR_MATH_CPU_SUPPORTS("avx2")) {
+            kernels.dot_int8 = DotInt8Avx2;
+            if (FLOCK_VECTOR_MATH_CPU_SUPPORTS("fma")) {
+                kernels.dot = DotAvx2;
+            }
+        }
+#endif
+#if defined(FLOCK_VECTOR_MATH_AVX512)
+        if (FLOCK_VECTOR_MATH_CPU_SUPPORTS("avx512f")) {
+            kernels.dot = DotAvx512;
+        }
+#endif
+#if defined(FLOCK_VECTOR_MATH_AVX512_POPCNT)
+        if (FLOCK_VECTOR_MATH_CPU_SUPPORTS("avx512f") && FLOCK_VECTOR_MATH_CPU_SUPPORTS("avx512vpopcntdq")) {
+            kernels.hamming = HammingAvx512;
+        }
+#endif
+        return kernels;
+    }
+
+    static float DotTail(const float* left, const float* right, size_t i, const size_t dims, float sum) {
+        for (; i < dims; i++) {
+            sum += left[i] * right[i];
+        }
+        return sum;
+    }
+
+    static float DotBaseline(const float* left, const float* right, const size_t dims) {
+        size_t i = 0;
+        float sum = 0.0f;
+#if defined(FLOCK_VECTOR_MATH_SSE)
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (; i + 8 <= dims; i += 8) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(right + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(left + i + 4), _mm_loadu_ps(right + i + 4)));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(FLOCK_VECTOR_MATH_NEON)
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (; i + 8 <= dims; i += 8) {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(left + i), vld1q_f32(right + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(left + i + 4), vld1q_f32(right + i + 4));
+        }
+        const float32x4_t acc = vaddq_f32(acc0, acc1);
+        sum = vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1) + vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3);
+#else
+        float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (; i + 4 <= dims; i += 4) {
+            acc[0] += left[i] * right[i];
+            acc[1] += left[i + 1] * right[i + 1];
+            acc[2] += left[i + 2] * right[i + 2];
+            acc[3] += left[i + 3] * right[i + 3];
+        }
+        sum = acc[0] + acc[1] + acc[2] + acc[3];
+#endif
+        return DotTail(left, right, i, dims, sum);
+    }
+
+#if defined(FLOCK_VECTOR_MATH_AVX2)
+    FLOCK_VECTOR_MATH_TARGET("avx2,fma")
+    static float DotAvx2(const float* left, const float* right, const size_t dims) {
+        size_t i = 0;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (; i + 16 <= dims; i += 16) {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(left + i + 8), _mm256_loadu_ps(right + i + 8), acc1);
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, _mm256_add_ps(acc0, acc1));
+        float sum = 0.0f;
+        for (const auto lane: lanes) {
+            sum += lane;
+        }
+        return DotTail(left, right, i, dims, sum);
+    }
+#endif
+
+#if defined(FLOCK_VECTOR_MATH_AVX512)
+    FLOCK_VECTOR_MATH_TARGET("avx512f")
+    static float DotAvx512(const float* left, const float* right, const size_t dims) {
+        size_t i = 0;
+        __m512 acc = _mm512_setzero_ps();
+        for (; i + 16 <= dims; i += 16) {
+            acc = _mm512_fmadd_ps(_mm512_loadu_ps(left + i), _mm512_loadu_ps(right + i), acc);
+        }
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, acc);
+        float sum = 0.0f;
+        for (const auto lane: lanes) {
+            sum += lane;
+        }
+        return DotTail(left, right, i, dims, sum);
+    }
+#endif
+
+    static int32_t DotInt8Tail(const int8_t* left, const int8_t* right, size_t i, const size_t dims, int32_t sum) {
+        for (; i < dims; i++) {
+            sum += static_cast<int32_t>(left[i]) * static_cast<int32_t>(right[i]);
+        }
+        return sum;
+    }
+
+    static int32_t DotInt8Baseline(const int8_t* left, const int8_t* right, const size_t dims) {
+        size_t i = 0;
+        int32_t sum = 0;
+#if defined(FLOCK_VECTOR_MATH_NEON)
+        int32x4_t acc = vdupq_n_s32(0);
+        for (; i + 16 <= dims; i += 16) {
+            const int8x16_t l = vld1q_s8(left + i);
+            const int8x16_t r = vld1q_s8(right + i);
+            acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(l), vget_low_s8(r)));
+            acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(l), vget_high_s8(r)));
+        }
+        sum = vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) + vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+#endif
+        return DotInt8Tail(left, right, i, dims, sum);
+    }
+
+#if defined(FLOCK_VECTOR_MATH_AVX2)
+    FLOCK_VECTOR_MATH_TARGET("avx2")
+    static int32_t DotInt8Avx2(const int8_t* left, const int8_t* right, const size_t dims) {
+        size_t i = 0;
+        __m256i acc = _mm256_setzero_si256();
+        for (; i + 16 <= dims; i += 16) {
+            const auto l = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i)));
+            const auto r = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i)));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(l, r));
+        }
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        int32_t sum = 0;
+        for (const auto lane: lanes) {
+            sum += lane;
+        }
+        return DotInt8Tail(left, right, i, dims, sum);
+    }
+#endif
+
+    static uint32_t HammingTail(const uint8_t* left, const uint8_t* right, size_t i, const size_t bytes,
+                                uint64_t distance) {
+        for (; i + 8 <= bytes; i += 8) {
+            uint64_t l;
+            uint64_t r;
+            std::memcpy(&l, left + i, sizeof(l));
+            std::memcpy(&r, right + i, sizeof(r));
+            distance += PopCount(l ^ r);
+        }
+        for (; i < bytes; i++) {
+            distance += PopCount(static_cast<uint64_t>(left[i] ^ right[i]));
+        }
+        return static_cast<uint32_t>(distance);
+    }
+
+    static uint32_t HammingBaseline(const uint8_t* left, const uint8_t* right, const size_t bytes) {
+        size_t i = 0;
+        uint64_t distance = 0;
+#if defined(FLOCK_VECTOR_MATH_NEON)
+        uint32x4_t acc = vdupq_n_u32(0);
+        for (; i + 16 <= bytes; i += 16) {
+            const uint8x16_t bits = vcntq_u8(veorq_u8(vld1q_u8(left + i), vld1q_u8(right + i)));
+            acc = vpadalq_u16(acc, vpaddlq_u8(bits));
+        }
+        distance = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+        return HammingTail(left, right, i, bytes, distance);
+    }
+
+#if defined(FLOCK_VECTOR_MATH_AVX512_POPCNT)
+    FLOCK_VECTOR_MATH_TARGET("avx512f,avx512vpopcntdq")
+    static uint32_t HammingAvx512(const uint8_t* left, const uint8_t* right, const size_t bytes) {
+        size_t i = 0;
+        __m512i acc = _mm512_setzero_si512();
+        for (; i + 64 <= bytes; i += 64) {
+            const auto bits = _mm512_xor_si512(_mm512_loadu_si512(left + i), _mm512_loadu_si512(right + i));
+            acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(bits));
+        }
+        alignas(64) uint64_t lanes[8];
+        _mm512_store_si512(lanes, acc);
+        uint64_t distance = 0;
+        for (const auto lane: lanes) {
+            distance += lane;
+        }
+        return HammingTail(left, right, i, bytes, distance);
+    }
+#endif
+};
+
+}// namespace flock
@@ -25,7 +25,8 @@ public:
     }
 
     void Initialize();
-    void Update(const nlohmann::json& input);
+    // Appends rows [begin, end) of `batch`; column metadata is taken from the first rows seen.
+    void Update(const ContextColumnBatch& batch, idx_t begin, idx_t end);
     void Combine(const AggregateFunctionState& source);
     void Destroy();
 };
@@ -64,8 +65,7 @@ private:
                                  LlmFunctionBindData& bind_data);
 
 public:
-    static std::tuple<nlohmann::json, nlohmann::json>
-    CastInputsToJson(duckdb::Vector inputs[], idx_t count);
+    static ContextColumnBatch ExtractContextColumns(duckdb::Vector inputs[], idx_t count);
 
     static duckdb::unique_ptr<LlmFunctionBindData> ValidateAndInitializeBindData(
             duckdb::ClientContext& context,
@@ -85,28 +85,13 @@ public:
     template<class Derived>
     static void Operation(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data, idx_t input_count,
                           duckdb::Vector& states, idx_t count) {
-        auto [prompt_details, columns] = CastInputsToJson(inputs, count);
+        const auto batch = ExtractContextColumns(inputs, count);
 
         auto state_map_p = reinterpret_cast<AggregateFunctionState**>(duckdb::FlatVector::GetData<duckdb::data_ptr_t>(states));
 
         for (idx_t i = 0; i < count; i++) {
-            auto state = state_map_p[i];
-            auto tuple = nlohmann::json::array();
-            auto idx = 0u;
-            for (const auto& column: columns) {
-                tuple.push_back(nlohmann::json::object());
-                for (const auto& item: column.items()) {
-                    if (item.key() == "data") {
-                        tuple[idx][item.key()].push_back(item.value()[i]);
-                    } else {
-                        tuple[idx][item.key()] = item.value();
-                    }
-                }
-                idx++;
-            }
-
-            if (state) {
-                state->Update(tuple);
+            if (auto state = state_map_p[i]) {
+                state->Update(batch, i, i + 1);
             }
         }
     }
@@ -114,10 +99,10 @@ public:
     template<class Derived>
     static void SimpleUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data, idx_t input_count,
                              duckdb::data_ptr_t state_p, idx_t count) {
-        auto [prompt_details, tuples] = CastInputsToJson(inputs, count);
+        const auto batch = ExtractContextColumns(inputs, count);
 
         if (const auto state = reinterpret_cast<AggregateFunctionState*>(state_p)) {
-            state->Update(tuples);
+            state->Update(batch, 0, batch.row_count);
         }
     }
 
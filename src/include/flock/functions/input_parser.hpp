@@ -1,12 +1,20 @@
 #pragma once
 #include "flock/core/common.hpp"
+#include "flock/core/context_column_batch.hpp"
 #include "flock/model_manager/model.hpp"
 #include "flock/prompt_manager/prompt_manager.hpp"
 #include <nlohmann/json.hpp>
+#include <optional>
 
 namespace flock {
 
-nlohmann::json CastVectorOfStructsToJson(const duckdb::Vector& struct_vector, int size);
+// Splits a vector of prompt structs into the per-call keys, written to `prompt_json`, and the
+// context columns of every row.
+ContextColumnBatch ExtractPromptInputs(duckdb::Vector& struct_vector, idx_t size, nlohmann::json& prompt_json);
+nlohmann::json CastVectorOfStructsToJson(duckdb::Vector& struct_vector, int size);
 nlohmann::json CastValueToJson(const duckdb::Value& value);
+// Number of a model struct option, or std::nullopt when it is not one. Decimal literals reach the
+// json as text, so numeric strings are accepted.
+std::optional<double> ParseJsonNumber(const nlohmann::json& value);
 
 }// namespace flock
@@ -5,13 +5,29 @@
 
 namespace flock {
 
+class DistilledClassifier;
+class DistilledPredicate;
+
 struct LlmFunctionBindData : public duckdb::FunctionData {
     nlohmann::json model_json;// Store model JSON to create fresh Model instances per call
     std::string prompt;
+    // Inline `returns` option of the model struct (see TypedOutput); empty for the default result.
+    std::string returns;
+    // Inline `cascade` option of `llm_filter`: the resolved model that rows below `cascade_threshold`
+    // confidence are escalated to; null without a cascade.
+    nlohmann::json cascade_model_json;
+    double cascade_threshold = 0;
+    // Inline `distill` option of `llm_filter`; null without distillation. The predicate is shared
+    // by every copy of the bind data, so all threads of a query use the same expression.
+    nlohmann::json distill_json;
+    std::shared_ptr<DistilledPredicate> distilled_predicate;
+    // Inline `classifier` option of `llm_filter` and `llm_complete`, shared the same way.
+    nlohmann::json classifier_json;
+    std::shared_ptr<DistilledClassifier> distilled_classifier;
 
     LlmFunctionBindData() = default;
 
-    // Create a fresh Model instance (thread-safe, each call gets its own provider)
+    // Create a Model for this call (thread-safe: each Model leases its own pooled provider)
     Model CreateModel() const {
         return Model(model_json);
     }
@@ -20,12 +36,21 @@ struct LlmFunctionBindData : public duckdb::FunctionData {
         auto result = duckdb::make_uniq<LlmFunctionBindData>();
         result->model_json = model_json;
         result->prompt = prompt;
+        result->returns = returns;
+        result->cascade_model_json = cascade_model_json;
+        result->cascade_threshold = cascade_threshold;
+        result->distill_json = distill_json;
+        result->distilled_predicate = distilled_predicate;
+        result->classifier_json = classifier_json;
+        result->distilled_classifier = distilled_classifier;
         return std::move(result);
     }
 
     bool Equals(const duckdb::FunctionData& other) const override {
         auto& other_bind = other.Cast<LlmFunctionBindData>();
-        return prompt == other_bind.prompt && model_json == other_bind.model_json;
+        return prompt == other_bind.prompt && model_json == other_bind.model_json && returns == other_bind.returns &&
+               cascade_model_json == other_bind.cascade_model_json && cascade_threshold == other_bind.cascade_threshold && distill_json == other_bind.distill_json &&
+               classifier_json == other_bind.classifier_json;
     }
 };
 
@@ -0,0 +1,20 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <set>
+#include <string>
+
+namespace flock {
+
+// Strict decoders for compact model outputs. Each returns std::nullopt when the
+// response does not match the expected shape exactly, so callers can fall back to
+// re-requesting the batch with the JSON encoding.
+
+// Decodes {"items": ["TFFT"]} style answers into a JSON array of booleans.
+std::optional<nlohmann::json> DecodeCompactBoolItems(const nlohmann::json& items, size_t expected_count);
+
+// Decodes {"items": ["3,1,2"]} style answers into a JSON array of row ids. The list must
+// be a permutation of `valid_ids`.
+std::optional<nlohmann::json> DecodeCompactIndexList(const nlohmann::json& items, const std::set<std::string>& valid_ids);
+
+}// namespace flock
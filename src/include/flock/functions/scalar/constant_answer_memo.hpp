@@ -0,0 +1,38 @@
+#pragma once
+
+#include "duckdb/main/client_context_state.hpp"
+#include "flock/core/common.hpp"
+#include "flock/model_manager/providers/provider.hpp"
+#include <functional>
+#include <future>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+
+namespace flock {
+
+// Answers of `llm_complete` and `llm_filter` calls without context columns. Their request is the
+// same for every row, so each distinct one is sent once per query: later chunks and other threads
+// reuse the answer, or wait for it while it is in flight. The answers are dropped when the query
+// ends, so the next query asks the model again.
+class ConstantAnswerMemo : public duckdb::ClientContextState {
+public:
+    static constexpr auto STATE_NAME = "flock_constant_answers";
+
+    static ConstantAnswerMemo& Get(duckdb::ClientContext& context);
+    static std::string Key(const nlohmann::json& model_json, const std::string& prompt, OutputType output_type);
+
+    // The answer stored under `key`, computed with `compute` by the first caller. If it throws,
+    // every caller waiting on the key sees the same exception.
+    nlohmann::json GetOrCompute(const std::string& key, const std::function<nlohmann::json()>& compute);
+    size_t Size() const;
+
+    void QueryEnd() override;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_future<nlohmann::json>> answers_;
+};
+
+}// namespace flock
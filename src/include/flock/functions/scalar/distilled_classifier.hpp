@@ -0,0 +1,105 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include "flock/core/context_column_batch.hpp"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace flock {
+
+// Multinomial logistic regression over unit-length embeddings, trained with full-batch gradient
+// descent. Classes are weighted by inverse frequency so a rare answer is not drowned out.
+class SoftmaxClassifier {
+public:
+    static constexpr size_t EPOCHS = 200;
+    static constexpr float LEARNING_RATE = 2.0f;
+    static constexpr float L2_PENALTY = 1e-4f;
+
+    // `labels` are class indexes below `class_count`, one per embedding.
+    void Train(const std::vector<std::vector<float>>& embeddings, const std::vector<size_t>& labels,
+               size_t class_count);
+    // Class probabilities of one embedding.
+    std::vector<float> Predict(const std::vector<float>& embedding) const;
+
+    size_t GetClassCount() const {
+        return class_count_;
+    }
+
+private:
+    void Logits(const float* embedding, float* logits) const;
+
+    size_t dims_ = 0;
+    size_t class_count_ = 0;
+    // class_count_ rows of dims_ weights.
+    std::vector<float> weights_;
+    std::vector<float> biases_;
+};
+
+// Inline `classifier` option of `llm_filter` and `llm_complete`. The model labels a random sample
+// of the first chunk, the labels are split into training and held-out rows per class, and a
+// SoftmaxClassifier is trained on embeddings of the rows. The held-out rows calibrate the lowest
+// confidence at which the classifier still reaches `target_accuracy`; rows scored below it, near
+// the decision boundary, keep going to the model. Calls with more than MAX_CLASSES distinct
+// answers in the sample are not categorical and are never distilled.
+class DistilledClassifier {
+public:
+    static constexpr auto OPTION_NAME = "classifier";
+    static constexpr size_t DEFAULT_SAMPLE_SIZE = 200;
+    static constexpr double DEFAULT_HOLDOUT = 0.25;
+    static constexpr double DEFAULT_TARGET_ACCURACY = 0.95;
+    static constexpr size_t MAX_CLASSES = 16;
+
+    enum class State { PENDING, ACCEPTED, REJECTED };
+
+    struct Options {
+        std::string embedding_model;
+        size_t sample_size = DEFAULT_SAMPLE_SIZE;
+        double holdout = DEFAULT_HOLDOUT;
+        double target_accuracy = DEFAULT_TARGET_ACCURACY;
+    };
+
+    // Answers the given context columns with the model, one answer per row.
+    using ModelAnswers = std::function<nlohmann::json(const ContextColumnBatch& rows)>;
+
+    // A struct with `embedding_model` and optional `sample_size`, `holdout` and `target_accuracy`.
+    static Options ParseOptions(const nlohmann::json& value, const std::string& function_name);
+
+    explicit DistilledClassifier(Options options);
+
+    // One answer per row, from the classifier where it is confident and from `model_answers` for
+    // the rest. The first chunk larger than the sample trains the classifier; other threads wait
+    // for it instead of paying for their own requests.
+    nlohmann::json Answer(const ContextColumnBatch& batch, const ModelAnswers& model_answers);
+
+    State GetState() const;
+    double GetThreshold() const;
+
+private:
+    struct Training {
+        State state = State::REJECTED;
+        SoftmaxClassifier classifier;
+        std::vector<nlohmann::json> classes;
+        double threshold = 1.0;
+    };
+
+    // Labels a sample of `rows` with the model into `answers`, then embeds only that sample to
+    // train and calibrate. Runs without the lock.
+    Training Train(const ContextColumnBatch& batch, const std::vector<size_t>& rows, const ModelAnswers& model_answers,
+                   nlohmann::json& answers) const;
+
+    Options options_;
+    mutable std::mutex mutex_;
+    // Signalled when the chunk that claimed training publishes its result.
+    std::condition_variable trained_;
+    bool training_ = false;
+    State state_ = State::PENDING;
+    SoftmaxClassifier classifier_;
+    std::vector<nlohmann::json> classes_;
+    double threshold_ = 1.0;
+};
+
+}// namespace flock
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include "flock/core/context_column_batch.hpp"
+#include "flock/model_manager/model.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+
+namespace duckdb_re2 {
+class RE2;
+}// namespace duckdb_re2
+
+namespace flock {
+
+// Inline `distill` option of `llm_filter`. The model labels a random sample of the first chunk and
+// is asked once for an RE2 regular expression equivalent to the prompt. When the expression agrees
+// with the labels on enough of the sample, it answers every later row without a request; otherwise
+// the call keeps asking the model. Only calls with a single text context column are distilled.
+class DistilledPredicate {
+public:
+    static constexpr auto OPTION_NAME = "distill";
+    static constexpr size_t DEFAULT_SAMPLE_SIZE = 200;
+    static constexpr double DEFAULT_AGREEMENT = 0.95;
+    // Labelled examples of each kind shown to the model when it writes the expression.
+    static constexpr size_t MAX_EXAMPLES = 10;
+
+    enum class State { PENDING, ACCEPTED, REJECTED };
+
+    struct Options {
+        size_t sample_size = DEFAULT_SAMPLE_SIZE;
+        double agreement = DEFAULT_AGREEMENT;
+
+        bool operator==(const Options& other) const {
+            return sample_size == other.sample_size && agreement == other.agreement;
+        }
+    };
+
+    // `true`, or a struct with optional `sample_size` and `agreement`; std::nullopt for `false`.
+    static std::optional<Options> ParseOptions(const nlohmann::json& value);
+
+    explicit DistilledPredicate(Options options);
+    ~DistilledPredicate();
+
+    // One answer per row. Rows the predicate cannot answer are null and listed in `model_rows`, to
+    // be sent to the model by the caller. The first chunk larger than the sample is used to derive
+    // the expression; other threads wait for it instead of paying for their own requests. Once
+    // derived, the expression is matched without holding the lock.
+    nlohmann::json Answer(const ContextColumnBatch& batch, const std::string& prompt, Model& model,
+                          std::vector<size_t>& model_rows);
+
+    const Options& GetOptions() const {
+        return options_;
+    }
+    State GetState() const;
+    std::string GetPattern() const;
+
+    static std::string BuildPatternPrompt(const std::string& prompt, const std::vector<std::string>& matching,
+                                          const std::vector<std::string>& non_matching);
+
+private:
+    struct Training {
+        State state = State::REJECTED;
+        std::string pattern;
+        std::shared_ptr<const duckdb_re2::RE2> regex;
+    };
+
+    // The row texts, or std::nullopt when the context columns cannot be matched as one text.
+    static std::optional<std::vector<std::optional<std::string>>> GetRowTexts(const ContextColumnBatch& batch);
+    // Labels a sample of the rows with the model, writes the labels into `answers`, and accepts or
+    // rejects the expression the model derives from them. The labelled rows shown to the model as
+    // examples are left out of the agreement check.
+    Training Train(const ContextColumnBatch& batch, const std::vector<std::optional<std::string>>& texts,
+                   const std::string& prompt, Model& model, nlohmann::json& answers) const;
+    static bool Matches(const duckdb_re2::RE2& regex, const std::string& text);
+
+    Options options_;
+    mutable std::mutex mutex_;
+    std::condition_variable trained_;
+    bool training_ = false;
+    State state_ = State::PENDING;
+    std::string pattern_;
+    // Immutable once published; RE2 matching is thread-safe.
+    std::shared_ptr<const duckdb_re2::RE2> regex_;
+};
+
+}// namespace flock
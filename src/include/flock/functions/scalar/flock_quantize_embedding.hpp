@@ -0,0 +1,37 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include <string>
+
+namespace flock {
+
+// Compact BLOB encodings of float embeddings. The first byte names the encoding:
+//   int8:   [1][float32 scale][dims x int8 code], each value ~= code * scale
+//   binary: [2][uint32 dims][ceil(dims / 8) bytes], one sign bit per dimension, first dimension in the MSB
+enum class EmbeddingEncoding : uint8_t { INT8 = 1,
+                                         BINARY = 2 };
+
+// Read-only view of an encoded embedding; `data` points into the BLOB it was parsed from.
+struct QuantizedEmbedding {
+    EmbeddingEncoding encoding;
+    float scale;
+    uint32_t dims;
+    const uint8_t* data;
+};
+
+// flock_quantize_embedding(embedding[, 'int8' | 'binary']): stores an embedding in 4x (int8) or
+// 32x (binary) less space than FLOAT[]; flock_topk_similar scores the encoded form directly.
+class FlockQuantizeEmbedding {
+public:
+    static constexpr auto FUNCTION_NAME = "flock_quantize_embedding";
+    static constexpr size_t HEADER_SIZE = 5;
+
+    static EmbeddingEncoding ParseEncoding(const std::string& encoding);
+    static std::string Quantize(const float* values, idx_t dims, EmbeddingEncoding encoding);
+    // Throws for BLOBs that were not written by Quantize.
+    static QuantizedEmbedding Parse(const char* blob, idx_t size);
+
+    static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
+};
+
+}// namespace flock
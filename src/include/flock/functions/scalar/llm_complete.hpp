@@ -12,7 +12,11 @@ public:
             duckdb::ScalarFunction& bound_function,
             duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
     static void ValidateArguments(duckdb::DataChunk& args);
-    static std::vector<std::string> Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data);
+    // One answer per row, or a single answer when the prompt has no context columns.
+    static std::vector<nlohmann::json> Answer(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data);
+    static std::vector<std::string> Operation(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 };
 
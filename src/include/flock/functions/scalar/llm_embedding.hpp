@@ -12,7 +12,8 @@ public:
             duckdb::ScalarFunction& bound_function,
             duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
     static void ValidateArguments(duckdb::DataChunk& args);
-    static std::vector<duckdb::vector<duckdb::Value>> Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data);
+    // One embedding per row: a JSON number array, a base64 float32 buffer, or null.
+    static std::vector<nlohmann::json> Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 };
 
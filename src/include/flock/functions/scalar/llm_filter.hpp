@@ -7,13 +7,38 @@ namespace flock {
 
 class LlmFilter : public ScalarFunctionBase {
 public:
+    // Model struct option `{'cascade': {'model_name': ..., 'threshold': ...}}`: the model evaluates
+    // every row with a self-reported confidence, and rows below the threshold are escalated to the
+    // cascade model.
+    static constexpr auto CASCADE_OPTION_NAME = "cascade";
+    static constexpr double DEFAULT_CASCADE_THRESHOLD = 0.8;
+
     static duckdb::unique_ptr<duckdb::FunctionData> Bind(
             duckdb::ClientContext& context,
             duckdb::ScalarFunction& bound_function,
             duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
     static void ValidateArguments(duckdb::DataChunk& args);
-    static std::vector<std::string> Operation(duckdb::DataChunk& args, LlmFunctionBindData* bind_data);
+    // One answer per row (rows without an answer are true), or a single answer without context columns.
+    static std::vector<nlohmann::json> Answer(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data);
+    static std::vector<std::string> Operation(duckdb::ClientContext& context, duckdb::DataChunk& args,
+                                              LlmFunctionBindData* bind_data);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
+
+    static std::string BuildCascadePrompt(const std::string& prompt);
+    static nlohmann::json BuildCascadeItemSchema();
+
+private:
+    // Validates the `cascade` option and resolves its model.
+    static void BindCascade(LlmFunctionBindData& bind_data);
+    // One answer per row from the model, or from the cascade when one is configured.
+    static nlohmann::json ModelAnswers(const ContextColumnBatch& batch, const LlmFunctionBindData& bind_data,
+                                       Model& model);
+    // One answer per row from the distilled predicate where it applies, from ModelAnswers otherwise.
+    static nlohmann::json DistilledAnswers(const ContextColumnBatch& batch, const LlmFunctionBindData& bind_data,
+                                           Model& model);
+    // One answer per row: confident answers of the first model, the cascade model's answers for the rest.
+    static nlohmann::json CascadeAnswers(const ContextColumnBatch& batch, const LlmFunctionBindData& bind_data);
 };
 
 }// namespace flock
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "flock/functions/llm_function_bind_data.hpp"
+#include "flock/functions/scalar/scalar.hpp"
+
+#include <memory>
+
+namespace flock {
+
+struct FusedTask {
+    std::string prompt;
+    ScalarFunctionType function_type;
+};
+
+// Sibling llm_complete / llm_filter calls that share a model and context columns. The first
+// call evaluated on a chunk answers every task in one request; its siblings reuse the result.
+struct LlmFusionGroup {
+    uint64_t id;
+    nlohmann::json model_json;
+    std::vector<FusedTask> tasks;
+};
+
+struct LlmFusedBindData : public LlmFunctionBindData {
+    std::shared_ptr<const LlmFusionGroup> group;
+    idx_t task_index = 0;
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        auto result = duckdb::make_uniq<LlmFusedBindData>();
+        result->model_json = model_json;
+        result->prompt = prompt;
+        result->group = group;
+        result->task_index = task_index;
+        return std::move(result);
+    }
+
+    bool Equals(const duckdb::FunctionData& other) const override {
+        auto& other_bind = other.Cast<LlmFusedBindData>();
+        return group->id == other_bind.group->id && task_index == other_bind.task_index;
+    }
+};
+
+class LlmFused : public ScalarFunctionBase {
+public:
+    static constexpr auto FUNCTION_NAME = "llm_fused";
+
+    static std::shared_ptr<const LlmFusionGroup> CreateGroup(const nlohmann::json& model_json,
+                                                             std::vector<FusedTask> tasks);
+    // Turns a bound llm_complete / llm_filter call into the fused variant answering `task_index`.
+    static void Rewrite(duckdb::BoundFunctionExpression& call, const std::shared_ptr<const LlmFusionGroup>& group,
+                        idx_t task_index);
+
+    static std::string GetTaskKey(idx_t task_index);
+    static std::string BuildFusedPrompt(const std::vector<FusedTask>& tasks);
+    static nlohmann::json BuildItemSchema(const std::vector<FusedTask>& tasks);
+    // Splits one object per row into one result column per task, formatted like the unfused call.
+    static std::vector<std::vector<std::string>> SplitResponses(const nlohmann::json& responses,
+                                                                const std::vector<FusedTask>& tasks);
+    static std::vector<std::vector<std::string>> Operation(const ContextColumnBatch& batch,
+                                                           const LlmFusionGroup& group);
+    static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
+};
+
+}// namespace flock
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include "flock/core/context_column_batch.hpp"
+#include "flock/model_manager/model.hpp"
+#include "flock/prompt_manager/repository.hpp"
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace flock {
+
+// Model option `long_input` of `llm_complete` and `llm_filter`. A row that exceeds the context
+// window even alone would otherwise come back NULL; instead its longest text value is split into
+// overlapping chunks, the chunks of all such rows are answered concurrently in waves of at most
+// flock_max_http_concurrency requests, and a final request per row combines the partial answers
+// into the function's usual answer. Audio columns are transcribed once per row, before splitting.
+class LongInput {
+public:
+    static constexpr auto PARTIAL_ANSWERS_COLUMN = "partial_answers";
+
+    // Answers for `rows` of `batch`, in order. A row stays NULL when it has no text long enough
+    // to split, or when one of its chunks or the combined partial answers still do not fit.
+    static std::vector<nlohmann::json> CompleteRows(const ContextColumnBatch& batch, const std::vector<int>& rows,
+                                                    const std::string& user_prompt,
+                                                    ScalarFunctionType function_type, Model& model);
+
+    // The text context column with the longest value in `row`, if any.
+    static std::optional<size_t> LongestTextColumn(const ContextColumnBatch& batch, size_t row);
+};
+
+}// namespace flock
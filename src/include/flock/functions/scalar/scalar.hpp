@@ -45,21 +45,56 @@ public:
     static std::vector<std::any> Operation(duckdb::DataChunk& args);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 
-    static void QueueCompletion(nlohmann::json& tuples, const std::string& user_prompt,
-                                ScalarFunctionType function_type, Model& model);
+    // A completion request rendered for one batch, ready to be queued on a model.
+    struct RenderedCompletion {
+        std::string prompt;
+        nlohmann::json media_data;
+        OutputType output_type = OutputType::STRING;
+        OutputEncoding output_encoding = OutputEncoding::JSON;
+        int num_tuples = 0;
+    };
+
+    // Renders the request for a batch without touching the model, so several batches can be
+    // rendered on different threads. Compact encodings are only used when the model enables
+    // them and `allow_compact_output` is set.
+    static RenderedCompletion RenderCompletion(const nlohmann::json& tuples, const std::string& user_prompt,
+                                               ScalarFunctionType function_type, const ModelDetails& model_details,
+                                               bool allow_compact_output = true);
+    static void QueueRendered(const RenderedCompletion& rendered, const std::string& user_prompt, Model& model);
+    // Renders and queues in one step; returns the encoding the queued request asks for.
+    static OutputEncoding QueueCompletion(nlohmann::json& tuples, const std::string& user_prompt,
+                                          ScalarFunctionType function_type, Model& model,
+                                          bool allow_compact_output = true);
+    // Decodes a batch response; std::nullopt means a compact answer failed validation.
+    static std::optional<nlohmann::json> DecodeItems(const nlohmann::json& response, OutputEncoding output_encoding,
+                                                     size_t expected_count);
     static nlohmann::json Complete(nlohmann::json& tuples, const std::string& user_prompt,
                                    ScalarFunctionType function_type, Model& model);
-    static nlohmann::json BatchAndCompleteSync(const nlohmann::json& tuples,
+    static nlohmann::json BatchAndCompleteSync(const ContextColumnBatch& batch,
                                                const std::string& user_prompt_name,
                                                ScalarFunctionType function_type,
                                                Model& model);
-    static nlohmann::json BatchAndCompleteAsync(const nlohmann::json& tuples,
+    static nlohmann::json BatchAndCompleteAsync(const ContextColumnBatch& batch,
                                                 const std::string& user_prompt_name,
                                                 ScalarFunctionType function_type,
                                                 Model& model);
-    static nlohmann::json BatchAndComplete(const nlohmann::json& tuples,
+    // Sends the rows in batches with the model's sync or async strategy.
+    static nlohmann::json DispatchBatches(const ContextColumnBatch& batch,
+                                          const std::string& user_prompt_name, ScalarFunctionType function_type,
+                                          Model& model);
+    // Answers empty rows with the model's `empty_input_default`, sends each distinct row once,
+    // and copies its answer to the duplicates.
+    static nlohmann::json BatchAndComplete(const ContextColumnBatch& batch,
                                            const std::string& user_prompt_name, ScalarFunctionType function_type,
                                            Model& model);
+    // Serves rows from the result cache when the model enables it and dispatches the rest.
+    static nlohmann::json CompleteWithCache(const ContextColumnBatch& batch,
+                                           const std::string& user_prompt_name, ScalarFunctionType function_type,
+                                           Model& model);
+
+    // The answer to the bound prompt when it has no context columns, sent once per query.
+    static nlohmann::json CompleteConstant(duckdb::ClientContext& context, const LlmFunctionBindData& bind_data,
+                                           OutputType output_type, Model& model);
 
     static duckdb::unique_ptr<LlmFunctionBindData> ValidateAndInitializeBindData(
             duckdb::ClientContext& context,
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "duckdb/function/aggregate_function.hpp"
+#include "duckdb/function/function_set.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "flock/core/common.hpp"
+#include "flock/functions/scalar/flock_quantize_embedding.hpp"
+
+#include <string>
+#include <vector>
+
+namespace flock {
+
+enum class SimilarityMetric { COSINE,
+                              DOT };
+
+struct TopkSimilarBindData : public duckdb::FunctionData {
+    SimilarityMetric metric = SimilarityMetric::COSINE;
+    idx_t k = 0;
+    // Candidates kept per state: k, or k * RESCORE_FACTOR when a full-precision column rescores them.
+    idx_t capacity = 0;
+    bool rescore = false;
+    // Unit length for COSINE, as given for DOT.
+    std::vector<float> query;
+    // The query in both quantized encodings, for BLOB embedding columns.
+    std::string query_int8;
+    std::string query_binary;
+    double query_int8_norm = 0.0;
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<TopkSimilarBindData>(*this);
+    }
+
+    bool Equals(const duckdb::FunctionData& other) const override {
+        auto& other_bind = other.Cast<TopkSimilarBindData>();
+        return metric == other_bind.metric && k == other_bind.k && rescore == other_bind.rescore &&
+               query == other_bind.query;
+    }
+};
+
+// Bounded min-heap of the best candidates seen by one thread; states are merged in Combine.
+struct TopkSimilarState {
+    struct Candidate {
+        double score;
+        duckdb::Value value;
+        std::vector<float> rescore_embedding;
+    };
+    std::vector<Candidate>* candidates;
+};
+
+// flock_topk_similar(query, table, k): the k rows of `table` whose embedding column is most similar
+// to `query`, with a `score` column, best first. It expands to the flock_topk_similar_agg aggregate,
+// so DuckDB scans the table in parallel with one heap per thread.
+class FlockTopkSimilar {
+public:
+    static constexpr auto FUNCTION_NAME = "flock_topk_similar";
+    static constexpr auto AGGREGATE_NAME = "flock_topk_similar_agg";
+    static constexpr auto DEFAULT_COLUMN = "embedding";
+    static constexpr idx_t RESCORE_FACTOR = 4;
+
+    static duckdb::unique_ptr<duckdb::TableRef> BindReplace(duckdb::ClientContext& context,
+                                                            duckdb::TableFunctionBindInput& input);
+
+    // flock_topk_similar_agg(value, embedding, query, k, metric[, rescore_embedding]) returns up to k
+    // STRUCT(value, score) entries, best first. Embeddings are float lists or flock_quantize_embedding BLOBs.
+    static duckdb::unique_ptr<duckdb::FunctionData> Bind(duckdb::ClientContext& context,
+                                                         duckdb::AggregateFunction& function,
+                                                         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
+    static void Initialize(const duckdb::AggregateFunction& function, duckdb::data_ptr_t state_p);
+    static void Update(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data, idx_t input_count,
+                       duckdb::Vector& states, idx_t count);
+    static void SimpleUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data, idx_t input_count,
+                             duckdb::data_ptr_t state_p, idx_t count);
+    static void Combine(duckdb::Vector& source, duckdb::Vector& target, duckdb::AggregateInputData& aggr_input_data,
+                        idx_t count);
+    static void Finalize(duckdb::Vector& states, duckdb::AggregateInputData& aggr_input_data, duckdb::Vector& result,
+                         idx_t count, idx_t offset);
+    static void Destroy(duckdb::Vector& states, duckdb::AggregateInputData& aggr_input_data, idx_t count);
+
+    static SimilarityMetric ParseMetric(const std::string& metric);
+    // Similarity of the query to one embedding; higher is more similar. Binary embeddings are
+    // scored by the fraction of matching bits, whatever the metric.
+    static double Score(const TopkSimilarBindData& bind_data, const float* embedding, idx_t dims);
+    static double Score(const TopkSimilarBindData& bind_data, const QuantizedEmbedding& embedding);
+
+private:
+    template<class STATE_OF_ROW>
+    static void AddRows(duckdb::Vector inputs[], const TopkSimilarBindData& bind_data, idx_t input_count, idx_t count,
+                        STATE_OF_ROW state_of_row);
+    static void AddCandidate(TopkSimilarState& state, idx_t capacity, TopkSimilarState::Candidate candidate);
+};
+
+}// namespace flock
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "duckdb/function/table_function.hpp"
+#include "flock/vector_index/vector_index.hpp"
+
+namespace flock {
+
+struct VectorIndexBindData : public duckdb::TableFunctionData {
+    VectorIndex::Definition definition;
+    // Text or embedding to search for.
+    duckdb::Value query;
+    idx_t k = 0;
+    idx_t ef_search = 0;
+};
+
+// The statements run once, on the first call; matches are emitted over as many calls as needed.
+struct VectorIndexGlobalState : public duckdb::GlobalTableFunctionState {
+    bool done = false;
+    std::vector<VectorIndex::Match> matches;
+    idx_t offset = 0;
+};
+
+// Table functions over VectorIndex:
+//   flock_create_index(name, table, key_column, embedding_column[, model])
+//   flock_update_index(name), flock_drop_index(name)
+//   flock_knn(name, query, k): the k nearest rows of the indexed table with a `score` column,
+//   where `query` is an embedding or a text embedded with the index's model. It expands to a
+//   join of the table with flock_knn_keys(name, query, k), which returns (row_key, score).
+class FlockVectorIndex {
+public:
+    static constexpr auto CREATE_FUNCTION_NAME = "flock_create_index";
+    static constexpr auto UPDATE_FUNCTION_NAME = "flock_update_index";
+    static constexpr auto DROP_FUNCTION_NAME = "flock_drop_index";
+    static constexpr auto KNN_FUNCTION_NAME = "flock_knn";
+    static constexpr auto KNN_KEYS_FUNCTION_NAME = "flock_knn_keys";
+
+    static duckdb::unique_ptr<duckdb::FunctionData> BindCreate(duckdb::ClientContext& context,
+                                                               duckdb::TableFunctionBindInput& input,
+                                                               duckdb::vector<duckdb::LogicalType>& return_types,
+                                                               duckdb::vector<std::string>& names);
+    static duckdb::unique_ptr<duckdb::FunctionData> BindUpdate(duckdb::ClientContext& context,
+                                                               duckdb::TableFunctionBindInput& input,
+                                                               duckdb::vector<duckdb::LogicalType>& return_types,
+                                                               duckdb::vector<std::string>& names);
+    static duckdb::unique_ptr<duckdb::FunctionData> BindDrop(duckdb::ClientContext& context,
+                                                             duckdb::TableFunctionBindInput& input,
+                                                             duckdb::vector<duckdb::LogicalType>& return_types,
+                                                             duckdb::vector<std::string>& names);
+    static duckdb::unique_ptr<duckdb::FunctionData> BindKnnKeys(duckdb::ClientContext& context,
+                                                                duckdb::TableFunctionBindInput& input,
+                                                                duckdb::vector<duckdb::LogicalType>& return_types,
+                                                                duckdb::vector<std::string>& names);
+    static duckdb::unique_ptr<duckdb::TableRef> BindReplaceKnn(duckdb::ClientContext& context,
+                                                               duckdb::TableFunctionBindInput& input);
+    static duckdb::unique_ptr<duckdb::GlobalTableFunctionState> InitGlobal(duckdb::ClientContext& context,
+                                                                           duckdb::TableFunctionInitInput& input);
+
+    static void ExecuteCreate(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                              duckdb::DataChunk& output);
+    static void ExecuteUpdate(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                              duckdb::DataChunk& output);
+    static void ExecuteDrop(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                            duckdb::DataChunk& output);
+    static void ExecuteKnnKeys(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                               duckdb::DataChunk& output);
+
+private:
+    static std::string GetIndexName(const duckdb::TableFunctionBindInput& input, const std::string& function_name);
+    // k and ef_search from the arguments, validated.
+    static void BindSearchSize(const duckdb::TableFunctionBindInput& input, VectorIndexBindData& bind_data);
+};
+
+}// namespace flock
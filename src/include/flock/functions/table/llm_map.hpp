@@ -0,0 +1,107 @@
+#pragma once
+
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "flock/core/context_column_batch.hpp"
+#include "flock/functions/llm_function_bind_data.hpp"
+
+#include <atomic>
+#include <deque>
+#include <future>
+#include <optional>
+
+namespace flock {
+
+struct LlmMapBindData : public LlmFunctionBindData {
+    std::vector<std::string> column_names;
+    size_t batch_size = 1;
+    size_t inflight_batches = 1;
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        auto result = duckdb::make_uniq<LlmMapBindData>();
+        result->model_json = model_json;
+        result->prompt = prompt;
+        result->column_names = column_names;
+        result->batch_size = batch_size;
+        result->inflight_batches = inflight_batches;
+        return std::move(result);
+    }
+
+    bool Equals(const duckdb::FunctionData& other) const override {
+        auto& other_bind = other.Cast<LlmMapBindData>();
+        return LlmFunctionBindData::Equals(other) && column_names == other_bind.column_names &&
+               batch_size == other_bind.batch_size && inflight_batches == other_bind.inflight_batches;
+    }
+};
+
+// Rows buffered by one thread, kept columnar in collections of at most `batch_size` rows. Full
+// batches are handed to the RequestExecutor while the thread keeps consuming input; answered
+// batches are emitted in the order their rows arrived.
+struct LlmMapLocalState : public duckdb::LocalTableFunctionState {
+    struct Batch {
+        duckdb::unique_ptr<duckdb::ColumnDataCollection> rows;
+        std::future<nlohmann::json> answers;
+    };
+
+    // An answered batch, copied to the output one scanned chunk at a time.
+    struct AnsweredBatch {
+        duckdb::unique_ptr<duckdb::ColumnDataCollection> rows;
+        std::vector<std::optional<std::string>> answers;
+        duckdb::ColumnDataScanState scan_state;
+        duckdb::DataChunk chunk;
+        idx_t chunk_offset = 0;
+        idx_t emitted = 0;
+    };
+
+    // Waits for the batches still on the executor, which use `db`; those not started yet are skipped.
+    ~LlmMapLocalState() override;
+
+    duckdb::DatabaseInstance* db = nullptr;
+    duckdb::Allocator* allocator = nullptr;
+    const void* invocation_id = nullptr;
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    // Rows not sent yet; every collection but the last holds a full batch.
+    std::deque<duckdb::unique_ptr<duckdb::ColumnDataCollection>> pending;
+    std::deque<Batch> inflight;
+    std::deque<AnsweredBatch> ready;
+    bool input_consumed = false;
+};
+
+// llm_map(TABLE, model, prompt): answers the prompt for every input row, using all input
+// columns as context, and returns the input columns plus one answer column.
+class LlmMap {
+public:
+    static constexpr auto FUNCTION_NAME = "llm_map";
+    static constexpr auto DEFAULT_OUTPUT_COLUMN = "result";
+    static constexpr size_t DEFAULT_INFLIGHT_BATCHES = 4;
+
+    static duckdb::unique_ptr<duckdb::FunctionData> Bind(duckdb::ClientContext& context,
+                                                         duckdb::TableFunctionBindInput& input,
+                                                         duckdb::vector<duckdb::LogicalType>& return_types,
+                                                         duckdb::vector<std::string>& names);
+    static duckdb::unique_ptr<duckdb::LocalTableFunctionState> InitLocal(duckdb::ExecutionContext& context,
+                                                                          duckdb::TableFunctionInitInput& input,
+                                                                          duckdb::GlobalTableFunctionState* global_state);
+    static duckdb::OperatorResultType Execute(duckdb::ExecutionContext& context, duckdb::TableFunctionInput& data,
+                                              duckdb::DataChunk& input, duckdb::DataChunk& output);
+    static duckdb::OperatorFinalizeResultType Finalize(duckdb::ExecutionContext& context,
+                                                       duckdb::TableFunctionInput& data, duckdb::DataChunk& output);
+
+    // Context columns for `rows`, shaped like the scalar functions' `context_columns`.
+    static ContextColumnBatch BuildContextColumns(const std::vector<std::string>& column_names,
+                                                  const duckdb::ColumnDataCollection& rows);
+    // The answer as text, or nothing for NULL.
+    static std::optional<std::string> FormatAnswer(const nlohmann::json& answer);
+
+private:
+    // Appends `input` to the pending collections, starting a new one every `batch_size` rows.
+    static void BufferRows(const LlmMapBindData& bind_data, LlmMapLocalState& state, duckdb::DataChunk& input);
+    // Sends buffered rows in batches of `batch_size`; with `flush` set the remainder is sent too.
+    static void SubmitBatches(const LlmMapBindData& bind_data, LlmMapLocalState& state, bool flush);
+    static void SubmitBatch(const LlmMapBindData& bind_data, LlmMapLocalState& state, LlmMapLocalState::Batch batch);
+    static void MoveAnswersToReady(LlmMapLocalState::Batch& batch, LlmMapLocalState& state);
+    // Fills `output` from answered batches; with `wait` set it blocks on the oldest batch.
+    static void Emit(LlmMapLocalState& state, duckdb::DataChunk& output, bool wait);
+};
+
+}// namespace flock
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include "flock/prompt_manager/repository.hpp"
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace flock {
+
+// Native result types for the scalar LLM functions, selected with the inline `returns` option
+// of the model struct. Answers are written straight into flat result vectors.
+class TypedOutput {
+public:
+    static constexpr auto OPTION_NAME = "returns";
+
+    // Return type of `function_type` for `returns`, or std::nullopt for the default text result.
+    // `schema` derives the type from model_parameters.response_format.json_schema.schema.
+    static std::optional<duckdb::LogicalType> ResolveReturnType(const std::string& returns,
+                                                                const nlohmann::json& model_json,
+                                                                ScalarFunctionType function_type);
+    // Maps a JSON schema to a DuckDB type: string -> VARCHAR, integer -> BIGINT, number -> DOUBLE,
+    // boolean -> BOOLEAN, object -> STRUCT, array -> LIST. Anything else stays JSON text.
+    static duckdb::LogicalType TypeFromJsonSchema(const nlohmann::json& schema);
+    // llm_embedding: 'float' returns FLOAT[N] with N taken from model_parameters.dimensions;
+    // 'double' (the default) returns std::nullopt for DOUBLE[].
+    static std::optional<duckdb::LogicalType> ResolveEmbeddingType(const std::string& returns,
+                                                                   const nlohmann::json& model_json);
+
+    // Writes one answer per row; a single answer is repeated for all `count` rows. Answers that
+    // are null or do not fit the result type become NULL.
+    static void WriteAnswers(const std::vector<nlohmann::json>& answers, duckdb::Vector& result, idx_t count);
+    static void WriteStrings(const std::vector<std::string>& values, duckdb::Vector& result, idx_t count);
+    static void WriteValue(duckdb::Vector& vector, idx_t row, const nlohmann::json& answer);
+    // Writes one embedding per row into a DOUBLE[] or FLOAT[N] result. Embeddings are JSON number
+    // arrays or base64 float32 buffers, which are decoded straight into the child vector.
+    static void WriteEmbeddings(const std::vector<nlohmann::json>& embeddings, duckdb::Vector& result, idx_t count);
+};
+
+}// namespace flock
@@ -70,6 +70,44 @@ public:
         GetThreadMetricsUnlocked(state_id).GetMetrics(type).execution_time_us += duration_us;
     }
 
+    // Add semantic cache outcomes (accumulative)
+    void AddSemanticCacheStats(const StateId& state_id, FunctionType type, int64_t hits, int64_t misses, int64_t rejections) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& metrics = GetThreadMetricsUnlocked(state_id).GetMetrics(type);
+        metrics.semantic_cache_hits += hits;
+        metrics.semantic_cache_misses += misses;
+        metrics.semantic_cache_threshold_rejections += rejections;
+    }
+
+    // Add cascade stage outcomes (accumulative)
+    void AddCascadeStats(const StateId& state_id, FunctionType type, const std::string& cascade_model_name,
+                         int64_t confident_rows, int64_t escalated_rows) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& metrics = GetThreadMetricsUnlocked(state_id).GetMetrics(type);
+        metrics.cascade_model_name = cascade_model_name;
+        metrics.cascade_confident_rows += confident_rows;
+        metrics.cascade_escalated_rows += escalated_rows;
+    }
+
+    // Record the outcome of training a distilled classifier
+    void SetClassifierTraining(const StateId& state_id, FunctionType type, int64_t training_rows, int64_t holdout_rows,
+                               double holdout_accuracy, double threshold) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& metrics = GetThreadMetricsUnlocked(state_id).GetMetrics(type);
+        metrics.classifier_training_rows = training_rows;
+        metrics.classifier_holdout_rows = holdout_rows;
+        metrics.classifier_holdout_accuracy = holdout_accuracy;
+        metrics.classifier_threshold = threshold;
+    }
+
+    // Add rows answered by a distilled classifier and rows it left to the model (accumulative)
+    void AddClassifierRows(const StateId& state_id, FunctionType type, int64_t local_rows, int64_t model_rows) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& metrics = GetThreadMetricsUnlocked(state_id).GetMetrics(type);
+        metrics.classifier_local_rows += local_rows;
+        metrics.classifier_model_rows += model_rows;
+    }
+
     // Get flattened metrics structure (merged across threads)
     nlohmann::json GetMetrics() const {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -119,6 +157,23 @@ public:
                         merged.api_calls += metrics.api_calls;
                         merged.api_duration_us += metrics.api_duration_us;
                         merged.execution_time_us += metrics.execution_time_us;
+                        merged.semantic_cache_hits += metrics.semantic_cache_hits;
+                        merged.semantic_cache_misses += metrics.semantic_cache_misses;
+                        merged.semantic_cache_threshold_rejections += metrics.semantic_cache_threshold_rejections;
+                        merged.cascade_confident_rows += metrics.cascade_confident_rows;
+                        merged.cascade_escalated_rows += metrics.cascade_escalated_rows;
+                        if (merged.cascade_model_name.empty()) {
+                            merged.cascade_model_name = metrics.cascade_model_name;
+                        }
+                        // Only the invocation that trained the classifier reports its training.
+                        if (metrics.classifier_training_rows != 0) {
+                            merged.classifier_training_rows = metrics.classifier_training_rows;
+                            merged.classifier_holdout_rows = metrics.classifier_holdout_rows;
+                            merged.classifier_holdout_accuracy = metrics.classifier_holdout_accuracy;
+                            merged.classifier_threshold = metrics.classifier_threshold;
+                        }
+                        merged.classifier_local_rows += metrics.classifier_local_rows;
+                        merged.classifier_model_rows += metrics.classifier_model_rows;
 
                         if (merged.model_name.empty() && !metrics.model_name.empty()) {
                             merged.model_name = metrics.model_name;
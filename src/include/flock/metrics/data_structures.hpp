@@ -19,6 +19,22 @@ struct FunctionMetricsData {
     int64_t api_calls = 0;
     int64_t api_duration_us = 0;
     int64_t execution_time_us = 0;
+    int64_t semantic_cache_hits = 0;
+    int64_t semantic_cache_misses = 0;
+    // Misses whose nearest cached row was comparable but below the similarity threshold.
+    int64_t semantic_cache_threshold_rejections = 0;
+    // `llm_filter` cascade: rows the first model answered confidently, and rows sent on to `cascade_model_name`.
+    std::string cascade_model_name;
+    int64_t cascade_confident_rows = 0;
+    int64_t cascade_escalated_rows = 0;
+    // Distilled classifier: labelled rows it was trained and evaluated on, its held-out accuracy, the
+    // confidence threshold calibrated on the held-out rows, and rows answered locally or by the model.
+    int64_t classifier_training_rows = 0;
+    int64_t classifier_holdout_rows = 0;
+    double classifier_holdout_accuracy = 0;
+    double classifier_threshold = 0;
+    int64_t classifier_local_rows = 0;
+    int64_t classifier_model_rows = 0;
 
     int64_t total_tokens() const noexcept {
         return input_tokens + output_tokens;
@@ -34,7 +50,9 @@ struct FunctionMetricsData {
 
     bool IsEmpty() const noexcept {
         return input_tokens == 0 && output_tokens == 0 && api_calls == 0 &&
-               api_duration_us == 0 && execution_time_us == 0;
+               api_duration_us == 0 && execution_time_us == 0 && semantic_cache_hits == 0 &&
+               semantic_cache_misses == 0 && cascade_confident_rows == 0 && cascade_escalated_rows == 0 &&
+               classifier_training_rows == 0 && classifier_local_rows == 0 && classifier_model_rows == 0;
     }
 
     nlohmann::json ToJson() const {
@@ -52,6 +70,24 @@ struct FunctionMetricsData {
         if (!provider.empty()) {
             result["provider"] = provider;
         }
+        if (semantic_cache_hits != 0 || semantic_cache_misses != 0) {
+            result["semantic_cache_hits"] = semantic_cache_hits;
+            result["semantic_cache_misses"] = semantic_cache_misses;
+            result["semantic_cache_threshold_rejections"] = semantic_cache_threshold_rejections;
+        }
+        if (cascade_confident_rows != 0 || cascade_escalated_rows != 0) {
+            result["cascade_model_name"] = cascade_model_name;
+            result["cascade_confident_rows"] = cascade_confident_rows;
+            result["cascade_escalated_rows"] = cascade_escalated_rows;
+        }
+        if (classifier_training_rows != 0 || classifier_local_rows != 0 || classifier_model_rows != 0) {
+            result["classifier_training_rows"] = classifier_training_rows;
+            result["classifier_holdout_rows"] = classifier_holdout_rows;
+            result["classifier_holdout_accuracy"] = classifier_holdout_accuracy;
+            result["classifier_threshold"] = classifier_threshold;
+            result["classifier_local_rows"] = classifier_local_rows;
+            result["classifier_model_rows"] = classifier_model_rows;
+        }
 
         return result;
     }
@@ -95,6 +95,68 @@ public:
         }
     }
 
+    // Record semantic cache hits, misses and threshold rejections (accumulative)
+    static void AddSemanticCacheStats(int64_t hits, int64_t misses, int64_t rejections) {
+        if (current_db_ != nullptr && current_state_id_ != nullptr) {
+            auto& manager = GetForDatabase(current_db_);
+            manager.BaseMetricsManager<const void*>::AddSemanticCacheStats(current_state_id_, current_function_type_, hits, misses, rejections);
+        }
+    }
+
+    // Record rows answered by the first `llm_filter` cascade stage and rows escalated to `cascade_model_name`
+    static void AddCascadeStats(const std::string& cascade_model_name, int64_t confident_rows, int64_t escalated_rows) {
+        if (current_db_ != nullptr && current_state_id_ != nullptr) {
+            auto& manager = GetForDatabase(current_db_);
+            manager.BaseMetricsManager<const void*>::AddCascadeStats(current_state_id_, current_function_type_,
+                                                                     cascade_model_name, confident_rows, escalated_rows);
+        }
+    }
+
+    // Record the training rows, held-out accuracy and calibrated threshold of a distilled classifier
+    static void SetClassifierTraining(int64_t training_rows, int64_t holdout_rows, double holdout_accuracy,
+                                      double threshold) {
+        if (current_db_ != nullptr && current_state_id_ != nullptr) {
+            auto& manager = GetForDatabase(current_db_);
+            manager.BaseMetricsManager<const void*>::SetClassifierTraining(current_state_id_, current_function_type_,
+                                                                           training_rows, holdout_rows,
+                                                                           holdout_accuracy, threshold);
+        }
+    }
+
+    // Record rows answered by a distilled classifier and rows it sent to the model
+    static void AddClassifierRows(int64_t local_rows, int64_t model_rows) {
+        if (current_db_ != nullptr && current_state_id_ != nullptr) {
+            auto& manager = GetForDatabase(current_db_);
+            manager.BaseMetricsManager<const void*>::AddClassifierRows(current_state_id_, current_function_type_,
+                                                                       local_rows, model_rows);
+        }
+    }
+
+    // The calling thread's invocation, for work a function hands to scheduler or I/O threads
+    struct Context {
+        duckdb::DatabaseInstance* db = nullptr;
+        const void* state_id = nullptr;
+        FunctionType function_type = FunctionType::UNKNOWN;
+    };
+
+    static Context GetContext() {
+        return {current_db_, current_state_id_, current_function_type_};
+    }
+
+    // Attributes metrics recorded on this thread to `context` until the scope ends
+    class ScopedContext {
+    public:
+        explicit ScopedContext(const Context& context) : previous_(GetContext()) {
+            SetContext(context);
+        }
+        ~ScopedContext() {
+            SetContext(previous_);
+        }
+
+    private:
+        Context previous_;
+    };
+
     // Clear stored context (optional, auto-cleared on next StartInvocation)
     static void ClearContext() {
         current_db_ = nullptr;
@@ -116,6 +178,12 @@ public:
     static void ExecuteResetMetrics(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 
 private:
+    static void SetContext(const Context& context) {
+        current_db_ = context.db;
+        current_state_id_ = context.state_id;
+        current_function_type_ = context.function_type;
+    }
+
     // Thread-local storage for current metrics context
     static thread_local duckdb::DatabaseInstance* current_db_;
     static thread_local const void* current_state_id_;
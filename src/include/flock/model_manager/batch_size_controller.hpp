@@ -0,0 +1,71 @@
+#pragma once
+
+#include "flock/model_manager/repository.hpp"
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace flock {
+
+// Learns the batch size of each (provider, model, prompt) with additive increase and multiplicative
+// decrease. A batch that exceeds the context window halves the size and becomes a ceiling the
+// additive steps stay below; a batch whose latency per row grows well past the learned average
+// is taken as a sign the batch stopped paying for itself and backs off more gently. The state
+// is process-wide, so later chunks and later queries start from what earlier ones learned
+// instead of rediscovering the limit through failed requests. Prompts are keyed by their hash,
+// and only the MAX_STATES most recently used keys are kept.
+class BatchSizeController {
+public:
+    static constexpr size_t MAX_STATES = 1024;
+    // Share of the model's max_batch_size added after a full batch succeeds.
+    static constexpr double ADDITIVE_INCREASE = 0.125;
+    static constexpr double TOKEN_LIMIT_DECREASE = 0.5;
+    static constexpr double LATENCY_DECREASE = 0.75;
+    // A batch slower per row than this multiple of the learned average backs off.
+    static constexpr double LATENCY_TOLERANCE = 1.5;
+    // Batches faster than this are too short for their latency to say anything about the model.
+    static constexpr double MIN_LATENCY_SIGNAL_MS = 50.0;
+    // Weight of the newest batch in the learned latency per row.
+    static constexpr double LEARNING_RATE = 0.2;
+    // Consecutive successes after which the token-limit ceiling is probed again, since the rows
+    // that exceeded it may have been unusually long.
+    static constexpr int CEILING_PROBE_SUCCESSES = 8;
+
+    struct State {
+        int batch_size = 0;
+        int largest_success = 0;
+        // Smallest batch that exceeded the context window, or 0 when none has.
+        int token_ceiling = 0;
+        int successes_since_token_limit = 0;
+        double latency_per_row_ms = 0.0;
+    };
+
+    // The batch size to start with, at most `max_batch_size`.
+    static int Initial(const ModelDetails& model_details, const std::string& user_prompt, int max_batch_size);
+    // Records a batch of `batch_size` rows that completed in `elapsed_ms` and returns the next size.
+    static int OnSuccess(const ModelDetails& model_details, const std::string& user_prompt, int batch_size,
+                         double elapsed_ms, int max_batch_size);
+    // Records a batch that exceeded the context window and returns the size to retry with, which is
+    // 0 once a single row does not fit.
+    static int OnTokenLimit(const ModelDetails& model_details, const std::string& user_prompt, int batch_size);
+
+    static std::optional<State> Get(const ModelDetails& model_details, const std::string& user_prompt);
+    static size_t Size();
+    static void Reset();
+
+private:
+    static std::string Key(const ModelDetails& model_details, const std::string& user_prompt);
+    // The state of `key`, created and marked most recently used; the caller holds `mutex_`.
+    static State& Touch(const std::string& key);
+
+    using LruList = std::list<std::pair<std::string, State>>;
+
+    inline static std::mutex mutex_;
+    inline static LruList lru_;
+    inline static std::unordered_map<std::string, LruList::iterator> states_;
+};
+
+}// namespace flock
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include <functional>
+#include <mutex>
+
+namespace flock {
+
+// Access to flock_storage for the answer caches. The database is attached to the instance once
+// and never detached here, so lookups and stores from concurrent DuckDB worker threads cannot
+// pull it away from each other; the lock serializes their statements.
+class CacheStorage {
+public:
+    // Runs `work` on a connection that sees flock_storage, under the storage lock.
+    static void Run(const std::function<void(duckdb::Connection&)>& work);
+
+private:
+    static void EnsureAttached(duckdb::Connection& con);
+
+    inline static std::mutex mutex_;
+};
+
+}// namespace flock
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
+namespace flock {
+
+// Process-wide budget for the bytes LLM requests hold while in flight. A request payload, with
+// its images, is reserved when it is sent and its response until it is parsed, so
+// `flock_max_inflight_bytes` bounds them across all threads and queries. A reservation that does
+// not fit waits for others to be released, unless nothing else is reserved: a single request
+// larger than the budget is still sent, on its own. Requests waiting to be sent are counted too,
+// so producers stop rendering, but senders never wait on them, since sending is what frees them.
+class InflightBudget {
+public:
+    static constexpr auto SETTING_NAME = "flock_max_inflight_bytes";
+    static constexpr size_t DEFAULT_MAX_BYTES = size_t(256) << 20;
+    // Growth of a streaming response between two updates of its reservation.
+    static constexpr size_t RESPONSE_STEP_BYTES = size_t(64) << 10;
+
+    // Bytes held in the budget until released or destroyed.
+    class Reservation {
+    public:
+        Reservation() = default;
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+        ~Reservation() { Release(); }
+
+        // Changes the reserved bytes without waiting, e.g. from a sent payload to its response.
+        // Only shrinking wakes waiting reservations.
+        void Resize(size_t bytes);
+        void Release();
+        size_t Bytes() const { return bytes_; }
+
+    private:
+        friend class InflightBudget;
+        Reservation(size_t bytes, bool queued) : bytes_(bytes), queued_(queued) {}
+
+        size_t bytes_ = 0;
+        bool queued_ = false;
+    };
+
+    static void Register(duckdb::DBConfig& config);
+
+    // Waits until `bytes` fit in the budget.
+    static Reservation Acquire(size_t bytes);
+    // Reserves `bytes` only if they fit now.
+    static std::optional<Reservation> TryAcquire(size_t bytes);
+    // Reserves `bytes` of a request waiting to be sent, without waiting. They count toward
+    // IsExhausted, but not toward what Acquire and TryAcquire wait for.
+    static Reservation Queue(size_t bytes);
+    // Whether the budget is used up, so producers should wait for in-flight requests first.
+    static bool IsExhausted();
+    static size_t InUse();
+    static void SetMaxBytes(size_t max_bytes);
+    static size_t GetMaxBytes();
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable released;
+        size_t max_bytes = DEFAULT_MAX_BYTES;
+        size_t in_use = 0;
+        // Part of `in_use` held by queued requests.
+        size_t queued = 0;
+    };
+
+    // Never destroyed: requests on detached I/O threads may still release bytes at process exit.
+    static State& GetState();
+    static bool Fits(const State& state, size_t bytes);
+    static void OnSettingChanged(duckdb::ClientContext& context, duckdb::SetScope scope, duckdb::Value& parameter);
+};
+
+}// namespace flock
@@ -27,14 +27,19 @@ namespace flock {
 class Model {
 public:
     explicit Model(const nlohmann::json& model_json);
-    explicit Model() = default;
+    explicit Model();
+    // Same details with a separately leased provider, for callers that must not share
+    // queued requests with `this`.
+    Model WithFreshProvider() const;
     void AddCompletionRequest(const std::string& prompt, const int num_output_tuples, OutputType output_type = OutputType::STRING, const nlohmann::json& media_data = nlohmann::json::object());
+    // Learned average output size of STRING completions, used for output token budgets.
+    void SetStringTokensPerTupleHint(std::optional<double> tokens_per_tuple);
     void AddEmbeddingRequest(const std::vector<std::string>& inputs);
     void AddTranscriptionRequest(const nlohmann::json& audio_files);
     std::vector<nlohmann::json> CollectCompletions(const std::string& contentType = "application/json");
     std::vector<nlohmann::json> CollectEmbeddings(const std::string& contentType = "application/json");
     std::vector<nlohmann::json> CollectTranscriptions(const std::string& contentType = "multipart/form-data");
-    ModelDetails GetModelDetails();
+    const ModelDetails& GetModelDetails() const;
     nlohmann::json GetModelDetailsAsJson() const;
 
     // Static helper method for binders to resolve model details to JSON
@@ -65,19 +70,26 @@ public:
     static std::shared_ptr<ModelUsageLimiter> GetOrCreateUsageLimiter(const std::string& model_name);
     static void ResetRateLimiters();
     static void ResetUsageLimiters();
+    // Drops cached model details and idle providers, e.g. after secrets or limiters change.
+    static void ResetModelPool();
+    // Idle providers currently pooled across all models.
+    static size_t CountIdleProviders();
 
     std::shared_ptr<IProvider>
             provider_;
 
 private:
-    ModelDetails model_details_;
+    std::shared_ptr<const ModelDetails> model_details_;
+    // Resolved model JSON identifying the pooled providers this Model leases from.
+    std::string pool_key_;
     inline static std::mutex limiter_registry_mutex_;
     inline static std::unordered_map<std::string, std::shared_ptr<ModelRateLimiter>> rate_limiters_by_model_;
     inline static std::unordered_map<std::string, std::shared_ptr<ModelUsageLimiter>> usage_limiters_by_model_;
     inline static std::shared_ptr<IProvider> mock_provider_ = nullptr;
     inline static MockProviderFactory mock_provider_factory_ = nullptr;
     void ConstructProvider();
-    void LoadModelDetails(const nlohmann::json& model_json);
+    static std::unique_ptr<IProvider> CreateProvider(const ModelDetails& model_details);
+    static ModelDetails LoadModelDetails(const nlohmann::json& model_json);
     static std::tuple<std::string, std::string, nlohmann::basic_json<>> GetQueriedModel(const std::string& model_name);
     std::string GetSecret(const std::string& secret_name);
 };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "flock/model_manager/providers/provider.hpp"
+#include "flock/model_manager/repository.hpp"
+#include <list>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace flock {
+
+// Caps the number of output tokens a completion request may generate, derived from
+// the expected output type and the number of tuples in the batch. Boolean and integer
+// answers need only a handful of tokens per tuple; string answers are budgeted from a
+// learned per-(provider, model, prompt) average once at least one batch has been observed.
+// Prompts are keyed by their hash, and only the MAX_STATES most recently used keys are kept.
+class OutputTokenBudget {
+public:
+    static constexpr size_t MAX_STATES = 1024;
+    // Room for the {"items": [...]} envelope around the per-tuple answers.
+    static constexpr size_t ENVELOPE_TOKENS = 32;
+    static constexpr size_t BOOL_TOKENS_PER_TUPLE = 4;
+    static constexpr size_t INTEGER_TOKENS_PER_TUPLE = 8;
+    static constexpr size_t BITSTRING_TOKENS_PER_TUPLE = 1;
+    static constexpr size_t INDEX_LIST_TOKENS_PER_TUPLE = 4;
+    static constexpr size_t MIN_STRING_TOKENS_PER_TUPLE = 32;
+    // Headroom over the learned average so ordinary variance is not cut off.
+    static constexpr double STRING_HEADROOM = 2.0;
+    // Weight of the newest batch in the learned moving average.
+    static constexpr double LEARNING_RATE = 0.2;
+
+    // Returns no budget when the output size cannot be bounded (objects, or strings
+    // without a learned average).
+    static std::optional<size_t> Compute(OutputType output_type, int num_output_tuples,
+                                         std::optional<double> string_tokens_per_tuple = std::nullopt);
+
+    // Budget for a request built by a provider adapter, or nothing when budgeting is
+    // disabled for the model or the user already set an explicit output limit.
+    static std::optional<size_t> Resolve(const ModelDetails& model_details, int num_output_tuples, OutputType output_type,
+                                         std::optional<double> string_tokens_per_tuple,
+                                         std::initializer_list<const char*> explicit_limit_keys);
+
+    // Records in a request payload that the field at JSON pointer `pointer` holds a budget.
+    // A response cut off by it is sent again with `unbudgeted` there, or without the field
+    // when `unbudgeted` is null, instead of counting as a context-window overflow.
+    static void Mark(nlohmann::json& payload, const std::string& pointer,
+                     const nlohmann::json& unbudgeted = nullptr);
+    static bool IsBudgeted(const nlohmann::json& payload);
+    // The payload as sent to the provider, without the mark.
+    static nlohmann::json Unmarked(nlohmann::json payload);
+    // The payload with its budget lifted, for the retry of a response that hit it.
+    static nlohmann::json Lifted(const nlohmann::json& payload);
+
+    static std::optional<double> LearnedTokensPerTuple(const ModelDetails& model_details,
+                                                       const std::string& user_prompt);
+    static void Observe(const ModelDetails& model_details, const std::string& user_prompt,
+                        const nlohmann::json& responses);
+    static size_t Size();
+    static void Reset();
+
+private:
+    static constexpr auto PAYLOAD_KEY = "_flock_output_token_budget";
+
+    static std::string Key(const ModelDetails& model_details, const std::string& user_prompt);
+
+    using LruList = std::list<std::pair<std::string, double>>;
+
+    inline static std::mutex mutex_;
+    inline static LruList lru_;
+    inline static std::unordered_map<std::string, LruList::iterator> tokens_per_tuple_;
+};
+
+}// namespace flock
@@ -86,7 +86,7 @@ protected:
         if (response.contains("stop_reason") && !response["stop_reason"].is_null()) {
             std::string stop_reason = response["stop_reason"].get<std::string>();
             if (stop_reason == "max_tokens") {
-                throw TokenLimitExceededError();
+                throw OutputBudgetExceededError();
             }
             if (stop_reason != "end_turn" && stop_reason != "stop_sequence" && stop_reason != "tool_use") {
                 throw std::runtime_error("Anthropic API unexpected stop_reason: " + stop_reason);
@@ -34,7 +34,7 @@ protected:
                 if (choice.contains("finish_reason") && !choice["finish_reason"].is_null()) {
                     std::string finish_reason = choice["finish_reason"].get<std::string>();
                     if (finish_reason == "length") {
-                        throw TokenLimitExceededError();
+                        throw OutputBudgetExceededError();
                     }
                     if (finish_reason != "stop") {
                         throw std::runtime_error("Azure API did not finish successfully. finish_reason: " + finish_reason);
@@ -2,7 +2,10 @@
 
 #include "flock/core/common.hpp"
 #include "flock/metrics/manager.hpp"
+#include "flock/model_manager/inflight_budget.hpp"
+#include "flock/model_manager/output_token_budget.hpp"
 #include "flock/model_manager/providers/handlers/handler.hpp"
+#include "flock/model_manager/providers/handlers/url_handler.hpp"
 #include "flock/model_manager/providers/provider.hpp"
 #include "flock/model_manager/rate_limiter.hpp"
 #include "flock/model_manager/usage_limiter.hpp"
@@ -36,12 +39,13 @@ public:
     void AddRequest(const nlohmann::json& json, RequestType type = RequestType::Completion) override {
         _request_batch.push_back(json);
         _request_types.push_back(type);
+        _request_reservations.push_back(InflightBudget::Queue(ApproximateBytes(json)));
     }
 
     std::vector<nlohmann::json> CollectCompletions(const std::string& contentType = "application/json") override {
         std::vector<nlohmann::json> completions;
         if (!_request_batch.empty()) completions = ExecuteBatch(_request_batch, true, contentType, RequestType::Completion);
-        _request_batch.clear();
+        ClearRequests();
         return completions;
     }
 
@@ -49,7 +53,7 @@ public:
         std::vector<nlohmann::json> embeddings;
         if (!_request_batch.empty()) embeddings = ExecuteBatch(_request_batch, true, contentType, RequestType::Embedding);
         ThrowOnTokenLimitMarkers(embeddings);
-        _request_batch.clear();
+        ClearRequests();
         return embeddings;
     }
 
@@ -72,6 +76,7 @@ public:
                     if (_request_types[i - 1] == RequestType::Transcription) {
                         _request_batch.erase(_request_batch.begin() + i - 1);
                         _request_types.erase(_request_types.begin() + i - 1);
+                        _request_reservations.erase(_request_reservations.begin() + i - 1);
                     }
                 }
             }
@@ -79,6 +84,11 @@ public:
         return transcriptions;
     }
 
+    void ClearRequests() override {
+        _request_batch.clear();
+        _request_types.clear();
+        _request_reservations.clear();
+    }
 
 public:
 protected:
@@ -96,12 +106,13 @@ protected:
         bool is_transcription = (request_type == RequestType::Transcription);
         auto url = is_completion ? getCompletionUrl() : getEmbedUrl();
         bool usage_limit_reached = false;
+        std::vector<size_t> budget_hits;
 
         for (size_t i = 0; i < jsons.size(); ++i) {
             EnsureUsageLimitNotExceeded();
 
             prepareSessionForRequest(url);
-            setParameters(jsons[i].dump(), contentType);
+            setParameters(OutputTokenBudget::Unmarked(URLHandler::ResolveDeferredBase64(jsons[i])).dump(), contentType);
             auto response = postRequest(contentType);
 
             if (!response.is_error && !response.text.empty() && isJson(response.text)) {
@@ -113,6 +124,8 @@ protected:
                         RecordTokenUsageWithSoftCap(input_tokens, output_tokens, usage_limit_reached);
                     }
                     ExtractOutputWithErrorHandling(parsed, request_type, results[i]);
+                } catch (const OutputBudgetExceededError&) {
+                    RecordOutputLimitHit(jsons, i, budget_hits, results);
                 } catch (const TokenLimitExceededError&) {
                     results[i] = TokenLimitExceededMarker();
                 } catch (const std::exception& e) {
@@ -122,24 +135,66 @@ protected:
                 trigger_error("Empty or invalid response: " + response.error_message);
             }
         }
+        RetryWithoutOutputBudget(jsons, budget_hits, async, contentType, request_type, results);
         return results;
 #else
-        // Native: Use curl multi-handle for parallel requests
+        // Native: Use curl multi-handle for parallel requests. A payload is built, with its
+        // deferred images or audio file, just before it is sent, and only sent while it fits in the
+        // in-flight budget; response bytes are reserved as they arrive, and each response is
+        // parsed and freed as soon as it is complete.
         struct CurlRequestData {
             std::string response;
             CURL* easy = nullptr;
             std::string payload;
             curl_mime* mime_form = nullptr;
             std::string temp_file_path;
-            bool is_temp_file;
+            bool is_temp_file = false;
+            InflightBudget::Reservation reservation;
+        };
+        bool is_transcription = (request_type == RequestType::Transcription);
+        bool is_completion = (request_type == RequestType::Completion);
+
+        // Owns the handles of the batch; requests still open when an error is thrown are
+        // released on destruction.
+        struct CurlBatch {
+            std::vector<CurlRequestData> requests;
+            CURLM* multi_handle = nullptr;
+            bool is_transcription = false;
+
+            void Release(CurlRequestData& request) {
+                if (request.easy == nullptr) {
+                    return;
+                }
+                // Clean up temp files for transcriptions
+                if (is_transcription && request.is_temp_file && !request.temp_file_path.empty()) {
+                    std::remove(request.temp_file_path.c_str());
+                }
+                // Clean up mime form for transcriptions
+                if (request.mime_form) {
+                    curl_mime_free(request.mime_form);
+                    request.mime_form = nullptr;
+                }
+                curl_multi_remove_handle(multi_handle, request.easy);
+                curl_easy_cleanup(request.easy);
+                request.easy = nullptr;
+                std::string().swap(request.payload);
+                std::string().swap(request.response);
+                request.reservation.Release();
+            }
+
+            ~CurlBatch() {
+                for (auto& request: requests) {
+                    Release(request);
+                }
+                curl_multi_cleanup(multi_handle);
+            }
         };
-        std::vector<CurlRequestData> requests(jsons.size());
-        CURLM* multi_handle = curl_multi_init();
+        CurlBatch batch{std::vector<CurlRequestData>(jsons.size()), curl_multi_init(), is_transcription};
+        auto& requests = batch.requests;
+        CURLM* multi_handle = batch.multi_handle;
 
         // Determine URL based on request type
         std::string url;
-        bool is_transcription = (request_type == RequestType::Transcription);
-        bool is_completion = (request_type == RequestType::Completion);
         if (is_transcription) {
             url = getTranscriptionUrl();
         } else if (is_completion) {
@@ -148,10 +203,10 @@ protected:
             url = getEmbedUrl();
         }
 
-        // Prepare all requests
-        for (size_t i = 0; i < jsons.size(); ++i) {
+        auto prepare_request = [&](size_t i) {
             requests[i].easy = curl_easy_init();
             curl_easy_setopt(requests[i].easy, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(requests[i].easy, CURLOPT_PRIVATE, reinterpret_cast<char*>(i));
 
             if (is_transcription) {
                 // Handle transcription requests (multipart/form-data)
@@ -162,10 +217,12 @@ protected:
                 if (!req.contains("model") || req["model"].is_null()) {
                     trigger_error("Missing or null model in transcription request");
                 }
-                auto file_path = req["file_path"].get<std::string>();
                 auto model = req["model"].get<std::string>();
                 auto prompt = req.contains("prompt") && !req["prompt"].is_null() ? req["prompt"].get<std::string>() : "";
-                requests[i].is_temp_file = req.contains("is_temp_file") ? req["is_temp_file"].get<bool>() : false;
+                // Queued requests hold the path or URL; a URL is downloaded only now, when it is sent.
+                const auto file_result = URLHandler::ResolveFilePath(req["file_path"].get<std::string>());
+                const auto& file_path = file_result.file_path;
+                requests[i].is_temp_file = file_result.is_temp_file;
                 if (requests[i].is_temp_file) {
                     requests[i].temp_file_path = file_path;
                 }
@@ -201,7 +258,7 @@ protected:
                 curl_easy_setopt(requests[i].easy, CURLOPT_HTTPHEADER, headers);
             } else {
                 // Handle JSON requests (completions/embeddings)
-                requests[i].payload = jsons[i].dump();
+                requests[i].payload = OutputTokenBudget::Unmarked(URLHandler::ResolveDeferredBase64(jsons[i])).dump();
                 struct curl_slist* headers = nullptr;
                 headers = curl_slist_append(headers, "Content-Type: application/json");
                 for (const auto& h: getExtraHeaders()) {
@@ -212,43 +269,32 @@ protected:
                 curl_easy_setopt(requests[i].easy, CURLOPT_POSTFIELDS, requests[i].payload.c_str());
             }
 
-            // Set response callback
+            // Set response callback; the response is reserved next to the payload as it grows, in
+            // steps of RESPONSE_STEP_BYTES, and exactly once it is complete.
             curl_easy_setopt(
                     requests[i].easy, CURLOPT_WRITEFUNCTION, +[](char* ptr, size_t size, size_t nmemb, void* userdata) -> size_t {
-                std::string* resp = static_cast<std::string*>(userdata);
-                resp->append(ptr, size * nmemb);
+                auto* request = static_cast<CurlRequestData*>(userdata);
+                request->response.append(ptr, size * nmemb);
+                const auto held = request->payload.size() + request->response.size();
+                if (held >= request->reservation.Bytes() + InflightBudget::RESPONSE_STEP_BYTES) {
+                    request->reservation.Resize(held);
+                }
                 return size * nmemb; });
-            curl_easy_setopt(requests[i].easy, CURLOPT_WRITEDATA, &requests[i].response);
-
-            curl_multi_add_handle(multi_handle, requests[i].easy);
-        }
-
-        auto api_start = std::chrono::high_resolution_clock::now();
-
-        int still_running = 0;
-        curl_multi_perform(multi_handle, &still_running);
-        while (still_running) {
-            int numfds;
-            curl_multi_wait(multi_handle, NULL, 0, 1000, &numfds);
-            curl_multi_perform(multi_handle, &still_running);
-        }
-
-        auto api_end = std::chrono::high_resolution_clock::now();
-        double api_duration_ms = std::chrono::duration<double, std::milli>(api_end - api_start).count();
+            curl_easy_setopt(requests[i].easy, CURLOPT_WRITEDATA, &requests[i]);
+        };
 
         int64_t batch_input_tokens = 0;
         int64_t batch_output_tokens = 0;
 
         std::vector<nlohmann::json> results(jsons.size());
+        std::vector<size_t> budget_hits;
         bool usage_limit_reached = false;
-        for (size_t i = 0; i < requests.size(); ++i) {
-            // Clean up temp files for transcriptions
-            if (is_transcription && requests[i].is_temp_file && !requests[i].temp_file_path.empty()) {
-                std::remove(requests[i].temp_file_path.c_str());
-            }
-
+        auto parse_response = [&](size_t i) {
             long http_code = 0;
             curl_easy_getinfo(requests[i].easy, CURLINFO_RESPONSE_CODE, &http_code);
+            // The payload is no longer needed; the response is held until it is parsed.
+            std::string().swap(requests[i].payload);
+            requests[i].reservation.Resize(requests[i].response.size());
 
             if (requests[i].response.empty()) {
                 trigger_error("Empty response from provider (HTTP " + std::to_string(http_code) + ", URL: " + url + ")");
@@ -266,6 +312,8 @@ protected:
                     }
 
                     ExtractOutputWithErrorHandling(parsed, request_type, results[i]);
+                } catch (const OutputBudgetExceededError&) {
+                    RecordOutputLimitHit(jsons, i, budget_hits, results);
                 } catch (const TokenLimitExceededError&) {
                     results[i] = TokenLimitExceededMarker();
                 } catch (const nlohmann::json::exception& e) {
@@ -275,14 +323,57 @@ protected:
                 trigger_error("Invalid JSON response (HTTP " + std::to_string(http_code) + ", URL: " + url + "): " + requests[i].response);
             }
 
-            // Clean up mime form for transcriptions
-            if (is_transcription && requests[i].mime_form) {
-                curl_mime_free(requests[i].mime_form);
+            batch.Release(requests[i]);
+        };
+
+        auto api_start = std::chrono::high_resolution_clock::now();
+
+        size_t next_request = 0;
+        size_t in_flight = 0;
+        bool next_prepared = false;
+        while (next_request < requests.size() || in_flight > 0) {
+            // Send requests while their payloads fit in the budget. With nothing of this batch in
+            // flight, wait for other requests to free it; otherwise, wait for our own responses.
+            while (next_request < requests.size()) {
+                auto& request = requests[next_request];
+                if (!next_prepared) {
+                    prepare_request(next_request);
+                    next_prepared = true;
+                }
+                if (in_flight == 0) {
+                    request.reservation = InflightBudget::Acquire(request.payload.size());
+                } else if (auto reservation = InflightBudget::TryAcquire(request.payload.size())) {
+                    request.reservation = std::move(*reservation);
+                } else {
+                    break;
+                }
+                curl_multi_add_handle(multi_handle, request.easy);
+                next_prepared = false;
+                next_request++;
+                in_flight++;
+            }
+
+            int still_running = 0;
+            curl_multi_perform(multi_handle, &still_running);
+            int messages_left = 0;
+            while (CURLMsg* message = curl_multi_info_read(multi_handle, &messages_left)) {
+                if (message->msg != CURLMSG_DONE) {
+                    continue;
+                }
+                char* request_index = nullptr;
+                curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &request_index);
+                in_flight--;
+                parse_response(reinterpret_cast<size_t>(request_index));
+            }
+            if (in_flight > 0 && still_running > 0) {
+                int numfds;
+                curl_multi_wait(multi_handle, NULL, 0, 1000, &numfds);
             }
-            curl_multi_remove_handle(multi_handle, requests[i].easy);
-            curl_easy_cleanup(requests[i].easy);
         }
 
+        auto api_end = std::chrono::high_resolution_clock::now();
+        double api_duration_ms = std::chrono::duration<double, std::milli>(api_end - api_start).count();
+
         if (!is_transcription) {
             MetricsManager::UpdateTokens(batch_input_tokens, batch_output_tokens);
         }
@@ -291,7 +382,7 @@ protected:
             MetricsManager::IncrementApiCalls();
         }
 
-        curl_multi_cleanup(multi_handle);
+        RetryWithoutOutputBudget(jsons, budget_hits, async, contentType, request_type, results);
         return results;
 #endif
     }
@@ -308,6 +399,8 @@ protected:
     std::shared_ptr<ModelUsageLimiter> _usage_limiter;
     std::vector<nlohmann::json> _request_batch;
     std::vector<RequestType> _request_types;
+    // Budget held by each queued request until its batch is collected.
+    std::vector<InflightBudget::Reservation> _request_reservations;
 
     virtual std::string getCompletionUrl() const = 0;
     virtual std::string getEmbedUrl() const = 0;
@@ -367,6 +460,52 @@ protected:
         }
     }
 
+    // A response cut off by Flock's output token budget is retried without it; without a budget
+    // the model ran out of room in its context window, which callers handle by shrinking the batch.
+    static void RecordOutputLimitHit(const std::vector<nlohmann::json>& jsons, const size_t i,
+                                     std::vector<size_t>& budget_hits, std::vector<nlohmann::json>& results) {
+        if (OutputTokenBudget::IsBudgeted(jsons[i])) {
+            budget_hits.push_back(i);
+        } else {
+            results[i] = TokenLimitExceededMarker();
+        }
+    }
+
+    void RetryWithoutOutputBudget(const std::vector<nlohmann::json>& jsons, const std::vector<size_t>& budget_hits,
+                                  const bool async, const std::string& contentType, const RequestType request_type,
+                                  std::vector<nlohmann::json>& results) {
+        if (budget_hits.empty()) {
+            return;
+        }
+        std::vector<nlohmann::json> lifted;
+        lifted.reserve(budget_hits.size());
+        for (const auto i: budget_hits) {
+            lifted.push_back(OutputTokenBudget::Lifted(jsons[i]));
+        }
+        auto retried = ExecuteBatch(lifted, async, contentType, request_type);
+        for (size_t k = 0; k < budget_hits.size(); k++) {
+            results[budget_hits[k]] = std::move(retried[k]);
+        }
+    }
+
+    // Rough memory held by a queued request: the text of its strings and keys, plus a value each.
+    static size_t ApproximateBytes(const nlohmann::json& value) {
+        if (value.is_string()) {
+            return value.get_ref<const std::string&>().size();
+        }
+        size_t bytes = sizeof(nlohmann::json);
+        if (value.is_object()) {
+            for (const auto& item: value.items()) {
+                bytes += item.key().size() + ApproximateBytes(item.value());
+            }
+        } else if (value.is_array()) {
+            for (const auto& element: value) {
+                bytes += ApproximateBytes(element);
+            }
+        }
+        return bytes;
+    }
+
     static void ThrowOnTokenLimitMarkers(const std::vector<nlohmann::json>& results) {
         for (const auto& result: results) {
             if (IsTokenLimitExceededMarker(result)) {
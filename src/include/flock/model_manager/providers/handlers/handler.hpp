@@ -21,6 +21,8 @@ public:
     virtual std::vector<nlohmann::json> CollectEmbeddings(const std::string& contentType = "application/json") = 0;
     // CollectTranscriptions: process all transcriptions, then clear
     virtual std::vector<nlohmann::json> CollectTranscriptions(const std::string& contentType = "multipart/form-data") = 0;
+    // ClearRequests: drop requests left queued by a failed collect before the handler is reused
+    virtual void ClearRequests() = 0;
 };
 
 }// namespace flock
@@ -42,6 +42,9 @@ protected:
         }
         bool is_completion = (request_type == RequestType::Completion);
         if (is_completion) {
+            if (response.contains("done_reason") && response["done_reason"] == "length") {
+                throw OutputBudgetExceededError();
+            }
             if (response.contains("done_reason") && response["done_reason"] != "stop") {
                 throw std::runtime_error("The request was refused due to some internal error with Ollama API");
             }
@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <curl/curl.h>
 #include <filesystem>
+#include <nlohmann/json.hpp>
 #include <random>
 #include <regex>
 #include <sstream>
@@ -244,6 +245,51 @@ public:
 
         return result;
     }
+
+    // Images are read and base64-encoded only when their request is sent, so queued requests
+    // hold a short reference instead of the file contents. References start with a random
+    // per-process marker, so no column value can be mistaken for one.
+    static const std::string& DeferredBase64Marker() {
+        static const std::string marker = []() {
+            std::random_device rd;
+            std::mt19937 gen(rd());
+            std::uniform_int_distribution<> dis(0, 15);
+            std::ostringstream nonce;
+            for (int i = 0; i < 16; ++i) {
+                nonce << std::hex << dis(gen);
+            }
+            return "\x1e" "flock-base64-" + nonce.str() + ":";
+        }();
+        return marker;
+    }
+
+    // Placeholder for the base64 contents of a file path or URL, resolved by ResolveDeferredBase64
+    static std::string DeferBase64(const std::string& file_path_or_url) {
+        return DeferredBase64Marker() + file_path_or_url;
+    }
+
+    // Copy of `payload` with every deferred reference replaced by the base64 contents of its file
+    // Throws std::runtime_error if a file cannot be processed
+    static nlohmann::json ResolveDeferredBase64(const nlohmann::json& payload) {
+        auto resolved = payload;
+        ResolveDeferredBase64InPlace(resolved);
+        return resolved;
+    }
+
+    static void ResolveDeferredBase64InPlace(nlohmann::json& value) {
+        if (value.is_string()) {
+            auto& text = value.get_ref<std::string&>();
+            const auto& marker = DeferredBase64Marker();
+            if (const auto pos = text.find(marker); pos != std::string::npos) {
+                auto base64_result = ResolveFileToBase64(text.substr(pos + marker.size()));
+                text.replace(pos, std::string::npos, base64_result.base64_content);
+            }
+        } else if (value.is_structured()) {
+            for (auto& element: value) {
+                ResolveDeferredBase64InPlace(element);
+            }
+        }
+    }
 };
 
 }// namespace flock
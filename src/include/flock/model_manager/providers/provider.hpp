@@ -7,6 +7,7 @@
 #include <cctype>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <regex>
 
 namespace flock {
@@ -20,7 +21,10 @@ enum class OutputType {
     STRING,
     OBJECT,
     BOOL,
-    INTEGER
+    INTEGER,
+    // Compact encodings: the whole batch is answered by a single string item.
+    BITSTRING,
+    INDEX_LIST
 };
 
 class IProvider {
@@ -34,6 +38,10 @@ public:
     std::shared_ptr<ModelRateLimiter> rate_limiter_ = nullptr;
     std::shared_ptr<ModelUsageLimiter> usage_limiter_ = nullptr;
 
+    // Expected output tokens per tuple for STRING completions, learned by the caller
+    // from earlier batches with the same prompt (see OutputTokenBudget).
+    std::optional<double> string_tokens_per_tuple_hint_ = std::nullopt;
+
     explicit IProvider(const ModelDetails& model_details, std::shared_ptr<ModelRateLimiter> rate_limiter = nullptr,
                        std::shared_ptr<ModelUsageLimiter> usage_limiter = nullptr)
         : model_details_(model_details), rate_limiter_(std::move(rate_limiter)),
@@ -54,6 +62,14 @@ public:
         return model_handler_->CollectTranscriptions(contentType);
     }
 
+    // Called before a pooled provider is handed to another Model.
+    void ResetForReuse() {
+        string_tokens_per_tuple_hint_ = std::nullopt;
+        if (model_handler_) {
+            model_handler_->ClearRequests();
+        }
+    }
+
     static std::string GetOutputTypeString(const OutputType output_type) {
         switch (output_type) {
             case OutputType::STRING:
@@ -64,10 +80,41 @@ public:
                 return "boolean";
             case OutputType::INTEGER:
                 return "integer";
+            case OutputType::BITSTRING:
+            case OutputType::INDEX_LIST:
+                return "string";
             default:
                 throw std::invalid_argument("Unsupported output type");
         }
     }
+
+    // Schema of a single element of the response `items` array; fused calls supply an object
+    // schema with one property per task through ModelDetails::item_schema.
+    nlohmann::json GetItemSchema(const OutputType output_type) const {
+        if (model_details_.item_schema.has_value()) {
+            return *model_details_.item_schema;
+        }
+        return {{"type", GetOutputTypeString(output_type)}};
+    }
+
+    // Whether the user's output-format parameter `key` shapes the response items. A schema Flock
+    // supplies itself (fused calls, cascades) takes precedence, since its answers are read back
+    // by property name.
+    bool UsesUserOutputFormat(const char* key) const {
+        return !model_details_.item_schema.has_value() && model_details_.model_parameters.contains(key);
+    }
+
+    // Number of elements expected in the response `items` array for a batch of
+    // `num_output_tuples` rows.
+    static int GetResponseItemCount(const OutputType output_type, const int num_output_tuples) {
+        switch (output_type) {
+            case OutputType::BITSTRING:
+            case OutputType::INDEX_LIST:
+                return 1;
+            default:
+                return num_output_tuples;
+        }
+    }
 };
 
 class TokenLimitExceededError : public duckdb::HTTPException {
@@ -81,6 +128,18 @@ public:
     }
 };
 
+// A completion stopped at its output token limit. The handler sends it again without Flock's
+// output token budget when it carried one; otherwise it is reported as a token-limit error.
+class OutputBudgetExceededError : public duckdb::HTTPException {
+public:
+    OutputBudgetExceededError()
+        : duckdb::HTTPException(429, "",
+                                duckdb::unordered_map<duckdb::string, duckdb::string>{},
+                                "output_budget_exceeded",
+                                "the response reached its output token limit before it was complete.") {
+    }
+};
+
 class UsageLimitExceededError : public duckdb::HTTPException {
 public:
     UsageLimitExceededError(const std::string& token_type, const int64_t token_count, const int64_t token_limit)
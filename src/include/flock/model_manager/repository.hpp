@@ -74,6 +74,134 @@ inline nlohmann::json UsageLimitToJson(const UsageLimit& limit) {
     return result;
 }
 
+// Opt-in prompt compression: string cells of at least `min_length` characters that
+// occur at least `min_repeats` times in a batch are rendered once in a legend and
+// referenced by short codes in the tuples.
+struct DictionaryEncoding {
+    size_t min_length = 16;
+    size_t min_repeats = 2;
+};
+
+inline DictionaryEncoding ParseDictionaryEncodingFromJson(const nlohmann::json& value) {
+    if (!value.is_object()) {
+        throw std::runtime_error("Expected 'dictionary_encoding' to be a JSON object.");
+    }
+    DictionaryEncoding encoding;
+    if (value.contains("min_length")) {
+        encoding.min_length = ParsePositiveSizeFromJson(value.at("min_length"), "min_length");
+    }
+    if (value.contains("min_repeats")) {
+        encoding.min_repeats = ParsePositiveSizeFromJson(value.at("min_repeats"), "min_repeats");
+    }
+    return encoding;
+}
+
+inline nlohmann::json DictionaryEncodingToJson(const DictionaryEncoding& encoding) {
+    return {{"min_length", encoding.min_length}, {"min_repeats", encoding.min_repeats}};
+}
+
+// Near-duplicate answer reuse: rows are embedded with `embedding_model` and a cached answer
+// is reused when the cosine similarity to an earlier row reaches `threshold`.
+struct SemanticCacheConfig {
+    std::string embedding_model;
+    double threshold = 0.95;
+};
+
+inline SemanticCacheConfig ParseSemanticCacheFromJson(const nlohmann::json& value) {
+    if (!value.is_object() || !value.contains("embedding_model") || !value.at("embedding_model").is_string()) {
+        throw std::runtime_error("Expected 'semantic_cache' to be a JSON object with a string 'embedding_model'.");
+    }
+    SemanticCacheConfig config;
+    config.embedding_model = value.at("embedding_model").get<std::string>();
+    if (value.contains("threshold")) {
+        if (!value.at("threshold").is_number()) {
+            throw std::runtime_error("Expected 'threshold' to be a number.");
+        }
+        config.threshold = value.at("threshold").get<double>();
+        if (config.threshold <= 0.0 || config.threshold > 1.0) {
+            throw std::runtime_error("'threshold' must be in (0, 1].");
+        }
+    }
+    return config;
+}
+
+inline nlohmann::json SemanticCacheToJson(const SemanticCacheConfig& config) {
+    return {{"embedding_model", config.embedding_model}, {"threshold", config.threshold}};
+}
+
+// Opt-in map-reduce for rows that exceed the context window on their own: their longest text
+// value is split into chunks of `chunk_tokens`, each starting `overlap_tokens` before the end of
+// the previous one, and the partial answers are combined with a final request.
+struct LongInputConfig {
+    size_t chunk_tokens = 2000;
+    size_t overlap_tokens = 200;
+};
+
+inline LongInputConfig ParseLongInputFromJson(const nlohmann::json& value) {
+    if (!value.is_object()) {
+        throw std::runtime_error("Expected 'long_input' to be a JSON object such as {\"chunk_tokens\": 2000, \"overlap_tokens\": 200}.");
+    }
+    LongInputConfig config;
+    if (value.contains("chunk_tokens")) {
+        config.chunk_tokens = ParsePositiveSizeFromJson(value.at("chunk_tokens"), "chunk_tokens");
+    }
+    if (value.contains("overlap_tokens")) {
+        const int overlap_tokens = value.at("overlap_tokens").get<int>();
+        if (overlap_tokens < 0) {
+            throw std::runtime_error("'overlap_tokens' must not be negative");
+        }
+        config.overlap_tokens = static_cast<size_t>(overlap_tokens);
+    }
+    if (config.overlap_tokens * 2 > config.chunk_tokens) {
+        throw std::runtime_error("'overlap_tokens' must be at most half of 'chunk_tokens'");
+    }
+    return config;
+}
+
+inline nlohmann::json LongInputToJson(const LongInputConfig& config) {
+    return {{"chunk_tokens", config.chunk_tokens}, {"overlap_tokens", config.overlap_tokens}};
+}
+
+// Answer used for rows whose context columns are all NULL or empty; such rows are never sent.
+inline nlohmann::json ParseEmptyInputDefault(const nlohmann::json& value) {
+    if (value.is_object() || value.is_array()) {
+        throw std::runtime_error("Expected 'empty_input_default' to be a string, number, boolean, or null.");
+    }
+    return value;
+}
+
+// Result cache usage: READ serves cached answers without adding new ones, READWRITE also
+// stores the answers of cache misses.
+enum class CacheMode { OFF,
+                       READ,
+                       READWRITE };
+
+inline CacheMode stringToCacheMode(const std::string& mode) {
+    auto lower_mode = mode;
+    std::transform(lower_mode.begin(), lower_mode.end(), lower_mode.begin(), ::tolower);
+    if (lower_mode == "off") {
+        return CacheMode::OFF;
+    }
+    if (lower_mode == "read") {
+        return CacheMode::READ;
+    }
+    if (lower_mode == "readwrite") {
+        return CacheMode::READWRITE;
+    }
+    throw std::runtime_error("Expected 'cache' to be one of: off, read or readwrite.");
+}
+
+inline std::string cacheModeToString(const CacheMode mode) {
+    switch (mode) {
+        case CacheMode::READ:
+            return "read";
+        case CacheMode::READWRITE:
+            return "readwrite";
+        default:
+            return "off";
+    }
+}
+
 struct ModelDetails {
     std::string provider_name;
     std::string model_name;
@@ -85,6 +213,15 @@ struct ModelDetails {
     bool is_async = true;
     std::optional<size_t> rate_limit;
     std::optional<UsageLimit> usage_limit;
+    std::optional<DictionaryEncoding> dictionary_encoding;
+    bool output_token_budget = false;
+    OutputEncoding output_encoding = OutputEncoding::JSON;
+    CacheMode cache = CacheMode::OFF;
+    std::optional<SemanticCacheConfig> semantic_cache;
+    nlohmann::json empty_input_default;
+    std::optional<LongInputConfig> long_input;
+    // Internal: per-item response schema set by fused calls; not a user-facing model arg.
+    std::optional<nlohmann::json> item_schema;
 };
 
 
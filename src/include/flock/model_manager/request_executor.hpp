@@ -0,0 +1,47 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+namespace flock {
+
+// Process-wide pool of I/O threads that wait on provider responses on behalf of DuckDB worker
+// threads. Callers keep working and collect the future later, so the number of open requests
+// is set by `flock_max_http_concurrency` rather than by `SET threads`. Threads are started on
+// demand and exit when idle workers exceed the limit.
+class RequestExecutor {
+public:
+    static constexpr auto SETTING_NAME = "flock_max_http_concurrency";
+    static constexpr size_t DEFAULT_MAX_CONCURRENCY = 16;
+
+    static void Register(duckdb::DBConfig& config);
+
+    static std::future<nlohmann::json> Submit(std::function<nlohmann::json()> job);
+    // Whether the caller runs on one of the pool's threads. Such callers must not block on jobs
+    // they submit: with every thread doing the same, those jobs stay queued behind them.
+    static bool OnWorkerThread();
+    static void SetMaxConcurrency(size_t max_concurrency);
+    static size_t GetMaxConcurrency();
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable job_available;
+        std::deque<std::packaged_task<nlohmann::json()>> jobs;
+        size_t max_concurrency = DEFAULT_MAX_CONCURRENCY;
+        size_t workers = 0;
+        size_t idle_workers = 0;
+    };
+
+    // Never destroyed: detached workers may still be waiting on it at process exit.
+    static State& GetState();
+    static void WorkerLoop();
+    static void OnSettingChanged(duckdb::ClientContext& context, duckdb::SetScope scope, duckdb::Value& parameter);
+};
+
+}// namespace flock
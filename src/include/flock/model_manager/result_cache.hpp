@@ -0,0 +1,58 @@
+#pragma once
+
+#include "flock/core/context_column_batch.hpp"
+#include "flock/model_manager/repository.hpp"
+#include <list>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace flock {
+
+// Two-tier cache of per-row LLM answers. Keys hash the answer-relevant model settings,
+// the prompt and the row content; the first tier is a bounded in-process LRU, the second
+// a table in flock_storage that outlives the process and is pruned by age and total size.
+// The storage tier is reached through CacheStorage and is best effort: any failure to read or
+// write it behaves like a miss.
+class ResultCache {
+public:
+    static constexpr size_t MEMORY_CAPACITY = 16384;
+    static constexpr int64_t TTL_SECONDS = 7 * 24 * 60 * 60;
+    static constexpr int64_t MAX_STORAGE_BYTES = 256LL * 1024 * 1024;
+    // Stored entries between two storage eviction passes.
+    static constexpr size_t EVICTION_INTERVAL = 1024;
+
+    // 128-bit hash rendered as 32 hex characters.
+    static std::string Hash(const std::string& content);
+    static std::string Hash(const char* data, size_t size);
+    // Model settings that change the answer; secrets, batching and limits are left out.
+    static std::string ModelFingerprint(const ModelDetails& model_details);
+    static std::vector<std::string> CompletionKeys(const ModelDetails& model_details, const std::string& user_prompt,
+                                                   ScalarFunctionType function_type, const ContextColumnBatch& batch);
+    static std::vector<std::string> EmbeddingKeys(const ModelDetails& model_details,
+                                                  const std::vector<std::string>& inputs);
+
+    static std::vector<std::optional<nlohmann::json>> Lookup(const std::vector<std::string>& keys);
+    static void Store(const std::vector<std::pair<std::string, nlohmann::json>>& entries);
+    static void Clear();
+
+private:
+    static std::optional<nlohmann::json> LookupMemory(const std::string& key);
+    static void StoreMemory(const std::string& key, const nlohmann::json& value);
+    static std::unordered_map<std::string, nlohmann::json> LookupStorage(const std::vector<std::string>& keys);
+    static void StoreStorage(const std::vector<std::pair<std::string, nlohmann::json>>& entries);
+    static std::string GetStorageTable();
+
+    using LruList = std::list<std::pair<std::string, nlohmann::json>>;
+
+    inline static std::mutex mutex_;
+    inline static LruList lru_;
+    inline static std::unordered_map<std::string, LruList::iterator> index_;
+    inline static size_t stores_since_eviction_ = 0;
+};
+
+}// namespace flock
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "flock/core/context_column_batch.hpp"
+#include "flock/model_manager/repository.hpp"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace flock {
+
+// Answer cache for near-duplicate rows. Each namespace (model settings, prompt, function and
+// embedding model) keeps unit-length row embeddings next to their answers; a lookup scans all
+// of them with a SIMD dot product and reuses the best answer at or above the threshold.
+// Entries are also written to flock_storage and reloaded when a namespace is first used. Each
+// namespace has its own lock: lookups scan it concurrently, and only inserts into the same
+// namespace wait for them. At most MAX_CACHED_VECTORS entries are kept in memory across all
+// namespaces; past that the least recently used namespaces are dropped and reload on next use.
+class SemanticCache {
+public:
+    static constexpr size_t MAX_ENTRIES_PER_NAMESPACE = 16384;
+    static constexpr size_t MAX_CACHED_VECTORS = 2 * MAX_ENTRIES_PER_NAMESPACE;
+    // Stored entries between two storage eviction passes.
+    static constexpr size_t EVICTION_INTERVAL = 1024;
+
+    struct Match {
+        std::optional<nlohmann::json> answer;
+        // Best similarity seen, or nothing when the namespace had no comparable entry.
+        std::optional<float> best_similarity;
+
+        // A comparable entry was found but was not similar enough to reuse.
+        bool RejectedByThreshold() const { return !answer.has_value() && best_similarity.has_value(); }
+    };
+
+    static std::string Namespace(const ModelDetails& model_details, const std::string& user_prompt,
+                                 ScalarFunctionType function_type);
+    // One line of text per requested row, used as the embedding input.
+    static std::vector<std::string> RowTexts(const ContextColumnBatch& batch, const std::vector<size_t>& rows);
+    // Embeds `texts` with the configured embedding model; vectors are normalized.
+    static std::vector<std::vector<float>> Embed(const std::string& embedding_model,
+                                                 const std::vector<std::string>& texts);
+
+    static std::vector<Match> Lookup(const std::string& cache_namespace, const std::vector<std::vector<float>>& embeddings,
+                                     double threshold);
+    static void Insert(const std::string& cache_namespace, const std::vector<std::vector<float>>& embeddings,
+                       const std::vector<nlohmann::json>& answers);
+    static void Clear();
+    // Entries currently held in memory across all namespaces.
+    static size_t CachedVectors();
+
+private:
+    struct Index {
+        size_t dims = 0;
+        std::vector<float> vectors;
+        std::vector<nlohmann::json> answers;
+        // Slot overwritten next once the index is full.
+        size_t next_slot = 0;
+    };
+
+    struct NamespaceState {
+        std::once_flag loaded;
+        std::shared_mutex mutex;
+        Index index;
+    };
+
+    using LruList = std::list<std::string>;
+
+    struct NamespaceEntry {
+        std::shared_ptr<NamespaceState> state;
+        // Entries of `state` counted in `cached_vectors_`.
+        size_t entries = 0;
+        LruList::iterator position;
+    };
+
+    // The namespace's state, loaded from storage by its first user without holding `mutex_`.
+    static std::shared_ptr<NamespaceState> GetNamespace(const std::string& cache_namespace);
+    // Counts `added` entries for `state` and drops least recently used namespaces past
+    // MAX_CACHED_VECTORS. Holders of a dropped state keep using it until they release it.
+    static void Account(const std::string& cache_namespace, const std::shared_ptr<NamespaceState>& state,
+                        size_t added);
+    static void AddUnlocked(Index& index, const std::vector<float>& embedding, const nlohmann::json& answer);
+    static void LoadFromStorage(const std::string& cache_namespace, Index& index);
+    static void StoreToStorage(const std::string& cache_namespace, const std::vector<std::vector<float>>& embeddings,
+                               const std::vector<nlohmann::json>& answers);
+    static std::string GetStorageTable();
+
+    // Guards the namespace map, its recency order and the counters only.
+    inline static std::mutex mutex_;
+    // Most recently used namespace first.
+    inline static LruList lru_;
+    inline static std::unordered_map<std::string, NamespaceEntry> namespaces_;
+    inline static size_t cached_vectors_ = 0;
+    inline static size_t stores_since_eviction_ = 0;
+};
+
+}// namespace flock
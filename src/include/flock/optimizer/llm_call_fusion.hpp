@@ -0,0 +1,24 @@
+#pragma once
+
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "flock/core/common.hpp"
+
+namespace flock {
+
+// Optimizer pass that fuses sibling llm_complete / llm_filter calls of one projection that share
+// a model and context columns, so their rows are rendered and sent once for all tasks.
+class LlmCallFusion {
+public:
+    static constexpr auto SETTING_NAME = "flock_fuse_llm_calls";
+
+    static void Register(duckdb::DBConfig& config);
+    static void Optimize(duckdb::OptimizerExtensionInput& input, duckdb::unique_ptr<duckdb::LogicalOperator>& plan);
+
+private:
+    static void FuseOperator(duckdb::LogicalOperator& op);
+    static void FuseExpressions(duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& expressions);
+    static const duckdb::Expression* GetContextColumns(const duckdb::BoundFunctionExpression& call);
+};
+
+}// namespace flock
@@ -4,9 +4,12 @@
 
 #include "flock/core/common.hpp"
 #include "flock/core/config.hpp"
+#include "flock/core/context_column_batch.hpp"
 #include "flock/model_manager/model.hpp"
 #include "flock/prompt_manager/repository.hpp"
+#include "flock/prompt_manager/token_counter.hpp"
 #include <nlohmann/json.hpp>
+#include <optional>
 
 namespace flock {
 
@@ -23,10 +26,10 @@ public:
     static T FromString(const std::string& element);
 
     template<typename FunctionType>
-    static std::string GetTemplate(FunctionType option) {
+    static std::string GetTemplate(FunctionType option, OutputEncoding output_encoding = OutputEncoding::JSON) {
         auto prompt_template =
                 PromptManager::ReplaceSection(META_PROMPT, PromptSection::INSTRUCTIONS, INSTRUCTIONS::Get(option));
-        auto response_format = RESPONSE_FORMAT::Get(option);
+        auto response_format = RESPONSE_FORMAT::Get(option, output_encoding);
         prompt_template =
                 PromptManager::ReplaceSection(prompt_template, PromptSection::RESPONSE_FORMAT, response_format);
         return prompt_template;
@@ -34,6 +37,10 @@ public:
 
     static PromptDetails CreatePromptDetails(const nlohmann::json& prompt_details_json);
 
+    // The batch with each audio column replaced by its transcription, so rendering its slices
+    // sends no transcription requests; batches without audio columns are returned as they are.
+    static ContextColumnBatch TranscribeAudioColumns(const ContextColumnBatch& batch);
+
     static std::string ConstructNumTuples(int num_tuples);
 
     static std::string ConstructInputTuplesHeader(const nlohmann::json& columns, TupleFormat tuple_format);
@@ -44,7 +51,16 @@ public:
     static std::string ConstructInputTuplesMarkdown(const nlohmann::json& columns);
     static std::string ConstructInputTuplesJSON(const nlohmann::json& columns);
 
-    static std::string ConstructInputTuples(const nlohmann::json& columns, TupleFormat tuple_format);
+    static std::string ConstructInputTuples(const nlohmann::json& columns, TupleFormat tuple_format,
+                                            const std::optional<DictionaryEncoding>& dictionary_encoding = std::nullopt);
+
+    // Replaces repeated long string cells with short codes in place and returns the legend
+    // describing them (empty when nothing qualifies for encoding).
+    static std::string DictionaryEncodeColumns(nlohmann::json& columns, const DictionaryEncoding& dictionary_encoding);
+
+    // Truncates cells of columns that declare a `max_tokens` budget, using the column's
+    // `truncate` strategy (head by default).
+    static void ApplyColumnTokenBudgets(nlohmann::json& columns);
 
     // Helper function to transcribe audio column and create transcription text column
     static nlohmann::json TranscribeAudioColumn(const nlohmann::json& audio_column);
@@ -52,7 +68,9 @@ public:
 public:
     template<typename FunctionType>
     static std::tuple<std::string, nlohmann::json> Render(const std::string& user_prompt, const nlohmann::json& columns, FunctionType option,
-                                                          TupleFormat tuple_format) {
+                                                          TupleFormat tuple_format,
+                                                          const std::optional<DictionaryEncoding>& dictionary_encoding = std::nullopt,
+                                                          OutputEncoding output_encoding = OutputEncoding::JSON) {
         auto image_data = nlohmann::json::array();
         auto tabular_data = nlohmann::json::array();
 
@@ -75,15 +93,17 @@ public:
             }
         }
 
+        PromptManager::ApplyColumnTokenBudgets(tabular_data);
+
         // Create media_data as an object with only image array (audio is now in tabular_data)
         nlohmann::json media_data;
         media_data["image"] = image_data;
         media_data["audio"] = nlohmann::json::array();// Empty - audio is now in tabular_data
 
-        auto prompt = PromptManager::GetTemplate(option);
+        auto prompt = PromptManager::GetTemplate(option, output_encoding);
         prompt = PromptManager::ReplaceSection(prompt, PromptSection::USER_PROMPT, user_prompt);
         if (!tabular_data.empty()) {
-            auto tuples = PromptManager::ConstructInputTuples(tabular_data, tuple_format);
+            auto tuples = PromptManager::ConstructInputTuples(tabular_data, tuple_format, dictionary_encoding);
             prompt = PromptManager::ReplaceSection(prompt, PromptSection::TUPLES, tuples);
         }
         return {prompt, media_data};
@@ -17,7 +17,8 @@ enum class AggregateFunctionType { REDUCE,
                                    RERANK };
 
 enum class ScalarFunctionType { COMPLETE,
-                                FILTER };
+                                FILTER,
+                                FUSED };
 
 enum class TupleFormat { XML,
                          JSON,
@@ -28,6 +29,14 @@ inline std::unordered_map<std::string, TupleFormat> TUPLE_FORMAT = {
         {"JSON", TupleFormat::JSON},
         {"MARKDOWN", TupleFormat::Markdown}};
 
+// How per-row answers are encoded in the model response. COMPACT replaces JSON arrays of
+// booleans / row ids with a single string (a T/F bitstring or a comma-separated list).
+enum class OutputEncoding { JSON,
+                            COMPACT };
+
+OutputEncoding stringToOutputEncoding(const std::string& encoding);
+std::string outputEncodingToString(OutputEncoding encoding);
+
 TupleFormat stringToTupleFormat(const std::string& format);
 TupleFormat tupleFormatFromStoredValue(const nlohmann::json& value);
 std::string tupleFormatToString(TupleFormat format);
@@ -107,6 +116,11 @@ public:
             "Return 'true' if the row meets the criteria, and 'false' otherwise. "
             "Ensure that each row is evaluated independently and that no row is skipped.";
 
+    static constexpr auto FUSED =
+            "For each row in the provided table, answer every task listed in the user's prompt. "
+            "Return one JSON object per row with exactly one key per task, named as in the task list, holding that task's answer. "
+            "Answer each task independently, and ensure that no row and no task is omitted.";
+
     // Aggregate Functions
     static constexpr auto REDUCE =
             "Analyze each row in the provided table to extract the most pertinent information related to the user's prompt. "
@@ -124,8 +138,21 @@ public:
             "Use the `flock_row_id` values and return them as a simple array of integers, not nested arrays. "
             "Each row should be considered independently, and the ranking should reflect the individual pertinence of each row.";
 
+    // Compact encodings
+    static constexpr auto FILTER_COMPACT =
+            "For each row in the provided table, determine whether it satisfies the user's prompt. "
+            "Return a single string with exactly one character per row, in row order: 'T' if the row meets the criteria, and 'F' otherwise. "
+            "Place this string as the only element of the `items` array, e.g. [\"TFFT\"] for four rows. "
+            "Ensure that each row is evaluated independently and that no row is skipped.";
+
+    static constexpr auto RERANK_COMPACT =
+            "Evaluate the relevance of each row in the provided table concerning the user's prompt. "
+            "Rank the rows in descending order of relevance and return their `flock_row_id` values in this order as a single "
+            "comma-separated string without spaces, placed as the only element of the `items` array, e.g. [\"3,1,2\"]. "
+            "Include every row exactly once, and let the ranking reflect the individual pertinence of each row.";
+
     template<typename FunctionType>
-    static std::string Get(const FunctionType option);
+    static std::string Get(const FunctionType option, OutputEncoding output_encoding = OutputEncoding::JSON);
 };
 
 struct PromptDetails {
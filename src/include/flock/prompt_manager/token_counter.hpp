@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace flock {
+
+enum class TruncationStrategy { HEAD,
+                                TAIL,
+                                MIDDLE };
+
+TruncationStrategy stringToTruncationStrategy(const std::string& strategy);
+
+// Provider-agnostic token estimates. Flock does not ship provider tokenizers, so
+// token counts are approximated from UTF-8 code points and cuts are placed on
+// whitespace where possible so no word or multi-byte character is split.
+class TokenCounter {
+public:
+    static constexpr size_t CHARS_PER_TOKEN = 4;
+
+    static size_t Estimate(const std::string& text);
+
+    // Returns `text` unchanged when it fits into `max_tokens`, otherwise keeps the
+    // start (HEAD), the end (TAIL) or both ends (MIDDLE) and marks the cut with "[...]".
+    static std::string Truncate(const std::string& text, size_t max_tokens, TruncationStrategy strategy);
+
+    // Splits `text` into chunks of at most `chunk_tokens`, each starting about `overlap_tokens`
+    // before the end of the previous one (at most half a chunk). Cuts are placed on whitespace.
+    static std::vector<std::string> Split(const std::string& text, size_t chunk_tokens, size_t overlap_tokens);
+
+private:
+    static size_t CodePointOffset(const std::string& text, size_t code_points);
+    static size_t CountCodePoints(const std::string& text);
+};
+
+}// namespace flock
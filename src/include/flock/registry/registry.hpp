@@ -3,6 +3,7 @@
 #include "flock/core/common.hpp"
 #include "flock/registry/aggregate.hpp"
 #include "flock/registry/scalar.hpp"
+#include "flock/registry/table.hpp"
 
 namespace flock {
 
@@ -13,6 +14,7 @@ public:
 private:
     static void RegisterAggregateFunctions(duckdb::ExtensionLoader& loader);
     static void RegisterScalarFunctions(duckdb::ExtensionLoader& loader);
+    static void RegisterTableFunctions(duckdb::ExtensionLoader& loader);
 };
 
 }// namespace flock
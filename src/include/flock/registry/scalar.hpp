@@ -11,6 +11,7 @@ public:
 private:
     static void RegisterLlmComplete(duckdb::ExtensionLoader& loader);
     static void RegisterLlmEmbedding(duckdb::ExtensionLoader& loader);
+    static void RegisterFlockQuantizeEmbedding(duckdb::ExtensionLoader& loader);
     static void RegisterLlmFilter(duckdb::ExtensionLoader& loader);
     static void RegisterFusionRRF(duckdb::ExtensionLoader& loader);
     static void RegisterFusionCombANZ(duckdb::ExtensionLoader& loader);
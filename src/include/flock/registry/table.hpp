@@ -0,0 +1,17 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+
+namespace flock {
+
+class TableRegistry {
+public:
+    static void Register(duckdb::ExtensionLoader& loader);
+
+private:
+    static void RegisterLlmMap(duckdb::ExtensionLoader& loader);
+    static void RegisterFlockTopkSimilar(duckdb::ExtensionLoader& loader);
+    static void RegisterFlockVectorIndex(duckdb::ExtensionLoader& loader);
+};
+
+}// namespace flock
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flock {
+
+// Hierarchical navigable small world graph (Malkov & Yashunin, 2018) over unit-length vectors,
+// scored by dot product. Node ids are dense and never reused, so a graph can be stored one row
+// per node and restored in id order.
+class HnswGraph {
+public:
+    // Links per node on the upper levels; level 0 keeps twice as many.
+    static constexpr size_t MAX_NEIGHBORS = 16;
+    static constexpr size_t MAX_NEIGHBORS_LEVEL0 = 2 * MAX_NEIGHBORS;
+    static constexpr size_t EF_CONSTRUCTION = 100;
+    static constexpr size_t MAX_LEVEL = 16;
+
+    struct Node {
+        std::string key;
+        std::vector<float> vector;
+        // One neighbor list per level, from level 0 up to the node's own level.
+        std::vector<std::vector<uint32_t>> neighbors;
+    };
+
+    struct Match {
+        uint32_t node;
+        float score;
+    };
+
+    // Links a new node into the graph and returns its id. Every existing node whose neighbor
+    // lists changed is appended to `changed`, possibly more than once.
+    uint32_t Insert(std::string key, std::vector<float> vector, std::vector<uint32_t>& changed);
+    // Appends a stored node as is; nodes must be restored in id order.
+    void Restore(Node node);
+    void SetEntryPoint(uint32_t entry_point);
+
+    // Up to k nodes, best first. `ef` is the size of the candidate list on level 0.
+    std::vector<Match> Search(const float* query, size_t k, size_t ef) const;
+
+    size_t Size() const { return nodes_.size(); }
+    size_t Dims() const { return dims_; }
+    uint32_t EntryPoint() const { return entry_point_; }
+    const Node& GetNode(const uint32_t id) const { return nodes_[id]; }
+
+    // Level of a new node, drawn from the exponential distribution of the paper. It is seeded by
+    // the node id, so rebuilding from the same rows in the same order gives the same graph.
+    static size_t RandomLevel(uint32_t id);
+
+private:
+    float Similarity(const float* query, uint32_t node) const;
+    size_t TopLevel() const { return nodes_[entry_point_].neighbors.size() - 1; }
+    // Best `ef` nodes reachable on `level` from the entry points, best first.
+    std::vector<Match> SearchLevel(const float* query, const std::vector<Match>& entry_points, size_t ef,
+                                   size_t level) const;
+    // Keeps candidates (best first) that are closer to the base than to any neighbor kept so
+    // far, so links spread in all directions; pruned candidates fill the remaining slots.
+    std::vector<uint32_t> SelectNeighbors(const std::vector<Match>& candidates, size_t max_neighbors) const;
+
+    size_t dims_ = 0;
+    std::vector<Node> nodes_;
+    uint32_t entry_point_ = 0;
+};
+
+}// namespace flock
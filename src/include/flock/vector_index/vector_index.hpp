@@ -0,0 +1,76 @@
+#pragma once
+
+#include "flock/core/common.hpp"
+#include "flock/vector_index/hnsw.hpp"
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <utility>
+
+namespace flock {
+
+// Named HNSW indexes over an embedding column of a table, scored by cosine similarity. An index
+// is stored in the database it was created in (one row per graph node) and loaded into memory
+// the first time it is searched there; loaded graphs are kept per database, so databases with
+// an index of the same name do not share it. Rows are identified by a key column, not by rowid,
+// because DuckDB may renumber rows.
+class VectorIndex {
+public:
+    static constexpr size_t DEFAULT_EF_SEARCH = 64;
+
+    struct Definition {
+        std::string name;
+        std::string table;
+        std::string key_column;
+        std::string embedding_column;
+        // SQL type of the key column, used to join matches back to the table.
+        std::string key_type;
+        // Model struct used to embed text queries; null when only vectors can be searched.
+        nlohmann::json model;
+    };
+
+    struct Match {
+        std::string key;
+        float score;
+    };
+
+    // Builds the index over every row with an embedding, replacing an index of the same name.
+    // Returns the number of rows indexed.
+    static size_t Create(duckdb::DatabaseInstance& db, Definition definition);
+    // Links rows whose key is not in the index yet; existing nodes are not rebuilt.
+    static size_t Update(duckdb::DatabaseInstance& db, const std::string& name);
+    static void Drop(duckdb::DatabaseInstance& db, const std::string& name);
+
+    static Definition GetDefinition(duckdb::DatabaseInstance& db, const std::string& name);
+    static std::vector<Match> Search(duckdb::DatabaseInstance& db, const std::string& name, std::vector<float> query,
+                                     size_t k, size_t ef);
+    // Embeds `text` with the index's model, so text queries match the indexed embeddings.
+    static std::vector<float> EmbedQuery(const Definition& definition, const std::string& text);
+    // Forgets the loaded graphs; they are read from the database again on next use.
+    static void Unload();
+    // `catalog.schema.table` with every part quoted as needed.
+    static std::string QuoteTableName(const std::string& table);
+
+private:
+    struct LoadedIndex {
+        Definition definition;
+        HnswGraph graph;
+    };
+
+    // The database an index is stored in, and its name.
+    using IndexKey = std::pair<const duckdb::DatabaseInstance*, std::string>;
+
+    static LoadedIndex& GetUnlocked(duckdb::DatabaseInstance& db, const std::string& name);
+    static Definition LoadDefinition(duckdb::Connection& con, const std::string& name);
+    static void LoadGraph(duckdb::Connection& con, LoadedIndex& index);
+    // Inserts the table rows missing from the index and stores the nodes that changed.
+    static size_t AddMissingRows(duckdb::Connection& con, LoadedIndex& index);
+    static void StoreNodes(duckdb::Connection& con, const LoadedIndex& index, std::vector<uint32_t> node_ids);
+    static std::string GetDefinitionTable();
+    static std::string GetNodeTable();
+
+    inline static std::mutex mutex_;
+    inline static std::map<IndexKey, std::unique_ptr<LoadedIndex>> indexes_;
+};
+
+}// namespace flock
@@ -0,0 +1,116 @@
+#include "flock/model_manager/batch_size_controller.hpp"
+#include "flock/model_manager/result_cache.hpp"
+
+#include <algorithm>
+
+namespace flock {
+
+std::string BatchSizeController::Key(const ModelDetails& model_details, const std::string& user_prompt) {
+    return model_details.provider_name + '\x1f' + model_details.model + '\x1f' + ResultCache::Hash(user_prompt);
+}
+
+BatchSizeController::State& BatchSizeController::Touch(const std::string& key) {
+    if (const auto it = states_.find(key); it != states_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+    }
+    lru_.emplace_front(key, State{});
+    states_[key] = lru_.begin();
+    if (lru_.size() > MAX_STATES) {
+        states_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    return lru_.front().second;
+}
+
+int BatchSizeController::Initial(const ModelDetails& model_details, const std::string& user_prompt,
+                                 const int max_batch_size) {
+    const auto key = Key(model_details, user_prompt);
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = states_.find(key);
+    if (it == states_.end() || it->second->second.batch_size <= 0) {
+        return max_batch_size;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return std::clamp(it->second->second.batch_size, 1, std::max(max_batch_size, 1));
+}
+
+int BatchSizeController::OnSuccess(const ModelDetails& model_details, const std::string& user_prompt,
+                                   const int batch_size, const double elapsed_ms, const int max_batch_size) {
+    const auto key = Key(model_details, user_prompt);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& state = Touch(key);
+    if (state.batch_size <= 0) {
+        state.batch_size = max_batch_size;
+    }
+    state.largest_success = std::max(state.largest_success, batch_size);
+
+    // Tail batches are smaller than the learned size for lack of rows, not because of the model;
+    // they say nothing about whether a larger batch would fit.
+    if (batch_size < state.batch_size || batch_size <= 0) {
+        return std::clamp(state.batch_size, 1, std::max(max_batch_size, 1));
+    }
+
+    const auto step = std::max(1, static_cast<int>(max_batch_size * ADDITIVE_INCREASE));
+    if (state.token_ceiling > 0 && ++state.successes_since_token_limit >= CEILING_PROBE_SUCCESSES) {
+        state.token_ceiling += step;
+        state.successes_since_token_limit = 0;
+    }
+
+    bool slower = false;
+    if (elapsed_ms >= MIN_LATENCY_SIGNAL_MS) {
+        const auto latency_per_row = elapsed_ms / batch_size;
+        slower = state.latency_per_row_ms > 0.0 && latency_per_row > LATENCY_TOLERANCE * state.latency_per_row_ms;
+        state.latency_per_row_ms = state.latency_per_row_ms > 0.0
+                                           ? (1.0 - LEARNING_RATE) * state.latency_per_row_ms +
+                                                     LEARNING_RATE * latency_per_row
+                                           : latency_per_row;
+    }
+
+    auto next = slower ? static_cast<int>(batch_size * LATENCY_DECREASE) : batch_size + step;
+    next = std::min(next, max_batch_size);
+    if (state.token_ceiling > 0) {
+        next = std::min(next, state.token_ceiling - 1);
+    }
+    state.batch_size = std::max(next, 1);
+    return state.batch_size;
+}
+
+int BatchSizeController::OnTokenLimit(const ModelDetails& model_details, const std::string& user_prompt,
+                                      const int batch_size) {
+    const auto next = static_cast<int>(batch_size * TOKEN_LIMIT_DECREASE);
+    const auto key = Key(model_details, user_prompt);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& state = Touch(key);
+    // A single row that does not fit is nulled by the caller; it is no reason to stop batching.
+    if (batch_size > 1) {
+        state.token_ceiling = state.token_ceiling > 0 ? std::min(state.token_ceiling, batch_size) : batch_size;
+        state.successes_since_token_limit = 0;
+        state.batch_size = state.batch_size > 0 ? std::min(state.batch_size, next) : next;
+    }
+    return next;
+}
+
+std::optional<BatchSizeController::State> BatchSizeController::Get(const ModelDetails& model_details,
+                                                                   const std::string& user_prompt) {
+    const auto key = Key(model_details, user_prompt);
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = states_.find(key);
+    if (it == states_.end()) {
+        return std::nullopt;
+    }
+    return it->second->second;
+}
+
+size_t BatchSizeController::Size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return states_.size();
+}
+
+void BatchSizeController::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    states_.clear();
+    lru_.clear();
+}
+
+}// namespace flock
@@ -0,0 +1,21 @@
+#include "flock/model_manager/cache_storage.hpp"
+#include "flock/core/config.hpp"
+
+namespace flock {
+
+void CacheStorage::Run(const std::function<void(duckdb::Connection&)>& work) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto con = Config::GetConnection();
+    EnsureAttached(con);
+    work(con);
+}
+
+void CacheStorage::EnsureAttached(duckdb::Connection& con) {
+    const auto attached = con.Query("SELECT 1 FROM duckdb_databases() WHERE database_name = 'flock_storage';");
+    if (!attached->HasError() && attached->RowCount() > 0) {
+        return;
+    }
+    Config::AttachToGlobalStorage(con, false);
+}
+
+}// namespace flock
@@ -0,0 +1,127 @@
+#include "flock/model_manager/inflight_budget.hpp"
+
+#include <algorithm>
+
+namespace flock {
+
+InflightBudget::Reservation::Reservation(Reservation&& other) noexcept
+    : bytes_(other.bytes_), queued_(other.queued_) {
+    other.bytes_ = 0;
+}
+
+InflightBudget::Reservation& InflightBudget::Reservation::operator=(Reservation&& other) noexcept {
+    if (this != &other) {
+        Release();
+        bytes_ = other.bytes_;
+        queued_ = other.queued_;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void InflightBudget::Reservation::Resize(const size_t bytes) {
+    if (bytes == bytes_) {
+        return;
+    }
+    auto& state = GetState();
+    const auto shrinks = bytes < bytes_;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.in_use = state.in_use - bytes_ + bytes;
+        if (queued_) {
+            state.queued = state.queued - bytes_ + bytes;
+        }
+        bytes_ = bytes;
+    }
+    if (shrinks) {
+        state.released.notify_all();
+    }
+}
+
+void InflightBudget::Reservation::Release() {
+    if (bytes_ == 0) {
+        return;
+    }
+    Resize(0);
+}
+
+void InflightBudget::Register(duckdb::DBConfig& config) {
+    config.AddExtensionOption(SETTING_NAME, "Maximum bytes of LLM request payloads and responses held in flight",
+                              duckdb::LogicalType::UBIGINT, duckdb::Value::UBIGINT(DEFAULT_MAX_BYTES),
+                              OnSettingChanged);
+}
+
+void InflightBudget::OnSettingChanged(duckdb::ClientContext& context, duckdb::SetScope scope,
+                                      duckdb::Value& parameter) {
+    const auto max_bytes = parameter.GetValue<uint64_t>();
+    if (max_bytes == 0) {
+        throw duckdb::InvalidInputException("'%s' must be larger than 0", SETTING_NAME);
+    }
+    SetMaxBytes(max_bytes);
+}
+
+InflightBudget::State& InflightBudget::GetState() {
+    static auto* state = new State();
+    return *state;
+}
+
+bool InflightBudget::Fits(const State& state, const size_t bytes) {
+    const auto sending = state.in_use - state.queued;
+    return sending == 0 || sending + bytes <= state.max_bytes;
+}
+
+InflightBudget::Reservation InflightBudget::Acquire(const size_t bytes) {
+    auto& state = GetState();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.released.wait(lock, [&state, bytes]() { return Fits(state, bytes); });
+    state.in_use += bytes;
+    return Reservation(bytes, false);
+}
+
+std::optional<InflightBudget::Reservation> InflightBudget::TryAcquire(const size_t bytes) {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!Fits(state, bytes)) {
+        return std::nullopt;
+    }
+    state.in_use += bytes;
+    return Reservation(bytes, false);
+}
+
+InflightBudget::Reservation InflightBudget::Queue(const size_t bytes) {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.in_use += bytes;
+    state.queued += bytes;
+    return Reservation(bytes, true);
+}
+
+bool InflightBudget::IsExhausted() {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.in_use >= state.max_bytes;
+}
+
+size_t InflightBudget::InUse() {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.in_use;
+}
+
+void InflightBudget::SetMaxBytes(const size_t max_bytes) {
+    auto& state = GetState();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.max_bytes = std::max<size_t>(max_bytes, 1);
+    }
+    // Waiting reservations may fit in a larger budget.
+    state.released.notify_all();
+}
+
+size_t InflightBudget::GetMaxBytes() {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.max_bytes;
+}
+
+}// namespace flock
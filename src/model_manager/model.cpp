@@ -2,6 +2,8 @@
 #include "flock/prompt_manager/repository.hpp"
 #include "flock/secret_manager/secret_manager.hpp"
 #include <algorithm>
+#include <deque>
+#include <list>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -28,6 +30,43 @@ std::string ResolveDefaultSecretName(const std::string& provider_name, const nlo
     return secret_name;
 }
 
+bool IsFullyResolved(const nlohmann::json& model_json) {
+    return model_json.contains("model") && model_json.contains("provider") && model_json.contains("secret") &&
+           model_json.contains("tuple_format") &&
+           (model_json.contains("max_batch_size") || model_json.contains("batch_size"));
+}
+
+// Resolved details and idle providers shared by every Model built from the same model JSON.
+// Fully resolved JSON maps straight to its details, so rebuilding a Model per chunk skips
+// parsing, secret lookup and handler setup. Leaked so providers released during static
+// destruction never touch a destroyed pool.
+// Idle providers are kept in release order, most recent first, and the least recently released
+// one is dropped once the pool holds MAX_IDLE_PROVIDERS across all models.
+struct ModelPool {
+    static constexpr size_t MAX_DETAILS = 1024;
+    static constexpr size_t MAX_IDLE_PROVIDERS_PER_MODEL = 64;
+    static constexpr size_t MAX_IDLE_PROVIDERS = 256;
+
+    using IdleList = std::list<std::pair<std::string, std::unique_ptr<IProvider>>>;
+
+    std::mutex mutex;
+    uint64_t generation = 0;
+    std::unordered_map<std::string, std::shared_ptr<const ModelDetails>> details_by_json;
+    IdleList idle_providers;
+    // Per model JSON, its idle entries oldest first.
+    std::unordered_map<std::string, std::deque<IdleList::iterator>> idle_by_key;
+};
+
+ModelPool& GetModelPool() {
+    static auto* pool = new ModelPool();
+    return *pool;
+}
+
+const std::shared_ptr<const ModelDetails>& EmptyModelDetails() {
+    static const auto empty = std::make_shared<const ModelDetails>();
+    return empty;
+}
+
 void NormalizeStoredModelArgs(nlohmann::json& model_args) {
     if (!model_args.contains("tuple_format") || !model_args.at("tuple_format").is_string()) {
         return;
@@ -44,14 +83,47 @@ bool is_base64(const std::string& str) {
     return std::regex_match(str, base64_regex);
 }
 
+Model::Model() : model_details_(EmptyModelDetails()) {}
+
 Model::Model(const nlohmann::json& model_json) {
-    LoadModelDetails(model_json);
+    const bool is_fully_resolved = IsFullyResolved(model_json);
+    if (is_fully_resolved) {
+        pool_key_ = model_json.dump();
+        auto& pool = GetModelPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (const auto it = pool.details_by_json.find(pool_key_); it != pool.details_by_json.end()) {
+            model_details_ = it->second;
+        }
+    }
+
+    if (!model_details_) {
+        model_details_ = std::make_shared<const ModelDetails>(LoadModelDetails(model_json));
+        if (is_fully_resolved) {
+            auto& pool = GetModelPool();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            if (pool.details_by_json.size() >= ModelPool::MAX_DETAILS) {
+                pool.details_by_json.clear();
+            }
+            pool.details_by_json.emplace(pool_key_, model_details_);
+        } else {
+            // Details that came from storage or secrets are looked up again next time, but
+            // providers are still shared through the JSON they resolved to.
+            pool_key_ = GetModelDetailsAsJson().dump();
+        }
+    }
     ConstructProvider();
 }
 
-void Model::LoadModelDetails(const nlohmann::json& model_json) {
-    model_details_.model_name = model_json.contains("model_name") ? model_json.at("model_name").get<std::string>() : "";
-    if (model_details_.model_name.empty()) {
+Model Model::WithFreshProvider() const {
+    Model model(*this);
+    model.ConstructProvider();
+    return model;
+}
+
+ModelDetails Model::LoadModelDetails(const nlohmann::json& model_json) {
+    ModelDetails details;
+    details.model_name = model_json.contains("model_name") ? model_json.at("model_name").get<std::string>() : "";
+    if (details.model_name.empty()) {
         throw std::invalid_argument("`model_name` is required in model settings");
     }
 
@@ -64,98 +136,96 @@ void Model::LoadModelDetails(const nlohmann::json& model_json) {
         return model_args.contains("max_batch_size") || model_args.contains("batch_size");
     };
 
-    const bool is_fully_resolved = model_json.contains("model") && model_json.contains("provider") &&
-                                   model_json.contains("secret") && model_json.contains("tuple_format") &&
-                                   hasBatchSizeConfig(model_json);
+    const bool is_fully_resolved = IsFullyResolved(model_json);
 
     // Each fallback path can call this helper, but only the first missing field
     // queries storage. Fully resolved model JSON skips DB defaults entirely.
     auto ensure_db_loaded = [&]() {
         if (!db_loaded) {
-            std::tie(db_model, db_provider, db_model_args) = GetQueriedModel(model_details_.model_name);
+            std::tie(db_model, db_provider, db_model_args) = GetQueriedModel(details.model_name);
             db_loaded = true;
         }
     };
 
     if (model_json.contains("model")) {
-        model_details_.model = model_json.at("model").get<std::string>();
+        details.model = model_json.at("model").get<std::string>();
     } else {
         ensure_db_loaded();
-        model_details_.model = db_model;
+        details.model = db_model;
     }
 
     if (model_json.contains("provider")) {
-        model_details_.provider_name = model_json.at("provider").get<std::string>();
+        details.provider_name = model_json.at("provider").get<std::string>();
     } else {
         ensure_db_loaded();
-        model_details_.provider_name = db_provider;
+        details.provider_name = db_provider;
     }
 
     if (model_json.contains("secret")) {
-        model_details_.secret = model_json["secret"].get<std::unordered_map<std::string, std::string>>();
+        details.secret = model_json["secret"].get<std::unordered_map<std::string, std::string>>();
     } else {
-        model_details_.secret = SecretManager::GetSecret(ResolveDefaultSecretName(model_details_.provider_name, model_json));
+        details.secret = SecretManager::GetSecret(ResolveDefaultSecretName(details.provider_name, model_json));
     }
 
     if (model_json.contains("model_parameters")) {
-        model_details_.model_parameters = ParseModelParametersField(model_json);
+        details.model_parameters = ParseModelParametersField(model_json);
     } else if (is_fully_resolved) {
-        model_details_.model_parameters = nlohmann::json::object();
+        details.model_parameters = nlohmann::json::object();
     } else {
         ensure_db_loaded();
         if (db_model_args.contains("model_parameters")) {
-            model_details_.model_parameters = db_model_args["model_parameters"];
+            details.model_parameters = db_model_args["model_parameters"];
         } else {
-            model_details_.model_parameters = nlohmann::json::object();
+            details.model_parameters = nlohmann::json::object();
         }
     }
 
     if (model_json.contains("tuple_format")) {
         const auto& tuple_format_value = model_json.at("tuple_format");
         if (tuple_format_value.is_string()) {
-            model_details_.tuple_format = stringToTupleFormat(tuple_format_value.get<std::string>());
+            details.tuple_format = stringToTupleFormat(tuple_format_value.get<std::string>());
         } else {
-            model_details_.tuple_format = tupleFormatFromStoredValue(tuple_format_value);
+            details.tuple_format = tupleFormatFromStoredValue(tuple_format_value);
         }
     } else {
         ensure_db_loaded();
         if (db_model_args.contains("tuple_format")) {
-            model_details_.tuple_format = tupleFormatFromStoredValue(db_model_args.at("tuple_format"));
+            details.tuple_format = tupleFormatFromStoredValue(db_model_args.at("tuple_format"));
         } else {
-            model_details_.tuple_format = TupleFormat::XML;
+            details.tuple_format = TupleFormat::XML;
         }
     }
 
     if (hasBatchSizeConfig(model_json)) {
-        model_details_.max_batch_size = ResolveMaxBatchSizeFromJson(model_json);
+        details.max_batch_size = ResolveMaxBatchSizeFromJson(model_json);
     } else {
         ensure_db_loaded();
         if (hasBatchSizeConfig(db_model_args)) {
-            model_details_.max_batch_size = ResolveMaxBatchSizeFromJson(db_model_args);
+            details.max_batch_size = ResolveMaxBatchSizeFromJson(db_model_args);
         } else {
-            model_details_.max_batch_size = DEFAULT_MAX_BATCH_SIZE;
+            details.max_batch_size = DEFAULT_MAX_BATCH_SIZE;
         }
     }
 
     if (model_json.contains("is_async")) {
-        model_details_.is_async = model_json.at("is_async").get<bool>();
+        details.is_async = model_json.at("is_async").get<bool>();
     } else if (is_fully_resolved) {
-        model_details_.is_async = true;
+        details.is_async = true;
     } else {
         ensure_db_loaded();
         if (db_model_args.contains("is_async")) {
-            model_details_.is_async = db_model_args.at("is_async").get<bool>();
+            details.is_async = db_model_args.at("is_async").get<bool>();
         } else {
-            model_details_.is_async = true;
+            details.is_async = true;
         }
     }
 
     if (model_json.contains("rate_limit")) {
-        model_details_.rate_limit = ParsePositiveSizeFromJson(model_json.at("rate_limit"), "rate_limit");
+        details.rate_limit = ParsePositiveSizeFromJson(model_json.at("rate_limit"), "rate_limit");
     } else {
         ensure_db_loaded();
         if (db_model_args.contains("rate_limit")) {
-            model_details_.rate_limit = ParsePositiveSizeFromJson(db_model_args.at("rate_limit"), "rate_limit");
+            details.rate_limit = ParsePositiveSizeFromJson(db_model_args.at("rate_limit"), "rate_limit");
         }
     }
 
@@ -164,8 +234,8 @@ void Model::LoadModelDetails(const nlohmann::json& model_json) {
         if (!usage_limit_value.is_object()) {
             throw std::runtime_error("Expected 'usage_limit' to be a JSON object.");
         }
-        model_details_.usage_limit = ParseUsageLimitFromJson(usage_limit_value);
-        if (!model_details_.usage_limit->HasAnyLimit()) {
+        details.usage_limit = ParseUsageLimitFromJson(usage_limit_value);
+        if (!details.usage_limit->HasAnyLimit()) {
             throw std::runtime_error(
                     "'usage_limit' must specify at least one of prompt_tokens_limit, completion_tokens_limit, or "
                     "total_tokens_limit.");
@@ -173,14 +243,82 @@ void Model::LoadModelDetails(const nlohmann::json& model_json) {
     } else if (!is_fully_resolved) {
         ensure_db_loaded();
         if (db_model_args.contains("usage_limit")) {
-            model_details_.usage_limit = ParseUsageLimitFromJson(db_model_args.at("usage_limit"));
-            if (!model_details_.usage_limit->HasAnyLimit()) {
+            details.usage_limit = ParseUsageLimitFromJson(db_model_args.at("usage_limit"));
+            if (!details.usage_limit->HasAnyLimit()) {
                 throw std::runtime_error(
                         "'usage_limit' must specify at least one of prompt_tokens_limit, completion_tokens_limit, or "
                         "total_tokens_limit.");
             }
         }
     }
+
+    if (model_json.contains("dictionary_encoding")) {
+        details.dictionary_encoding = ParseDictionaryEncodingFromJson(model_json.at("dictionary_encoding"));
+    } else if (!is_fully_resolved) {
+        ensure_db_loaded();
+        if (db_model_args.contains("dictionary_encoding")) {
+            details.dictionary_encoding = ParseDictionaryEncodingFromJson(db_model_args.at("dictionary_encoding"));
+        }
+    }
+
+    if (model_json.contains("output_token_budget")) {
+        details.output_token_budget = model_json.at("output_token_budget").get<bool>();
+    } else if (!is_fully_resolved) {
+        ensure_db_loaded();
+        if (db_model_args.contains("output_token_budget")) {
+            details.output_token_budget = db_model_args.at("output_token_budget").get<bool>();
+        }
+    }
+
+    if (model_json.contains("output_encoding")) {
+        details.output_encoding = stringToOutputEncoding(model_json.at("output_encoding").get<std::string>());
+    } else if (!is_fully_resolved) {
+        ensure_db_loaded();
+        if (db_model_args.contains("output_encoding")) {
+            details.output_encoding = stringToOutputEncoding(db_model_args.at("output_encoding").get<std::string>());
+        }
+    }
+
+    if (model_json.contains("cache")) {
+        details.cache = stringToCacheMode(model_json.at("cache").get<std::string>());
+    } else if (!is_fully_resolved) {
+        ensure_db_loaded();
+        if (db_model_args.contains("cache")) {
+            details.cache = stringToCacheMode(db_model_args.at("cache").get<std::string>());
+        }
+    }
+
+    if (model_json.contains("semantic_cache")) {
+        details.semantic_cache = ParseSemanticCacheFromJson(model_json.at("semantic_cache"));
+    } else if (!is_fully_resolved) {
+        ensure_db_loaded();
+        if (db_model_args.contains("semantic_cache")) {
+            details.semantic_cache = ParseSemanticCacheFromJson(db_model_args.at("semantic_cache"));
+        }
+    }
+
+    if (model_json.contains("empty_input_default")) {
+        details.empty_input_default = ParseEmptyInputDefault(model_json.at("empty_input_default"));
+    } else if (!is_fully_resolved) {
+        ensure_db_loaded();
+        if (db_model_args.contains("empty_input_default")) {
+            details.empty_input_default = ParseEmptyInputDefault(db_model_args.at("empty_input_default"));
+        }
+    }
+
+    if (model_json.contains("long_input")) {
+        details.long_input = ParseLongInputFromJson(model_json.at("long_input"));
+    } else if (!is_fully_resolved) {
+        ensure_db_loaded();
+        if (db_model_args.contains("long_input")) {
+            details.long_input = ParseLongInputFromJson(db_model_args.at("long_input"));
+        }
+    }
+
+    if (model_json.contains("item_schema")) {
+        details.item_schema = model_json.at("item_schema");
+    }
+    return details;
 }
 
 std::tuple<std::string, std::string, nlohmann::basic_json<>> Model::GetQueriedModel(const std::string& model_name) {
@@ -237,69 +375,171 @@ std::shared_ptr<ModelUsageLimiter> Model::GetOrCreateUsageLimiter(const std::str
 }
 
 void Model::ResetRateLimiters() {
-    std::lock_guard<std::mutex> lock(limiter_registry_mutex_);
-    rate_limiters_by_model_.clear();
+    {
+        std::lock_guard<std::mutex> lock(limiter_registry_mutex_);
+        rate_limiters_by_model_.clear();
+    }
+    // Pooled providers still point at the old limiters.
+    ResetModelPool();
 }
 
 void Model::ResetUsageLimiters() {
-    std::lock_guard<std::mutex> lock(limiter_registry_mutex_);
-    usage_limiters_by_model_.clear();
+    {
+        std::lock_guard<std::mutex> lock(limiter_registry_mutex_);
+        usage_limiters_by_model_.clear();
+    }
+    ResetModelPool();
 }
 
-void Model::ConstructProvider() {
-    std::shared_ptr<ModelRateLimiter> rate_limiter;
-    std::shared_ptr<ModelUsageLimiter> usage_limiter;
-    if (!model_details_.model_name.empty()) {
-        rate_limiter = GetOrCreateRateLimiter(model_details_.model_name);
-        usage_limiter = GetOrCreateUsageLimiter(model_details_.model_name);
+void Model::ResetModelPool() {
+    ModelPool::IdleList idle_providers;
+    {
+        auto& pool = GetModelPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.generation++;
+        pool.details_by_json.clear();
+        pool.idle_by_key.clear();
+        idle_providers.swap(pool.idle_providers);
     }
+}
 
-    if (mock_provider_factory_) {
-        provider_ = mock_provider_factory_(model_details_, std::move(rate_limiter), std::move(usage_limiter));
-        return;
-    }
-    if (mock_provider_) {
-        provider_ = mock_provider_;
-        return;
+size_t Model::CountIdleProviders() {
+    auto& pool = GetModelPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.idle_providers.size();
+}
+
+std::unique_ptr<IProvider> Model::CreateProvider(const ModelDetails& model_details) {
+    std::shared_ptr<ModelRateLimiter> rate_limiter;
+    std::shared_ptr<ModelUsageLimiter> usage_limiter;
+    if (!model_details.model_name.empty()) {
+        rate_limiter = GetOrCreateRateLimiter(model_details.model_name);
+        usage_limiter = GetOrCreateUsageLimiter(model_details.model_name);
     }
 
-    switch (GetProviderType(model_details_.provider_name)) {
+    switch (GetProviderType(model_details.provider_name)) {
         case FLOCKMTL_OPENAI:
-            provider_ = std::make_shared<OpenAIProvider>(model_details_, rate_limiter, usage_limiter);
-            break;
+            return std::make_unique<OpenAIProvider>(model_details, rate_limiter, usage_limiter);
         case FLOCKMTL_AZURE:
-            provider_ = std::make_shared<AzureProvider>(model_details_, rate_limiter, usage_limiter);
-            break;
+            return std::make_unique<AzureProvider>(model_details, rate_limiter, usage_limiter);
         case FLOCKMTL_OLLAMA:
-            provider_ = std::make_shared<OllamaProvider>(model_details_, rate_limiter, usage_limiter);
-            break;
+            return std::make_unique<OllamaProvider>(model_details, rate_limiter, usage_limiter);
         case FLOCKMTL_ANTHROPIC:
-            provider_ = std::make_shared<AnthropicProvider>(model_details_, rate_limiter, usage_limiter);
-            break;
+            return std::make_unique<AnthropicProvider>(model_details, rate_limiter, usage_limiter);
         default:
-            throw std::invalid_argument(duckdb_fmt::format("Unsupported provider: {}", model_details_.provider_name));
+            throw std::invalid_argument(duckdb_fmt::format("Unsupported provider: {}", model_details.provider_name));
+    }
+}
+
+void Model::ConstructProvider() {
+    if (mock_provider_factory_ || mock_provider_) {
+        std::shared_ptr<ModelRateLimiter> rate_limiter;
+        std::shared_ptr<ModelUsageLimiter> usage_limiter;
+        if (!model_details_->model_name.empty()) {
+            rate_limiter = GetOrCreateRateLimiter(model_details_->model_name);
+            usage_limiter = GetOrCreateUsageLimiter(model_details_->model_name);
+        }
+        provider_ = mock_provider_factory_
+                            ? mock_provider_factory_(*model_details_, std::move(rate_limiter), std::move(usage_limiter))
+                            : mock_provider_;
+        return;
+    }
+
+    // A provider is leased to one Model (and its copies) at a time, since it holds queued
+    // requests; it goes back to the pool when the last copy releases it.
+    std::unique_ptr<IProvider> provider;
+    uint64_t generation;
+    {
+        auto& pool = GetModelPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        generation = pool.generation;
+        if (const auto it = pool.idle_by_key.find(pool_key_); it != pool.idle_by_key.end()) {
+            const auto entry = it->second.back();
+            provider = std::move(entry->second);
+            pool.idle_providers.erase(entry);
+            it->second.pop_back();
+            if (it->second.empty()) {
+                pool.idle_by_key.erase(it);
+            }
+        }
     }
+    if (!provider) {
+        provider = CreateProvider(*model_details_);
+    }
+
+    provider_ = std::shared_ptr<IProvider>(provider.release(), [key = pool_key_, generation](IProvider* released) {
+        std::unique_ptr<IProvider> owned(released);
+        owned->ResetForReuse();
+        std::unique_ptr<IProvider> evicted;
+        auto& pool = GetModelPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        // Stale generations hold limiters that were reset, so their providers are dropped.
+        if (generation != pool.generation) {
+            return;
+        }
+        auto& idle = pool.idle_by_key[key];
+        if (idle.size() >= ModelPool::MAX_IDLE_PROVIDERS_PER_MODEL) {
+            return;
+        }
+        pool.idle_providers.emplace_front(key, std::move(owned));
+        idle.push_back(pool.idle_providers.begin());
+
+        if (pool.idle_providers.size() > ModelPool::MAX_IDLE_PROVIDERS) {
+            auto& oldest = pool.idle_providers.back();
+            auto& oldest_idle = pool.idle_by_key[oldest.first];
+            oldest_idle.pop_front();
+            if (oldest_idle.empty()) {
+                pool.idle_by_key.erase(oldest.first);
+            }
+            evicted = std::move(oldest.second);
+            pool.idle_providers.pop_back();
+        }
+    });
 }
 
-ModelDetails Model::GetModelDetails() { return model_details_; }
+const ModelDetails& Model::GetModelDetails() const { return *model_details_; }
 
 nlohmann::json Model::GetModelDetailsAsJson() const {
     nlohmann::json result;
-    result["model_name"] = model_details_.model_name;
-    result["model"] = model_details_.model;
-    result["provider"] = model_details_.provider_name;
-    result["tuple_format"] = static_cast<int>(model_details_.tuple_format);
-    result["max_batch_size"] = model_details_.max_batch_size;
-    result["is_async"] = model_details_.is_async;
-    result["secret"] = model_details_.secret;
-    if (model_details_.rate_limit.has_value()) {
-        result["rate_limit"] = *model_details_.rate_limit;
-    }
-    if (model_details_.usage_limit.has_value()) {
-        result["usage_limit"] = UsageLimitToJson(*model_details_.usage_limit);
-    }
-    if (!model_details_.model_parameters.empty()) {
-        result["model_parameters"] = model_details_.model_parameters;
+    result["model_name"] = model_details_->model_name;
+    result["model"] = model_details_->model;
+    result["provider"] = model_details_->provider_name;
+    result["tuple_format"] = static_cast<int>(model_details_->tuple_format);
+    result["max_batch_size"] = model_details_->max_batch_size;
+    result["is_async"] = model_details_->is_async;
+    result["secret"] = model_details_->secret;
+    if (model_details_->rate_limit.has_value()) {
+        result["rate_limit"] = *model_details_->rate_limit;
+    }
+    if (model_details_->usage_limit.has_value()) {
+        result["usage_limit"] = UsageLimitToJson(*model_details_->usage_limit);
+    }
+    if (model_details_->dictionary_encoding.has_value()) {
+        result["dictionary_encoding"] = DictionaryEncodingToJson(*model_details_->dictionary_encoding);
+    }
+    if (model_details_->output_token_budget) {
+        result["output_token_budget"] = true;
+    }
+    if (model_details_->output_encoding != OutputEncoding::JSON) {
+        result["output_encoding"] = outputEncodingToString(model_details_->output_encoding);
+    }
+    if (model_details_->cache != CacheMode::OFF) {
+        result["cache"] = cacheModeToString(model_details_->cache);
+    }
+    if (model_details_->semantic_cache.has_value()) {
+        result["semantic_cache"] = SemanticCacheToJson(*model_details_->semantic_cache);
+    }
+    if (!model_details_->empty_input_default.is_null()) {
+        result["empty_input_default"] = model_details_->empty_input_default;
+    }
+    if (model_details_->long_input.has_value()) {
+        result["long_input"] = LongInputToJson(*model_details_->long_input);
+    }
+    if (model_details_->item_schema.has_value()) {
+        result["item_schema"] = *model_details_->item_schema;
+    }
+    if (!model_details_->model_parameters.empty()) {
+        result["model_parameters"] = model_details_->model_parameters;
     }
     return result;
 }
@@ -319,6 +559,10 @@ void Model::AddCompletionRequest(const std::string& prompt, const int num_output
     provider_->AddCompletionRequest(prompt, num_output_tuples, output_type, media_data);
 }
 
+void Model::SetStringTokensPerTupleHint(const std::optional<double> tokens_per_tuple) {
+    provider_->string_tokens_per_tuple_hint_ = tokens_per_tuple;
+}
+
 void Model::AddEmbeddingRequest(const std::vector<std::string>& inputs) {
     provider_->AddEmbeddingRequest(inputs);
 }
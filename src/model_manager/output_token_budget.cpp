@@ -0,0 +1,139 @@
+#include "flock/model_manager/output_token_budget.hpp"
+#include "flock/model_manager/result_cache.hpp"
+#include "flock/prompt_manager/token_counter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace flock {
+
+std::optional<size_t> OutputTokenBudget::Compute(const OutputType output_type, const int num_output_tuples,
+                                                 const std::optional<double> string_tokens_per_tuple) {
+    const auto num_tuples = static_cast<size_t>(std::max(num_output_tuples, 1));
+    switch (output_type) {
+        case OutputType::BOOL:
+            return ENVELOPE_TOKENS + BOOL_TOKENS_PER_TUPLE * num_tuples;
+        case OutputType::INTEGER:
+            return ENVELOPE_TOKENS + INTEGER_TOKENS_PER_TUPLE * num_tuples;
+        case OutputType::BITSTRING:
+            return ENVELOPE_TOKENS + BITSTRING_TOKENS_PER_TUPLE * num_tuples;
+        case OutputType::INDEX_LIST:
+            return ENVELOPE_TOKENS + INDEX_LIST_TOKENS_PER_TUPLE * num_tuples;
+        case OutputType::STRING: {
+            if (!string_tokens_per_tuple.has_value()) {
+                return std::nullopt;
+            }
+            const auto per_tuple = std::max(MIN_STRING_TOKENS_PER_TUPLE,
+                                            static_cast<size_t>(std::ceil(*string_tokens_per_tuple * STRING_HEADROOM)));
+            return ENVELOPE_TOKENS + per_tuple * num_tuples;
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<size_t> OutputTokenBudget::Resolve(const ModelDetails& model_details, const int num_output_tuples,
+                                                 const OutputType output_type,
+                                                 const std::optional<double> string_tokens_per_tuple,
+                                                 const std::initializer_list<const char*> explicit_limit_keys) {
+    if (!model_details.output_token_budget) {
+        return std::nullopt;
+    }
+    for (const auto* key: explicit_limit_keys) {
+        if (model_details.model_parameters.contains(key)) {
+            return std::nullopt;
+        }
+    }
+    return Compute(output_type, num_output_tuples, string_tokens_per_tuple);
+}
+
+void OutputTokenBudget::Mark(nlohmann::json& payload, const std::string& pointer, const nlohmann::json& unbudgeted) {
+    payload[PAYLOAD_KEY] = {{"pointer", pointer}, {"unbudgeted", unbudgeted}};
+}
+
+bool OutputTokenBudget::IsBudgeted(const nlohmann::json& payload) {
+    return payload.is_object() && payload.contains(PAYLOAD_KEY);
+}
+
+nlohmann::json OutputTokenBudget::Unmarked(nlohmann::json payload) {
+    if (IsBudgeted(payload)) {
+        payload.erase(PAYLOAD_KEY);
+    }
+    return payload;
+}
+
+nlohmann::json OutputTokenBudget::Lifted(const nlohmann::json& payload) {
+    if (!IsBudgeted(payload)) {
+        return payload;
+    }
+    const auto& mark = payload[PAYLOAD_KEY];
+    const nlohmann::json::json_pointer pointer(mark["pointer"].get<std::string>());
+    auto lifted = Unmarked(payload);
+    if (!mark["unbudgeted"].is_null()) {
+        lifted[pointer] = mark["unbudgeted"];
+    } else if (lifted.contains(pointer)) {
+        lifted[pointer.parent_pointer()].erase(pointer.back());
+    }
+    return lifted;
+}
+
+std::string OutputTokenBudget::Key(const ModelDetails& model_details, const std::string& user_prompt) {
+    return model_details.provider_name + '\x1f' + model_details.model + '\x1f' + ResultCache::Hash(user_prompt);
+}
+
+std::optional<double> OutputTokenBudget::LearnedTokensPerTuple(const ModelDetails& model_details,
+                                                               const std::string& user_prompt) {
+    const auto key = Key(model_details, user_prompt);
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = tokens_per_tuple_.find(key);
+    if (it == tokens_per_tuple_.end()) {
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+void OutputTokenBudget::Observe(const ModelDetails& model_details, const std::string& user_prompt,
+                                const nlohmann::json& responses) {
+    size_t total_tokens = 0;
+    size_t observed = 0;
+    for (const auto& response: responses) {
+        if (response.is_null()) {
+            continue;
+        }
+        total_tokens += TokenCounter::Estimate(response.is_string() ? response.get<std::string>() : response.dump());
+        observed++;
+    }
+    if (observed == 0) {
+        return;
+    }
+
+    const auto batch_average = static_cast<double>(total_tokens) / static_cast<double>(observed);
+    const auto key = Key(model_details, user_prompt);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const auto it = tokens_per_tuple_.find(key); it != tokens_per_tuple_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        auto& average = it->second->second;
+        average = (1.0 - LEARNING_RATE) * average + LEARNING_RATE * batch_average;
+        return;
+    }
+    lru_.emplace_front(key, batch_average);
+    tokens_per_tuple_[key] = lru_.begin();
+    if (lru_.size() > MAX_STATES) {
+        tokens_per_tuple_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+size_t OutputTokenBudget::Size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tokens_per_tuple_.size();
+}
+
+void OutputTokenBudget::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tokens_per_tuple_.clear();
+    lru_.clear();
+}
+
+}// namespace flock
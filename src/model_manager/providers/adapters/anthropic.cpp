@@ -1,5 +1,7 @@
 #include "flock/model_manager/providers/adapters/anthropic.hpp"
+#include "flock/model_manager/output_token_budget.hpp"
 #include "flock/model_manager/providers/handlers/url_handler.hpp"
+#include <algorithm>
 #include <fmt/format.h>
 
 namespace flock {
@@ -45,8 +47,8 @@ void AnthropicProvider::AddCompletionRequest(const std::string& prompt, const in
 
                     std::string base64_data;
                     if (URLHandler::IsUrl(image_str) || !is_base64(image_str)) {
-                        auto base64_result = URLHandler::ResolveFileToBase64(image_str);
-                        base64_data = base64_result.base64_content;
+                        // Read and converted to base64 when the request is sent
+                        base64_data = URLHandler::DeferBase64(image_str);
                     } else {
                         base64_data = image_str;
                     }
@@ -65,17 +67,23 @@ void AnthropicProvider::AddCompletionRequest(const std::string& prompt, const in
         request_payload.update(model_details_.model_parameters);
     }
 
-    // Anthropic API requires max_tokens; use fallback when not specified
+    // Anthropic API requires max_tokens; use the output budget or a fallback when not specified
     if (!request_payload.contains("max_tokens")) {
-        request_payload["max_tokens"] = 4096;
+        constexpr size_t default_max_tokens = 4096;
+        const auto budget = OutputTokenBudget::Resolve(model_details_, num_output_tuples, output_type,
+                                                       string_tokens_per_tuple_hint_, {"max_tokens"});
+        request_payload["max_tokens"] = budget.value_or(default_max_tokens);
+        if (budget.has_value()) {
+            OutputTokenBudget::Mark(request_payload, "/max_tokens", std::max(default_max_tokens, *budget * 2));
+        }
     }
 
     // Build the schema for structured output
     nlohmann::json item_schema;
-    if (model_details_.model_parameters.contains("output_format")) {
+    if (UsesUserOutputFormat("output_format")) {
         item_schema = model_details_.model_parameters["output_format"]["schema"];
     } else {
-        item_schema = {{"type", GetOutputTypeString(output_type)}};
+        item_schema = GetItemSchema(output_type);
     }
 
     if (SupportsOutputFormat(model_details_.model)) {
@@ -1,5 +1,6 @@
 #include "flock/model_manager/providers/adapters/azure.hpp"
 #include "flock/model_manager/model.hpp"
+#include "flock/model_manager/output_token_budget.hpp"
 #include "flock/model_manager/providers/handlers/url_handler.hpp"
 
 namespace flock {
@@ -50,9 +51,8 @@ void AzureProvider::AddCompletionRequest(const std::string& prompt, const int nu
                     // URL - send directly to API
                     image_url = image_str;
                 } else {
-                    // File path - read and convert to base64
-                    auto base64_result = URLHandler::ResolveFileToBase64(image_str);
-                    image_url = duckdb_fmt::format("data:{};base64,{}", mime_type, base64_result.base64_content);
+                    // File path - read and converted to base64 when the request is sent
+                    image_url = duckdb_fmt::format("data:{};base64,{}", mime_type, URLHandler::DeferBase64(image_str));
                 }
 
                 message_content.push_back(
@@ -71,7 +71,16 @@ void AzureProvider::AddCompletionRequest(const std::string& prompt, const int nu
         request_payload.update(model_details_.model_parameters);
     }
 
-    if (model_details_.model_parameters.contains("response_format")) {
+    // Azure deployments on older API versions only understand max_tokens.
+    if (const auto budget = OutputTokenBudget::Resolve(model_details_, num_output_tuples, output_type,
+                                                        string_tokens_per_tuple_hint_,
+                                                        {"max_tokens", "max_completion_tokens"})) {
+        request_payload["max_tokens"] = *budget;
+        OutputTokenBudget::Mark(request_payload, "/max_tokens");
+    }
+
+    const auto num_response_items = GetResponseItemCount(output_type, num_output_tuples);
+    if (UsesUserOutputFormat("response_format")) {
         auto schema = model_details_.model_parameters["response_format"]["json_schema"]["schema"];
         auto strict = model_details_.model_parameters["response_format"]["strict"];
         request_payload["response_format"] = {
@@ -79,14 +88,14 @@ void AzureProvider::AddCompletionRequest(const std::string& prompt, const int nu
                 {"json_schema",
                  {{"name", "flock_response"},
                   {"strict", strict},
-                  {"schema", {{"type", "object"}, {"properties", {{"items", {{"type", "array"}, {"minItems", num_output_tuples}, {"maxItems", num_output_tuples}, {"items", schema}}}}}, {"required", {"items"}}, {"additionalProperties", false}}}}}};
+                  {"schema", {{"type", "object"}, {"properties", {{"items", {{"type", "array"}, {"minItems", num_response_items}, {"maxItems", num_response_items}, {"items", schema}}}}}, {"required", {"items"}}, {"additionalProperties", false}}}}}};
     } else {
         request_payload["response_format"] = {
                 {"type", "json_schema"},
                 {"json_schema",
                  {{"name", "flock_response"},
                   {"strict", false},
-                  {"schema", {{"type", "object"}, {"properties", {{"items", {{"type", "array"}, {"minItems", num_output_tuples}, {"maxItems", num_output_tuples}, {"items", {{"type", GetOutputTypeString(output_type)}}}}}}}}}}}};
+                  {"schema", {{"type", "object"}, {"properties", {{"items", {{"type", "array"}, {"minItems", num_response_items}, {"maxItems", num_response_items}, {"items", GetItemSchema(output_type)}}}}}}}}}};
         ;
     }
 
@@ -108,13 +117,10 @@ void AzureProvider::AddTranscriptionRequest(const nlohmann::json& audio_files) {
     for (const auto& audio_file: audio_files) {
         auto audio_file_str = audio_file.get<std::string>();
 
-        // Handle file download and validation
-        auto file_result = URLHandler::ResolveFilePath(audio_file_str);
-
+        // The file is downloaded and validated when the request is sent, like deferred images.
         nlohmann::json transcription_request = {
-                {"file_path", file_result.file_path},
-                {"model", model_details_.model},
-                {"is_temp_file", file_result.is_temp_file}};
+                {"file_path", audio_file_str},
+                {"model", model_details_.model}};
         model_handler_->AddRequest(transcription_request, IModelProviderHandler::RequestType::Transcription);
     }
 }
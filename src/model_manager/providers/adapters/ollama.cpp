@@ -1,4 +1,5 @@
 #include "flock/model_manager/providers/adapters/ollama.hpp"
+#include "flock/model_manager/output_token_budget.hpp"
 #include "flock/model_manager/providers/handlers/url_handler.hpp"
 #include "flock/model_manager/providers/provider.hpp"
 
@@ -26,9 +27,8 @@ void OllamaProvider::AddCompletionRequest(const std::string& prompt, const int n
                         image_str = image.dump();
                     }
 
-                    // Handle file path or URL - resolve and convert to base64
-                    auto base64_result = URLHandler::ResolveFileToBase64(image_str);
-                    images.push_back(base64_result.base64_content);
+                    // Handle file path or URL - resolved and converted to base64 when the request is sent
+                    images.push_back(URLHandler::DeferBase64(image_str));
                 }
             }
         }
@@ -45,16 +45,27 @@ void OllamaProvider::AddCompletionRequest(const std::string& prompt, const int n
         request_payload.update(model_details_.model_parameters);
     }
 
-    if (model_details_.model_parameters.contains("format")) {
+    const auto has_num_predict = request_payload.contains("options") && request_payload["options"].is_object() &&
+                                 request_payload["options"].contains("num_predict");
+    if (!has_num_predict) {
+        if (const auto budget = OutputTokenBudget::Resolve(model_details_, num_output_tuples, output_type,
+                                                            string_tokens_per_tuple_hint_, {})) {
+            request_payload["options"]["num_predict"] = *budget;
+            OutputTokenBudget::Mark(request_payload, "/options/num_predict");
+        }
+    }
+
+    const auto num_response_items = GetResponseItemCount(output_type, num_output_tuples);
+    if (UsesUserOutputFormat("format")) {
         auto schema = model_details_.model_parameters["format"];
         request_payload["format"] = {
                 {"type", "object"},
-                {"properties", {{"items", {{"type", "array"}, {"minItems", num_output_tuples}, {"maxItems", num_output_tuples}, {"items", schema}}}}},
+                {"properties", {{"items", {{"type", "array"}, {"minItems", num_response_items}, {"maxItems", num_response_items}, {"items", schema}}}}},
                 {"required", {"items"}}};
     } else {
         request_payload["format"] = {
                 {"type", "object"},
-                {"properties", {{"items", {{"type", "array"}, {"minItems", num_output_tuples}, {"maxItems", num_output_tuples}, {"items", {{"type", GetOutputTypeString(output_type)}}}}}}},
+                {"properties", {{"items", {{"type", "array"}, {"minItems", num_response_items}, {"maxItems", num_response_items}, {"items", GetItemSchema(output_type)}}}}},
                 {"required", {"items"}}};
     }
 
@@ -62,14 +73,13 @@ void OllamaProvider::AddCompletionRequest(const std::string& prompt, const int n
 }
 
 void OllamaProvider::AddEmbeddingRequest(const std::vector<std::string>& inputs) {
-    for (const auto& input: inputs) {
-        nlohmann::json request_payload = {
-                {"model", model_details_.model},
-                {"input", input},
-        };
+    // /api/embed takes the whole batch and answers with one embedding per input, in order.
+    nlohmann::json request_payload = {
+            {"model", model_details_.model},
+            {"input", inputs},
+    };
 
-        model_handler_->AddRequest(request_payload, IModelProviderHandler::RequestType::Embedding);
-    }
+    model_handler_->AddRequest(request_payload, IModelProviderHandler::RequestType::Embedding);
 }
 
 void OllamaProvider::AddTranscriptionRequest(const nlohmann::json& audio_files) {
@@ -0,0 +1,107 @@
+#include "flock/model_manager/request_executor.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace flock {
+
+namespace {
+
+thread_local bool on_worker_thread = false;
+
+}// namespace
+
+void RequestExecutor::Register(duckdb::DBConfig& config) {
+    config.AddExtensionOption(SETTING_NAME, "Maximum number of LLM provider requests waited on in the background",
+                              duckdb::LogicalType::UBIGINT,
+                              duckdb::Value::UBIGINT(DEFAULT_MAX_CONCURRENCY), OnSettingChanged);
+}
+
+void RequestExecutor::OnSettingChanged(duckdb::ClientContext& context, duckdb::SetScope scope,
+                                       duckdb::Value& parameter) {
+    const auto max_concurrency = parameter.GetValue<uint64_t>();
+    if (max_concurrency == 0) {
+        throw duckdb::InvalidInputException("'%s' must be larger than 0", SETTING_NAME);
+    }
+    SetMaxConcurrency(max_concurrency);
+}
+
+RequestExecutor::State& RequestExecutor::GetState() {
+    static auto* state = new State();
+    return *state;
+}
+
+std::future<nlohmann::json> RequestExecutor::Submit(std::function<nlohmann::json()> job) {
+    std::packaged_task<nlohmann::json()> task(std::move(job));
+    auto result = task.get_future();
+
+    auto& state = GetState();
+    bool start_worker = false;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.jobs.push_back(std::move(task));
+        if (state.idle_workers == 0 && state.workers < state.max_concurrency) {
+            state.workers++;
+            start_worker = true;
+        }
+    }
+
+    if (start_worker) {
+        std::thread(WorkerLoop).detach();
+    } else {
+        state.job_available.notify_one();
+    }
+    return result;
+}
+
+void RequestExecutor::SetMaxConcurrency(const size_t max_concurrency) {
+    auto& state = GetState();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.max_concurrency = std::max<size_t>(max_concurrency, 1);
+    }
+    // Surplus idle workers wake up and exit.
+    state.job_available.notify_all();
+}
+
+size_t RequestExecutor::GetMaxConcurrency() {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.max_concurrency;
+}
+
+bool RequestExecutor::OnWorkerThread() {
+    return on_worker_thread;
+}
+
+void RequestExecutor::WorkerLoop() {
+    on_worker_thread = true;
+    auto& state = GetState();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (true) {
+        if (state.workers > state.max_concurrency) {
+            break;
+        }
+        if (state.jobs.empty()) {
+            state.idle_workers++;
+            state.job_available.wait(lock, [&state]() {
+                return !state.jobs.empty() || state.workers > state.max_concurrency;
+            });
+            state.idle_workers--;
+            continue;
+        }
+
+        auto task = std::move(state.jobs.front());
+        state.jobs.pop_front();
+        lock.unlock();
+        // Exceptions are stored in the task's future.
+        task();
+        lock.lock();
+    }
+    state.workers--;
+    lock.unlock();
+    // This worker may have taken a wake-up meant for a queued job.
+    state.job_available.notify_one();
+}
+
+}// namespace flock
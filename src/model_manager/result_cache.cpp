@@ -0,0 +1,265 @@
+#include "flock/model_manager/result_cache.hpp"
+#include "flock/core/config.hpp"
+#include "flock/model_manager/cache_storage.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace flock {
+
+namespace {
+
+uint64_t MixHash(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+}// namespace
+
+std::string ResultCache::Hash(const std::string& content) {
+    return Hash(content.data(), content.size());
+}
+
+std::string ResultCache::Hash(const char* data, const size_t size) {
+    // Two FNV-1a lanes with different offset bases, each finalized with a 64-bit mixer.
+    uint64_t low = 0xcbf29ce484222325ULL;
+    uint64_t high = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < size; i++) {
+        const auto byte = static_cast<uint8_t>(data[i]);
+        low = (low ^ byte) * 0x100000001b3ULL;
+        high = (high ^ byte) * 0x100000001b3ULL + 0x2545f4914f6cdd1dULL;
+    }
+    low = MixHash(low ^ size);
+    high = MixHash(high + size);
+
+    char buffer[33];
+    std::snprintf(buffer, sizeof(buffer), "%016" PRIx64 "%016" PRIx64, high, low);
+    return buffer;
+}
+
+std::string ResultCache::ModelFingerprint(const ModelDetails& model_details) {
+    nlohmann::json fingerprint = {{"model", model_details.model},
+                                  {"provider", model_details.provider_name},
+                                  {"model_parameters", model_details.model_parameters}};
+    if (model_details.item_schema.has_value()) {
+        fingerprint["item_schema"] = *model_details.item_schema;
+    }
+    return fingerprint.dump();
+}
+
+std::vector<std::string> ResultCache::CompletionKeys(const ModelDetails& model_details, const std::string& user_prompt,
+                                                     const ScalarFunctionType function_type,
+                                                     const ContextColumnBatch& batch) {
+    std::string prefix = ModelFingerprint(model_details);
+    prefix += '\x1f';
+    prefix += std::to_string(static_cast<int>(function_type));
+    prefix += '\x1f';
+    prefix += user_prompt;
+
+    std::vector<std::string> headers;
+    headers.reserve(batch.columns.size());
+    for (const auto& column: batch.columns) {
+        headers.push_back(column.metadata.dump());
+    }
+
+    // Cells are length-prefixed, so the key does not depend on escaping their text.
+    const auto num_rows = batch.empty() ? 0 : batch.row_count;
+    std::vector<std::string> keys;
+    keys.reserve(num_rows);
+    for (size_t row = 0; row < num_rows; row++) {
+        auto content = prefix;
+        for (size_t column = 0; column < batch.columns.size(); column++) {
+            const auto cell = batch.GetCell(column, row);
+            content += '\x1e';
+            content += headers[column];
+            content += '\x1d';
+            content += std::to_string(cell.size());
+            content += ':';
+            content += cell;
+        }
+        keys.push_back(Hash(content));
+    }
+    return keys;
+}
+
+std::vector<std::string> ResultCache::EmbeddingKeys(const ModelDetails& model_details,
+                                                    const std::vector<std::string>& inputs) {
+    const auto prefix = ModelFingerprint(model_details) + "\x1f" "embedding" "\x1f";
+    std::vector<std::string> keys;
+    keys.reserve(inputs.size());
+    for (const auto& input: inputs) {
+        keys.push_back(Hash(prefix + input));
+    }
+    return keys;
+}
+
+std::vector<std::optional<nlohmann::json>> ResultCache::Lookup(const std::vector<std::string>& keys) {
+    std::vector<std::optional<nlohmann::json>> results(keys.size());
+    std::vector<std::string> storage_keys;
+    for (size_t i = 0; i < keys.size(); i++) {
+        results[i] = LookupMemory(keys[i]);
+        if (!results[i].has_value()) {
+            storage_keys.push_back(keys[i]);
+        }
+    }
+    if (storage_keys.empty()) {
+        return results;
+    }
+
+    const auto stored = LookupStorage(storage_keys);
+    for (size_t i = 0; i < keys.size() && !stored.empty(); i++) {
+        if (results[i].has_value()) {
+            continue;
+        }
+        if (const auto it = stored.find(keys[i]); it != stored.end()) {
+            results[i] = it->second;
+            StoreMemory(keys[i], it->second);
+        }
+    }
+    return results;
+}
+
+void ResultCache::Store(const std::vector<std::pair<std::string, nlohmann::json>>& entries) {
+    if (entries.empty()) {
+        return;
+    }
+    for (const auto& [key, value]: entries) {
+        StoreMemory(key, value);
+    }
+    StoreStorage(entries);
+}
+
+void ResultCache::Clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        stores_since_eviction_ = 0;
+    }
+    try {
+        CacheStorage::Run([](duckdb::Connection& con) {
+            con.Query(duckdb_fmt::format("DELETE FROM {};", GetStorageTable()));
+        });
+    } catch (...) {
+    }
+}
+
+std::optional<nlohmann::json> ResultCache::LookupMemory(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+void ResultCache::StoreMemory(const std::string& key, const nlohmann::json& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const auto it = index_.find(key); it != index_.end()) {
+        it->second->second = value;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(key, value);
+    index_[key] = lru_.begin();
+    if (lru_.size() > MEMORY_CAPACITY) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+std::unordered_map<std::string, nlohmann::json> ResultCache::LookupStorage(const std::vector<std::string>& keys) {
+    std::unordered_map<std::string, nlohmann::json> stored;
+    try {
+        // Keys are hex digests, so they can be inlined without escaping.
+        std::string key_list;
+        for (const auto& key: keys) {
+            key_list += key_list.empty() ? "'" : ", '";
+            key_list += key + "'";
+        }
+
+        CacheStorage::Run([&](duckdb::Connection& con) {
+            const auto result = con.Query(duckdb_fmt::format(
+                    " SELECT cache_key, value FROM {} "
+                    "  WHERE cache_key IN ({}) "
+                    "    AND created_at >= CAST(now() AS TIMESTAMP) - to_seconds({});",
+                    GetStorageTable(), key_list, TTL_SECONDS));
+            if (result->HasError()) {
+                return;
+            }
+            for (idx_t row = 0; row < result->RowCount(); row++) {
+                stored.emplace(result->GetValue(0, row).ToString(),
+                               nlohmann::json::parse(result->GetValue(1, row).ToString()));
+            }
+        });
+    } catch (...) {
+        stored.clear();
+    }
+    return stored;
+}
+
+void ResultCache::StoreStorage(const std::vector<std::pair<std::string, nlohmann::json>>& entries) {
+    // One statement per call; a key may appear only once in it, so the last answer wins.
+    std::unordered_map<std::string, size_t> last_entry;
+    for (size_t i = 0; i < entries.size(); i++) {
+        last_entry[entries[i].first] = i;
+    }
+    std::string values;
+    for (size_t i = 0; i < entries.size(); i++) {
+        const auto& [key, value] = entries[i];
+        if (last_entry[key] != i) {
+            continue;
+        }
+        const auto serialized = value.dump();
+        values += values.empty() ? "" : ", ";
+        values += duckdb_fmt::format("('{}', {}, {}, CAST(now() AS TIMESTAMP))", key,
+                                     duckdb::Value(serialized).ToSQLString(), key.size() + serialized.size());
+    }
+
+    bool evict = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stores_since_eviction_ += last_entry.size();
+        if (stores_since_eviction_ >= EVICTION_INTERVAL) {
+            stores_since_eviction_ = 0;
+            evict = true;
+        }
+    }
+
+    try {
+        CacheStorage::Run([&](duckdb::Connection& con) {
+            const auto table = GetStorageTable();
+            con.Query(duckdb_fmt::format(
+                    " INSERT OR REPLACE INTO {} (cache_key, value, size_bytes, created_at) VALUES {};", table,
+                    values));
+            if (!evict) {
+                return;
+            }
+
+            con.Query(duckdb_fmt::format(
+                    " DELETE FROM {} WHERE created_at < CAST(now() AS TIMESTAMP) - to_seconds({});", table,
+                    TTL_SECONDS));
+            // Keep the most recent entries that fit in the size budget.
+            con.Query(duckdb_fmt::format(
+                    " DELETE FROM {0} WHERE cache_key IN ( "
+                    "   SELECT cache_key FROM ( "
+                    "     SELECT cache_key, SUM(size_bytes) OVER (ORDER BY created_at DESC, cache_key) AS retained_bytes "
+                    "       FROM {0} "
+                    "   ) WHERE retained_bytes > {1} "
+                    " );",
+                    table, MAX_STORAGE_BYTES));
+        });
+    } catch (...) {
+    }
+}
+
+std::string ResultCache::GetStorageTable() {
+    return "flock_storage." + Config::get_schema_name() + "." + Config::get_result_cache_table_name();
+}
+
+}// namespace flock
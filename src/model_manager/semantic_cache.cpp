@@ -0,0 +1,307 @@
+#include "flock/model_manager/semantic_cache.hpp"
+#include "flock/core/config.hpp"
+#include "flock/core/vector_math.hpp"
+#include "flock/model_manager/cache_storage.hpp"
+#include "flock/model_manager/model.hpp"
+#include "flock/model_manager/result_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace flock {
+
+std::string SemanticCache::Namespace(const ModelDetails& model_details, const std::string& user_prompt,
+                                     const ScalarFunctionType function_type) {
+    const auto embedding_model = model_details.semantic_cache.has_value()
+                                         ? model_details.semantic_cache->embedding_model
+                                         : std::string();
+    return ResultCache::Hash(ResultCache::ModelFingerprint(model_details) + '\x1f' +
+                             std::to_string(static_cast<int>(function_type)) + '\x1f' + user_prompt + '\x1f' +
+                             embedding_model);
+}
+
+std::vector<std::string> SemanticCache::RowTexts(const ContextColumnBatch& batch, const std::vector<size_t>& rows) {
+    std::vector<std::string> texts;
+    texts.reserve(rows.size());
+    for (const auto row: rows) {
+        std::string text;
+        for (size_t column = 0; column < batch.columns.size(); column++) {
+            if (!text.empty()) {
+                text += '\n';
+            }
+            const auto& metadata = batch.columns[column].metadata;
+            if (metadata.contains("name") && metadata["name"].is_string()) {
+                text += metadata["name"].get<std::string>() + ": ";
+            }
+            text += batch.GetCell(column, row);
+        }
+        texts.push_back(std::move(text));
+    }
+    return texts;
+}
+
+std::vector<std::vector<float>> SemanticCache::Embed(const std::string& embedding_model,
+                                                     const std::vector<std::string>& texts) {
+    std::vector<std::vector<float>> embeddings;
+    if (texts.empty()) {
+        return embeddings;
+    }
+
+    Model model(nlohmann::json{{"model_name", embedding_model}});
+    const auto batch_size = std::max<size_t>(model.GetModelDetails().max_batch_size, 1);
+    for (size_t i = 0; i < texts.size(); i += batch_size) {
+        const auto end = std::min(i + batch_size, texts.size());
+        model.AddEmbeddingRequest(std::vector<std::string>(texts.begin() + i, texts.begin() + end));
+    }
+
+    embeddings.reserve(texts.size());
+    for (const auto& batch: model.CollectEmbeddings()) {
+        for (const auto& embedding: batch) {
+            std::vector<float> values;
+            values.reserve(embedding.size());
+            for (const auto& value: embedding) {
+                values.push_back(value.get<float>());
+            }
+            VectorMath::Normalize(values);
+            embeddings.push_back(std::move(values));
+        }
+    }
+    if (embeddings.size() != texts.size()) {
+        throw std::runtime_error(duckdb_fmt::format("Semantic cache expected {} embeddings from '{}', got {}",
+                                                    texts.size(), embedding_model, embeddings.size()));
+    }
+    return embeddings;
+}
+
+std::vector<SemanticCache::Match> SemanticCache::Lookup(const std::string& cache_namespace,
+                                                        const std::vector<std::vector<float>>& embeddings,
+                                                        const double threshold) {
+    std::vector<Match> matches(embeddings.size());
+
+    const auto state = GetNamespace(cache_namespace);
+    std::shared_lock<std::shared_mutex> lock(state->mutex);
+    const auto& index = state->index;
+    const auto num_entries = index.answers.size();
+    for (size_t i = 0; i < embeddings.size(); i++) {
+        const auto& query = embeddings[i];
+        if (num_entries == 0 || query.size() != index.dims) {
+            continue;
+        }
+
+        std::optional<size_t> best_entry;
+        float best_similarity = -1.0f;
+        for (size_t entry = 0; entry < num_entries; entry++) {
+            const auto similarity = VectorMath::Dot(query.data(), index.vectors.data() + entry * index.dims, index.dims);
+            if (!best_entry.has_value() || similarity > best_similarity) {
+                best_similarity = similarity;
+                best_entry = entry;
+            }
+        }
+        // A NaN similarity (an empty or broken embedding) is not a candidate.
+        if (std::isnan(best_similarity)) {
+            continue;
+        }
+
+        matches[i].best_similarity = best_similarity;
+        if (best_similarity >= static_cast<float>(threshold)) {
+            matches[i].answer = index.answers[*best_entry];
+        }
+    }
+    return matches;
+}
+
+void SemanticCache::Insert(const std::string& cache_namespace, const std::vector<std::vector<float>>& embeddings,
+                           const std::vector<nlohmann::json>& answers) {
+    if (embeddings.empty()) {
+        return;
+    }
+    {
+        const auto state = GetNamespace(cache_namespace);
+        size_t added = 0;
+        {
+            std::unique_lock<std::shared_mutex> lock(state->mutex);
+            const auto before = state->index.answers.size();
+            for (size_t i = 0; i < embeddings.size() && i < answers.size(); i++) {
+                AddUnlocked(state->index, embeddings[i], answers[i]);
+            }
+            added = state->index.answers.size() - before;
+        }
+        Account(cache_namespace, state, added);
+    }
+    StoreToStorage(cache_namespace, embeddings, answers);
+}
+
+void SemanticCache::Clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        namespaces_.clear();
+        lru_.clear();
+        cached_vectors_ = 0;
+        stores_since_eviction_ = 0;
+    }
+    try {
+        CacheStorage::Run([](duckdb::Connection& con) {
+            con.Query(duckdb_fmt::format("DELETE FROM {};", GetStorageTable()));
+        });
+    } catch (...) {
+    }
+}
+
+size_t SemanticCache::CachedVectors() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cached_vectors_;
+}
+
+std::shared_ptr<SemanticCache::NamespaceState> SemanticCache::GetNamespace(const std::string& cache_namespace) {
+    std::shared_ptr<NamespaceState> state;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = namespaces_.find(cache_namespace);
+        if (it == namespaces_.end()) {
+            lru_.push_front(cache_namespace);
+            it = namespaces_.emplace(cache_namespace, NamespaceEntry{std::make_shared<NamespaceState>(), 0, lru_.begin()})
+                         .first;
+        } else {
+            lru_.splice(lru_.begin(), lru_, it->second.position);
+        }
+        state = it->second.state;
+    }
+    // Other users of the same namespace wait here for the load; other namespaces do not.
+    std::call_once(state->loaded, [&]() {
+        size_t loaded = 0;
+        {
+            std::unique_lock<std::shared_mutex> lock(state->mutex);
+            LoadFromStorage(cache_namespace, state->index);
+            loaded = state->index.answers.size();
+        }
+        Account(cache_namespace, state, loaded);
+    });
+    return state;
+}
+
+void SemanticCache::Account(const std::string& cache_namespace, const std::shared_ptr<NamespaceState>& state,
+                            const size_t added) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = namespaces_.find(cache_namespace);
+    // The namespace was dropped (or dropped and recreated) since `state` was handed out.
+    if (it == namespaces_.end() || it->second.state != state) {
+        return;
+    }
+    it->second.entries += added;
+    cached_vectors_ += added;
+    lru_.splice(lru_.begin(), lru_, it->second.position);
+
+    // The namespace just used sits at the front and is never dropped for its own entries.
+    while (cached_vectors_ > MAX_CACHED_VECTORS && lru_.size() > 1) {
+        const auto victim = namespaces_.find(lru_.back());
+        cached_vectors_ -= victim->second.entries;
+        namespaces_.erase(victim);
+        lru_.pop_back();
+    }
+}
+
+void SemanticCache::AddUnlocked(Index& index, const std::vector<float>& embedding, const nlohmann::json& answer) {
+    if (index.answers.empty()) {
+        index.dims = embedding.size();
+    }
+    if (embedding.size() != index.dims || index.dims == 0) {
+        return;
+    }
+
+    if (index.answers.size() < MAX_ENTRIES_PER_NAMESPACE) {
+        index.vectors.insert(index.vectors.end(), embedding.begin(), embedding.end());
+        index.answers.push_back(answer);
+        return;
+    }
+
+    std::copy(embedding.begin(), embedding.end(), index.vectors.begin() + index.next_slot * index.dims);
+    index.answers[index.next_slot] = answer;
+    index.next_slot = (index.next_slot + 1) % MAX_ENTRIES_PER_NAMESPACE;
+}
+
+void SemanticCache::LoadFromStorage(const std::string& cache_namespace, Index& index) {
+    try {
+        CacheStorage::Run([&](duckdb::Connection& con) {
+            const auto result = con.Query(duckdb_fmt::format(
+                    " SELECT embedding, value FROM {} "
+                    "  WHERE cache_namespace = '{}' "
+                    "    AND created_at >= CAST(now() AS TIMESTAMP) - to_seconds({}) "
+                    "  ORDER BY created_at DESC LIMIT {};",
+                    GetStorageTable(), cache_namespace, ResultCache::TTL_SECONDS, MAX_ENTRIES_PER_NAMESPACE));
+            if (result->HasError()) {
+                return;
+            }
+            for (idx_t row = 0; row < result->RowCount(); row++) {
+                std::vector<float> embedding;
+                for (const auto& value: duckdb::ListValue::GetChildren(result->GetValue(0, row))) {
+                    embedding.push_back(value.GetValue<float>());
+                }
+                AddUnlocked(index, embedding, nlohmann::json::parse(result->GetValue(1, row).ToString()));
+            }
+        });
+    } catch (...) {
+        index = Index{};
+    }
+}
+
+void SemanticCache::StoreToStorage(const std::string& cache_namespace, const std::vector<std::vector<float>>& embeddings,
+                                   const std::vector<nlohmann::json>& answers) {
+    // One statement per call. Namespaces are hex digests, so they can be inlined without escaping.
+    std::string values;
+    size_t num_rows = 0;
+    for (; num_rows < embeddings.size() && num_rows < answers.size(); num_rows++) {
+        duckdb::vector<duckdb::Value> embedding;
+        embedding.reserve(embeddings[num_rows].size());
+        for (const auto value: embeddings[num_rows]) {
+            embedding.push_back(duckdb::Value::FLOAT(value));
+        }
+        values += values.empty() ? "" : ", ";
+        values += duckdb_fmt::format("('{}', {}, {}, CAST(now() AS TIMESTAMP))", cache_namespace,
+                                     duckdb::Value::LIST(duckdb::LogicalType::FLOAT, std::move(embedding)).ToSQLString(),
+                                     duckdb::Value(answers[num_rows].dump()).ToSQLString());
+    }
+    if (num_rows == 0) {
+        return;
+    }
+
+    bool evict = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stores_since_eviction_ += num_rows;
+        if (stores_since_eviction_ >= EVICTION_INTERVAL) {
+            stores_since_eviction_ = 0;
+            evict = true;
+        }
+    }
+
+    try {
+        CacheStorage::Run([&](duckdb::Connection& con) {
+            const auto table = GetStorageTable();
+            con.Query(duckdb_fmt::format(" INSERT INTO {} (cache_namespace, embedding, value, created_at) VALUES {};",
+                                         table, values));
+            if (!evict) {
+                return;
+            }
+
+            con.Query(duckdb_fmt::format(
+                    " DELETE FROM {} WHERE created_at < CAST(now() AS TIMESTAMP) - to_seconds({});", table,
+                    ResultCache::TTL_SECONDS));
+            // Rows beyond what a namespace can load are never read again.
+            con.Query(duckdb_fmt::format(
+                    " DELETE FROM {0} WHERE rowid IN ( "
+                    "   SELECT rowid FROM ( "
+                    "     SELECT rowid, ROW_NUMBER() OVER (PARTITION BY cache_namespace ORDER BY created_at DESC) AS recency "
+                    "       FROM {0} "
+                    "   ) WHERE recency > {1} "
+                    " );",
+                    table, MAX_ENTRIES_PER_NAMESPACE));
+        });
+    } catch (...) {
+    }
+}
+
+std::string SemanticCache::GetStorageTable() {
+    return "flock_storage." + Config::get_schema_name() + "." + Config::get_semantic_cache_table_name();
+}
+
+}// namespace flock
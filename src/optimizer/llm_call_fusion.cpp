@@ -0,0 +1,141 @@
+#include "flock/optimizer/llm_call_fusion.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/planner/logical_operator.hpp"
+#include "flock/functions/scalar/llm_fused.hpp"
+
+#include <algorithm>
+
+namespace flock {
+
+namespace {
+
+struct FusionCandidate {
+    duckdb::BoundFunctionExpression* call;
+    const duckdb::Expression* context_columns;
+    ScalarFunctionType function_type;
+};
+
+// A user output format shapes each answer, which the fused per-task schema would replace.
+bool HasUserOutputFormat(const nlohmann::json& model_json) {
+    if (!model_json.contains("model_parameters") || !model_json["model_parameters"].is_object()) {
+        return false;
+    }
+    const auto& model_parameters = model_json["model_parameters"];
+    return model_parameters.contains("response_format") || model_parameters.contains("format") ||
+           model_parameters.contains("output_format");
+}
+
+}// namespace
+
+void LlmCallFusion::Register(duckdb::DBConfig& config) {
+    config.AddExtensionOption(SETTING_NAME,
+                              "Fuse llm_complete/llm_filter calls that share a model and context columns into one request",
+                              duckdb::LogicalType::BOOLEAN, duckdb::Value::BOOLEAN(true));
+
+    duckdb::OptimizerExtension optimizer;
+    optimizer.optimize_function = LlmCallFusion::Optimize;
+    duckdb::OptimizerExtension::Register(config, optimizer);
+}
+
+void LlmCallFusion::Optimize(duckdb::OptimizerExtensionInput& input, duckdb::unique_ptr<duckdb::LogicalOperator>& plan) {
+    duckdb::Value enabled;
+    if (input.context.TryGetCurrentSetting(SETTING_NAME, enabled) && !enabled.IsNull() && !enabled.GetValue<bool>()) {
+        return;
+    }
+    FuseOperator(*plan);
+}
+
+void LlmCallFusion::FuseOperator(duckdb::LogicalOperator& op) {
+    for (auto& child: op.children) {
+        FuseOperator(*child);
+    }
+    // Only projections evaluate every expression over the full chunk; filters and CASE branches
+    // see row subsets, so their calls are left alone.
+    if (op.type == duckdb::LogicalOperatorType::LOGICAL_PROJECTION) {
+        FuseExpressions(op.expressions);
+    }
+}
+
+const duckdb::Expression* LlmCallFusion::GetContextColumns(const duckdb::BoundFunctionExpression& call) {
+    const auto& prompt_expr = call.children[1];
+    if (prompt_expr->expression_class != duckdb::ExpressionClass::BOUND_FUNCTION ||
+        prompt_expr->return_type.id() != duckdb::LogicalTypeId::STRUCT) {
+        return nullptr;
+    }
+
+    const auto& prompt_struct = prompt_expr->Cast<duckdb::BoundFunctionExpression>();
+    const auto& struct_type = prompt_expr->return_type;
+    for (idx_t i = 0; i < duckdb::StructType::GetChildCount(struct_type) && i < prompt_struct.children.size(); i++) {
+        if (duckdb::StructType::GetChildName(struct_type, i) == "context_columns") {
+            return prompt_struct.children[i].get();
+        }
+    }
+    return nullptr;
+}
+
+void LlmCallFusion::FuseExpressions(duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& expressions) {
+    std::vector<std::vector<FusionCandidate>> groups;
+
+    for (auto& expr: expressions) {
+        if (expr->expression_class != duckdb::ExpressionClass::BOUND_FUNCTION) {
+            continue;
+        }
+        auto& call = expr->Cast<duckdb::BoundFunctionExpression>();
+        const auto& name = call.function.name;
+        if ((name != "llm_complete" && name != "llm_filter") || call.children.size() != 2 || !call.bind_info) {
+            continue;
+        }
+        // Fused answers are written as text, so calls with a typed `returns` result stay unfused.
+        if (call.return_type.id() != duckdb::LogicalTypeId::VARCHAR) {
+            continue;
+        }
+        const auto& bind_data = call.bind_info->Cast<LlmFunctionBindData>();
+        if (!bind_data.model_json.is_object() || bind_data.model_json.empty() || bind_data.prompt.empty() ||
+            HasUserOutputFormat(bind_data.model_json)) {
+            continue;
+        }
+        // Cascades and distilled predicates or classifiers answer rows without the shared request.
+        if (!bind_data.cascade_model_json.is_null() || !bind_data.distill_json.is_null() ||
+            !bind_data.classifier_json.is_null()) {
+            continue;
+        }
+        const auto* context_columns = GetContextColumns(call);
+        if (context_columns == nullptr) {
+            continue;
+        }
+
+        FusionCandidate candidate{&call, context_columns,
+                                  name == "llm_filter" ? ScalarFunctionType::FILTER : ScalarFunctionType::COMPLETE};
+        auto group = std::find_if(groups.begin(), groups.end(), [&](const std::vector<FusionCandidate>& members) {
+            const auto& first = members.front();
+            return first.call->bind_info->Cast<LlmFunctionBindData>().model_json == bind_data.model_json &&
+                   first.context_columns->Equals(*context_columns);
+        });
+        if (group == groups.end()) {
+            groups.push_back({candidate});
+        } else {
+            group->push_back(candidate);
+        }
+    }
+
+    for (const auto& members: groups) {
+        if (members.size() < 2) {
+            continue;
+        }
+
+        std::vector<FusedTask> tasks;
+        tasks.reserve(members.size());
+        for (const auto& member: members) {
+            tasks.push_back({member.call->bind_info->Cast<LlmFunctionBindData>().prompt, member.function_type});
+        }
+
+        const auto fusion_group =
+                LlmFused::CreateGroup(members.front().call->bind_info->Cast<LlmFunctionBindData>().model_json,
+                                      std::move(tasks));
+        for (idx_t i = 0; i < members.size(); i++) {
+            LlmFused::Rewrite(*members[i].call, fusion_group, i);
+        }
+    }
+}
+
+}// namespace flock
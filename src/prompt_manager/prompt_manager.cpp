@@ -1,5 +1,8 @@
 #include "flock/prompt_manager/prompt_manager.hpp"
 
+#include <unordered_map>
+#include <vector>
+
 namespace flock {
 template<>
 std::string PromptManager::ToString<PromptSection>(const PromptSection section) {
@@ -157,19 +160,114 @@ std::string PromptManager::ConstructNumTuples(const int num_tuples) {
     return "- The Number of Tuples to Generate Responses for: " + std::to_string(num_tuples) + "\n\n";
 }
 
-std::string PromptManager::ConstructInputTuples(const nlohmann::json& columns, const TupleFormat tuple_format) {
+std::string PromptManager::DictionaryEncodeColumns(nlohmann::json& columns,
+                                                   const DictionaryEncoding& dictionary_encoding) {
+    const auto is_encodable_column = [](const nlohmann::json& column) {
+        // Row ids are echoed back by the model, so they must stay verbatim.
+        return column.contains("data") && column["data"].is_array() &&
+               !(column.contains("name") && column["name"].is_string() &&
+                 column["name"].get<std::string>() == "flock_row_id");
+    };
+
+    std::unordered_map<std::string, size_t> occurrences;
+    std::vector<std::string> values_in_order;
+    for (const auto& column: columns) {
+        if (!is_encodable_column(column)) {
+            continue;
+        }
+        for (const auto& item: column["data"]) {
+            if (!item.is_string()) {
+                continue;
+            }
+            const auto& value = item.get_ref<const std::string&>();
+            if (value.size() < dictionary_encoding.min_length) {
+                continue;
+            }
+            auto [it, inserted] = occurrences.emplace(value, 0);
+            if (inserted) {
+                values_in_order.push_back(value);
+            }
+            it->second++;
+        }
+    }
+
+    std::unordered_map<std::string, std::string> codes;
+    auto legend = std::string("");
+    for (const auto& value: values_in_order) {
+        if (occurrences[value] < dictionary_encoding.min_repeats) {
+            continue;
+        }
+        auto code = "@V" + std::to_string(codes.size() + 1);
+        if (code.size() >= value.size()) {
+            continue;
+        }
+        legend += code + " = " + nlohmann::json(value).dump() + "\n";
+        codes.emplace(value, std::move(code));
+    }
+
+    if (codes.empty()) {
+        return "";
+    }
+
+    for (auto& column: columns) {
+        if (!is_encodable_column(column)) {
+            continue;
+        }
+        for (auto& item: column["data"]) {
+            if (!item.is_string()) {
+                continue;
+            }
+            const auto code = codes.find(item.get_ref<const std::string&>());
+            if (code != codes.end()) {
+                item = code->second;
+            }
+        }
+    }
+
+    return "- Value Dictionary: the codes below appear in the tuples in place of the full values they stand for.\n" +
+           legend + "\n";
+}
+
+std::string PromptManager::ConstructInputTuples(const nlohmann::json& columns, const TupleFormat tuple_format,
+                                                const std::optional<DictionaryEncoding>& dictionary_encoding) {
     auto tuples_str = std::string("");
     const auto num_tuples = columns.size() > 0 ? static_cast<int>(columns[0]["data"].size()) : 0;
 
     tuples_str += PromptManager::ConstructNumTuples(num_tuples);
-    tuples_str += PromptManager::ConstructInputTuplesHeader(columns, tuple_format);
+
+    const nlohmann::json* rendered_columns = &columns;
+    nlohmann::json encoded_columns;
+    if (dictionary_encoding.has_value()) {
+        encoded_columns = columns;
+        tuples_str += PromptManager::DictionaryEncodeColumns(encoded_columns, *dictionary_encoding);
+        rendered_columns = &encoded_columns;
+    }
+
+    tuples_str += PromptManager::ConstructInputTuplesHeader(*rendered_columns, tuple_format);
     switch (tuple_format) {
         case TupleFormat::XML:
-            return tuples_str + ConstructInputTuplesXML(columns);
+            return tuples_str + ConstructInputTuplesXML(*rendered_columns);
         case TupleFormat::Markdown:
-            return tuples_str + ConstructInputTuplesMarkdown(columns);
+            return tuples_str + ConstructInputTuplesMarkdown(*rendered_columns);
         case TupleFormat::JSON:
-            return tuples_str + ConstructInputTuplesJSON(columns);
+            return tuples_str + ConstructInputTuplesJSON(*rendered_columns);
+    }
+}
+
+void PromptManager::ApplyColumnTokenBudgets(nlohmann::json& columns) {
+    for (auto& column: columns) {
+        if (!column.contains("max_tokens") || !column.contains("data")) {
+            continue;
+        }
+        const auto max_tokens = column["max_tokens"].get<size_t>();
+        const auto strategy = column.contains("truncate")
+                                      ? stringToTruncationStrategy(column["truncate"].get<std::string>())
+                                      : TruncationStrategy::HEAD;
+        for (auto& item: column["data"]) {
+            if (item.is_string()) {
+                item = TokenCounter::Truncate(item.get<std::string>(), max_tokens, strategy);
+            }
+        }
     }
 }
 
@@ -270,4 +368,38 @@ nlohmann::json PromptManager::TranscribeAudioColumn(const nlohmann::json& audio_
     return transcription_column;
 }
 
+ContextColumnBatch PromptManager::TranscribeAudioColumns(const ContextColumnBatch& batch) {
+    auto transcribed = batch;
+    for (auto& column: transcribed.columns) {
+        if (!column.metadata.contains("type") || column.metadata["type"] != "audio" ||
+            !column.metadata.contains("transcription_model")) {
+            continue;
+        }
+
+        auto audio_column = column.metadata;
+        auto data = nlohmann::json::array();
+        for (idx_t row = 0; row < transcribed.row_count; row++) {
+            data.push_back(column.valid[row] ? column.cells[row].GetString() : std::string("NULL"));
+        }
+        audio_column["data"] = std::move(data);
+        const auto transcription_column = TranscribeAudioColumn(audio_column);
+
+        if (!transcribed.owned_cells) {
+            transcribed.owned_cells = std::make_shared<std::deque<std::string>>();
+        }
+        column.metadata = {{"name", transcription_column["name"]}};
+        const auto& transcriptions = transcription_column["data"];
+        for (idx_t row = 0; row < transcribed.row_count; row++) {
+            column.valid[row] = row < transcriptions.size() && !transcriptions[row].is_null();
+            if (!column.valid[row]) {
+                continue;
+            }
+            const auto& text = transcribed.owned_cells->emplace_back(
+                    transcriptions[row].is_string() ? transcriptions[row].get<std::string>() : transcriptions[row].dump());
+            column.cells[row] = duckdb::string_t(text.data(), static_cast<uint32_t>(text.size()));
+        }
+    }
+    return transcribed;
+}
+
 }// namespace flock
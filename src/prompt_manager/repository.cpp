@@ -16,24 +16,28 @@ std::string INSTRUCTIONS::Get(AggregateFunctionType option) {
 };
 
 template<>
-std::string RESPONSE_FORMAT::Get(const ScalarFunctionType option) {
+std::string RESPONSE_FORMAT::Get(const ScalarFunctionType option, const OutputEncoding output_encoding) {
     switch (option) {
         case ScalarFunctionType::COMPLETE:
             return RESPONSE_FORMAT::COMPLETE;
         case ScalarFunctionType::FILTER:
-            return RESPONSE_FORMAT::FILTER;
+            return output_encoding == OutputEncoding::COMPACT ? RESPONSE_FORMAT::FILTER_COMPACT
+                                                              : RESPONSE_FORMAT::FILTER;
+        case ScalarFunctionType::FUSED:
+            return RESPONSE_FORMAT::FUSED;
         default:
             return "";
     }
 }
 
 template<>
-std::string RESPONSE_FORMAT::Get(const AggregateFunctionType option) {
+std::string RESPONSE_FORMAT::Get(const AggregateFunctionType option, const OutputEncoding output_encoding) {
     switch (option) {
         case AggregateFunctionType::REDUCE:
             return RESPONSE_FORMAT::REDUCE;
         case AggregateFunctionType::RERANK:
-            return RESPONSE_FORMAT::RERANK;
+            return output_encoding == OutputEncoding::COMPACT ? RESPONSE_FORMAT::RERANK_COMPACT
+                                                              : RESPONSE_FORMAT::RERANK;
         case AggregateFunctionType::FIRST:
         case AggregateFunctionType::LAST: {
             return PromptManager::ReplaceSection(RESPONSE_FORMAT::FIRST_OR_LAST, "{{RELEVANCE}}",
@@ -44,6 +48,28 @@ std::string RESPONSE_FORMAT::Get(const AggregateFunctionType option) {
     }
 }
 
+OutputEncoding stringToOutputEncoding(const std::string& encoding) {
+    auto lower_encoding = encoding;
+    std::transform(lower_encoding.begin(), lower_encoding.end(), lower_encoding.begin(), ::tolower);
+    if (lower_encoding == "json") {
+        return OutputEncoding::JSON;
+    }
+    if (lower_encoding == "compact") {
+        return OutputEncoding::COMPACT;
+    }
+    throw std::runtime_error("Expected 'output_encoding' to be one of: json or compact.");
+}
+
+std::string outputEncodingToString(const OutputEncoding encoding) {
+    switch (encoding) {
+        case OutputEncoding::JSON:
+            return "json";
+        case OutputEncoding::COMPACT:
+            return "compact";
+    }
+    return "json";
+}
+
 TupleFormat stringToTupleFormat(const std::string& format) {
     auto upper_format = format;
     std::transform(upper_format.begin(), upper_format.end(), upper_format.begin(), ::toupper);
@@ -0,0 +1,209 @@
+#include "flock/prompt_manager/token_counter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace flock {
+
+namespace {
+
+constexpr auto TRUNCATION_MARKER = "[...]";
+
+bool IsContinuationByte(const unsigned char byte) { return (byte & 0xC0) == 0x80; }
+
+bool IsSpace(const char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+
+// A cut that lands inside a word is moved to the nearest whitespace, giving up at
+// most a quarter of the kept text (but always allowing a few characters of slack).
+constexpr size_t MIN_ALIGNMENT_SLACK = 8;
+
+size_t AlignmentSlack(const size_t kept) { return std::min(kept, std::max(kept / 4, MIN_ALIGNMENT_SLACK)); }
+
+size_t AlignCutBackward(const std::string& text, const size_t cut) {
+    if (cut == 0 || cut >= text.size() || IsSpace(text[cut]) || IsSpace(text[cut - 1])) {
+        return cut;
+    }
+    const auto floor = cut - AlignmentSlack(cut);
+    for (auto pos = cut; pos > floor && pos > 1; pos--) {
+        if (IsSpace(text[pos - 1])) {
+            return pos;
+        }
+    }
+    return cut;
+}
+
+size_t AlignCutForward(const std::string& text, const size_t cut) {
+    if (cut == 0 || cut >= text.size() || IsSpace(text[cut]) || IsSpace(text[cut - 1])) {
+        return cut;
+    }
+    const auto ceiling = cut + AlignmentSlack(text.size() - cut);
+    for (auto pos = cut; pos < ceiling && pos + 1 < text.size(); pos++) {
+        if (IsSpace(text[pos])) {
+            return pos;
+        }
+    }
+    return cut;
+}
+
+std::string TrimRight(std::string text) {
+    while (!text.empty() && IsSpace(text.back())) {
+        text.pop_back();
+    }
+    return text;
+}
+
+std::string TrimLeft(const std::string& text) {
+    size_t start = 0;
+    while (start < text.size() && IsSpace(text[start])) {
+        start++;
+    }
+    return text.substr(start);
+}
+
+// Byte offset `code_points` code points after `pos`, or the end of `text`.
+size_t AdvanceCodePoints(const std::string& text, size_t pos, size_t code_points) {
+    for (; pos < text.size(); pos++) {
+        if (!IsContinuationByte(static_cast<unsigned char>(text[pos]))) {
+            if (code_points == 0) {
+                return pos;
+            }
+            code_points--;
+        }
+    }
+    return text.size();
+}
+
+// Byte offset `code_points` code points before `pos`, but after `floor`.
+size_t RetreatCodePoints(const std::string& text, size_t pos, size_t code_points, const size_t floor) {
+    while (pos > floor + 1 && code_points > 0) {
+        pos--;
+        if (!IsContinuationByte(static_cast<unsigned char>(text[pos]))) {
+            code_points--;
+        }
+    }
+    return pos;
+}
+
+// Moves the end of the chunk starting at `start` back to whitespace, like AlignCutBackward
+// but with the slack measured from the chunk start.
+size_t AlignChunkEnd(const std::string& text, const size_t start, const size_t cut) {
+    if (cut >= text.size() || IsSpace(text[cut]) || IsSpace(text[cut - 1])) {
+        return cut;
+    }
+    const auto floor = cut - std::min(cut - start - 1, std::max((cut - start) / 4, MIN_ALIGNMENT_SLACK));
+    for (auto pos = cut; pos > floor; pos--) {
+        if (IsSpace(text[pos - 1])) {
+            return pos;
+        }
+    }
+    return cut;
+}
+
+// Moves the start of a chunk forward to the next word, without passing `end`.
+size_t AlignChunkStart(const std::string& text, const size_t pos, const size_t end) {
+    if (pos == 0 || IsSpace(text[pos - 1])) {
+        return pos;
+    }
+    for (auto next = pos; next < end; next++) {
+        if (IsSpace(text[next])) {
+            return next + 1;
+        }
+    }
+    return pos;
+}
+
+}// namespace
+
+TruncationStrategy stringToTruncationStrategy(const std::string& strategy) {
+    auto lower_strategy = strategy;
+    std::transform(lower_strategy.begin(), lower_strategy.end(), lower_strategy.begin(), ::tolower);
+    if (lower_strategy == "head") {
+        return TruncationStrategy::HEAD;
+    }
+    if (lower_strategy == "tail") {
+        return TruncationStrategy::TAIL;
+    }
+    if (lower_strategy == "middle") {
+        return TruncationStrategy::MIDDLE;
+    }
+    throw std::runtime_error("Expected 'truncate' to be one of: head, tail, or middle.");
+}
+
+size_t TokenCounter::CountCodePoints(const std::string& text) {
+    size_t code_points = 0;
+    for (const auto c: text) {
+        if (!IsContinuationByte(static_cast<unsigned char>(c))) {
+            code_points++;
+        }
+    }
+    return code_points;
+}
+
+size_t TokenCounter::CodePointOffset(const std::string& text, const size_t code_points) {
+    size_t seen = 0;
+    for (size_t pos = 0; pos < text.size(); pos++) {
+        if (!IsContinuationByte(static_cast<unsigned char>(text[pos]))) {
+            if (seen == code_points) {
+                return pos;
+            }
+            seen++;
+        }
+    }
+    return text.size();
+}
+
+size_t TokenCounter::Estimate(const std::string& text) {
+    return (CountCodePoints(text) + CHARS_PER_TOKEN - 1) / CHARS_PER_TOKEN;
+}
+
+std::string TokenCounter::Truncate(const std::string& text, const size_t max_tokens, const TruncationStrategy strategy) {
+    const auto total_code_points = CountCodePoints(text);
+    const auto budget = max_tokens * CHARS_PER_TOKEN;
+    if (total_code_points <= budget) {
+        return text;
+    }
+
+    switch (strategy) {
+        case TruncationStrategy::HEAD: {
+            const auto cut = AlignCutBackward(text, CodePointOffset(text, budget));
+            return TrimRight(text.substr(0, cut)) + " " + TRUNCATION_MARKER;
+        }
+        case TruncationStrategy::TAIL: {
+            const auto cut = AlignCutForward(text, CodePointOffset(text, total_code_points - budget));
+            return std::string(TRUNCATION_MARKER) + " " + TrimLeft(text.substr(cut));
+        }
+        case TruncationStrategy::MIDDLE: {
+            const auto head_budget = (budget + 1) / 2;
+            const auto tail_budget = budget - head_budget;
+            const auto head_cut = AlignCutBackward(text, CodePointOffset(text, head_budget));
+            const auto tail_cut = AlignCutForward(text, CodePointOffset(text, total_code_points - tail_budget));
+            return TrimRight(text.substr(0, head_cut)) + " " + TRUNCATION_MARKER + " " + TrimLeft(text.substr(tail_cut));
+        }
+    }
+    return text;
+}
+
+std::vector<std::string> TokenCounter::Split(const std::string& text, const size_t chunk_tokens,
+                                             const size_t overlap_tokens) {
+    const auto chunk_code_points = std::max<size_t>(chunk_tokens * CHARS_PER_TOKEN, 1);
+    const auto overlap_code_points = std::min(overlap_tokens * CHARS_PER_TOKEN, chunk_code_points / 2);
+
+    std::vector<std::string> chunks;
+    size_t start = 0;
+    while (start < text.size()) {
+        const auto end = AlignChunkEnd(text, start, AdvanceCodePoints(text, start, chunk_code_points));
+        auto chunk = TrimLeft(TrimRight(text.substr(start, end - start)));
+        if (!chunk.empty()) {
+            chunks.push_back(std::move(chunk));
+        }
+        if (end >= text.size()) {
+            break;
+        }
+        const auto next = AlignChunkStart(text, RetreatCodePoints(text, end, overlap_code_points, start), end);
+        start = next > start ? next : end;
+    }
+    return chunks;
+}
+
+}// namespace flock
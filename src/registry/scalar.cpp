@@ -5,6 +5,7 @@ namespace flock {
 void ScalarRegistry::Register(duckdb::ExtensionLoader& loader) {
     RegisterLlmComplete(loader);
     RegisterLlmEmbedding(loader);
+    RegisterFlockQuantizeEmbedding(loader);
     RegisterLlmFilter(loader);
     RegisterFusionRRF(loader);
     RegisterFusionCombANZ(loader);
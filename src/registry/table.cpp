@@ -0,0 +1,11 @@
+#include "flock/registry/table.hpp"
+
+namespace flock {
+
+void TableRegistry::Register(duckdb::ExtensionLoader& loader) {
+    RegisterLlmMap(loader);
+    RegisterFlockTopkSimilar(loader);
+    RegisterFlockVectorIndex(loader);
+}
+
+}// namespace flock
@@ -0,0 +1,187 @@
+#include "flock/vector_index/hnsw.hpp"
+#include "flock/core/vector_math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace flock {
+
+namespace {
+
+bool ByScoreDescending(const HnswGraph::Match& left, const HnswGraph::Match& right) {
+    return left.score > right.score;
+}
+
+bool ByScoreAscending(const HnswGraph::Match& left, const HnswGraph::Match& right) {
+    return left.score < right.score;
+}
+
+}// namespace
+
+size_t HnswGraph::RandomLevel(const uint32_t id) {
+    std::mt19937 generator(id);
+    std::uniform_real_distribution<double> uniform(std::numeric_limits<double>::min(), 1.0);
+    const auto level = -std::log(uniform(generator)) / std::log(static_cast<double>(MAX_NEIGHBORS));
+    return std::min(static_cast<size_t>(level), MAX_LEVEL);
+}
+
+float HnswGraph::Similarity(const float* query, const uint32_t node) const {
+    return VectorMath::Dot(query, nodes_[node].vector.data(), dims_);
+}
+
+uint32_t HnswGraph::Insert(std::string key, std::vector<float> vector, std::vector<uint32_t>& changed) {
+    if (nodes_.empty()) {
+        dims_ = vector.size();
+    }
+    if (vector.size() != dims_ || dims_ == 0) {
+        throw std::runtime_error("Vector index: all embeddings must have the same, non-zero number of dimensions.");
+    }
+
+    const auto id = static_cast<uint32_t>(nodes_.size());
+    const auto level = RandomLevel(id);
+    nodes_.push_back(Node{std::move(key), std::move(vector), std::vector<std::vector<uint32_t>>(level + 1)});
+    if (id == 0) {
+        entry_point_ = id;
+        return id;
+    }
+
+    const auto* query = nodes_[id].vector.data();
+    const auto top_level = TopLevel();
+    std::vector<Match> entry_points{{entry_point_, Similarity(query, entry_point_)}};
+    for (auto current = top_level; current > level; current--) {
+        entry_points = {SearchLevel(query, entry_points, 1, current).front()};
+    }
+
+    for (auto current = std::min(level, top_level) + 1; current-- > 0;) {
+        auto candidates = SearchLevel(query, entry_points, EF_CONSTRUCTION, current);
+        const auto max_neighbors = current == 0 ? MAX_NEIGHBORS_LEVEL0 : MAX_NEIGHBORS;
+        nodes_[id].neighbors[current] = SelectNeighbors(candidates, max_neighbors);
+
+        for (const auto neighbor: nodes_[id].neighbors[current]) {
+            auto& links = nodes_[neighbor].neighbors[current];
+            links.push_back(id);
+            if (links.size() > max_neighbors) {
+                std::vector<Match> pool;
+                pool.reserve(links.size());
+                for (const auto link: links) {
+                    pool.push_back({link, Similarity(nodes_[neighbor].vector.data(), link)});
+                }
+                std::sort(pool.begin(), pool.end(), ByScoreDescending);
+                links = SelectNeighbors(pool, max_neighbors);
+            }
+            changed.push_back(neighbor);
+        }
+        entry_points = std::move(candidates);
+    }
+
+    if (level > top_level) {
+        entry_point_ = id;
+    }
+    return id;
+}
+
+void HnswGraph::Restore(Node node) {
+    if (nodes_.empty()) {
+        dims_ = node.vector.size();
+    }
+    if (node.vector.size() != dims_ || node.neighbors.empty()) {
+        throw std::runtime_error("Vector index: the stored graph is corrupt.");
+    }
+    nodes_.push_back(std::move(node));
+}
+
+void HnswGraph::SetEntryPoint(const uint32_t entry_point) {
+    if (!nodes_.empty() && entry_point >= nodes_.size()) {
+        throw std::runtime_error("Vector index: the stored graph is corrupt.");
+    }
+    entry_point_ = entry_point;
+}
+
+std::vector<HnswGraph::Match> HnswGraph::Search(const float* query, const size_t k, const size_t ef) const {
+    if (nodes_.empty() || k == 0) {
+        return {};
+    }
+    std::vector<Match> entry_points{{entry_point_, Similarity(query, entry_point_)}};
+    for (auto current = TopLevel(); current > 0; current--) {
+        entry_points = {SearchLevel(query, entry_points, 1, current).front()};
+    }
+    auto results = SearchLevel(query, entry_points, std::max(ef, k), 0);
+    results.resize(std::min(k, results.size()));
+    return results;
+}
+
+std::vector<HnswGraph::Match> HnswGraph::SearchLevel(const float* query, const std::vector<Match>& entry_points,
+                                                     const size_t ef, const size_t level) const {
+    // `candidates` pops the best node to expand next; `results` pops its worst entry.
+    std::vector<Match> candidates = entry_points;
+    std::vector<Match> results = entry_points;
+    std::unordered_set<uint32_t> visited;
+    for (const auto& entry: entry_points) {
+        visited.insert(entry.node);
+    }
+    std::make_heap(candidates.begin(), candidates.end(), ByScoreAscending);
+    std::make_heap(results.begin(), results.end(), ByScoreDescending);
+    while (results.size() > ef) {
+        std::pop_heap(results.begin(), results.end(), ByScoreDescending);
+        results.pop_back();
+    }
+
+    while (!candidates.empty()) {
+        std::pop_heap(candidates.begin(), candidates.end(), ByScoreAscending);
+        const auto current = candidates.back();
+        candidates.pop_back();
+        if (results.size() >= ef && current.score < results.front().score) {
+            break;
+        }
+
+        for (const auto neighbor: nodes_[current.node].neighbors[level]) {
+            if (!visited.insert(neighbor).second) {
+                continue;
+            }
+            const Match match{neighbor, Similarity(query, neighbor)};
+            if (results.size() >= ef && match.score <= results.front().score) {
+                continue;
+            }
+            candidates.push_back(match);
+            std::push_heap(candidates.begin(), candidates.end(), ByScoreAscending);
+            results.push_back(match);
+            std::push_heap(results.begin(), results.end(), ByScoreDescending);
+            if (results.size() > ef) {
+                std::pop_heap(results.begin(), results.end(), ByScoreDescending);
+                results.pop_back();
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end(), ByScoreDescending);
+    return results;
+}
+
+std::vector<uint32_t> HnswGraph::SelectNeighbors(const std::vector<Match>& candidates,
+                                                 const size_t max_neighbors) const {
+    std::vector<uint32_t> selected;
+    std::vector<uint32_t> pruned;
+    for (const auto& candidate: candidates) {
+        if (selected.size() >= max_neighbors) {
+            break;
+        }
+        const auto* vector = nodes_[candidate.node].vector.data();
+        const auto diverse = std::none_of(selected.begin(), selected.end(), [&](const uint32_t kept) {
+            return Similarity(vector, kept) > candidate.score;
+        });
+        (diverse ? selected : pruned).push_back(candidate.node);
+    }
+    for (const auto node: pruned) {
+        if (selected.size() >= max_neighbors) {
+            break;
+        }
+        selected.push_back(node);
+    }
+    return selected;
+}
+
+}// namespace flock
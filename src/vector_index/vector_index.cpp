@@ -0,0 +1,338 @@
+#include "flock/vector_index/vector_index.hpp"
+#include "duckdb/main/appender.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/parser/qualified_name.hpp"
+#include "flock/core/config.hpp"
+#include "flock/core/vector_math.hpp"
+#include "flock/model_manager/model.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace flock {
+
+namespace {
+
+std::string QuoteIdentifier(const std::string& identifier) {
+    return duckdb::KeywordHelper::WriteOptionallyQuoted(identifier);
+}
+
+duckdb::unique_ptr<duckdb::MaterializedQueryResult> Execute(duckdb::Connection& con, const std::string& query,
+                                                            duckdb::vector<duckdb::Value> values = {}) {
+    const auto statement = con.Prepare(query);
+    if (statement->HasError()) {
+        throw std::runtime_error("Vector index: " + statement->GetError());
+    }
+    auto result = statement->Execute(values, false);
+    if (result->HasError()) {
+        throw std::runtime_error("Vector index: " + result->GetError());
+    }
+    return duckdb::unique_ptr_cast<duckdb::QueryResult, duckdb::MaterializedQueryResult>(std::move(result));
+}
+
+// Calls `callback` with every row of `result` and the FLOAT[] in its `embedding_column`, read
+// from the vectors directly: building and loading an index touch every dimension of every row.
+void ForEachEmbedding(duckdb::MaterializedQueryResult& result, const idx_t embedding_column,
+                      const std::function<void(duckdb::DataChunk&, idx_t, std::vector<float>)>& callback) {
+    while (auto chunk = result.Fetch()) {
+        auto& lists = chunk->data[embedding_column];
+        duckdb::UnifiedVectorFormat list_format;
+        lists.ToUnifiedFormat(chunk->size(), list_format);
+        duckdb::UnifiedVectorFormat child_format;
+        duckdb::ListVector::GetEntry(lists).ToUnifiedFormat(duckdb::ListVector::GetListSize(lists), child_format);
+        const auto entries = duckdb::UnifiedVectorFormat::GetData<duckdb::list_entry_t>(list_format);
+        const auto values = duckdb::UnifiedVectorFormat::GetData<float>(child_format);
+
+        for (idx_t row = 0; row < chunk->size(); row++) {
+            const auto& entry = entries[list_format.sel->get_index(row)];
+            std::vector<float> embedding(entry.length);
+            for (idx_t i = 0; i < entry.length; i++) {
+                const auto child_index = child_format.sel->get_index(entry.offset + i);
+                if (!child_format.validity.RowIsValid(child_index)) {
+                    throw std::runtime_error("Vector index: embeddings must not contain NULL values.");
+                }
+                embedding[i] = values[child_index];
+            }
+            callback(*chunk, row, std::move(embedding));
+        }
+    }
+}
+
+}// namespace
+
+size_t VectorIndex::Create(duckdb::DatabaseInstance& db, Definition definition) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    indexes_.erase({&db, definition.name});
+
+    duckdb::Connection con(db);
+    const auto probe = con.Prepare(duckdb_fmt::format("SELECT t.{}, t.{} FROM {} AS t",
+                                                      QuoteIdentifier(definition.key_column),
+                                                      QuoteIdentifier(definition.embedding_column),
+                                                      QuoteTableName(definition.table)));
+    if (probe->HasError()) {
+        throw std::runtime_error("Vector index: " + probe->GetError());
+    }
+    const auto& embedding_type = probe->GetTypes()[1];
+    if (embedding_type.id() != duckdb::LogicalTypeId::LIST && embedding_type.id() != duckdb::LogicalTypeId::ARRAY) {
+        throw std::runtime_error(duckdb_fmt::format("Vector index: column '{}' must hold embeddings, not {}.",
+                                                    definition.embedding_column, embedding_type.ToString()));
+    }
+    definition.key_type = probe->GetTypes()[0].ToString();
+
+    auto index = std::make_unique<LoadedIndex>();
+    index->definition = std::move(definition);
+    const auto& stored = index->definition;
+
+    con.BeginTransaction();
+    Execute(con, duckdb_fmt::format("DELETE FROM {} WHERE index_name = $1;", GetNodeTable()), {stored.name});
+    Execute(con, duckdb_fmt::format("DELETE FROM {} WHERE index_name = $1;", GetDefinitionTable()), {stored.name});
+    Execute(con,
+            duckdb_fmt::format(" INSERT INTO {} (index_name, table_name, key_column, embedding_column, key_type, "
+                               "                 model, entry_point) "
+                               " VALUES ($1, $2, $3, $4, $5, $6, 0);",
+                               GetDefinitionTable()),
+            {stored.name, stored.table, stored.key_column, stored.embedding_column, stored.key_type,
+             stored.model.is_null() ? duckdb::Value(duckdb::LogicalType::VARCHAR) : duckdb::Value(stored.model.dump())});
+    const auto count = AddMissingRows(con, *index);
+    con.Commit();
+
+    indexes_[{&db, index->definition.name}] = std::move(index);
+    return count;
+}
+
+size_t VectorIndex::Update(duckdb::DatabaseInstance& db, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    try {
+        auto& index = GetUnlocked(db, name);
+        duckdb::Connection con(db);
+        con.BeginTransaction();
+        const auto count = AddMissingRows(con, index);
+        con.Commit();
+        return count;
+    } catch (...) {
+        // The graph in memory may hold nodes that were never stored.
+        indexes_.erase({&db, name});
+        throw;
+    }
+}
+
+void VectorIndex::Drop(duckdb::DatabaseInstance& db, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    indexes_.erase({&db, name});
+    duckdb::Connection con(db);
+    LoadDefinition(con, name);
+    con.BeginTransaction();
+    Execute(con, duckdb_fmt::format("DELETE FROM {} WHERE index_name = $1;", GetNodeTable()), {name});
+    Execute(con, duckdb_fmt::format("DELETE FROM {} WHERE index_name = $1;", GetDefinitionTable()), {name});
+    con.Commit();
+}
+
+VectorIndex::Definition VectorIndex::GetDefinition(duckdb::DatabaseInstance& db, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GetUnlocked(db, name).definition;
+}
+
+std::vector<VectorIndex::Match> VectorIndex::Search(duckdb::DatabaseInstance& db, const std::string& name,
+                                                    std::vector<float> query, const size_t k, const size_t ef) {
+    VectorMath::Normalize(query);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto& index = GetUnlocked(db, name);
+    if (index.graph.Size() > 0 && query.size() != index.graph.Dims()) {
+        throw std::runtime_error(duckdb_fmt::format("flock_knn: the query has {} dimensions but index '{}' has {}.",
+                                                    query.size(), name, index.graph.Dims()));
+    }
+
+    std::vector<Match> matches;
+    for (const auto& match: index.graph.Search(query.data(), k, ef)) {
+        matches.push_back({index.graph.GetNode(match.node).key, match.score});
+    }
+    return matches;
+}
+
+std::vector<float> VectorIndex::EmbedQuery(const Definition& definition, const std::string& text) {
+    if (definition.model.is_null()) {
+        throw std::runtime_error(duckdb_fmt::format(
+                "flock_knn: index '{}' was created without a model, so it can only be searched with a vector.",
+                definition.name));
+    }
+    Model model(Model::ResolveModelDetailsToJson(definition.model));
+    model.AddEmbeddingRequest({text});
+    const auto batches = model.CollectEmbeddings();
+    if (batches.empty() || !batches[0].is_array() || batches[0].empty()) {
+        throw std::runtime_error("flock_knn: the model returned no embedding for the query.");
+    }
+
+    std::vector<float> embedding;
+    for (const auto& value: batches[0][0]) {
+        embedding.push_back(value.get<float>());
+    }
+    return embedding;
+}
+
+void VectorIndex::Unload() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    indexes_.clear();
+}
+
+std::string VectorIndex::QuoteTableName(const std::string& table) {
+    const auto name = duckdb::QualifiedName::Parse(table);
+    std::string quoted;
+    if (!name.catalog.empty()) {
+        quoted += QuoteIdentifier(name.catalog) + ".";
+    }
+    if (!name.schema.empty()) {
+        quoted += QuoteIdentifier(name.schema) + ".";
+    }
+    return quoted + QuoteIdentifier(name.name);
+}
+
+VectorIndex::LoadedIndex& VectorIndex::GetUnlocked(duckdb::DatabaseInstance& db, const std::string& name) {
+    const IndexKey key{&db, name};
+    const auto it = indexes_.find(key);
+    if (it != indexes_.end()) {
+        return *it->second;
+    }
+
+    duckdb::Connection con(db);
+    auto index = std::make_unique<LoadedIndex>();
+    index->definition = LoadDefinition(con, name);
+    LoadGraph(con, *index);
+    return *(indexes_[key] = std::move(index));
+}
+
+VectorIndex::Definition VectorIndex::LoadDefinition(duckdb::Connection& con, const std::string& name) {
+    const auto result = Execute(con,
+                                duckdb_fmt::format(" SELECT table_name, key_column, embedding_column, key_type, model "
+                                                   "   FROM {} WHERE index_name = $1;",
+                                                   GetDefinitionTable()),
+                                {name});
+    if (result->RowCount() == 0) {
+        throw std::runtime_error(duckdb_fmt::format("Vector index '{}' does not exist.", name));
+    }
+
+    Definition definition;
+    definition.name = name;
+    definition.table = result->GetValue(0, 0).ToString();
+    definition.key_column = result->GetValue(1, 0).ToString();
+    definition.embedding_column = result->GetValue(2, 0).ToString();
+    definition.key_type = result->GetValue(3, 0).ToString();
+    const auto model = result->GetValue(4, 0);
+    if (!model.IsNull()) {
+        definition.model = nlohmann::json::parse(model.ToString());
+    }
+    return definition;
+}
+
+void VectorIndex::LoadGraph(duckdb::Connection& con, LoadedIndex& index) {
+    const auto& name = index.definition.name;
+    const auto entry_point = Execute(con, duckdb_fmt::format("SELECT entry_point FROM {} WHERE index_name = $1;",
+                                                             GetDefinitionTable()),
+                                     {name});
+    const auto nodes = Execute(con,
+                               duckdb_fmt::format(" SELECT node_id, row_key, neighbors, embedding FROM {} "
+                                                  "  WHERE index_name = $1 ORDER BY node_id;",
+                                                  GetNodeTable()),
+                               {name});
+
+    ForEachEmbedding(*nodes, 3, [&](duckdb::DataChunk& chunk, const idx_t row, std::vector<float> embedding) {
+        if (chunk.GetValue(0, row).GetValue<uint32_t>() != index.graph.Size()) {
+            throw std::runtime_error(duckdb_fmt::format("Vector index '{}' is corrupt; create it again.", name));
+        }
+        HnswGraph::Node node;
+        node.key = chunk.GetValue(1, row).ToString();
+        node.vector = std::move(embedding);
+        for (const auto& level: duckdb::ListValue::GetChildren(chunk.GetValue(2, row))) {
+            auto& links = node.neighbors.emplace_back();
+            for (const auto& link: duckdb::ListValue::GetChildren(level)) {
+                links.push_back(link.GetValue<uint32_t>());
+            }
+        }
+        index.graph.Restore(std::move(node));
+    });
+    index.graph.SetEntryPoint(entry_point->GetValue(0, 0).GetValue<uint32_t>());
+}
+
+size_t VectorIndex::AddMissingRows(duckdb::Connection& con, LoadedIndex& index) {
+    const auto& definition = index.definition;
+    const auto key = "t." + QuoteIdentifier(definition.key_column);
+    const auto embedding = "t." + QuoteIdentifier(definition.embedding_column);
+    // Ordered by key, so building twice from the same rows gives the same graph.
+    const auto rows = Execute(con,
+                              duckdb_fmt::format(" SELECT CAST({0} AS VARCHAR), CAST({1} AS FLOAT[]) FROM {2} AS t "
+                                                 "  WHERE {0} IS NOT NULL AND {1} IS NOT NULL "
+                                                 "    AND CAST({0} AS VARCHAR) NOT IN ( "
+                                                 "        SELECT row_key FROM {3} WHERE index_name = $1) "
+                                                 "  ORDER BY 1;",
+                                                 key, embedding, QuoteTableName(definition.table), GetNodeTable()),
+                              {definition.name});
+
+    std::vector<uint32_t> changed;
+    size_t count = 0;
+    ForEachEmbedding(*rows, 1, [&](duckdb::DataChunk& chunk, const idx_t row, std::vector<float> vector) {
+        VectorMath::Normalize(vector);
+        changed.push_back(index.graph.Insert(chunk.GetValue(0, row).ToString(), std::move(vector), changed));
+        count++;
+    });
+    if (count == 0) {
+        return 0;
+    }
+
+    StoreNodes(con, index, std::move(changed));
+    Execute(con, duckdb_fmt::format("UPDATE {} SET entry_point = $2 WHERE index_name = $1;", GetDefinitionTable()),
+            {definition.name, duckdb::Value::UINTEGER(index.graph.EntryPoint())});
+    return count;
+}
+
+void VectorIndex::StoreNodes(duckdb::Connection& con, const LoadedIndex& index, std::vector<uint32_t> node_ids) {
+    std::sort(node_ids.begin(), node_ids.end());
+    node_ids.erase(std::unique(node_ids.begin(), node_ids.end()), node_ids.end());
+
+    // Rewritten nodes are deleted first; nodes added by this call have no rows yet.
+    duckdb::vector<duckdb::Value> ids;
+    ids.reserve(node_ids.size());
+    for (const auto id: node_ids) {
+        ids.push_back(duckdb::Value::UINTEGER(id));
+    }
+    Execute(con,
+            duckdb_fmt::format("DELETE FROM {} WHERE index_name = $1 AND list_contains($2, node_id);", GetNodeTable()),
+            {index.definition.name, duckdb::Value::LIST(duckdb::LogicalType::UINTEGER, std::move(ids))});
+
+    const auto links_type = duckdb::LogicalType::LIST(duckdb::LogicalType::UINTEGER);
+    duckdb::Appender appender(con, Config::get_schema_name(), Config::get_vector_index_nodes_table_name());
+    for (const auto id: node_ids) {
+        const auto& node = index.graph.GetNode(id);
+        duckdb::vector<duckdb::Value> vector;
+        vector.reserve(node.vector.size());
+        for (const auto value: node.vector) {
+            vector.push_back(duckdb::Value::FLOAT(value));
+        }
+        duckdb::vector<duckdb::Value> levels;
+        for (const auto& links: node.neighbors) {
+            duckdb::vector<duckdb::Value> values;
+            for (const auto link: links) {
+                values.push_back(duckdb::Value::UINTEGER(link));
+            }
+            levels.push_back(duckdb::Value::LIST(duckdb::LogicalType::UINTEGER, std::move(values)));
+        }
+
+        appender.BeginRow();
+        appender.Append(duckdb::Value(index.definition.name));
+        appender.Append(duckdb::Value::UINTEGER(id));
+        appender.Append(duckdb::Value(node.key));
+        appender.Append(duckdb::Value::LIST(links_type, std::move(levels)));
+        appender.Append(duckdb::Value::LIST(duckdb::LogicalType::FLOAT, std::move(vector)));
+        appender.EndRow();
+    }
+    appender.Close();
+}
+
+std::string VectorIndex::GetDefinitionTable() {
+    return Config::get_schema_name() + "." + Config::get_vector_index_table_name();
+}
+
+std::string VectorIndex::GetNodeTable() {
+    return Config::get_schema_name() + "." + Config::get_vector_index_nodes_table_name();
+}
+
+}// namespace flock
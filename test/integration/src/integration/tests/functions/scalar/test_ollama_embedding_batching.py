@@ -0,0 +1,58 @@
+import os
+import time
+
+import pytest
+from integration.conftest import run_cli
+
+# Throughput comparison between one Ollama request per row and batched /api/embed requests.
+# Run with FLOCK_BENCHMARK=1 against a local Ollama server, e.g.
+#   FLOCK_BENCHMARK=1 uv run pytest -s -k ollama_embedding_batching
+BENCHMARK_ROWS = int(os.getenv("FLOCK_BENCHMARK_ROWS", "512"))
+BENCHMARK_MODEL = os.getenv("FLOCK_BENCHMARK_OLLAMA_EMBEDDING_MODEL", "all-minilm")
+
+pytestmark = pytest.mark.skipif(
+    os.getenv("FLOCK_BENCHMARK") != "1", reason="set FLOCK_BENCHMARK=1 to run benchmarks"
+)
+
+
+def embed_rows(duckdb_cli_path, db_path, model_name, batch_size):
+    query = f"""
+    SELECT count(*) AS embedded
+    FROM (
+        SELECT llm_embedding(
+            {{'model_name': '{model_name}', 'max_batch_size': {batch_size}}},
+            {{'context_columns': [{{'data': 'Benchmark document number ' || i::VARCHAR}}]}}
+        ) AS embedding
+        FROM range({BENCHMARK_ROWS}) AS t(i)
+    )
+    WHERE len(embedding) > 0;
+    """
+    start = time.perf_counter()
+    result = run_cli(duckdb_cli_path, db_path, query)
+    elapsed = time.perf_counter() - start
+
+    assert result.returncode == 0, f"Query failed with error: {result.stderr}"
+    assert str(BENCHMARK_ROWS) in result.stdout
+    return elapsed
+
+
+def test_ollama_embedding_batching_throughput(integration_setup):
+    duckdb_cli_path, db_path = integration_setup
+
+    test_model_name = f"benchmark-embedding_{BENCHMARK_MODEL}"
+    create_model_query = f"CREATE MODEL('{test_model_name}', '{BENCHMARK_MODEL}', 'ollama');"
+    run_cli(duckdb_cli_path, db_path, create_model_query, with_secrets=False)
+
+    # Warm up so model loading is not charged to the first mode.
+    embed_rows(duckdb_cli_path, db_path, test_model_name, 64)
+
+    per_row = embed_rows(duckdb_cli_path, db_path, test_model_name, 1)
+    batched = embed_rows(duckdb_cli_path, db_path, test_model_name, 128)
+
+    print(
+        f"\nollama {BENCHMARK_MODEL}, {BENCHMARK_ROWS} rows: "
+        f"per-row requests {BENCHMARK_ROWS / per_row:.1f} rows/s, "
+        f"batched requests {BENCHMARK_ROWS / batched:.1f} rows/s "
+        f"({per_row / batched:.1f}x)"
+    )
+    assert batched < per_row
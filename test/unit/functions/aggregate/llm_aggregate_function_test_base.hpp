@@ -3,6 +3,7 @@
 #include "../mock_provider.hpp"
 #include "flock/core/config.hpp"
 #include "flock/functions/aggregate/aggregate.hpp"
+#include "flock/model_manager/batch_size_controller.hpp"
 #include "flock/model_manager/model.hpp"
 #include "nlohmann/json.hpp"
 #include <gmock/gmock.h>
@@ -37,6 +38,9 @@ protected:
                   "       TYPE OLLAMA,"
                   "    API_URL '127.0.0.1:11434');");
 
+        // Batch sizes learned by earlier tests would change the expected request sizes.
+        BatchSizeController::Reset();
+
         // Create a shared mock provider for expectations
         mock_provider = std::make_shared<MockProvider>(ModelDetails{});
 
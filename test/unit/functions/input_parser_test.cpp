@@ -0,0 +1,65 @@
+#include "flock/core/config.hpp"
+#include "flock/functions/input_parser.hpp"
+#include <gtest/gtest.h>
+
+namespace flock {
+using json = nlohmann::json;
+
+class InputParserTest : public ::testing::Test {
+protected:
+    static duckdb::unique_ptr<duckdb::DataChunk> FetchPromptChunk(duckdb::Connection& con, const std::string& query) {
+        auto result = con.Query(query);
+        EXPECT_FALSE(result->HasError()) << result->GetError();
+        return result->Fetch();
+    }
+};
+
+TEST_F(InputParserTest, ExtractsContextColumnsPerRowWithMetadataOnce) {
+    auto con = Config::GetConnection();
+    auto chunk = FetchPromptChunk(
+            con, "SELECT {'prompt': 'Describe', 'context_columns': [{'name': 'id', 'data': i}, "
+                 "{'name': 'score', 'data': CASE WHEN i = 1 THEN NULL ELSE i * 10 END}]} "
+                 "FROM range(3) AS t(i);");
+    ASSERT_NE(chunk, nullptr);
+
+    json prompt_json;
+    const auto batch = ExtractPromptInputs(chunk->data[0], chunk->size(), prompt_json);
+    EXPECT_EQ(prompt_json["prompt"], "Describe");
+    EXPECT_FALSE(prompt_json.contains("context_columns"));
+
+    ASSERT_EQ(batch.columns.size(), 2);
+    EXPECT_EQ(batch.columns[0].metadata["name"], "id");
+    EXPECT_EQ(batch.columns[1].metadata["name"], "score");
+    EXPECT_FALSE(batch.columns[1].valid[1]);
+
+    const auto context_columns = batch.ToJson();
+    EXPECT_EQ(context_columns[0]["data"], json::array({"0", "1", "2"}));
+    EXPECT_EQ(context_columns[1]["data"], json::array({"0", "NULL", "20"}));
+}
+
+TEST_F(InputParserTest, CastVectorOfStructsToJsonKeepsContextColumnsShape) {
+    auto con = Config::GetConnection();
+    auto chunk = FetchPromptChunk(
+            con, "SELECT {'prompt': 'Summarize', 'context_columns': [{'name': 'text', 'data': t, 'max_tokens': 10}]} "
+                 "FROM (VALUES ('first'), ('second')) AS v(t);");
+    ASSERT_NE(chunk, nullptr);
+
+    const auto prompt_json = CastVectorOfStructsToJson(chunk->data[0], static_cast<int>(chunk->size()));
+    ASSERT_EQ(prompt_json["context_columns"].size(), 1);
+    const auto& column = prompt_json["context_columns"][0];
+    EXPECT_EQ(column["name"], "text");
+    EXPECT_EQ(column["max_tokens"], 10);
+    EXPECT_FALSE(column.contains("type"));
+    EXPECT_EQ(column["data"], json::array({"first", "second"}));
+}
+
+TEST_F(InputParserTest, RejectsUnknownContextColumnKeys) {
+    auto con = Config::GetConnection();
+    auto chunk = FetchPromptChunk(con, "SELECT {'prompt': 'x', 'context_columns': [{'data': 'a', 'color': 'red'}]};");
+    ASSERT_NE(chunk, nullptr);
+
+    json prompt_json;
+    EXPECT_THROW(ExtractPromptInputs(chunk->data[0], chunk->size(), prompt_json), std::runtime_error);
+}
+
+}// namespace flock
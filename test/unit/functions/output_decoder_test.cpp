@@ -0,0 +1,39 @@
+#include "flock/functions/output_decoder.hpp"
+#include "nlohmann/json.hpp"
+#include <gtest/gtest.h>
+
+namespace flock {
+using json = nlohmann::json;
+
+TEST(OutputDecoder, DecodesBitstring) {
+    const auto decoded = DecodeCompactBoolItems(json::array({"TfF t"}), 4);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(*decoded, json::array({true, false, false, true}));
+}
+
+TEST(OutputDecoder, RejectsMalformedBitstring) {
+    EXPECT_FALSE(DecodeCompactBoolItems(json::array({"TFT"}), 4).has_value());
+    EXPECT_FALSE(DecodeCompactBoolItems(json::array({"TFTX"}), 4).has_value());
+    EXPECT_FALSE(DecodeCompactBoolItems(json::array({true, false}), 2).has_value());
+    EXPECT_FALSE(DecodeCompactBoolItems(json::array({"TF", "TF"}), 2).has_value());
+    EXPECT_FALSE(DecodeCompactBoolItems(json::object(), 0).has_value());
+}
+
+TEST(OutputDecoder, DecodesIndexList) {
+    const std::set<std::string> valid_ids = {"0", "1", "2"};
+    const auto decoded = DecodeCompactIndexList(json::array({"2, 0,1"}), valid_ids);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(*decoded, json::array({2, 0, 1}));
+}
+
+TEST(OutputDecoder, RejectsMalformedIndexList) {
+    const std::set<std::string> valid_ids = {"0", "1", "2"};
+    EXPECT_FALSE(DecodeCompactIndexList(json::array({"2,0"}), valid_ids).has_value());
+    EXPECT_FALSE(DecodeCompactIndexList(json::array({"2,0,0"}), valid_ids).has_value());
+    EXPECT_FALSE(DecodeCompactIndexList(json::array({"2,0,7"}), valid_ids).has_value());
+    EXPECT_FALSE(DecodeCompactIndexList(json::array({"2,0,1,"}), valid_ids).has_value());
+    EXPECT_FALSE(DecodeCompactIndexList(json::array({"2;0;1"}), valid_ids).has_value());
+    EXPECT_FALSE(DecodeCompactIndexList(json::array({2, 0, 1}), valid_ids).has_value());
+}
+
+}// namespace flock
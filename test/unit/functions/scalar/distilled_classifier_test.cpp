@@ -0,0 +1,162 @@
+#include "../mock_provider.hpp"
+#include "flock/core/config.hpp"
+#include "flock/functions/scalar/distilled_classifier.hpp"
+#include "flock/model_manager/model.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace flock {
+
+class DistilledClassifierTest : public ::testing::Test {
+protected:
+    static constexpr size_t ROW_COUNT = 40;
+
+    std::shared_ptr<MockProvider> mock_provider;
+    std::vector<std::vector<std::string>> embedding_batches;
+    size_t labelled_rows = 0;
+    size_t embedded_rows = 0;
+
+    void SetUp() override {
+        auto con = Config::GetConnection();
+        con.Query(" CREATE SECRET ("
+                  "       TYPE OPENAI,"
+                  "    API_KEY 'your-api-key');");
+        mock_provider = std::make_shared<MockProvider>(ModelDetails{});
+        Model::SetMockProvider(mock_provider);
+
+        // Texts starting with "good" embed to one axis, everything else to another.
+        ON_CALL(*mock_provider, AddEmbeddingRequest(::testing::_))
+                .WillByDefault([this](const std::vector<std::string>& inputs) {
+                    embedding_batches.push_back(inputs);
+                    embedded_rows += inputs.size();
+                });
+        ON_CALL(*mock_provider, CollectEmbeddings(::testing::_)).WillByDefault([this](const std::string&) {
+            std::vector<nlohmann::json> batches;
+            for (const auto& inputs: embedding_batches) {
+                auto batch = nlohmann::json::array();
+                for (const auto& input: inputs) {
+                    batch.push_back(input.rfind("good", 0) == 0 ? nlohmann::json{1.0, 0.0, 0.0}
+                                                                : nlohmann::json{0.0, 1.0, 0.0});
+                }
+                batches.push_back(batch);
+            }
+            embedding_batches.clear();
+            return batches;
+        });
+        EXPECT_CALL(*mock_provider, AddEmbeddingRequest(::testing::_)).Times(::testing::AnyNumber());
+        EXPECT_CALL(*mock_provider, CollectEmbeddings(::testing::_)).Times(::testing::AnyNumber());
+    }
+
+    void TearDown() override {
+        Model::ResetMockProvider();
+    }
+
+    static ContextColumnBatch Rows() {
+        auto data = nlohmann::json::array();
+        for (size_t i = 0; i < ROW_COUNT; i++) {
+            data.push_back((i % 2 == 0 ? "good " : "bad ") + std::to_string(i));
+        }
+        return ContextColumnBatch::FromJson(nlohmann::json::array({{{"data", data}}}));
+    }
+
+    // Labels rows like the model would, counting how many it was asked about.
+    DistilledClassifier::ModelAnswers LabelBy(const std::function<nlohmann::json(const std::string&)>& label) {
+        return [this, label](const ContextColumnBatch& rows) {
+            auto answers = nlohmann::json::array();
+            for (idx_t row = 0; row < rows.row_count; row++) {
+                answers.push_back(label(rows.GetCell(0, row)));
+                labelled_rows++;
+            }
+            return answers;
+        };
+    }
+
+    static DistilledClassifier::Options Options() {
+        DistilledClassifier::Options options;
+        options.embedding_model = "text-embedding-3-small";
+        options.sample_size = 20;
+        options.holdout = 0.25;
+        options.target_accuracy = 0.9;
+        return options;
+    }
+};
+
+TEST_F(DistilledClassifierTest, SoftmaxClassifierSeparatesClusters) {
+    SoftmaxClassifier classifier;
+    classifier.Train({{1.0f, 0.0f, 0.0f}, {0.9f, 0.1f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.1f, 0.9f, 0.0f},
+                      {0.0f, 0.0f, 1.0f}, {0.0f, 0.1f, 0.9f}},
+                     {0, 0, 1, 1, 2, 2}, 3);
+    ASSERT_EQ(classifier.GetClassCount(), 3);
+
+    const auto first = classifier.Predict({0.95f, 0.05f, 0.0f});
+    EXPECT_GT(first[0], first[1]);
+    EXPECT_GT(first[0], first[2]);
+    const auto third = classifier.Predict({0.05f, 0.0f, 0.95f});
+    EXPECT_GT(third[2], third[0]);
+    EXPECT_GT(third[2], third[1]);
+    EXPECT_NEAR(third[0] + third[1] + third[2], 1.0f, 1e-5f);
+
+    EXPECT_THROW(classifier.Predict({1.0f, 0.0f}), std::runtime_error);
+}
+
+TEST_F(DistilledClassifierTest, AnswersUnlabelledRowsLocallyOnceCalibrated) {
+    DistilledClassifier classifier(Options());
+    const auto answers = classifier.Answer(Rows(), LabelBy([](const std::string& text) {
+                                               return nlohmann::json(text.rfind("good", 0) == 0);
+                                           }));
+
+    EXPECT_EQ(classifier.GetState(), DistilledClassifier::State::ACCEPTED);
+    EXPECT_EQ(labelled_rows, 20);
+    // The labelled sample for training, then only the rows left to score.
+    EXPECT_EQ(embedded_rows, ROW_COUNT);
+    ASSERT_EQ(answers.size(), ROW_COUNT);
+    for (size_t i = 0; i < ROW_COUNT; i++) {
+        EXPECT_EQ(answers[i], i % 2 == 0) << "row " << i;
+    }
+
+    // Later chunks are scored without labelling.
+    labelled_rows = 0;
+    const auto later_answers = classifier.Answer(Rows(), LabelBy([](const std::string&) { return nullptr; }));
+    EXPECT_EQ(labelled_rows, 0);
+    EXPECT_EQ(later_answers, answers);
+}
+
+TEST_F(DistilledClassifierTest, KeepsAskingTheModelWithoutTwoAnswers) {
+    DistilledClassifier classifier(Options());
+    const auto answers =
+            classifier.Answer(Rows(), LabelBy([](const std::string&) { return nlohmann::json("positive"); }));
+
+    EXPECT_EQ(classifier.GetState(), DistilledClassifier::State::REJECTED);
+    EXPECT_EQ(labelled_rows, ROW_COUNT);
+    EXPECT_EQ(embedded_rows, 0);
+    for (const auto& answer: answers) {
+        EXPECT_EQ(answer, "positive");
+    }
+}
+
+TEST_F(DistilledClassifierTest, SmallChunksAreAnsweredByTheModel) {
+    DistilledClassifier::Options options = Options();
+    options.sample_size = ROW_COUNT;
+    DistilledClassifier classifier(options);
+    classifier.Answer(Rows(), LabelBy([](const std::string&) { return nlohmann::json(true); }));
+
+    EXPECT_EQ(classifier.GetState(), DistilledClassifier::State::PENDING);
+    EXPECT_EQ(labelled_rows, ROW_COUNT);
+}
+
+TEST_F(DistilledClassifierTest, RejectsInvalidOptionsAtBind) {
+    auto con = Config::GetConnection();
+    EXPECT_TRUE(con.Query("SELECT llm_filter({'model_name': 'gpt-4o', 'classifier': {'sample_size': 100}}, "
+                          "{'prompt': 'Is it positive?', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+    EXPECT_TRUE(con.Query("SELECT llm_complete({'model_name': 'gpt-4o', "
+                          "'classifier': {'embedding_model': 'text-embedding-3-small', 'holdout': 1}}, "
+                          "{'prompt': 'Classify', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+    EXPECT_TRUE(con.Query("SELECT llm_filter({'model_name': 'gpt-4o', "
+                          "'classifier': {'embedding_model': 'text-embedding-3-small', 'sample_size': 2048}}, "
+                          "{'prompt': 'Is it positive?', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+}
+
+}// namespace flock
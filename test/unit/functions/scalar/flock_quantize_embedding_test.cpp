@@ -0,0 +1,52 @@
+#include "flock/core/config.hpp"
+#include "flock/functions/scalar/flock_quantize_embedding.hpp"
+#include <gtest/gtest.h>
+
+namespace flock {
+
+TEST(FlockQuantizeEmbedding, Int8StoresScaleAndRoundedCodes) {
+    const std::vector<float> values = {1.0f, -0.5f, 0.25f};
+    const auto blob = FlockQuantizeEmbedding::Quantize(values.data(), values.size(), EmbeddingEncoding::INT8);
+    ASSERT_EQ(blob.size(), FlockQuantizeEmbedding::HEADER_SIZE + 3);
+
+    const auto embedding = FlockQuantizeEmbedding::Parse(blob.data(), blob.size());
+    EXPECT_EQ(embedding.encoding, EmbeddingEncoding::INT8);
+    EXPECT_EQ(embedding.dims, 3);
+    EXPECT_FLOAT_EQ(embedding.scale, 1.0f / 127.0f);
+    const auto codes = reinterpret_cast<const int8_t*>(embedding.data);
+    EXPECT_EQ(codes[0], 127);
+    EXPECT_EQ(codes[1], -64);
+    EXPECT_EQ(codes[2], 32);
+}
+
+TEST(FlockQuantizeEmbedding, BinaryPacksSignBitsMostSignificantFirst) {
+    const std::vector<float> values = {1.0f, -1.0f, -1.0f, 2.0f, -3.0f, 0.5f, 0.1f, 0.0f, 4.0f};
+    const auto blob = FlockQuantizeEmbedding::Quantize(values.data(), values.size(), EmbeddingEncoding::BINARY);
+    ASSERT_EQ(blob.size(), FlockQuantizeEmbedding::HEADER_SIZE + 2);
+
+    const auto embedding = FlockQuantizeEmbedding::Parse(blob.data(), blob.size());
+    EXPECT_EQ(embedding.encoding, EmbeddingEncoding::BINARY);
+    EXPECT_EQ(embedding.dims, 9);
+    EXPECT_EQ(embedding.data[0], 0x96);
+    EXPECT_EQ(embedding.data[1], 0x80);
+}
+
+TEST(FlockQuantizeEmbedding, ParseRejectsForeignBlobs) {
+    const std::string blob = "\x07hello";
+    EXPECT_THROW(FlockQuantizeEmbedding::Parse(blob.data(), blob.size()), std::runtime_error);
+    EXPECT_THROW(FlockQuantizeEmbedding::Parse(blob.data(), 2), std::runtime_error);
+}
+
+TEST(FlockQuantizeEmbedding, SqlDefaultsToInt8AndRejectsUnknownEncodings) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT octet_length(flock_quantize_embedding([1.0, -0.5, 0.25]::FLOAT[])) AS int8, "
+                                   "octet_length(flock_quantize_embedding([1.0, -0.5, 0.25]::FLOAT[], 'binary')) AS binary;");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<int64_t>(), 8);
+    EXPECT_EQ(results->GetValue(1, 0).GetValue<int64_t>(), 6);
+
+    const auto rejected = con.Query("SELECT flock_quantize_embedding([1.0]::FLOAT[], 'int4');");
+    EXPECT_TRUE(rejected->HasError());
+}
+
+}// namespace flock
@@ -1,5 +1,9 @@
 #include "flock/functions/scalar/llm_complete.hpp"
+#include "flock/model_manager/inflight_budget.hpp"
+#include "flock/model_manager/request_executor.hpp"
+#include "flock/model_manager/result_cache.hpp"
 #include "llm_function_test_base.hpp"
+#include <atomic>
 
 namespace flock {
 
@@ -60,6 +64,25 @@ TEST_F(LLMCompleteTest, LLMCompleteWithoutInputColumns) {
     ASSERT_EQ(results->GetValue(0, 0).GetValue<std::string>(), GetExpectedResponse());
 }
 
+TEST_F(LLMCompleteTest, LLMCompleteSendsConstantPromptOncePerQuery) {
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, ::testing::_, ::testing::_))
+            .Times(2);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .Times(2)
+            .WillRepeatedly(::testing::Return(std::vector<nlohmann::json>{GetExpectedJsonResponse()}));
+
+    // Several chunks share one request; the next query asks again.
+    auto con = Config::GetConnection();
+    for (int query = 0; query < 2; query++) {
+        const auto results = con.Query("SELECT " + GetFunctionName() +
+                                       "({'model_name': 'gpt-4o'}, {'prompt': 'Explain the purpose of FlockMTL.'}) "
+                                       "AS flock_purpose FROM range(5000);");
+        ASSERT_FALSE(results->HasError()) << results->GetError();
+        ASSERT_EQ(results->RowCount(), 5000);
+        EXPECT_EQ(results->GetValue(0, 4999).GetValue<std::string>(), GetExpectedResponse());
+    }
+}
+
 TEST_F(LLMCompleteTest, LLMCompleteWithInputColumns) {
     const nlohmann::json expected_response = {{"items", {"The capital of Canada is Ottawa."}}};
     EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, ::testing::_, ::testing::_, ::testing::_))
@@ -73,6 +96,33 @@ TEST_F(LLMCompleteTest, LLMCompleteWithInputColumns) {
     ASSERT_EQ(results->GetValue(0, 0).GetValue<std::string>(), expected_response["items"][0]);
 }
 
+TEST_F(LLMCompleteTest, LLMCompleteTruncatesColumnsWithTokenBudget) {
+    const nlohmann::json expected_response = {{"items", {"Summary."}}};
+    std::string rendered_prompt;
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, ::testing::_, ::testing::_, ::testing::_))
+            .WillOnce(::testing::SaveArg<0>(&rendered_prompt));
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT " + GetFunctionName() + "({'model_name': 'gpt-4o'}, {'prompt': 'Summarize', 'context_columns': [{'data': ticket, 'max_tokens': 3, 'truncate': 'middle'}]}) AS summary FROM unnest(['alpha beta gamma delta epsilon']) as tbl(ticket);");
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    EXPECT_NE(rendered_prompt.find("[...]"), std::string::npos);
+    EXPECT_EQ(rendered_prompt.find("gamma"), std::string::npos);
+}
+
+TEST_F(LLMCompleteTest, LLMCompleteRejectsInvalidColumnTokenBudget) {
+    auto con = Config::GetConnection();
+    auto results = con.Query("SELECT " + GetFunctionName() + "({'model_name': 'gpt-4o'}, {'prompt': 'Summarize', 'context_columns': [{'data': ticket, 'max_tokens': 0}]}) FROM unnest(['text']) as tbl(ticket);");
+    ASSERT_TRUE(results->HasError());
+
+    results = con.Query("SELECT " + GetFunctionName() + "({'model_name': 'gpt-4o'}, {'prompt': 'Summarize', 'context_columns': [{'data': ticket, 'max_tokens': 10, 'truncate': 'start'}]}) FROM unnest(['text']) as tbl(ticket);");
+    ASSERT_TRUE(results->HasError());
+
+    results = con.Query("SELECT " + GetFunctionName() + "({'model_name': 'gpt-4o'}, {'prompt': 'Summarize', 'context_columns': [{'data': ticket, 'truncate': 'tail'}]}) FROM unnest(['text']) as tbl(ticket);");
+    ASSERT_TRUE(results->HasError());
+}
+
 TEST_F(LLMCompleteTest, ValidateArguments) {
     TestValidateArguments();
 }
@@ -213,6 +263,101 @@ TEST_F(LLMCompleteTest, Operation_AsyncLargeInputSet_CollectsOnceAndPreservesOrd
     }
 }
 
+TEST_F(LLMCompleteTest, Operation_AsyncSendsRoundInWavesOfHttpConcurrency) {
+    constexpr size_t input_count = 64;
+    const nlohmann::json batch_response = {{"items", std::vector<std::string>(16, "ok")}};
+
+    // Four batches of 16 rows go out as two waves of two requests each.
+    RequestExecutor::SetMaxConcurrency(2);
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 16, ::testing::_, ::testing::_))
+            .Times(4);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .Times(2)
+            .WillRepeatedly(::testing::Return(std::vector<nlohmann::json>{batch_response, batch_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT " + GetFunctionName() +
+                                   "({'model_name': 'gpt-4o', 'max_batch_size': 16, 'is_async': true}, "
+                                   "{'prompt': 'Summarize', 'context_columns': [{'data': 'Input text ' || i::VARCHAR}]}) "
+                                   "AS result FROM range(" +
+                                   std::to_string(input_count) + ") AS t(i);");
+    RequestExecutor::SetMaxConcurrency(RequestExecutor::DEFAULT_MAX_CONCURRENCY);
+
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), input_count);
+    for (size_t i = 0; i < input_count; i++) {
+        EXPECT_EQ(results->GetValue(0, i).GetValue<std::string>(), "ok");
+    }
+}
+
+TEST_F(LLMCompleteTest, Operation_AsyncKeepsAtMostTwoWavesInFlight) {
+    constexpr size_t input_count = 96;
+    const nlohmann::json batch_response = {{"items", std::vector<std::string>(16, "ok")}};
+
+    // Six batches of 16 rows go out as three waves of two; the third is only queued once the
+    // first has been collected.
+    RequestExecutor::SetMaxConcurrency(2);
+    std::atomic<int> collected_waves{0};
+    std::vector<int> collected_before_request;
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 16, ::testing::_, ::testing::_))
+            .Times(6)
+            .WillRepeatedly(::testing::InvokeWithoutArgs(
+                    [&]() { collected_before_request.push_back(collected_waves.load()); }));
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .Times(3)
+            .WillRepeatedly(::testing::InvokeWithoutArgs([&]() {
+                collected_waves++;
+                return std::vector<nlohmann::json>{batch_response, batch_response};
+            }));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT " + GetFunctionName() +
+                                   "({'model_name': 'gpt-4o', 'max_batch_size': 16, 'is_async': true}, "
+                                   "{'prompt': 'Summarize', 'context_columns': [{'data': 'Input text ' || i::VARCHAR}]}) "
+                                   "AS result FROM range(" +
+                                   std::to_string(input_count) + ") AS t(i);");
+    RequestExecutor::SetMaxConcurrency(RequestExecutor::DEFAULT_MAX_CONCURRENCY);
+
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(collected_before_request.size(), 6);
+    EXPECT_GE(collected_before_request[4], 1);
+    EXPECT_GE(collected_before_request[5], 1);
+    EXPECT_EQ(results->GetValue(0, input_count - 1).GetValue<std::string>(), "ok");
+}
+
+TEST_F(LLMCompleteTest, Operation_AsyncWaitsForWaveWhenInflightBudgetIsUsedUp) {
+    constexpr size_t input_count = 64;
+    const nlohmann::json batch_response = {{"items", std::vector<std::string>(16, "ok")}};
+
+    // With the budget used up, the first wave is collected before the second one is queued.
+    RequestExecutor::SetMaxConcurrency(2);
+    InflightBudget::SetMaxBytes(1);
+    auto held = InflightBudget::Acquire(1);
+    {
+        ::testing::InSequence waves;
+        for (int wave = 0; wave < 2; wave++) {
+            EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 16, ::testing::_, ::testing::_))
+                    .Times(2);
+            EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                    .WillOnce(::testing::Return(std::vector<nlohmann::json>{batch_response, batch_response}));
+        }
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT " + GetFunctionName() +
+                                   "({'model_name': 'gpt-4o', 'max_batch_size': 16, 'is_async': true}, "
+                                   "{'prompt': 'Summarize', 'context_columns': [{'data': 'Input text ' || i::VARCHAR}]}) "
+                                   "AS result FROM range(" +
+                                   std::to_string(input_count) + ") AS t(i);");
+    held.Release();
+    InflightBudget::SetMaxBytes(InflightBudget::DEFAULT_MAX_BYTES);
+    RequestExecutor::SetMaxConcurrency(RequestExecutor::DEFAULT_MAX_CONCURRENCY);
+
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), input_count);
+    EXPECT_EQ(results->GetValue(0, input_count - 1).GetValue<std::string>(), "ok");
+}
+
 TEST_F(LLMCompleteTest, Operation_AsyncRetriesWithSmallerBatchOnTokenOverflow) {
     constexpr size_t input_count = 100;
 
@@ -296,6 +441,130 @@ TEST_F(LLMCompleteTest, Operation_SyncNullsRowAndContinuesAfterTokenOverflowExha
     EXPECT_EQ(results->GetValue(0, 2).GetValue<std::string>(), "response 2");
 }
 
+TEST_F(LLMCompleteTest, Operation_SyncChunksOversizedRowWithLongInput) {
+    const nlohmann::json partial_response = {{"items", {"partial"}}};
+    const nlohmann::json combined_response = {{"items", {"combined"}}};
+    std::vector<std::string> chunk_prompts(2);
+
+    {
+        ::testing::InSequence sequence;
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, ::testing::_, ::testing::_));
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Throw(TokenLimitExceededError()));
+        // The row splits into two chunks, answered together, then combined.
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, ::testing::_, ::testing::_))
+                .WillOnce(::testing::SaveArg<0>(&chunk_prompts[0]))
+                .WillOnce(::testing::SaveArg<0>(&chunk_prompts[1]));
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{partial_response, partial_response}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::HasSubstr("partial"), 1, ::testing::_, ::testing::_));
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{combined_response}));
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "("
+                                            "{'model_name': 'gpt-4o', 'is_async': false, "
+                                            "'long_input': {'chunk_tokens': 4, 'overlap_tokens': 0}}, "
+                                            "{'prompt': 'Summarize', 'context_columns': [{'data': content}]}"
+                                            ") AS result FROM unnest(['alpha beta gamma delta epsilon']) AS tbl(content);");
+
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    ASSERT_EQ(results->RowCount(), 1);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "combined");
+    EXPECT_NE(chunk_prompts[0].find("alpha beta gamma"), std::string::npos);
+    EXPECT_EQ(chunk_prompts[0].find("epsilon"), std::string::npos);
+    EXPECT_NE(chunk_prompts[1].find("delta epsilon"), std::string::npos);
+}
+
+TEST_F(LLMCompleteTest, Operation_AsyncChunksOversizedRowWithLongInput) {
+    const nlohmann::json partial_response = {{"items", {"partial"}}};
+    const nlohmann::json combined_response = {{"items", {"combined"}}};
+
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, ::testing::_, ::testing::_))
+            .Times(4);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Throw(TokenLimitExceededError()))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{partial_response, partial_response}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{combined_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "("
+                                            "{'model_name': 'gpt-4o', 'is_async': true, "
+                                            "'long_input': {'chunk_tokens': 4, 'overlap_tokens': 0}}, "
+                                            "{'prompt': 'Summarize', 'context_columns': [{'data': content}]}"
+                                            ") AS result FROM unnest(['alpha beta gamma delta epsilon']) AS tbl(content);");
+
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    ASSERT_EQ(results->RowCount(), 1);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "combined");
+}
+
+TEST_F(LLMCompleteTest, Operation_SyncChunksRowAnsweredWithTokenLimitMarker) {
+    const nlohmann::json partial_response = {{"items", {"partial"}}};
+    const nlohmann::json combined_response = {{"items", {"combined"}}};
+
+    // Providers report the overflow as a marker, not an error; the sync path still chunks the row.
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, ::testing::_, ::testing::_))
+            .Times(4);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{TokenLimitExceededMarker()}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{partial_response, partial_response}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{combined_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "("
+                                            "{'model_name': 'gpt-4o', 'is_async': false, "
+                                            "'long_input': {'chunk_tokens': 4, 'overlap_tokens': 0}}, "
+                                            "{'prompt': 'Summarize', 'context_columns': [{'data': content}]}"
+                                            ") AS result FROM unnest(['alpha beta gamma delta epsilon']) AS tbl(content);");
+
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    ASSERT_EQ(results->RowCount(), 1);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "combined");
+}
+
+TEST_F(LLMCompleteTest, Operation_LongInputMapsChunksInWavesOfHttpConcurrency) {
+    const nlohmann::json partial_response = {{"items", {"partial"}}};
+    const nlohmann::json combined_response = {{"items", {"combined"}}};
+
+    // Two oversized rows of two chunks each: the four chunks are mapped in two waves of two.
+    RequestExecutor::SetMaxConcurrency(2);
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, ::testing::_, ::testing::_))
+            .Times(8);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Throw(TokenLimitExceededError()))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{partial_response, partial_response}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{partial_response, partial_response}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{combined_response, combined_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "("
+                                            "{'model_name': 'gpt-4o', 'is_async': true, 'max_batch_size': 1, "
+                                            "'long_input': {'chunk_tokens': 4, 'overlap_tokens': 0}}, "
+                                            "{'prompt': 'Summarize', 'context_columns': [{'data': content}]}"
+                                            ") AS result FROM unnest(['alpha beta gamma delta epsilon', "
+                                            "'zeta eta theta iota kappa']) AS tbl(content);");
+    RequestExecutor::SetMaxConcurrency(RequestExecutor::DEFAULT_MAX_CONCURRENCY);
+
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    ASSERT_EQ(results->RowCount(), 2);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "combined");
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "combined");
+}
+
+TEST_F(LLMCompleteTest, LLMCompleteRejectsInvalidLongInput) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT " + GetFunctionName() +
+                                   "({'model_name': 'gpt-4o', 'long_input': {'chunk_tokens': 100, 'overlap_tokens': 80}}, "
+                                   "{'prompt': 'Summarize', 'context_columns': [{'data': 'text'}]});");
+    ASSERT_TRUE(results->HasError());
+}
+
 TEST_F(LLMCompleteTest, Operation_SyncHalvesBatchAndRetriesBeforeSuccess) {
     nlohmann::json first_half_response = {{"items", {"response 0", "response 1"}}};
     nlohmann::json second_half_response = {{"items", {"response 2", "response 3"}}};
@@ -469,6 +738,50 @@ TEST_F(LLMCompleteTest, LLMCompleteWithAudioAndText) {
     ASSERT_EQ(results->RowCount(), 1);
 }
 
+TEST_F(LLMCompleteTest, LLMCompleteServesRepeatedRowsFromCache) {
+    ResultCache::Clear();
+    const nlohmann::json expected_response = {{"items", {"Positive", "Negative"}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, ::testing::_, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const std::string query =
+            "SELECT " + GetFunctionName() + "({'model_name': 'gpt-4o', 'cache': 'readwrite'}, "
+            "{'prompt': 'What is the sentiment?', 'context_columns': [{'data': text}]}) AS result "
+            "FROM unnest(['I love it', 'I hate it']) AS tbl(text);";
+    for (int run = 0; run < 2; run++) {
+        const auto results = con.Query(query);
+        ASSERT_FALSE(results->HasError()) << results->GetError();
+        ASSERT_EQ(results->RowCount(), 2);
+        EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "Positive");
+        EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "Negative");
+    }
+    ResultCache::Clear();
+}
+
+TEST_F(LLMCompleteTest, LLMCompleteSendsDistinctRowsOnceAndSkipsEmptyRows) {
+    const nlohmann::json expected_response = {{"items", {"Positive", "Negative"}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, ::testing::_, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "({'model_name': 'gpt-4o', 'empty_input_default': 'n/a'}, "
+            "{'prompt': 'What is the sentiment?', 'context_columns': [{'data': text}]}) AS result "
+            "FROM unnest(['I love it', 'I hate it', 'I love it', '', NULL]) AS tbl(text);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 5);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "Positive");
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "Negative");
+    EXPECT_EQ(results->GetValue(0, 2).GetValue<std::string>(), "Positive");
+    EXPECT_EQ(results->GetValue(0, 3).GetValue<std::string>(), "n/a");
+    EXPECT_EQ(results->GetValue(0, 4).GetValue<std::string>(), "n/a");
+}
+
 // Test audio transcription error handling
 TEST_F(LLMCompleteTest, LLMCompleteAudioTranscriptionError) {
     auto con = Config::GetConnection();
@@ -507,4 +820,44 @@ TEST_F(LLMCompleteTest, LLMCompleteAudioMissingTranscriptionModel) {
     ASSERT_TRUE(results->HasError());
 }
 
+TEST_F(LLMCompleteTest, LLMCompleteReturnsStructFromResponseSchema) {
+    const nlohmann::json expected_response = {
+            {"items", {{{"name", "Laptop"}, {"price", 999.5}}, {{"name", "Phone"}, {"price", "599"}}}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::STRING, ::testing::_)).Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT product.name, product.price FROM (SELECT llm_complete("
+            "{'model_name': 'gpt-4o', 'returns': 'schema', 'model_parameters': '{\"response_format\": "
+            "{\"strict\": true, \"json_schema\": {\"schema\": {\"type\": \"object\", \"properties\": "
+            "{\"name\": {\"type\": \"string\"}, \"price\": {\"type\": \"number\"}}}}}}'}, "
+            "{'prompt': 'Extract the product', 'context_columns': [{'data': text}]}) AS product "
+            "FROM unnest(['A laptop for 999.5', 'A phone for 599']) AS tbl(text));");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 2);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "Laptop");
+    EXPECT_DOUBLE_EQ(results->GetValue(1, 0).GetValue<double>(), 999.5);
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "Phone");
+    EXPECT_DOUBLE_EQ(results->GetValue(1, 1).GetValue<double>(), 599.0);
+}
+
+TEST_F(LLMCompleteTest, LLMCompleteReturnsNullForAnswersOfAnotherType) {
+    const nlohmann::json expected_response = {{"items", {"42", "many"}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::STRING, ::testing::_)).Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_complete({'model_name': 'gpt-4o', 'returns': 'integer'}, "
+            "{'prompt': 'How many items are listed?', 'context_columns': [{'data': text}]}) AS item_count "
+            "FROM unnest(['a, b', 'lots of things']) AS tbl(text);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->types[0], duckdb::LogicalType::BIGINT);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<int64_t>(), 42);
+    EXPECT_TRUE(results->GetValue(0, 1).IsNull());
+}
+
 }// namespace flock
@@ -190,4 +190,54 @@ TEST_F(LLMEmbeddingTest, Operation_DefaultBatchSizeSplitsLargeInput) {
     ASSERT_EQ(results->GetValue(0, DEFAULT_MAX_BATCH_SIZE).type().id(), duckdb::LogicalTypeId::LIST);
 }
 
+TEST_F(LLMEmbeddingTest, LLMEmbeddingReturnsFloatArrayFromBase64) {
+    // Little-endian float32 [1, 2, 3] and [0.5, -1, 0.25], as sent with encoding_format=base64.
+    const nlohmann::json expected_response = nlohmann::json::array({"AACAPwAAAEAAAEBA", "AAAAPwAAgL8AAIA+"});
+    EXPECT_CALL(*mock_provider, AddEmbeddingRequest(::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectEmbeddings(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "({'model_name': 'text-embedding-3-small', 'returns': 'float', "
+                                            "'model_parameters': '{\"dimensions\": 3}'}, "
+                                            "{'context_columns': [{'data': text}]}) AS embedding "
+                                            "FROM unnest(['first', 'second']) AS tbl(text);");
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    ASSERT_EQ(results->RowCount(), 2);
+    ASSERT_EQ(results->types[0], duckdb::LogicalType::ARRAY(duckdb::LogicalType::FLOAT, 3));
+
+    const auto second = duckdb::ArrayValue::GetChildren(results->GetValue(0, 1));
+    ASSERT_EQ(second.size(), 3);
+    EXPECT_FLOAT_EQ(second[0].GetValue<float>(), 0.5f);
+    EXPECT_FLOAT_EQ(second[1].GetValue<float>(), -1.0f);
+    EXPECT_FLOAT_EQ(second[2].GetValue<float>(), 0.25f);
+}
+
+TEST_F(LLMEmbeddingTest, LLMEmbeddingFloatArrayRejectsWrongDimensions) {
+    const nlohmann::json expected_response = nlohmann::json::array({{0.1, 0.2, 0.3, 0.4, 0.5}});
+    EXPECT_CALL(*mock_provider, AddEmbeddingRequest(::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectEmbeddings(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "({'model_name': 'text-embedding-3-small', 'returns': 'float', "
+                                            "'model_parameters': '{\"dimensions\": 3}'}, "
+                                            "{'context_columns': [{'data': 'text'}]}) AS embedding;");
+    ASSERT_TRUE(results->HasError());
+    EXPECT_NE(results->GetError().find("expected 3 dimensions"), std::string::npos);
+}
+
+TEST_F(LLMEmbeddingTest, LLMEmbeddingFloatArrayRequiresDimensions) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "({'model_name': 'text-embedding-3-small', 'returns': 'float'}, "
+                                            "{'context_columns': [{'data': 'text'}]}) AS embedding;");
+    ASSERT_TRUE(results->HasError());
+    EXPECT_NE(results->GetError().find("model_parameters.dimensions"), std::string::npos);
+}
+
 }// namespace flock
@@ -1,5 +1,6 @@
 #include "flock/functions/scalar/llm_filter.hpp"
 #include "llm_function_test_base.hpp"
+#include <sstream>
 
 namespace flock {
 
@@ -213,6 +214,55 @@ TEST_F(LLMFilterTest, Operation_AsyncQueuesBooleanBatchesBeforeSingleCollect) {
     }
 }
 
+TEST_F(LLMFilterTest, Operation_CompactEncodingDecodesBitstring) {
+    const nlohmann::json compact_response = {{"items", {"TFT"}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 3, OutputType::BITSTRING, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{compact_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "("
+                                            "{'model_name': 'gpt-4o', 'output_encoding': 'compact'}, "
+                                            "{'prompt': 'Is this content relevant?', 'context_columns': [{'data': content}]}"
+                                            ") AS result FROM unnest(['a', 'b', 'c']) AS tbl(content);");
+
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    ASSERT_EQ(results->RowCount(), 3);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "true");
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "false");
+    EXPECT_EQ(results->GetValue(0, 2).GetValue<std::string>(), "true");
+}
+
+TEST_F(LLMFilterTest, Operation_CompactEncodingFallsBackToJsonOnMismatch) {
+    const nlohmann::json short_compact_response = {{"items", {"TF"}}};
+    const nlohmann::json json_response = {{"items", {false, false, true}}};
+    {
+        ::testing::InSequence sequence;
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 3, OutputType::BITSTRING, ::testing::_))
+                .Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{short_compact_response}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 3, OutputType::BOOL, ::testing::_))
+                .Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{json_response}));
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT " + GetFunctionName() + "("
+                                            "{'model_name': 'gpt-4o', 'output_encoding': 'compact'}, "
+                                            "{'prompt': 'Is this content relevant?', 'context_columns': [{'data': content}]}"
+                                            ") AS result FROM unnest(['a', 'b', 'c']) AS tbl(content);");
+
+    ASSERT_TRUE(!results->HasError()) << "Query failed: " << results->GetError();
+    ASSERT_EQ(results->RowCount(), 3);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "false");
+    EXPECT_EQ(results->GetValue(0, 2).GetValue<std::string>(), "true");
+}
+
 // Test llm_filter with audio transcription
 TEST_F(LLMFilterTest, LLMFilterWithAudioTranscription) {
     const nlohmann::json expected_transcription = "{\"text\": \"This audio contains positive sentiment\"}";
@@ -299,4 +349,207 @@ TEST_F(LLMFilterTest, LLMFilterAudioTranscriptionOllamaError) {
     ASSERT_TRUE(results->HasError());
 }
 
+TEST_F(LLMFilterTest, LLMFilterReturnsBooleanForWhereClauses) {
+    const nlohmann::json expected_response = {{"items", {true, false}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::BOOL, ::testing::_)).Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{expected_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT review FROM unnest(['Great product!', 'Terrible quality']) AS tbl(review) "
+            "WHERE llm_filter({'model_name': 'gpt-4o', 'returns': 'boolean'}, "
+            "{'prompt': 'Is this review positive?', 'context_columns': [{'data': review}]});");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 1);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "Great product!");
+}
+
+TEST_F(LLMFilterTest, LLMFilterRejectsUnsupportedReturns) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_filter({'model_name': 'gpt-4o', 'returns': 'integer'}, {'prompt': 'Is it positive?'});");
+    EXPECT_TRUE(results->HasError());
+}
+
+TEST_F(LLMFilterTest, CascadeEscalatesOnlyUncertainRows) {
+    const nlohmann::json first_stage_response = {{"items",
+                                                  {{{"keep", true}, {"confidence", 0.95}},
+                                                   {{"keep", false}, {"confidence", 0.4}},
+                                                   {{"keep", false}, {"confidence", 0.99}}}}};
+    const nlohmann::json cascade_response = {{"items", {true}}};
+    {
+        ::testing::InSequence sequence;
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 3, OutputType::OBJECT, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{first_stage_response}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::BOOL, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{cascade_response}));
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_filter({'model_name': 'gpt-4o-mini', 'cascade': {'model_name': 'gpt-4o', 'threshold': 0.9}}, "
+            "{'prompt': 'Is this review positive?', 'context_columns': [{'data': review}]}) AS result "
+            "FROM unnest(['Great!', 'Fine, I guess', 'Awful']) AS tbl(review);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 3);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "true");
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "true");
+    EXPECT_EQ(results->GetValue(0, 2).GetValue<std::string>(), "false");
+}
+
+TEST_F(LLMFilterTest, CascadeSkipsSecondModelWhenAllRowsAreConfident) {
+    const nlohmann::json first_stage_response = {
+            {"items", {{{"keep", true}, {"confidence", 0.9}}, {{"keep", false}, {"confidence", 0.85}}}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::OBJECT, ::testing::_)).Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{first_stage_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_filter({'model_name': 'gpt-4o-mini', 'cascade': {'model_name': 'gpt-4o'}}, "
+            "{'prompt': 'Is this review positive?', 'context_columns': [{'data': review}]}) AS result "
+            "FROM unnest(['Great!', 'Awful']) AS tbl(review);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 2);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "true");
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "false");
+}
+
+TEST_F(LLMFilterTest, CascadeRejectsInvalidOptions) {
+    auto con = Config::GetConnection();
+    EXPECT_TRUE(con.Query("SELECT llm_filter({'model_name': 'gpt-4o-mini', 'cascade': {'model_name': 'gpt-4o', 'threshold': 1.5}}, "
+                          "{'prompt': 'Is it positive?', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+    EXPECT_TRUE(con.Query("SELECT llm_complete({'model_name': 'gpt-4o-mini', 'cascade': {'model_name': 'gpt-4o'}}, "
+                          "{'prompt': 'Summarize', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+}
+
+TEST_F(LLMFilterTest, DistillAnswersRemainingRowsWithAgreeingExpression) {
+    const nlohmann::json labels_response = {{"items", {true, true, true, true}}};
+    const nlohmann::json pattern_response = {{"items", {"(?i)refund"}}};
+    {
+        ::testing::InSequence sequence;
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 4, OutputType::BOOL, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{labels_response}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::STRING, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{pattern_response}));
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_filter({'model_name': 'gpt-4o', 'distill': {'sample_size': 4}}, "
+            "{'prompt': 'Does the message ask for a refund?', 'context_columns': [{'data': message}]}) AS result "
+            "FROM range(6) AS t(i), unnest(['Refund request #' || i::VARCHAR]) AS tbl(message);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 6);
+    for (idx_t row = 0; row < 6; row++) {
+        EXPECT_EQ(results->GetValue(0, row).GetValue<std::string>(), "true");
+    }
+}
+
+TEST_F(LLMFilterTest, DistillFallsBackToModelWhenExpressionDisagrees) {
+    const nlohmann::json labels_response = {{"items", {false, false, false, false}}};
+    const nlohmann::json pattern_response = {{"items", {"(?i)refund"}}};
+    const nlohmann::json remaining_response = {{"items", {false, false}}};
+    {
+        ::testing::InSequence sequence;
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 4, OutputType::BOOL, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{labels_response}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::STRING, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{pattern_response}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::BOOL, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{remaining_response}));
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_filter({'model_name': 'gpt-4o', 'distill': {'sample_size': 4, 'agreement': 0.9}}, "
+            "{'prompt': 'Is the message angry?', 'context_columns': [{'data': message}]}) AS result "
+            "FROM range(6) AS t(i), unnest(['Refund request #' || i::VARCHAR]) AS tbl(message);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 6);
+    for (idx_t row = 0; row < 6; row++) {
+        EXPECT_EQ(results->GetValue(0, row).GetValue<std::string>(), "false");
+    }
+}
+
+TEST_F(LLMFilterTest, DistillRejectsExpressionThatOnlyListsTheExamples) {
+    const nlohmann::json labels_response = {{"items", {true, true, true, true}}};
+    const nlohmann::json remaining_response = {{"items", {true, true}}};
+    std::string pattern_prompt;
+    {
+        ::testing::InSequence sequence;
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 4, OutputType::BOOL, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{labels_response}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::STRING, ::testing::_))
+                .WillOnce(::testing::SaveArg<0>(&pattern_prompt));
+        // The expression matches exactly the example texts listed in the prompt.
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_)).WillOnce(::testing::Invoke([&](const std::string&) {
+            std::string pattern;
+            std::istringstream lines(pattern_prompt);
+            for (std::string line; std::getline(lines, line);) {
+                if (line.rfind("- ", 0) == 0) {
+                    pattern += (pattern.empty() ? "^(" : "|") + nlohmann::json::parse(line.substr(2)).get<std::string>();
+                }
+            }
+            return std::vector<nlohmann::json>{{{"items", {pattern + ")$"}}}};
+        }));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::BOOL, ::testing::_)).Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{remaining_response}));
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_filter({'model_name': 'gpt-4o', 'distill': {'sample_size': 4}}, "
+            "{'prompt': 'Does the message ask for a refund?', 'context_columns': [{'data': message}]}) AS result "
+            "FROM range(6) AS t(i), unnest(['Refund request #' || i::VARCHAR]) AS tbl(message);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 6);
+    for (idx_t row = 0; row < 6; row++) {
+        EXPECT_EQ(results->GetValue(0, row).GetValue<std::string>(), "true");
+    }
+}
+
+TEST_F(LLMFilterTest, DistillFalseSendsEveryRowToTheModel) {
+    const nlohmann::json response = {{"items", {true, false, true}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 3, OutputType::BOOL, ::testing::_)).Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_filter({'model_name': 'gpt-4o', 'distill': false}, "
+            "{'prompt': 'Does the message ask for a refund?', 'context_columns': [{'data': message}]}) AS result "
+            "FROM range(3) AS t(i), unnest(['Refund request #' || i::VARCHAR]) AS tbl(message);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 3);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "true");
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "false");
+    EXPECT_EQ(results->GetValue(0, 2).GetValue<std::string>(), "true");
+}
+
+TEST_F(LLMFilterTest, DistillRejectsInvalidOptions) {
+    auto con = Config::GetConnection();
+    EXPECT_TRUE(con.Query("SELECT llm_filter({'model_name': 'gpt-4o', 'distill': {'agreement': 0}}, "
+                          "{'prompt': 'Is it positive?', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+    EXPECT_TRUE(con.Query("SELECT llm_filter({'model_name': 'gpt-4o', 'distill': {'sample_size': 2048}}, "
+                          "{'prompt': 'Is it positive?', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+    EXPECT_TRUE(con.Query("SELECT llm_complete({'model_name': 'gpt-4o', 'distill': true}, "
+                          "{'prompt': 'Summarize', 'context_columns': [{'data': 'text'}]});")
+                        ->HasError());
+}
+
 }// namespace flock
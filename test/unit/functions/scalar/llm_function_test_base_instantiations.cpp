@@ -16,6 +16,8 @@ void LLMFunctionTestBase<FunctionClass>::SetUp() {
               "       TYPE OLLAMA,"
               "    API_URL '127.0.0.1:11434');");
 
+    // Batch sizes learned by earlier tests would change the expected request sizes.
+    BatchSizeController::Reset();
     mock_provider = std::make_shared<MockProvider>(ModelDetails{});
     Model::SetMockProvider(mock_provider);
 }
@@ -0,0 +1,146 @@
+#include "../mock_provider.hpp"
+#include "flock/core/config.hpp"
+#include "flock/functions/scalar/llm_fused.hpp"
+#include "flock/model_manager/model.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace flock {
+
+class LlmFusedTest : public ::testing::Test {
+protected:
+    std::shared_ptr<MockProvider> mock_provider;
+
+    void SetUp() override {
+        auto con = Config::GetConnection();
+        con.Query(" CREATE SECRET ("
+                  "       TYPE OPENAI,"
+                  "    API_KEY 'your-api-key');");
+
+        mock_provider = std::make_shared<MockProvider>(ModelDetails{});
+        Model::SetMockProvider(mock_provider);
+    }
+
+    void TearDown() override {
+        Model::ResetMockProvider();
+    }
+};
+
+TEST_F(LlmFusedTest, BuildFusedPromptListsEveryTask) {
+    const std::vector<FusedTask> tasks = {{"Summarize the review", ScalarFunctionType::COMPLETE},
+                                          {"Is this spam?", ScalarFunctionType::FILTER}};
+    const auto prompt = LlmFused::BuildFusedPrompt(tasks);
+    EXPECT_NE(prompt.find("- task_0 (text answer): Summarize the review"), std::string::npos);
+    EXPECT_NE(prompt.find("- task_1 (true or false): Is this spam?"), std::string::npos);
+
+    const auto schema = LlmFused::BuildItemSchema(tasks);
+    EXPECT_EQ(schema["properties"]["task_0"]["type"], "string");
+    EXPECT_EQ(schema["properties"]["task_1"]["type"], "boolean");
+    EXPECT_EQ(schema["required"], nlohmann::json::array({"task_0", "task_1"}));
+}
+
+TEST_F(LlmFusedTest, SplitResponsesFormatsLikeUnfusedCalls) {
+    const std::vector<FusedTask> tasks = {{"Summarize", ScalarFunctionType::COMPLETE},
+                                          {"Is it positive?", ScalarFunctionType::FILTER}};
+    const nlohmann::json first_row = {{"task_0", "Great"}, {"task_1", true}};
+    const nlohmann::json second_row = {{"task_0", "Bad"}, {"task_1", "False"}};
+    const nlohmann::json responses = nlohmann::json::array({first_row, second_row, nullptr});
+
+    const auto results = LlmFused::SplitResponses(responses, tasks);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0], (std::vector<std::string>{"Great", "Bad", "null"}));
+    EXPECT_EQ(results[1], (std::vector<std::string>{"true", "false", "true"}));
+}
+
+TEST_F(LlmFusedTest, SiblingCallsShareOneRequest) {
+    const nlohmann::json first_row = {{"task_0", "Positive"}, {"task_1", false}};
+    const nlohmann::json second_row = {{"task_0", "Negative"}, {"task_1", true}};
+    const nlohmann::json response = {{"items", {first_row, second_row}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::OBJECT, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_complete({'model_name': 'gpt-4o'}, {'prompt': 'What is the sentiment?', 'context_columns': [{'data': text}]}) AS sentiment, "
+            "llm_filter({'model_name': 'gpt-4o'}, {'prompt': 'Is this spam?', 'context_columns': [{'data': text}]}) AS is_spam "
+            "FROM unnest(['I love this product!', 'Buy cheap watches now']) AS tbl(text);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 2);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "Positive");
+    EXPECT_EQ(results->GetValue(1, 0).GetValue<std::string>(), "false");
+    EXPECT_EQ(results->GetValue(0, 1).GetValue<std::string>(), "Negative");
+    EXPECT_EQ(results->GetValue(1, 1).GetValue<std::string>(), "true");
+}
+
+TEST_F(LlmFusedTest, CallsOverDifferentColumnsAreNotFused) {
+    const nlohmann::json complete_response = {{"items", {"Positive"}}};
+    const nlohmann::json filter_response = {{"items", {true}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::STRING, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::BOOL, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{complete_response}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{filter_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_complete({'model_name': 'gpt-4o'}, {'prompt': 'What is the sentiment?', 'context_columns': [{'data': review}]}) AS sentiment, "
+            "llm_filter({'model_name': 'gpt-4o'}, {'prompt': 'Is this spam?', 'context_columns': [{'data': title}]}) AS is_spam "
+            "FROM (VALUES ('I love this product!', 'Great buy')) AS tbl(review, title);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 1);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "Positive");
+    EXPECT_EQ(results->GetValue(1, 0).GetValue<std::string>(), "true");
+}
+
+TEST_F(LlmFusedTest, CallsWithUserResponseFormatAreNotFused) {
+    const nlohmann::json complete_response = {{"items", {{{"sentiment", "positive"}}}}};
+    const nlohmann::json filter_response = {{"items", {false}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::STRING, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::BOOL, ::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, ::testing::_, OutputType::OBJECT, ::testing::_))
+            .Times(0);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{complete_response}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{filter_response}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT llm_complete({'model_name': 'gpt-4o', 'model_parameters': '{\"response_format\": {\"type\": \"json_schema\", "
+            "\"json_schema\": {\"schema\": {\"type\": \"object\", \"properties\": {\"sentiment\": {\"type\": \"string\"}}}}}}'}, "
+            "{'prompt': 'What is the sentiment?', 'context_columns': [{'data': text}]}) AS sentiment, "
+            "llm_filter({'model_name': 'gpt-4o', 'model_parameters': '{\"response_format\": {\"type\": \"json_schema\", "
+            "\"json_schema\": {\"schema\": {\"type\": \"object\", \"properties\": {\"sentiment\": {\"type\": \"string\"}}}}}}'}, "
+            "{'prompt': 'Is this spam?', 'context_columns': [{'data': text}]}) AS is_spam "
+            "FROM unnest(['I love this product!']) AS tbl(text);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 1);
+    EXPECT_EQ(results->GetValue(1, 0).GetValue<std::string>(), "false");
+}
+
+TEST_F(LlmFusedTest, FusionCanBeDisabled) {
+    const nlohmann::json complete_response = {{"items", {"Positive"}}};
+    const nlohmann::json filter_response = {{"items", {false}}};
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, ::testing::_, ::testing::_, ::testing::_))
+            .Times(2);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{complete_response}))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{filter_response}));
+
+    auto con = Config::GetConnection();
+    con.Query("SET flock_fuse_llm_calls = false;");
+    const auto results = con.Query(
+            "SELECT llm_complete({'model_name': 'gpt-4o'}, {'prompt': 'What is the sentiment?', 'context_columns': [{'data': text}]}) AS sentiment, "
+            "llm_filter({'model_name': 'gpt-4o'}, {'prompt': 'Is this spam?', 'context_columns': [{'data': text}]}) AS is_spam "
+            "FROM unnest(['I love this product!']) AS tbl(text);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "Positive");
+    EXPECT_EQ(results->GetValue(1, 0).GetValue<std::string>(), "false");
+}
+
+}// namespace flock
@@ -31,13 +31,13 @@ nlohmann::json MakeModelJson(bool is_async, const std::string& model_name = "rat
             {"secret", {{"api_key", "test-key"}}}};
 }
 
-nlohmann::json MakeTuples(int row_count) {
+ContextColumnBatch MakeTuples(int row_count) {
     nlohmann::json data = nlohmann::json::array();
     for (int i = 0; i < row_count; i++) {
         data.push_back("row-" + std::to_string(i));
     }
 
-    return nlohmann::json::array({{{"name", "content"}, {"data", data}}});
+    return ContextColumnBatch::FromJson(nlohmann::json::array({{{"name", "content"}, {"data", data}}}));
 }
 
 std::shared_ptr<RateLimitAwareProvider> g_last_rate_limit_provider;
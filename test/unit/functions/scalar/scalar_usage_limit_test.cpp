@@ -28,13 +28,13 @@ nlohmann::json MakeModelJson(const std::string& model_name, int total_tokens_lim
 
 constexpr const char* kUsageLimitModelName = "gpt-4o-test";
 
-nlohmann::json MakeTuples(int row_count) {
+ContextColumnBatch MakeTuples(int row_count) {
     nlohmann::json data = nlohmann::json::array();
     for (int i = 0; i < row_count; i++) {
         data.push_back("row-" + std::to_string(i));
     }
 
-    return nlohmann::json::array({{{"name", "content"}, {"data", data}}});
+    return ContextColumnBatch::FromJson(nlohmann::json::array({{{"name", "content"}, {"data", data}}}));
 }
 
 std::shared_ptr<UsageLimitAwareProvider> g_last_usage_limit_provider;
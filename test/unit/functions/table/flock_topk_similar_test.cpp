@@ -0,0 +1,99 @@
+#include "flock/core/config.hpp"
+#include "flock/core/vector_math.hpp"
+#include "flock/functions/table/flock_topk_similar.hpp"
+#include <gtest/gtest.h>
+
+namespace flock {
+
+class FlockTopkSimilarTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto con = Config::GetConnection();
+        con.Query("DROP TABLE IF EXISTS topk_docs;");
+        con.Query("CREATE TABLE topk_docs AS SELECT * FROM (VALUES "
+                  "(1, 'north', [1.0, 0.0, 0.0, 0.0]::FLOAT[]), "
+                  "(2, 'north-east', [0.7, 0.7, 0.0, 0.0]::FLOAT[]), "
+                  "(3, 'east', [0.0, 1.0, 0.0, 0.0]::FLOAT[]), "
+                  "(4, 'south', [-1.0, 0.0, 0.0, 0.0]::FLOAT[]), "
+                  "(5, 'north, long', [3.0, 0.3, 0.0, 0.0]::FLOAT[])) AS t(id, name, embedding);");
+    }
+
+    void TearDown() override {
+        Config::GetConnection().Query("DROP TABLE IF EXISTS topk_docs;");
+    }
+
+    static std::vector<int32_t> Ids(duckdb::MaterializedQueryResult& results) {
+        std::vector<int32_t> ids;
+        for (idx_t row = 0; row < results.RowCount(); row++) {
+            ids.push_back(results.GetValue(0, row).GetValue<int32_t>());
+        }
+        return ids;
+    }
+};
+
+TEST_F(FlockTopkSimilarTest, ReturnsRowsBestFirstByCosine) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT id, name, score FROM flock_topk_similar([1.0, 0.1, 0.0, 0.0], 'topk_docs', 3);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(Ids(*results), (std::vector<int32_t>{5, 1, 2}));
+    EXPECT_EQ(results->GetValue(1, 1).GetValue<std::string>(), "north");
+    EXPECT_NEAR(results->GetValue(2, 0).GetValue<double>(), 1.0, 1e-5);
+}
+
+TEST_F(FlockTopkSimilarTest, DotMetricFavorsLongVectors) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT id, score FROM flock_topk_similar([0.0, 1.0, 0.0, 0.0], 'topk_docs', 2, metric := 'dot');");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(Ids(*results), (std::vector<int32_t>{3, 2}));
+    EXPECT_NEAR(results->GetValue(1, 1).GetValue<double>(), 0.7, 1e-5);
+}
+
+TEST_F(FlockTopkSimilarTest, ScoresInt8EmbeddingsLikeFloats) {
+    auto con = Config::GetConnection();
+    con.Query("ALTER TABLE topk_docs ADD COLUMN embedding_int8 BLOB;");
+    con.Query("UPDATE topk_docs SET embedding_int8 = flock_quantize_embedding(embedding);");
+    const auto results = con.Query("SELECT id FROM flock_topk_similar([1.0, 0.1, 0.0, 0.0], 'topk_docs', 3, "
+                                   "column := 'embedding_int8');");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(Ids(*results), (std::vector<int32_t>{5, 1, 2}));
+}
+
+TEST_F(FlockTopkSimilarTest, RescoresBinaryCandidatesWithFullPrecision) {
+    auto con = Config::GetConnection();
+    con.Query("ALTER TABLE topk_docs ADD COLUMN embedding_bits BLOB;");
+    con.Query("UPDATE topk_docs SET embedding_bits = flock_quantize_embedding(embedding, 'binary');");
+    // The sign bits tie ids 2 and 5 and put id 1 behind them; rescoring with the floats restores the order.
+    const auto results = con.Query("SELECT id, score FROM flock_topk_similar([1.0, 0.1, 0.0, 0.0], 'topk_docs', 2, "
+                                   "column := 'embedding_bits', rescore := 'embedding');");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(Ids(*results), (std::vector<int32_t>{5, 1}));
+}
+
+TEST_F(FlockTopkSimilarTest, RejectsUnknownMetricsAndMismatchedDimensions) {
+    auto con = Config::GetConnection();
+    EXPECT_TRUE(con.Query("SELECT * FROM flock_topk_similar([1.0, 0.0, 0.0, 0.0], 'topk_docs', 1, metric := 'l2');")
+                        ->HasError());
+    EXPECT_TRUE(con.Query("SELECT * FROM flock_topk_similar([1.0, 0.0], 'topk_docs', 1);")->HasError());
+}
+
+TEST(VectorMathKernels, MatchScalarReferences) {
+    std::vector<int8_t> left(77), right(77);
+    std::vector<uint8_t> left_bits(45), right_bits(45);
+    int32_t dot = 0;
+    uint32_t distance = 0;
+    for (size_t i = 0; i < left.size(); i++) {
+        left[i] = static_cast<int8_t>((i * 37) % 255 - 127);
+        right[i] = static_cast<int8_t>(127 - (i * 53) % 255);
+        dot += left[i] * right[i];
+    }
+    for (size_t i = 0; i < left_bits.size(); i++) {
+        left_bits[i] = static_cast<uint8_t>(i * 29);
+        right_bits[i] = static_cast<uint8_t>(i * 71 + 3);
+        distance += __builtin_popcount(left_bits[i] ^ right_bits[i]);
+    }
+    EXPECT_EQ(VectorMath::DotInt8(left.data(), right.data(), left.size()), dot);
+    EXPECT_EQ(VectorMath::Hamming(left_bits.data(), right_bits.data(), left_bits.size()), distance);
+}
+
+}// namespace flock
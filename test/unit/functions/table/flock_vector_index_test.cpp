@@ -0,0 +1,95 @@
+#include "../mock_provider.hpp"
+#include "flock/core/config.hpp"
+#include "flock/functions/table/flock_vector_index.hpp"
+#include "flock/model_manager/model.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace flock {
+
+class FlockVectorIndexTest : public ::testing::Test {
+protected:
+    std::shared_ptr<MockProvider> mock_provider;
+
+    void SetUp() override {
+        auto con = Config::GetConnection();
+        con.Query(" CREATE SECRET ("
+                  "       TYPE OPENAI,"
+                  "    API_KEY 'your-api-key');");
+        mock_provider = std::make_shared<MockProvider>(ModelDetails{});
+        Model::SetMockProvider(mock_provider);
+
+        con.Query("DROP TABLE IF EXISTS knn_docs;");
+        con.Query("CREATE TABLE knn_docs AS SELECT * FROM (VALUES "
+                  "(1, 'north', [1.0, 0.0, 0.0]::FLOAT[]), "
+                  "(2, 'east', [0.0, 1.0, 0.0]::FLOAT[]), "
+                  "(3, 'north-east', [0.7, 0.7, 0.0]::FLOAT[]), "
+                  "(4, 'up', [0.0, 0.0, 1.0]::FLOAT[])) AS t(id, name, embedding);");
+        const auto created = con.Query("SELECT * FROM flock_create_index('knn_docs_index', 'knn_docs', 'id', 'embedding', "
+                                       "{'model_name': 'text-embedding-3-small'});");
+        ASSERT_FALSE(created->HasError()) << created->GetError();
+        EXPECT_EQ(created->GetValue(1, 0).GetValue<int64_t>(), 4);
+    }
+
+    void TearDown() override {
+        auto con = Config::GetConnection();
+        con.Query("SELECT * FROM flock_drop_index('knn_docs_index');");
+        con.Query("DROP TABLE IF EXISTS knn_docs;");
+        Model::ResetMockProvider();
+    }
+
+    static std::vector<int32_t> Ids(duckdb::MaterializedQueryResult& results) {
+        std::vector<int32_t> ids;
+        for (idx_t row = 0; row < results.RowCount(); row++) {
+            ids.push_back(results.GetValue(0, row).GetValue<int32_t>());
+        }
+        return ids;
+    }
+};
+
+TEST_F(FlockVectorIndexTest, KnnReturnsNearestRowsForAVector) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT id, name, score FROM flock_knn('knn_docs_index', [1.0, 0.1, 0.0], 2);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(Ids(*results), (std::vector<int32_t>{1, 3}));
+    EXPECT_EQ(results->GetValue(1, 0).GetValue<std::string>(), "north");
+    EXPECT_GT(results->GetValue(2, 0).GetValue<float>(), results->GetValue(2, 1).GetValue<float>());
+}
+
+TEST_F(FlockVectorIndexTest, KnnEmbedsTextQueriesWithTheIndexModel) {
+    EXPECT_CALL(*mock_provider, AddEmbeddingRequest(::testing::ElementsAre("up there")));
+    EXPECT_CALL(*mock_provider, CollectEmbeddings(::testing::_))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{nlohmann::json::array({{0.1, 0.0, 0.9}})}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query("SELECT id FROM flock_knn('knn_docs_index', 'up there', 1);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(Ids(*results), std::vector<int32_t>{4});
+}
+
+TEST_F(FlockVectorIndexTest, UpdateIndexesOnlyNewRowsAndSurvivesReload) {
+    auto con = Config::GetConnection();
+    con.Query("INSERT INTO knn_docs VALUES (5, 'west', [-1.0, 0.0, 0.0]::FLOAT[]), (6, 'south', [0.0, -1.0, 0.0]::FLOAT[]);");
+    const auto updated = con.Query("SELECT * FROM flock_update_index('knn_docs_index');");
+    ASSERT_FALSE(updated->HasError()) << updated->GetError();
+    EXPECT_EQ(updated->GetValue(1, 0).GetValue<int64_t>(), 2);
+
+    // The graph is read back from the database.
+    VectorIndex::Unload();
+    const auto results = con.Query("SELECT id FROM flock_knn('knn_docs_index', [-1.0, -0.2, 0.0], 2);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    EXPECT_EQ(Ids(*results), (std::vector<int32_t>{5, 6}));
+
+    const auto unchanged = con.Query("SELECT * FROM flock_update_index('knn_docs_index');");
+    EXPECT_EQ(unchanged->GetValue(1, 0).GetValue<int64_t>(), 0);
+}
+
+TEST_F(FlockVectorIndexTest, RejectsWrongDimensionsAndDroppedIndexes) {
+    auto con = Config::GetConnection();
+    EXPECT_TRUE(con.Query("SELECT * FROM flock_knn('knn_docs_index', [1.0, 0.0], 1);")->HasError());
+
+    ASSERT_FALSE(con.Query("SELECT * FROM flock_drop_index('knn_docs_index');")->HasError());
+    EXPECT_TRUE(con.Query("SELECT * FROM flock_knn('knn_docs_index', [1.0, 0.0, 0.0], 1);")->HasError());
+}
+
+}// namespace flock
@@ -0,0 +1,146 @@
+#include "../mock_provider.hpp"
+#include "flock/core/config.hpp"
+#include "flock/functions/table/llm_map.hpp"
+#include "flock/model_manager/batch_size_controller.hpp"
+#include "flock/model_manager/model.hpp"
+#include "flock/model_manager/request_executor.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace flock {
+
+class LlmMapTest : public ::testing::Test {
+protected:
+    std::shared_ptr<MockProvider> mock_provider;
+
+    void SetUp() override {
+        auto con = Config::GetConnection();
+        con.Query(" CREATE SECRET ("
+                  "       TYPE OPENAI,"
+                  "    API_KEY 'your-api-key');");
+
+        mock_provider = std::make_shared<MockProvider>(ModelDetails{});
+        Model::SetMockProvider(mock_provider);
+    }
+
+    void TearDown() override {
+        Model::ResetMockProvider();
+        BatchSizeController::Reset();
+        RequestExecutor::SetMaxConcurrency(RequestExecutor::DEFAULT_MAX_CONCURRENCY);
+    }
+};
+
+TEST_F(LlmMapTest, BuildContextColumnsUsesColumnNames) {
+    const duckdb::vector<duckdb::LogicalType> types = {duckdb::LogicalType::VARCHAR, duckdb::LogicalType::INTEGER};
+    duckdb::ColumnDataCollection rows(duckdb::Allocator::DefaultAllocator(), types);
+    duckdb::DataChunk chunk;
+    chunk.Initialize(duckdb::Allocator::DefaultAllocator(), types);
+    chunk.SetValue(0, 0, duckdb::Value("Laptop"));
+    chunk.SetValue(1, 0, duckdb::Value::INTEGER(999));
+    chunk.SetValue(0, 1, duckdb::Value(duckdb::LogicalType::VARCHAR));
+    chunk.SetValue(1, 1, duckdb::Value::INTEGER(5));
+    chunk.SetCardinality(2);
+    rows.Append(chunk);
+
+    const auto context_columns = LlmMap::BuildContextColumns({"title", "price"}, rows).ToJson();
+    ASSERT_EQ(context_columns.size(), 2);
+    EXPECT_EQ(context_columns[0]["name"], "title");
+    EXPECT_EQ(context_columns[0]["data"], nlohmann::json::array({"Laptop", "NULL"}));
+    EXPECT_EQ(context_columns[1]["data"], nlohmann::json::array({"999", "5"}));
+}
+
+TEST_F(LlmMapTest, FillsBatchesAcrossRowsAndKeepsInputOrder) {
+    const nlohmann::json first_batch = {{"items", {"Positive", "Negative"}}};
+    const nlohmann::json last_batch = {{"items", {"Neutral"}}};
+    {
+        ::testing::InSequence sequence;
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 2, OutputType::STRING, ::testing::_))
+                .Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{first_batch}));
+        EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::STRING, ::testing::_))
+                .Times(1);
+        EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+                .WillOnce(::testing::Return(std::vector<nlohmann::json>{last_batch}));
+    }
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT * FROM llm_map((SELECT * FROM unnest(['I love it', 'I hate it', 'It is fine']) AS tbl(review)), "
+            "{'model_name': 'gpt-4o', 'max_batch_size': 2}, {'prompt': 'What is the sentiment?'}, "
+            "inflight_batches := 1, output_column := 'sentiment');");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->ColumnCount(), 2);
+    EXPECT_EQ(results->ColumnName(1), "sentiment");
+    ASSERT_EQ(results->RowCount(), 3);
+    EXPECT_EQ(results->GetValue(0, 0).GetValue<std::string>(), "I love it");
+    EXPECT_EQ(results->GetValue(1, 0).GetValue<std::string>(), "Positive");
+    EXPECT_EQ(results->GetValue(1, 1).GetValue<std::string>(), "Negative");
+    EXPECT_EQ(results->GetValue(0, 2).GetValue<std::string>(), "It is fine");
+    EXPECT_EQ(results->GetValue(1, 2).GetValue<std::string>(), "Neutral");
+}
+
+TEST_F(LlmMapTest, BatchesSpanInputChunks) {
+    // 3000 rows arrive in two chunks; batches of 1000 take the rest of the first chunk and the
+    // start of the second, and every row keeps its own values and answer.
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1000, OutputType::STRING, ::testing::_))
+            .Times(3);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .Times(3)
+            .WillRepeatedly(::testing::InvokeWithoutArgs([]() {
+                auto items = nlohmann::json::array();
+                for (int i = 0; i < 1000; i++) {
+                    items.push_back(std::to_string(i));
+                }
+                return std::vector<nlohmann::json>{{{"items", items}}};
+            }));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT * FROM llm_map((SELECT range AS id, 'row ' || range AS label FROM range(3000)), "
+            "{'model_name': 'gpt-4o', 'max_batch_size': 1000}, {'prompt': 'Classify'}, inflight_batches := 1);");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 3000);
+    for (idx_t row = 0; row < 3000; row++) {
+        ASSERT_EQ(results->GetValue(0, row).GetValue<int64_t>(), static_cast<int64_t>(row));
+        ASSERT_EQ(results->GetValue(1, row).GetValue<std::string>(), "row " + std::to_string(row));
+        ASSERT_EQ(results->GetValue(2, row).GetValue<std::string>(), std::to_string(row % 1000));
+    }
+}
+
+TEST_F(LlmMapTest, AsyncModelWithSmallerLearnedBatchSizeDoesNotDeadlock) {
+    // The learned size of 1 splits each llm_map batch of 4 rows into four waves of one request. They
+    // run on the executor's only thread, which must collect them itself instead of queueing them
+    // behind its own job.
+    const std::string prompt = "What is the sentiment?";
+    const Model model(Model::ResolveModelDetailsToJson(nlohmann::json{{"model_name", "gpt-4o"}}));
+    BatchSizeController::OnTokenLimit(model.GetModelDetails(), prompt, 2);
+    ASSERT_EQ(BatchSizeController::Initial(model.GetModelDetails(), prompt, 4), 1);
+    RequestExecutor::SetMaxConcurrency(1);
+
+    EXPECT_CALL(*mock_provider, AddCompletionRequest(::testing::_, 1, OutputType::STRING, ::testing::_))
+            .Times(4);
+    EXPECT_CALL(*mock_provider, CollectCompletions(::testing::_))
+            .Times(4)
+            .WillRepeatedly(::testing::Return(std::vector<nlohmann::json>{{{"items", {"ok"}}}}));
+
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT * FROM llm_map((SELECT * FROM unnest(['a', 'b', 'c', 'd']) AS tbl(review)), "
+            "{'model_name': 'gpt-4o', 'max_batch_size': 4, 'is_async': true}, {'prompt': '" + prompt + "'});");
+    ASSERT_FALSE(results->HasError()) << results->GetError();
+    ASSERT_EQ(results->RowCount(), 4);
+    for (idx_t row = 0; row < 4; row++) {
+        EXPECT_EQ(results->GetValue(1, row).GetValue<std::string>(), "ok");
+    }
+}
+
+TEST_F(LlmMapTest, RejectsContextColumnsInPrompt) {
+    auto con = Config::GetConnection();
+    const auto results = con.Query(
+            "SELECT * FROM llm_map((SELECT 'text' AS review), {'model_name': 'gpt-4o'}, "
+            "{'prompt': 'Summarize', 'context_columns': [{'data': 'x'}]});");
+    EXPECT_TRUE(results->HasError());
+}
+
+}// namespace flock
@@ -0,0 +1,97 @@
+#include "flock/model_manager/batch_size_controller.hpp"
+#include <gtest/gtest.h>
+
+namespace flock {
+
+class BatchSizeControllerTest : public ::testing::Test {
+protected:
+    static constexpr auto PROMPT = "Summarize";
+    // Slow enough for the latency per row to count.
+    static constexpr double ELAPSED_MS = 1000.0;
+
+    ModelDetails model_details = Details("openai", "gpt-4o");
+
+    static ModelDetails Details(const std::string& provider_name, const std::string& model) {
+        ModelDetails details{};
+        details.provider_name = provider_name;
+        details.model_name = model;
+        details.model = model;
+        return details;
+    }
+
+    void SetUp() override { BatchSizeController::Reset(); }
+    void TearDown() override { BatchSizeController::Reset(); }
+};
+
+TEST_F(BatchSizeControllerTest, StartsAtTheConfiguredSizeWithoutHistory) {
+    EXPECT_EQ(BatchSizeController::Initial(model_details, PROMPT, 64), 64);
+    EXPECT_FALSE(BatchSizeController::Get(model_details, PROMPT).has_value());
+}
+
+TEST_F(BatchSizeControllerTest, TokenLimitHalvesAndIsRememberedAcrossCalls) {
+    EXPECT_EQ(BatchSizeController::OnTokenLimit(model_details, PROMPT, 64), 32);
+    EXPECT_EQ(BatchSizeController::Initial(model_details, PROMPT, 64), 32);
+    EXPECT_EQ(BatchSizeController::Initial(model_details, "Other prompt", 64), 64);
+
+    const auto state = BatchSizeController::Get(model_details, PROMPT);
+    ASSERT_TRUE(state.has_value());
+    EXPECT_EQ(state->token_ceiling, 64);
+}
+
+TEST_F(BatchSizeControllerTest, AdditiveIncreaseStaysBelowTheTokenCeiling) {
+    BatchSizeController::OnTokenLimit(model_details, PROMPT, 64);
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 32, ELAPSED_MS, 64), 40);
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 40, ELAPSED_MS, 64), 48);
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 48, ELAPSED_MS, 64), 56);
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 56, ELAPSED_MS, 64), 63);
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 63, ELAPSED_MS, 64), 63);
+    EXPECT_EQ(BatchSizeController::Get(model_details, PROMPT)->largest_success, 63);
+}
+
+TEST_F(BatchSizeControllerTest, TailBatchesDoNotChangeTheLearnedSize) {
+    BatchSizeController::OnTokenLimit(model_details, PROMPT, 64);
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 5, ELAPSED_MS, 64), 32);
+    EXPECT_EQ(BatchSizeController::Get(model_details, PROMPT)->batch_size, 32);
+}
+
+TEST_F(BatchSizeControllerTest, SlowerBatchesBackOff) {
+    BatchSizeController::OnTokenLimit(model_details, PROMPT, 64);
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 32, 32 * 10.0, 64), 40);
+    // Twice the learned latency per row.
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 40, 40 * 20.0, 64), 30);
+    // Short mocked or cached batches carry no latency signal.
+    EXPECT_EQ(BatchSizeController::OnSuccess(model_details, PROMPT, 30, 1.0, 64), 38);
+}
+
+TEST_F(BatchSizeControllerTest, SingleRowOverflowKeepsBatching) {
+    EXPECT_EQ(BatchSizeController::OnTokenLimit(model_details, PROMPT, 1), 0);
+    EXPECT_EQ(BatchSizeController::Initial(model_details, PROMPT, 64), 64);
+}
+
+TEST_F(BatchSizeControllerTest, CeilingIsProbedAfterRepeatedSuccesses) {
+    BatchSizeController::OnTokenLimit(model_details, PROMPT, 16);
+    for (int i = 0; i < BatchSizeController::CEILING_PROBE_SUCCESSES; i++) {
+        BatchSizeController::OnSuccess(model_details, PROMPT, BatchSizeController::Initial(model_details, PROMPT, 64), ELAPSED_MS, 64);
+    }
+    EXPECT_EQ(BatchSizeController::Get(model_details, PROMPT)->token_ceiling, 24);
+    EXPECT_EQ(BatchSizeController::Initial(model_details, PROMPT, 64), 23);
+}
+
+TEST_F(BatchSizeControllerTest, StateIsKeptPerProviderAndModel) {
+    BatchSizeController::OnTokenLimit(model_details, PROMPT, 64);
+    EXPECT_EQ(BatchSizeController::Initial(model_details, PROMPT, 64), 32);
+    EXPECT_EQ(BatchSizeController::Initial(Details("azure", "gpt-4o"), PROMPT, 64), 64);
+    EXPECT_EQ(BatchSizeController::Initial(Details("openai", "gpt-4o-mini"), PROMPT, 64), 64);
+}
+
+TEST_F(BatchSizeControllerTest, EvictsTheLeastRecentlyUsedState) {
+    BatchSizeController::OnTokenLimit(model_details, PROMPT, 64);
+    for (size_t i = 0; i < BatchSizeController::MAX_STATES; i++) {
+        BatchSizeController::OnTokenLimit(model_details, "Prompt " + std::to_string(i), 64);
+    }
+    EXPECT_EQ(BatchSizeController::Size(), BatchSizeController::MAX_STATES);
+    EXPECT_FALSE(BatchSizeController::Get(model_details, PROMPT).has_value());
+    EXPECT_TRUE(BatchSizeController::Get(model_details, "Prompt 0").has_value());
+}
+
+}// namespace flock
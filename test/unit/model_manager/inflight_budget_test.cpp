@@ -0,0 +1,104 @@
+#include "flock/core/config.hpp"
+#include "flock/model_manager/inflight_budget.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace flock {
+
+class InflightBudgetTest : public ::testing::Test {
+protected:
+    void TearDown() override { InflightBudget::SetMaxBytes(InflightBudget::DEFAULT_MAX_BYTES); }
+};
+
+TEST_F(InflightBudgetTest, ReservationsAreReleasedWhenDestroyed) {
+    InflightBudget::SetMaxBytes(100);
+    {
+        auto first = InflightBudget::Acquire(60);
+        EXPECT_EQ(InflightBudget::InUse(), 60);
+        EXPECT_FALSE(InflightBudget::TryAcquire(50).has_value());
+
+        auto moved = std::move(first);
+        EXPECT_EQ(InflightBudget::InUse(), 60);
+        moved.Resize(90);
+        EXPECT_EQ(InflightBudget::InUse(), 90);
+    }
+    EXPECT_EQ(InflightBudget::InUse(), 0);
+}
+
+TEST_F(InflightBudgetTest, OversizedRequestRunsAlone) {
+    InflightBudget::SetMaxBytes(100);
+    auto oversized = InflightBudget::TryAcquire(500);
+    ASSERT_TRUE(oversized.has_value());
+    EXPECT_TRUE(InflightBudget::IsExhausted());
+    EXPECT_FALSE(InflightBudget::TryAcquire(1).has_value());
+}
+
+TEST_F(InflightBudgetTest, QueuedRequestsExhaustButDoNotBlockSending) {
+    InflightBudget::SetMaxBytes(100);
+    {
+        auto queued = InflightBudget::Queue(150);
+        EXPECT_EQ(InflightBudget::InUse(), 150);
+        EXPECT_TRUE(InflightBudget::IsExhausted());
+
+        auto sent = InflightBudget::TryAcquire(60);
+        ASSERT_TRUE(sent.has_value());
+        EXPECT_FALSE(InflightBudget::TryAcquire(50).has_value());
+
+        queued.Resize(10);
+        EXPECT_EQ(InflightBudget::InUse(), 70);
+        EXPECT_FALSE(InflightBudget::TryAcquire(50).has_value());
+    }
+    EXPECT_EQ(InflightBudget::InUse(), 0);
+    EXPECT_TRUE(InflightBudget::TryAcquire(100).has_value());
+}
+
+TEST_F(InflightBudgetTest, AcquireWaitsForRelease) {
+    InflightBudget::SetMaxBytes(100);
+    auto held = InflightBudget::Acquire(80);
+    std::atomic<bool> acquired{false};
+
+    std::thread waiter([&acquired]() {
+        auto reservation = InflightBudget::Acquire(50);
+        acquired = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(acquired.load());
+
+    held.Release();
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+    EXPECT_EQ(InflightBudget::InUse(), 0);
+}
+
+TEST_F(InflightBudgetTest, ShrinkingResizeWakesAcquire) {
+    InflightBudget::SetMaxBytes(100);
+    auto held = InflightBudget::Acquire(80);
+    std::atomic<bool> acquired{false};
+
+    std::thread waiter([&acquired]() {
+        auto reservation = InflightBudget::Acquire(50);
+        acquired = true;
+    });
+    held.Resize(90);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(acquired.load());
+
+    held.Resize(40);
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+    EXPECT_EQ(InflightBudget::InUse(), 40);
+}
+
+TEST_F(InflightBudgetTest, SettingControlsBudget) {
+    auto con = Config::GetConnection();
+    auto result = con.Query("SET flock_max_inflight_bytes = 1048576;");
+    ASSERT_FALSE(result->HasError()) << result->GetError();
+    EXPECT_EQ(InflightBudget::GetMaxBytes(), 1048576);
+
+    result = con.Query("SET flock_max_inflight_bytes = 0;");
+    EXPECT_TRUE(result->HasError());
+    EXPECT_EQ(InflightBudget::GetMaxBytes(), 1048576);
+}
+
+}// namespace flock
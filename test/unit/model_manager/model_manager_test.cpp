@@ -439,4 +439,71 @@ TEST_F(ModelManagerTest, ResolveModelDetailsToJsonPreservesInlineLimitOverrides)
     DeleteLocalTestModel(con, kInlineOverrideModelName);
 }
 
+TEST_F(ModelManagerTest, ResolvedModelsShareDetailsAndReuseReleasedProviders) {
+    Model::ResetModelPool();
+    const json model_config = {{"model_name", "gpt-4o-pool-test"},
+                               {"model", "gpt-4o"},
+                               {"provider", "openai"},
+                               {"secret", {{"api_key", "your-api-key"}}},
+                               {"tuple_format", "json"},
+                               {"max_batch_size", 16}};
+
+    const ModelDetails* first_details;
+    const IProvider* first_provider;
+    {
+        Model first(model_config);
+        first_details = &first.GetModelDetails();
+        first_provider = first.provider_.get();
+        first.SetStringTokensPerTupleHint(2.0);
+
+        // Models alive at the same time never share a provider.
+        Model concurrent(model_config);
+        EXPECT_EQ(&concurrent.GetModelDetails(), first_details);
+        EXPECT_NE(concurrent.provider_.get(), first_provider);
+        EXPECT_NE(first.WithFreshProvider().provider_.get(), first_provider);
+    }
+
+    Model reused(model_config);
+    EXPECT_EQ(&reused.GetModelDetails(), first_details);
+    EXPECT_EQ(reused.provider_.get(), first_provider);
+    EXPECT_FALSE(reused.provider_->string_tokens_per_tuple_hint_.has_value());
+
+    Model::ResetModelPool();
+    Model after_reset(model_config);
+    EXPECT_NE(&after_reset.GetModelDetails(), first_details);
+    EXPECT_EQ(after_reset.GetModelDetails().max_batch_size, 16);
+}
+
+TEST_F(ModelManagerTest, IdleProvidersAreCappedAcrossModels) {
+    Model::ResetModelPool();
+    const auto model_config = [](size_t index) {
+        return json{{"model_name", "gpt-4o-pool-cap-" + std::to_string(index)},
+                    {"model", "gpt-4o"},
+                    {"provider", "openai"},
+                    {"secret", {{"api_key", "your-api-key"}}},
+                    {"tuple_format", "json"},
+                    {"max_batch_size", 16}};
+    };
+
+    const size_t num_models = 300;
+    for (size_t i = 0; i < num_models; i++) {
+        Model model(model_config(i));
+    }
+    EXPECT_EQ(Model::CountIdleProviders(), 256);
+
+    // The most recently released provider is still pooled and leased again.
+    {
+        Model recent(model_config(num_models - 1));
+        EXPECT_EQ(Model::CountIdleProviders(), 255);
+    }
+    // The least recently released one was evicted, so a new provider is created.
+    {
+        Model evicted(model_config(0));
+        EXPECT_EQ(Model::CountIdleProviders(), 256);
+    }
+    EXPECT_EQ(Model::CountIdleProviders(), 256);
+    Model::ResetModelPool();
+    EXPECT_EQ(Model::CountIdleProviders(), 0);
+}
+
 }// namespace flock
@@ -171,6 +171,70 @@ TEST(ModelProvidersTest, OllamaProviderTranscriptionError) {
     EXPECT_THROW(provider.AddTranscriptionRequest(audio_files), std::runtime_error);
 }
 
+// Handler that records queued requests instead of sending them
+class RecordingHandler : public IModelProviderHandler {
+public:
+    std::vector<std::pair<json, RequestType>> requests;
+
+    void AddRequest(const json& request, RequestType type = RequestType::Completion) override {
+        requests.emplace_back(request, type);
+    }
+    std::vector<json> CollectCompletions(const std::string&) override { return {}; }
+    std::vector<json> CollectEmbeddings(const std::string&) override { return {}; }
+    std::vector<json> CollectTranscriptions(const std::string&) override { return {}; }
+    void ClearRequests() override { requests.clear(); }
+};
+
+// Test Ollama provider sends a whole embedding batch in one request
+TEST(ModelProvidersTest, OllamaProviderBatchesEmbeddingInputs) {
+    ModelDetails model_details;
+    model_details.model_name = "test_model";
+    model_details.model = "all-minilm";
+    model_details.provider_name = "ollama";
+    model_details.secret = {{"api_url", "http://localhost:11434"}};
+
+    OllamaProvider provider(model_details);
+    auto handler = std::make_unique<RecordingHandler>();
+    auto* recorded = handler.get();
+    provider.model_handler_ = std::move(handler);
+
+    provider.AddEmbeddingRequest({"first", "second", "third"});
+
+    ASSERT_EQ(recorded->requests.size(), 1);
+    EXPECT_EQ(recorded->requests[0].second, IModelProviderHandler::RequestType::Embedding);
+    EXPECT_EQ(recorded->requests[0].first["model"], "all-minilm");
+    EXPECT_EQ(recorded->requests[0].first["input"], json::array({"first", "second", "third"}));
+}
+
+// Test a Flock item schema (fused calls, cascades) takes precedence over a user response_format
+TEST(ModelProvidersTest, OpenAIProviderPrefersItemSchemaOverUserResponseFormat) {
+    ModelDetails model_details;
+    model_details.model_name = "test_model";
+    model_details.model = "gpt-4o";
+    model_details.provider_name = "openai";
+    model_details.secret = {{"api_key", "test_api_key"}};
+    const json user_schema = {{"type", "object"}, {"properties", {{"sentiment", {{"type", "string"}}}}}};
+    model_details.model_parameters = {
+            {"response_format", {{"type", "json_schema"}, {"strict", true}, {"json_schema", {{"schema", user_schema}}}}}};
+
+    OpenAIProvider provider(model_details);
+    auto handler = std::make_unique<RecordingHandler>();
+    auto* recorded = handler.get();
+    provider.model_handler_ = std::move(handler);
+
+    provider.AddCompletionRequest("prompt", 2, OutputType::STRING, json::object());
+    ASSERT_EQ(recorded->requests.size(), 1);
+    EXPECT_EQ(recorded->requests[0].first["response_format"]["json_schema"]["schema"]["properties"]["items"]["items"],
+              user_schema);
+
+    const json item_schema = {{"type", "object"}, {"properties", {{"task_0", {{"type", "string"}}}}}};
+    provider.model_details_.item_schema = item_schema;
+    provider.AddCompletionRequest("prompt", 2, OutputType::OBJECT, json::object());
+    ASSERT_EQ(recorded->requests.size(), 2);
+    EXPECT_EQ(recorded->requests[1].first["response_format"]["json_schema"]["schema"]["properties"]["items"]["items"],
+              item_schema);
+}
+
 // Test transcription with multiple audio files
 TEST(ModelProvidersTest, TranscriptionWithMultipleFiles) {
     ModelDetails model_details;
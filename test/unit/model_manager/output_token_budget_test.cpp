@@ -0,0 +1,98 @@
+#include "flock/model_manager/output_token_budget.hpp"
+#include "nlohmann/json.hpp"
+#include <gtest/gtest.h>
+
+namespace flock {
+using json = nlohmann::json;
+
+class OutputTokenBudgetTest : public ::testing::Test {
+protected:
+    ModelDetails model_details = Details("openai", "gpt-4o");
+
+    static ModelDetails Details(const std::string& provider_name, const std::string& model) {
+        ModelDetails details{};
+        details.provider_name = provider_name;
+        details.model_name = model;
+        details.model = model;
+        return details;
+    }
+
+    void SetUp() override { OutputTokenBudget::Reset(); }
+    void TearDown() override { OutputTokenBudget::Reset(); }
+};
+
+TEST_F(OutputTokenBudgetTest, ComputeScalesWithTuplesForFixedSizeOutputs) {
+    EXPECT_EQ(OutputTokenBudget::Compute(OutputType::BOOL, 64),
+              OutputTokenBudget::ENVELOPE_TOKENS + 64 * OutputTokenBudget::BOOL_TOKENS_PER_TUPLE);
+    EXPECT_EQ(OutputTokenBudget::Compute(OutputType::INTEGER, 10),
+              OutputTokenBudget::ENVELOPE_TOKENS + 10 * OutputTokenBudget::INTEGER_TOKENS_PER_TUPLE);
+    EXPECT_FALSE(OutputTokenBudget::Compute(OutputType::OBJECT, 10).has_value());
+}
+
+TEST_F(OutputTokenBudgetTest, ComputeStringRequiresLearnedAverage) {
+    EXPECT_FALSE(OutputTokenBudget::Compute(OutputType::STRING, 4).has_value());
+    EXPECT_EQ(OutputTokenBudget::Compute(OutputType::STRING, 4, 50.0), OutputTokenBudget::ENVELOPE_TOKENS + 4 * 100);
+    EXPECT_EQ(OutputTokenBudget::Compute(OutputType::STRING, 4, 1.0),
+              OutputTokenBudget::ENVELOPE_TOKENS + 4 * OutputTokenBudget::MIN_STRING_TOKENS_PER_TUPLE);
+}
+
+TEST_F(OutputTokenBudgetTest, ResolveHonoursModelSettings) {
+    ModelDetails model_details;
+    EXPECT_FALSE(OutputTokenBudget::Resolve(model_details, 8, OutputType::BOOL, std::nullopt, {"max_tokens"}).has_value());
+
+    model_details.output_token_budget = true;
+    EXPECT_TRUE(OutputTokenBudget::Resolve(model_details, 8, OutputType::BOOL, std::nullopt, {"max_tokens"}).has_value());
+
+    model_details.model_parameters = {{"max_tokens", 10}};
+    EXPECT_FALSE(OutputTokenBudget::Resolve(model_details, 8, OutputType::BOOL, std::nullopt, {"max_tokens"}).has_value());
+}
+
+TEST_F(OutputTokenBudgetTest, LiftedPayloadDropsOrRaisesTheBudget) {
+    json openai = {{"model", "gpt-4o"}, {"max_completion_tokens", 64}};
+    EXPECT_FALSE(OutputTokenBudget::IsBudgeted(openai));
+    OutputTokenBudget::Mark(openai, "/max_completion_tokens");
+    ASSERT_TRUE(OutputTokenBudget::IsBudgeted(openai));
+    EXPECT_EQ(OutputTokenBudget::Unmarked(openai), json({{"model", "gpt-4o"}, {"max_completion_tokens", 64}}));
+    EXPECT_EQ(OutputTokenBudget::Lifted(openai), json({{"model", "gpt-4o"}}));
+
+    json ollama = {{"options", {{"temperature", 0}, {"num_predict", 64}}}};
+    OutputTokenBudget::Mark(ollama, "/options/num_predict");
+    EXPECT_EQ(OutputTokenBudget::Lifted(ollama), json({{"options", {{"temperature", 0}}}}));
+
+    json anthropic = {{"max_tokens", 64}};
+    OutputTokenBudget::Mark(anthropic, "/max_tokens", 4096);
+    const auto lifted = OutputTokenBudget::Lifted(anthropic);
+    EXPECT_EQ(lifted, json({{"max_tokens", 4096}}));
+    EXPECT_FALSE(OutputTokenBudget::IsBudgeted(lifted));
+}
+
+TEST_F(OutputTokenBudgetTest, ObserveLearnsPerModelAndPrompt) {
+    EXPECT_FALSE(OutputTokenBudget::LearnedTokensPerTuple(model_details, "summarize").has_value());
+
+    // 40 characters estimate to 10 tokens; null rows are ignored.
+    OutputTokenBudget::Observe(model_details, "summarize",
+                               json::array({std::string(40, 'a'), nullptr, std::string(40, 'b')}));
+    ASSERT_TRUE(OutputTokenBudget::LearnedTokensPerTuple(model_details, "summarize").has_value());
+    EXPECT_DOUBLE_EQ(*OutputTokenBudget::LearnedTokensPerTuple(model_details, "summarize"), 10.0);
+
+    OutputTokenBudget::Observe(model_details, "summarize", json::array({std::string(80, 'c')}));
+    EXPECT_DOUBLE_EQ(*OutputTokenBudget::LearnedTokensPerTuple(model_details, "summarize"),
+                     (1.0 - OutputTokenBudget::LEARNING_RATE) * 10.0 + OutputTokenBudget::LEARNING_RATE * 20.0);
+
+    EXPECT_FALSE(OutputTokenBudget::LearnedTokensPerTuple(model_details, "translate").has_value());
+    EXPECT_FALSE(OutputTokenBudget::LearnedTokensPerTuple(Details("openai", "gpt-4o-mini"), "summarize").has_value());
+    EXPECT_FALSE(OutputTokenBudget::LearnedTokensPerTuple(Details("azure", "gpt-4o"), "summarize").has_value());
+}
+
+TEST_F(OutputTokenBudgetTest, EvictsTheLeastRecentlyUsedAverage) {
+    const auto responses = json::array({std::string(40, 'a')});
+    OutputTokenBudget::Observe(model_details, "summarize", responses);
+    for (size_t i = 0; i < OutputTokenBudget::MAX_STATES; i++) {
+        OutputTokenBudget::Observe(model_details, "Prompt " + std::to_string(i), responses);
+    }
+    EXPECT_EQ(OutputTokenBudget::Size(), OutputTokenBudget::MAX_STATES);
+    EXPECT_FALSE(OutputTokenBudget::LearnedTokensPerTuple(model_details, "summarize").has_value());
+    EXPECT_TRUE(OutputTokenBudget::LearnedTokensPerTuple(model_details, "Prompt 0").has_value());
+}
+
+}// namespace flock
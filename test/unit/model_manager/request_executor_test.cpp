@@ -0,0 +1,54 @@
+#include "flock/core/config.hpp"
+#include "flock/model_manager/request_executor.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace flock {
+
+class RequestExecutorTest : public ::testing::Test {
+protected:
+    void TearDown() override { RequestExecutor::SetMaxConcurrency(RequestExecutor::DEFAULT_MAX_CONCURRENCY); }
+};
+
+TEST_F(RequestExecutorTest, RunsJobsWithinConcurrencyLimit) {
+    RequestExecutor::SetMaxConcurrency(2);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+
+    std::vector<std::future<nlohmann::json>> results;
+    for (int i = 0; i < 8; i++) {
+        results.push_back(RequestExecutor::Submit([&running, &peak, i]() {
+            const auto now_running = ++running;
+            auto observed = peak.load();
+            while (now_running > observed && !peak.compare_exchange_weak(observed, now_running)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            --running;
+            return nlohmann::json(i);
+        }));
+    }
+
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(results[i].get(), i);
+    }
+    EXPECT_LE(peak.load(), 2);
+}
+
+TEST_F(RequestExecutorTest, ExceptionsReachTheCaller) {
+    auto result = RequestExecutor::Submit([]() -> nlohmann::json { throw std::runtime_error("provider failed"); });
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST_F(RequestExecutorTest, SettingControlsConcurrency) {
+    auto con = Config::GetConnection();
+    auto result = con.Query("SET flock_max_http_concurrency = 3;");
+    ASSERT_FALSE(result->HasError()) << result->GetError();
+    EXPECT_EQ(RequestExecutor::GetMaxConcurrency(), 3);
+
+    result = con.Query("SET flock_max_http_concurrency = 0;");
+    EXPECT_TRUE(result->HasError());
+    EXPECT_EQ(RequestExecutor::GetMaxConcurrency(), 3);
+}
+
+}// namespace flock
@@ -0,0 +1,84 @@
+#include "flock/model_manager/result_cache.hpp"
+#include "nlohmann/json.hpp"
+#include <gtest/gtest.h>
+
+namespace flock {
+using json = nlohmann::json;
+
+class ResultCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override { ResultCache::Clear(); }
+    void TearDown() override { ResultCache::Clear(); }
+
+    static ModelDetails MakeModelDetails() {
+        ModelDetails model_details;
+        model_details.model_name = "gpt-4o";
+        model_details.model = "gpt-4o";
+        model_details.provider_name = "openai";
+        model_details.model_parameters = json::object();
+        model_details.max_batch_size = 16;
+        return model_details;
+    }
+
+    static ContextColumnBatch MakeTuples(const std::vector<std::string>& values) {
+        return ContextColumnBatch::FromJson(json::array({{{"name", "review"}, {"data", values}}}));
+    }
+};
+
+TEST_F(ResultCacheTest, HashIsStableAndDistinguishesContent) {
+    EXPECT_EQ(ResultCache::Hash("hello").size(), 32);
+    EXPECT_EQ(ResultCache::Hash("hello"), ResultCache::Hash("hello"));
+    EXPECT_NE(ResultCache::Hash("hello"), ResultCache::Hash("hellp"));
+    EXPECT_NE(ResultCache::Hash(""), ResultCache::Hash(std::string(1, '\0')));
+
+    const std::string cells = "hello world";
+    EXPECT_EQ(ResultCache::Hash(cells.data(), 5), ResultCache::Hash("hello"));
+}
+
+TEST_F(ResultCacheTest, CompletionKeysDependOnPromptRowAndModelParameters) {
+    auto model_details = MakeModelDetails();
+    const auto tuples = MakeTuples({"great", "bad", "great"});
+
+    const auto keys = ResultCache::CompletionKeys(model_details, "Sentiment?", ScalarFunctionType::COMPLETE, tuples);
+    ASSERT_EQ(keys.size(), 3);
+    EXPECT_EQ(keys[0], keys[2]);
+    EXPECT_NE(keys[0], keys[1]);
+
+    EXPECT_NE(ResultCache::CompletionKeys(model_details, "Topic?", ScalarFunctionType::COMPLETE, tuples)[0], keys[0]);
+    EXPECT_NE(ResultCache::CompletionKeys(model_details, "Sentiment?", ScalarFunctionType::FILTER, tuples)[0], keys[0]);
+
+    auto batched_details = model_details;
+    batched_details.max_batch_size = 64;
+    batched_details.secret = {{"api_key", "other"}};
+    EXPECT_EQ(ResultCache::CompletionKeys(batched_details, "Sentiment?", ScalarFunctionType::COMPLETE, tuples)[0], keys[0]);
+
+    auto tuned_details = model_details;
+    tuned_details.model_parameters = {{"temperature", 0.2}};
+    EXPECT_NE(ResultCache::CompletionKeys(tuned_details, "Sentiment?", ScalarFunctionType::COMPLETE, tuples)[0], keys[0]);
+}
+
+TEST_F(ResultCacheTest, EmbeddingKeysDifferFromCompletionKeys) {
+    const auto model_details = MakeModelDetails();
+    const auto embedding_keys = ResultCache::EmbeddingKeys(model_details, {"great"});
+    const auto completion_keys =
+            ResultCache::CompletionKeys(model_details, "", ScalarFunctionType::COMPLETE, MakeTuples({"great"}));
+    ASSERT_EQ(embedding_keys.size(), 1);
+    EXPECT_NE(embedding_keys[0], completion_keys[0]);
+}
+
+TEST_F(ResultCacheTest, StoredAnswersAreReturnedUntilCleared) {
+    const auto first_key = ResultCache::Hash("first");
+    const auto second_key = ResultCache::Hash("second");
+    ResultCache::Store({{first_key, "positive"}});
+
+    const auto results = ResultCache::Lookup({first_key, second_key});
+    ASSERT_EQ(results.size(), 2);
+    ASSERT_TRUE(results[0].has_value());
+    EXPECT_EQ(*results[0], "positive");
+    EXPECT_FALSE(results[1].has_value());
+
+    ResultCache::Clear();
+    EXPECT_FALSE(ResultCache::Lookup({first_key})[0].has_value());
+}
+
+}// namespace flock
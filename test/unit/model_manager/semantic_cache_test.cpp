@@ -0,0 +1,152 @@
+#include "flock/core/vector_math.hpp"
+#include "flock/metrics/data_structures.hpp"
+#include "flock/model_manager/result_cache.hpp"
+#include "flock/model_manager/semantic_cache.hpp"
+#include "nlohmann/json.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace flock {
+using json = nlohmann::json;
+
+class SemanticCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override { SemanticCache::Clear(); }
+    void TearDown() override { SemanticCache::Clear(); }
+
+    static std::vector<float> Unit(std::vector<float> values) {
+        VectorMath::Normalize(values);
+        return values;
+    }
+};
+
+TEST_F(SemanticCacheTest, DotMatchesScalarSumForAllTailLengths) {
+    for (size_t dims = 0; dims <= 19; dims++) {
+        std::vector<float> left(dims);
+        std::vector<float> right(dims);
+        float expected = 0.0f;
+        for (size_t i = 0; i < dims; i++) {
+            left[i] = static_cast<float>(i) * 0.5f - 2.0f;
+            right[i] = 1.0f + static_cast<float>(i % 3);
+            expected += left[i] * right[i];
+        }
+        EXPECT_NEAR(VectorMath::Dot(left.data(), right.data(), dims), expected, 1e-4f) << "dims=" << dims;
+    }
+}
+
+TEST_F(SemanticCacheTest, NormalizeProducesUnitLengthAndKeepsZeroVectors) {
+    const auto unit = Unit({3.0f, 4.0f});
+    EXPECT_NEAR(unit[0], 0.6f, 1e-6f);
+    EXPECT_NEAR(unit[1], 0.8f, 1e-6f);
+
+    std::vector<float> zero(5, 0.0f);
+    VectorMath::Normalize(zero);
+    EXPECT_EQ(zero, std::vector<float>(5, 0.0f));
+}
+
+TEST_F(SemanticCacheTest, LookupReusesAnswersAboveThresholdOnly) {
+    const auto cache_namespace = ResultCache::Hash("semantic-cache-test");
+    SemanticCache::Insert(cache_namespace, {Unit({1.0f, 0.0f, 0.0f, 0.0f})}, {"positive"});
+
+    const auto matches = SemanticCache::Lookup(
+            cache_namespace, {Unit({0.99f, 0.05f, 0.0f, 0.0f}), Unit({0.0f, 1.0f, 0.0f, 0.0f}), Unit({1.0f, 0.0f})},
+            0.95);
+    ASSERT_EQ(matches.size(), 3);
+
+    ASSERT_TRUE(matches[0].answer.has_value());
+    EXPECT_EQ(*matches[0].answer, "positive");
+
+    EXPECT_FALSE(matches[1].answer.has_value());
+    ASSERT_TRUE(matches[1].best_similarity.has_value());
+    EXPECT_LT(*matches[1].best_similarity, 0.95f);
+
+    // Embeddings of another width are never compared.
+    EXPECT_FALSE(matches[2].answer.has_value());
+    EXPECT_FALSE(matches[2].best_similarity.has_value());
+}
+
+TEST_F(SemanticCacheTest, NamespacesAreIsolated) {
+    SemanticCache::Insert(ResultCache::Hash("first"), {Unit({1.0f, 0.0f})}, {"positive"});
+    const auto matches = SemanticCache::Lookup(ResultCache::Hash("second"), {Unit({1.0f, 0.0f})}, 0.5);
+    ASSERT_EQ(matches.size(), 1);
+    EXPECT_FALSE(matches[0].answer.has_value());
+}
+
+TEST_F(SemanticCacheTest, OnlyFoundCandidatesCountAsThresholdRejections) {
+    const auto cache_namespace = ResultCache::Hash("rejections");
+    const auto empty = SemanticCache::Lookup(cache_namespace, {Unit({1.0f, 0.0f})}, 0.9);
+    ASSERT_EQ(empty.size(), 1);
+    EXPECT_FALSE(empty[0].RejectedByThreshold());
+
+    SemanticCache::Insert(cache_namespace, {Unit({1.0f, 0.0f})}, {"positive"});
+    const auto matches = SemanticCache::Lookup(cache_namespace, {Unit({1.0f, 0.0f}), Unit({0.0f, 1.0f}),
+                                                                 std::vector<float>{NAN, NAN}},
+                                               0.9);
+    ASSERT_EQ(matches.size(), 3);
+    EXPECT_FALSE(matches[0].RejectedByThreshold());
+    EXPECT_TRUE(matches[1].RejectedByThreshold());
+    EXPECT_FALSE(matches[2].RejectedByThreshold());
+}
+
+TEST_F(SemanticCacheTest, ConcurrentLookupsAndInsertsAcrossNamespaces) {
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 8; thread++) {
+        threads.emplace_back([thread]() {
+            const auto cache_namespace = ResultCache::Hash("concurrent-" + std::to_string(thread % 2));
+            for (int i = 0; i < 50; i++) {
+                SemanticCache::Insert(cache_namespace, {Unit({1.0f, static_cast<float>(i)})}, {i});
+                SemanticCache::Lookup(cache_namespace, {Unit({1.0f, 0.0f})}, 0.99);
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    const auto matches = SemanticCache::Lookup(ResultCache::Hash("concurrent-0"), {Unit({1.0f, 0.0f})}, 0.99);
+    ASSERT_EQ(matches.size(), 1);
+    ASSERT_TRUE(matches[0].answer.has_value());
+    EXPECT_EQ(*matches[0].answer, 0);
+}
+
+TEST_F(SemanticCacheTest, DropsLeastRecentlyUsedNamespacePastCachedVectorBound) {
+    const auto fill = [](const std::string& name, size_t count) {
+        std::vector<std::vector<float>> embeddings(count, std::vector<float>{1.0f});
+        std::vector<json> answers(count, name);
+        SemanticCache::Insert(ResultCache::Hash(name), embeddings, answers);
+    };
+    fill("lru-first", SemanticCache::MAX_ENTRIES_PER_NAMESPACE);
+    fill("lru-second", SemanticCache::MAX_ENTRIES_PER_NAMESPACE - 1000);
+    EXPECT_EQ(SemanticCache::CachedVectors(), SemanticCache::MAX_CACHED_VECTORS - 1000);
+
+    // Using the first namespace leaves the second one least recently used.
+    SemanticCache::Lookup(ResultCache::Hash("lru-first"), {{1.0f}}, 0.5);
+    fill("lru-third", 2000);
+    EXPECT_EQ(SemanticCache::CachedVectors(), SemanticCache::MAX_ENTRIES_PER_NAMESPACE + 2000);
+}
+
+TEST_F(SemanticCacheTest, RowTextsJoinNamedColumns) {
+    const json tuples = json::array({{{"name", "title"}, {"data", {"Laptop", "Phone"}}},
+                                     {{"name", "price"}, {"data", {999, 599}}}});
+    const auto texts = SemanticCache::RowTexts(ContextColumnBatch::FromJson(tuples), {1});
+    ASSERT_EQ(texts.size(), 1);
+    EXPECT_EQ(texts[0], "title: Phone\nprice: 599");
+}
+
+TEST_F(SemanticCacheTest, MetricsReportSemanticCacheOutcomes) {
+    FunctionMetricsData metrics;
+    EXPECT_FALSE(metrics.ToJson().contains("semantic_cache_hits"));
+
+    metrics.semantic_cache_hits = 3;
+    metrics.semantic_cache_misses = 2;
+    metrics.semantic_cache_threshold_rejections = 1;
+    EXPECT_FALSE(metrics.IsEmpty());
+
+    const auto metrics_json = metrics.ToJson();
+    EXPECT_EQ(metrics_json["semantic_cache_hits"], 3);
+    EXPECT_EQ(metrics_json["semantic_cache_misses"], 2);
+    EXPECT_EQ(metrics_json["semantic_cache_threshold_rejections"], 1);
+}
+
+}// namespace flock
@@ -161,6 +161,64 @@ TEST(PromptManager, ConstructInputTuplesEmpty) {
     EXPECT_EQ(PromptManager::ConstructInputTuples(empty_tuples, TupleFormat::JSON), json_expected);
 }
 
+TEST(PromptManager, ConstructInputTuplesDictionaryEncoded) {
+    auto tuples = json::array();
+    tuples.push_back({{"name", "country"}, {"data", {"United Kingdom", "United Kingdom", "Peru", "United Kingdom"}}});
+    tuples.push_back({{"name", "note"}, {"data", {"x", "Peru", "y", "z"}}});
+
+    DictionaryEncoding dictionary_encoding;
+    dictionary_encoding.min_length = 8;
+    dictionary_encoding.min_repeats = 2;
+
+    auto xml_expected = std::string("- The Number of Tuples to Generate Responses for: 4\n\n");
+    xml_expected += "- Value Dictionary: the codes below appear in the tuples in place of the full values they stand for.\n";
+    xml_expected += "@V1 = \"United Kingdom\"\n\n";
+    xml_expected += "<header><column>country</column><column>note</column></header>\n";
+    xml_expected += "<row><column>@V1</column><column>x</column></row>\n";
+    xml_expected += "<row><column>@V1</column><column>Peru</column></row>\n";
+    xml_expected += "<row><column>Peru</column><column>y</column></row>\n";
+    xml_expected += "<row><column>@V1</column><column>z</column></row>\n";
+    EXPECT_EQ(PromptManager::ConstructInputTuples(tuples, TupleFormat::XML, dictionary_encoding), xml_expected);
+
+    // The caller's columns are left untouched.
+    EXPECT_EQ(tuples[0]["data"][0], "United Kingdom");
+}
+
+TEST(PromptManager, DictionaryEncodeColumnsRespectsThresholds) {
+    auto tuples = json::array();
+    tuples.push_back({{"name", "flock_row_id"}, {"data", {"1000000001", "1000000001"}}});
+    tuples.push_back({{"name", "category"}, {"data", {"Home & Garden", "Home & Garden", "Electronics", nullptr}}});
+
+    DictionaryEncoding high_repeats;
+    high_repeats.min_length = 4;
+    high_repeats.min_repeats = 3;
+    auto unchanged = tuples;
+    EXPECT_EQ(PromptManager::DictionaryEncodeColumns(unchanged, high_repeats), "");
+    EXPECT_EQ(unchanged, tuples);
+
+    DictionaryEncoding low_repeats;
+    low_repeats.min_length = 4;
+    low_repeats.min_repeats = 2;
+    auto encoded = tuples;
+    const auto legend = PromptManager::DictionaryEncodeColumns(encoded, low_repeats);
+    EXPECT_NE(legend.find("@V1 = \"Home & Garden\""), std::string::npos);
+    EXPECT_EQ(encoded[0]["data"], tuples[0]["data"]);
+    EXPECT_EQ(encoded[1]["data"], json({"@V1", "@V1", "Electronics", nullptr}));
+}
+
+TEST(PromptManager, ApplyColumnTokenBudgetsTruncatesOversizedCells) {
+    auto columns = json::array();
+    columns.push_back({{"name", "ticket"}, {"max_tokens", 3}, {"truncate", "tail"}, {"data", {"alpha beta gamma delta epsilon", "ok", nullptr}}});
+    columns.push_back({{"name", "subject"}, {"max_tokens", 3}, {"data", {"alpha beta gamma delta epsilon", "ok", "fine"}}});
+    columns.push_back({{"name", "body"}, {"data", {"alpha beta gamma delta epsilon", "ok", "fine"}}});
+
+    PromptManager::ApplyColumnTokenBudgets(columns);
+
+    EXPECT_EQ(columns[0]["data"], json({"[...] epsilon", "ok", nullptr}));
+    EXPECT_EQ(columns[1]["data"], json({"alpha beta [...]", "ok", "fine"}));
+    EXPECT_EQ(columns[2]["data"][0], "alpha beta gamma delta epsilon");
+}
+
 TEST(PromptManager, CreatePromptDetailsLiteralPrompt) {
     const json prompt_json = {{"prompt", "test_prompt"}};
     const auto [prompt_name, prompt, version] = PromptManager::CreatePromptDetails(prompt_json);
@@ -267,6 +325,31 @@ protected:
     std::shared_ptr<MockProvider> mock_provider;
 };
 
+// Test TranscribeAudioColumns replaces audio columns and keeps the others
+TEST_F(TranscribeAudioColumnTest, TranscribeAudioColumnsReplacesAudioColumns) {
+    const auto batch = ContextColumnBatch::FromJson(json::array(
+            {{{"name", "title"}, {"data", {"first", "second"}}},
+             {{"name", "review"},
+              {"type", "audio"},
+              {"transcription_model", "gpt-4o-transcribe"},
+              {"data", {"https://example.com/audio1.mp3", "https://example.com/audio2.mp3"}}}}));
+
+    EXPECT_CALL(*mock_provider, AddTranscriptionRequest(::testing::_))
+            .Times(1);
+    EXPECT_CALL(*mock_provider, CollectTranscriptions("multipart/form-data"))
+            .WillOnce(::testing::Return(std::vector<nlohmann::json>{"first transcription", "second transcription"}));
+
+    const auto transcribed = PromptManager::TranscribeAudioColumns(batch);
+
+    ASSERT_EQ(transcribed.columns.size(), 2);
+    EXPECT_EQ(transcribed.GetCell(0, 1), "second");
+    EXPECT_EQ(transcribed.columns[1].metadata, json({{"name", "transcription_of_review"}}));
+    EXPECT_EQ(transcribed.GetCell(1, 0), "first transcription");
+    EXPECT_EQ(transcribed.GetCell(1, 1), "second transcription");
+    // The source batch keeps its audio column.
+    EXPECT_EQ(batch.columns[1].metadata["type"], "audio");
+}
+
 // Test TranscribeAudioColumn with named column
 TEST_F(TranscribeAudioColumnTest, TranscribeAudioColumnWithName) {
     json audio_column = {
@@ -0,0 +1,83 @@
+#include "flock/prompt_manager/token_counter.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace flock {
+
+TEST(TokenCounter, EstimateRoundsUp) {
+    EXPECT_EQ(TokenCounter::Estimate(""), 0u);
+    EXPECT_EQ(TokenCounter::Estimate("abc"), 1u);
+    EXPECT_EQ(TokenCounter::Estimate("abcdefgh"), 2u);
+    EXPECT_EQ(TokenCounter::Estimate("abcdefghi"), 3u);
+}
+
+TEST(TokenCounter, EstimateCountsCodePoints) {
+    // Four two-byte characters make a single estimated token.
+    EXPECT_EQ(TokenCounter::Estimate("\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9"), 1u);
+}
+
+TEST(TokenCounter, TruncateKeepsTextWithinBudget) {
+    const std::string text = "short text";
+    EXPECT_EQ(TokenCounter::Truncate(text, 10, TruncationStrategy::HEAD), text);
+    EXPECT_EQ(TokenCounter::Truncate(text, 10, TruncationStrategy::TAIL), text);
+    EXPECT_EQ(TokenCounter::Truncate(text, 10, TruncationStrategy::MIDDLE), text);
+}
+
+TEST(TokenCounter, TruncateHeadCutsAtWordBoundary) {
+    const std::string text = "alpha beta gamma delta epsilon";
+    EXPECT_EQ(TokenCounter::Truncate(text, 3, TruncationStrategy::HEAD), "alpha beta [...]");
+}
+
+TEST(TokenCounter, TruncateTailCutsAtWordBoundary) {
+    const std::string text = "alpha beta gamma delta epsilon";
+    EXPECT_EQ(TokenCounter::Truncate(text, 3, TruncationStrategy::TAIL), "[...] epsilon");
+}
+
+TEST(TokenCounter, TruncateMiddleKeepsBothEnds) {
+    const std::string text = "alpha beta gamma delta epsilon";
+    EXPECT_EQ(TokenCounter::Truncate(text, 4, TruncationStrategy::MIDDLE), "alpha [...] epsilon");
+}
+
+TEST(TokenCounter, TruncateNeverSplitsMultiByteCharacters) {
+    std::string text;
+    for (int i = 0; i < 20; i++) {
+        text += "\xC3\xA9";
+    }
+    const auto truncated = TokenCounter::Truncate(text, 1, TruncationStrategy::HEAD);
+    EXPECT_EQ(truncated, "\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9 [...]");
+}
+
+TEST(TokenCounter, StrategyFromString) {
+    EXPECT_EQ(stringToTruncationStrategy("head"), TruncationStrategy::HEAD);
+    EXPECT_EQ(stringToTruncationStrategy("TAIL"), TruncationStrategy::TAIL);
+    EXPECT_EQ(stringToTruncationStrategy("Middle"), TruncationStrategy::MIDDLE);
+    EXPECT_THROW(stringToTruncationStrategy("start"), std::runtime_error);
+}
+
+TEST(TokenCounter, SplitKeepsShortTextWhole) {
+    EXPECT_EQ(TokenCounter::Split("short text", 10, 2), std::vector<std::string>{"short text"});
+    EXPECT_TRUE(TokenCounter::Split("", 10, 2).empty());
+}
+
+TEST(TokenCounter, SplitCutsAtWordBoundariesWithOverlap) {
+    const std::string text = "alpha beta gamma delta epsilon";
+    EXPECT_EQ(TokenCounter::Split(text, 4, 2),
+              (std::vector<std::string>{"alpha beta gamma", "gamma delta", "delta epsilon"}));
+    EXPECT_EQ(TokenCounter::Split(text, 3, 0), (std::vector<std::string>{"alpha beta", "gamma delta", "epsilon"}));
+}
+
+TEST(TokenCounter, SplitCoversLongTextWithinBudget) {
+    std::string text;
+    for (int i = 0; i < 500; i++) {
+        text += "word" + std::to_string(i) + " ";
+    }
+    const auto chunks = TokenCounter::Split(text, 50, 10);
+    ASSERT_GT(chunks.size(), 1u);
+    for (const auto& chunk: chunks) {
+        EXPECT_LE(TokenCounter::Estimate(chunk), 50u);
+    }
+    EXPECT_EQ(chunks.front().rfind("word0 ", 0), 0u);
+    EXPECT_NE(chunks.back().find("word499"), std::string::npos);
+}
+
+}// namespace flock
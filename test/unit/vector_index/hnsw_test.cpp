@@ -0,0 +1,93 @@
+#include "flock/core/vector_math.hpp"
+#include "flock/vector_index/hnsw.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace flock {
+
+class HnswGraphTest : public ::testing::Test {
+protected:
+    static constexpr size_t DIMS = 32;
+
+    static std::vector<std::vector<float>> RandomVectors(const size_t count, const uint32_t seed) {
+        std::mt19937 generator(seed);
+        std::normal_distribution<float> normal;
+        std::vector<std::vector<float>> vectors(count, std::vector<float>(DIMS));
+        for (auto& vector: vectors) {
+            std::generate(vector.begin(), vector.end(), [&] { return normal(generator); });
+            VectorMath::Normalize(vector);
+        }
+        return vectors;
+    }
+
+    static HnswGraph Build(const std::vector<std::vector<float>>& vectors) {
+        HnswGraph graph;
+        std::vector<uint32_t> changed;
+        for (size_t i = 0; i < vectors.size(); i++) {
+            graph.Insert(std::to_string(i), vectors[i], changed);
+        }
+        return graph;
+    }
+};
+
+TEST_F(HnswGraphTest, SearchFindsMostExactNeighbors) {
+    const auto vectors = RandomVectors(2000, 7);
+    const auto graph = Build(vectors);
+    constexpr size_t k = 10;
+
+    size_t found = 0;
+    const auto queries = RandomVectors(50, 11);
+    for (const auto& query: queries) {
+        std::vector<std::pair<float, uint32_t>> exact;
+        for (uint32_t i = 0; i < vectors.size(); i++) {
+            exact.emplace_back(VectorMath::Dot(query.data(), vectors[i].data(), DIMS), i);
+        }
+        std::partial_sort(exact.begin(), exact.begin() + k, exact.end(), std::greater<>());
+
+        const auto matches = graph.Search(query.data(), k, 64);
+        ASSERT_EQ(matches.size(), k);
+        EXPECT_TRUE(std::is_sorted(matches.begin(), matches.end(),
+                                   [](const auto& left, const auto& right) { return left.score > right.score; }));
+        for (size_t i = 0; i < k; i++) {
+            found += std::any_of(matches.begin(), matches.end(),
+                                 [&](const HnswGraph::Match& match) { return match.node == exact[i].second; });
+        }
+    }
+    EXPECT_GE(static_cast<double>(found) / (queries.size() * k), 0.9);
+}
+
+TEST_F(HnswGraphTest, RestoredGraphSearchesLikeTheOriginal) {
+    const auto vectors = RandomVectors(300, 3);
+    const auto graph = Build(vectors);
+
+    HnswGraph restored;
+    for (uint32_t id = 0; id < graph.Size(); id++) {
+        restored.Restore(graph.GetNode(id));
+    }
+    restored.SetEntryPoint(graph.EntryPoint());
+
+    const auto query = RandomVectors(1, 5)[0];
+    const auto expected = graph.Search(query.data(), 5, 32);
+    const auto actual = restored.Search(query.data(), 5, 32);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(actual[i].node, expected[i].node);
+    }
+}
+
+TEST_F(HnswGraphTest, InsertReportsChangedNeighborsAndRejectsOtherWidths) {
+    HnswGraph graph;
+    std::vector<uint32_t> changed;
+    graph.Insert("a", {1.0f, 0.0f}, changed);
+    EXPECT_TRUE(changed.empty());
+    graph.Insert("b", {0.0f, 1.0f}, changed);
+    ASSERT_FALSE(changed.empty());
+    EXPECT_TRUE(std::all_of(changed.begin(), changed.end(), [](const uint32_t node) { return node == 0; }));
+    EXPECT_EQ(graph.GetNode(0).neighbors[0], std::vector<uint32_t>{1});
+
+    EXPECT_THROW(graph.Insert("c", {1.0f, 0.0f, 0.0f}, changed), std::runtime_error);
+    EXPECT_TRUE(graph.Search(std::vector<float>{1.0f, 0.0f}.data(), 0, 8).empty());
+}
+
+}// namespace flock